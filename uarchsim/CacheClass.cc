@@ -24,10 +24,12 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
                        int _hitLatency, int _missLatency,
                        int _numMHSR, int _numMissSrvPorts,  int _missSrvLatency,
                        pipeline_t* _proc, const char* _identifier, 
-                       CacheClass* _nextLevel, int histLen)
+                       CacheClass* _nextLevel, repl_policy_e _replPolicy,
+                       int histLen)
 	: proc(_proc),
-    array(sets, assoc),  // Allocate cache array.
+    array(new_cache_array<CacheLineClass>(_replPolicy, sets, assoc)),  // Allocate cache array.
     nextLevel(_nextLevel),
+    memory(NULL),
     lineSize(_lineSize),
     hitLatency(_hitLatency),
     missLatency(_missLatency),
@@ -50,6 +52,7 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 	   |                  cycle (number of ports to the backing store.)
 	   |  missSrvLatency     The number of cycles before a miss service port can be
 	   |                  reused (port pipeline latency).
+	   |  replPolicy     The replacement policy of the cache array.
 	  \*------------------------------------------------------------------------*/
 {
 	int i;
@@ -65,8 +68,64 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 	for (i=0; i<numMHSR; i++) {
 		mhsr[i].resolved = 0;
 		mhsr[i].busy = false;
+		mhsr[i].numTargets = 0;
+		mhsr[i].prefetch = false;
 	}
 
+	/* Secondary-miss coalescing (unlimited targets unless set_mhsr_targets()). */
+	maxTargets = 0;
+	retryTargetsFull = false;
+
+	/* MHSR occupancy and MLP accounting. */
+	occLastCycle = 0;
+	occCycles = new uint64_t[numMHSR+1];
+	for (i=0; i<=numMHSR; i++) {
+		occCycles[i] = 0;
+	}
+	targetsPerMiss = new HistogramClass(MHSR_TARGET_HIST_BINS);
+	accessLatency = new HistogramClass(histLen);
+	missCycles = 0;
+	n_primary = 0;
+	n_secondary = 0;
+	n_secondary_no_line = 0;
+	n_targets_full = 0;
+	n_mhsr_full = 0;
+	n_next_busy = 0;
+
+	/* No prefetcher unless set_prefetcher(). */
+	prefetcher = (prefetcher_t*)NULL;
+	trainFromCore = false;
+	lastMiss = false;
+	lastPfHit = false;
+	pfEvicted = new reg_t[PF_POLLUTION_ENTRIES];
+	for (i=0; i<PF_POLLUTION_ENTRIES; i++) {
+		pfEvicted[i] = (reg_t)-1;
+	}
+	n_pf_issued = 0;
+	n_pf_redundant = 0;
+	n_pf_no_mhsr = 0;
+	n_pf_next_busy = 0;
+	n_pf_useful = 0;
+	n_pf_late = 0;
+	n_pf_useless = 0;
+	n_pf_pollution = 0;
+
+	/* Non-inclusive, no victim cache, unless set_inclusion()/set_victim_cache(). */
+	inclusion = INCL_NON_INCLUSIVE;
+	n_back_inval = 0;
+	n_back_inval_dirty = 0;
+	n_excl_moved_up = 0;
+	n_excl_inserts = 0;
+	lastDirty = false;
+	victimCache = (CacheArray*)NULL;
+	vcEntries = 0;
+	vcLatency = 0;
+	n_vc_probes = 0;
+	n_vc_hits = 0;
+	n_vc_inserts = 0;
+	n_vc_writebacks = 0;
+	profiler = (stack_dist_t*)NULL;
+
 	/* Allocate miss service ports. */
 	missPortAvail = new cycle_t[numMissSrvPorts];
 	assert(missPortAvail);
@@ -78,6 +137,24 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 
   assert(stats);
 
+  // Load latency and memory-level parallelism, also per phase.
+  ctrLoadLatency        = stats->register_counter((identifier+"_load_latency").c_str()        ,identifier.c_str());
+  ctrLoadLatencySamples = stats->register_counter((identifier+"_load_latency_samples").c_str(),identifier.c_str());
+  ctrMhsrBusyCycles     = stats->register_counter((identifier+"_mhsr_busy_cycles").c_str()    ,identifier.c_str());
+  ctrMhsrOccupancy      = stats->register_counter((identifier+"_mhsr_occupancy").c_str()      ,identifier.c_str());
+  stats->register_phase_counter((identifier+"_load_latency").c_str()        ,identifier.c_str());
+  stats->register_phase_counter((identifier+"_load_latency_samples").c_str(),identifier.c_str());
+  stats->register_phase_counter((identifier+"_mhsr_busy_cycles").c_str()    ,identifier.c_str());
+  stats->register_phase_counter((identifier+"_mhsr_occupancy").c_str()      ,identifier.c_str());
+  stats->register_rate((identifier+"_avg_load_latency_rate").c_str(), identifier.c_str(),
+                       (identifier+"_load_latency").c_str(), (identifier+"_load_latency_samples").c_str(), 1.0);
+  stats->register_rate((identifier+"_mlp_rate").c_str(), identifier.c_str(),
+                       (identifier+"_mhsr_occupancy").c_str(), (identifier+"_mhsr_busy_cycles").c_str(), 1.0);
+  stats->register_phase_rate((identifier+"_avg_load_latency_rate").c_str(), identifier.c_str(),
+                             (identifier+"_load_latency").c_str(), (identifier+"_load_latency_samples").c_str(), 1.0);
+  stats->register_phase_rate((identifier+"_mlp_rate").c_str(), identifier.c_str(),
+                             (identifier+"_mhsr_occupancy").c_str(), (identifier+"_mhsr_busy_cycles").c_str(), 1.0);
+
 #if 0
   stats->register_counter((identifier+"_load_count").c_str()        ,identifier.c_str());
   stats->register_counter((identifier+"_store_count").c_str()       ,identifier.c_str());
@@ -100,11 +177,21 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
   }
 #endif
 
+  // Handles of the access counters (their updates are ignored unless they are declared above).
+  ctrLoad        = stats->find_counter((identifier+"_load_count").c_str());
+  ctrStore       = stats->find_counter((identifier+"_store_count").c_str());
+  ctrLoadHit     = stats->find_counter((identifier+"_load_hit_count").c_str());
+  ctrStoreHit    = stats->find_counter((identifier+"_store_hit_count").c_str());
+  ctrLoadMiss    = stats->find_counter((identifier+"_load_miss_count").c_str());
+  ctrStoreMiss   = stats->find_counter((identifier+"_store_miss_count").c_str());
+  ctrReadAccess  = stats->find_counter((identifier+"_read_access_count").c_str());
+  ctrWriteAccess = stats->find_counter((identifier+"_write_access_count").c_str());
+
 }
 
 void CacheClass::flush()
 {
-	array.flush();
+	array->flush();
 }
 
 CacheClass::~CacheClass()
@@ -114,13 +201,24 @@ CacheClass::~CacheClass()
 {
 	delete [] mhsr;
 	delete [] missPortAvail;
-
+	delete array;
+	delete [] occCycles;
+	delete targetsPerMiss;
+	delete accessLatency;
+	delete [] pfEvicted;
+	if (prefetcher)
+		delete prefetcher;
+	if (victimCache)
+		delete victimCache;
+	if (profiler)
+		delete profiler;
 }
 
 cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
                              cycle_t curCycle, reg_t addr,
                              bool isStore, bool* isHit,
-                             bool probe, bool commit)
+                             bool probe, bool commit,
+                             mhsr_status_e* mhsrStatus)
 /*------------------------------------------------------------------------*\
  | Access the data cache.  Determines how many cycles access will take.
  |
@@ -134,6 +232,8 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
  |  addr              The address of the word being accessed.
  |  isStore           Indicates whether the access is a store (true) or
  |                     load (false).
+ |  mhsrStatus        (optional) Why the access returned -1: no free MHSR,
+ |                     or the MHSR of the line has no free target slot.
  |
  | Returns the cycle when the access will complete.  Returns -1 if the
  |  access can not be handled, due to limited miss handleing status
@@ -148,28 +248,42 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 	int busyMHSR;
 	int newMHSR;
 	int newPort;
+	bool secondary;
+	bool allocate;
 	cycle_t portAvail;
+	cycle_t missStart;
 	cycle_t lineInArray;
 
 //	assert (curCycle >= lastCycle);
 //	lastCycle = curCycle;
 
+	if (mhsrStatus != NULL)
+		(*mhsrStatus) = MHSR_OK;
+
 	// ER 11/16/02
 	//lineAddr = addr >> lineSize;
 	assert((Tid < 4) && (lineSize >= 2));
 	lineAddr = ((addr >> lineSize) | (Tid << 30));
 
-	line = array.lookup(lineAddr, NULL, &hit, &oldAddr, false);
-
 	if (probe) {
+		array->probe(lineAddr, &hit);
 		(*isHit) = hit;
 		return(curCycle);
 	}
 
+	line = array->lookup(lineAddr, NULL, &hit, &oldAddr, false);
+
+	// Account MHSR occupancy up to this access.
+	AdvanceOccupancy(curCycle);
+
+	lastMiss = false;
+	lastPfHit = false;
+	lastDirty = false;
+
   if(isStore){
-    inc_counter_str((identifier+"_store_count").c_str());
+    stats->update_counter(ctrStore, 1);
   } else {
-    inc_counter_str((identifier+"_load_count").c_str());
+    stats->update_counter(ctrLoad, 1);
   }
   // Line has been allocated in cache.
 	if (hit) {
@@ -180,6 +294,13 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			line->dirty = true;
 		}
 
+		// First demand access to a prefetched line.
+		if (line->prefetched) {
+			line->prefetched = false;
+			n_pf_useful++;
+			lastPfHit = true;
+		}
+
 		// Check if line is currently being loaded (is busy).
 		busyMHSR = line->mhsr;
 		if (busyMHSR != -1) {
@@ -190,11 +311,24 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			if (mhsr[busyMHSR].resolved <= curCycle) {
 				lineInArray = curCycle;
 				line->mhsr = -1;
-				mhsr[busyMHSR].resolved = 0;
-        		mhsr[busyMHSR].busy = false;
+				FreeMHSR(busyMHSR);
 			}
-			// Cache line is being loaded.
+			// Cache line is being loaded: secondary miss.
 			else {
+				// The MHSR must have a free target slot for this access.
+				if (maxTargets && (mhsr[busyMHSR].numTargets >= maxTargets))
+					return(TargetsFull(busyMHSR, isHit, mhsrStatus));
+				mhsr[busyMHSR].numTargets++;
+				n_secondary++;
+				if (mhsr[busyMHSR].prefetch) {
+					// Late prefetch: the demand access waits for it.
+					mhsr[busyMHSR].prefetch = false;
+					n_pf_late++;
+				}
+				else {
+					lastMiss = true;
+				}
+
 				lineInArray = mhsr[busyMHSR].resolved;
 				// For lines that are being loaded now, must 
         // wait at least one cache check hit time 
@@ -209,66 +343,151 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			//lineInArray = curCycle + hitLatency;
 			lineInArray = curCycle;
       if(isStore){
-        inc_counter_str((identifier+"_store_hit_count").c_str());
-        inc_counter_str((identifier+"_write_access_count").c_str());
+        stats->update_counter(ctrStoreHit, 1);
+        stats->update_counter(ctrWriteAccess, 1);
       } else {
-        inc_counter_str((identifier+"_load_hit_count").c_str());
-        inc_counter_str((identifier+"_read_access_count").c_str());
+        stats->update_counter(ctrLoadHit, 1);
+        stats->update_counter(ctrReadAccess, 1);
       }
 		}
+
+		// Exclusive: the line moves to the level above, which takes over
+		// its dirty bit (lastDirty) and with it the eventual writeback.
+		if ((inclusion == INCL_EXCLUSIVE) && !isStore && commit) {
+			lastDirty = line->dirty;
+			array->invalidate(lineAddr);
+			delete line;
+			n_excl_moved_up++;
+		}
 	}
   // Line has not been allocated in cache.
 	else {
 
     if(isStore){
-      inc_counter_str((identifier+"_store_miss_count").c_str());
+      stats->update_counter(ctrStoreMiss, 1);
     } else {
-      inc_counter_str((identifier+"_load_miss_count").c_str());
+      stats->update_counter(ctrLoadMiss, 1);
     }
 
-		// Allocate MHSR to handle cache miss.
-    // Return error value if no free MHSR
-    // is found. The previous level will
-    // retry later.
-		newMHSR = FindFreeMHSR(curCycle);
-		if (newMHSR == -1) {
-		   if (isHit != NULL)
-		      (*isHit) = false;
+		// The line may still be in flight even though it is not in the
+		// array: it was replaced while being loaded, or the access that
+		// missed on it did not commit.  Coalesce with its MHSR rather
+		// than sending a duplicate request to the next level.
+		newMHSR = FindMHSR(lineAddr, curCycle);
+		secondary = (newMHSR != -1);
 
-		   return(-1);
+		if (secondary) {
+			if (maxTargets && (mhsr[newMHSR].numTargets >= maxTargets)) {
+				lineInArray = TargetsFull(newMHSR, isHit, mhsrStatus);
+				if (profiler && commit && (lineInArray != -1))
+					profiler->Access(lineAddr);
+				return(lineInArray);
+			}
+			mhsr[newMHSR].numTargets++;
+			n_secondary++;
+			n_secondary_no_line++;
+			if (mhsr[newMHSR].prefetch) {
+				// Late prefetch, whose line was already replaced again.
+				mhsr[newMHSR].prefetch = false;
+				n_pf_useful++;
+				n_pf_late++;
+				lastPfHit = true;
+			}
+			else {
+				lastMiss = true;
+			}
 		}
-		//if (newMHSR == -1) return(-1);
-		//if (newMHSR == -1) {
-		//	assert(0);
-		//}
+		else {
+			// A victim cache hit swaps the line back into the array.
+			if (victimCache && commit) {
+				n_vc_probes++;
+				newLine = victimCache->invalidate(lineAddr);
+				if (newLine) {
+					n_vc_hits++;
+					lastMiss = true;
+					if (isStore)
+						newLine->dirty = true;
+					lineInArray = curCycle + vcLatency;
+					line = array->lookup(lineAddr, newLine, &hit, &oldAddr, true);
+					if (line != NULL)
+						Evict(Tid, lineInArray, oldAddr, line);
+					if (isHit != NULL)
+						(*isHit) = false;
+					if (!isStore)
+						SampleLoadLatency(lineInArray + hitLatency - curCycle);
+					if (profiler)
+						profiler->Access(lineAddr);
+					return(lineInArray + hitLatency);
+				}
+			}
+
+			// Allocate MHSR to handle cache miss.
+			// Return error value if no free MHSR
+			// is found. The previous level will
+			// retry later.
+			newMHSR = FindFreeMHSR(curCycle);
+			if (newMHSR == -1) {
+			   if (isHit != NULL)
+			      (*isHit) = false;
+			   if (mhsrStatus != NULL)
+			      (*mhsrStatus) = MHSR_NONE_FREE;
+			   n_mhsr_full++;
 
-		// Find the miss port to use for handling the miss.
-		newPort = FindNextPort(curCycle, &portAvail);
+			   return(-1);
+			}
+
+			lastMiss = true;
+			if (pfEvicted[lineAddr % PF_POLLUTION_ENTRIES] == lineAddr) {
+				// A prefetch evicted this line.
+				pfEvicted[lineAddr % PF_POLLUTION_ENTRIES] = (reg_t)-1;
+				n_pf_pollution++;
+			}
+			//if (newMHSR == -1) return(-1);
+			//if (newMHSR == -1) {
+			//	assert(0);
+			//}
+		}
+
+		// Exclusive: a read miss fills only the level above.
+		allocate = (commit && !((inclusion == INCL_EXCLUSIVE) && !isStore));
 
 		// Allocate a new cache line structure.
-		if (commit) {
+		if (allocate) {
 			// Allocate a new cache line structure.
 			newLine = new CacheLineClass;
 			assert(newLine);
 			newLine -> mhsr = newMHSR;
 			newLine -> dirty = isStore;
+			newLine -> prefetched = false;
 
 			// Replace the old line in the cache.
-			line = array.lookup(lineAddr, newLine, &hit, &oldAddr, true);
+			line = array->lookup(lineAddr, newLine, &hit, &oldAddr, true);
 		}
 
-		// Compute the time to load the new line from the next memory level.
-    // Added curCycle: RBRC 04/04/2015
-		lineInArray = (portAvail < curCycle) ? curCycle : portAvail;
-		//lineInArray = portAvail;
+		if (secondary) {
+			// The fill is already on its way from the next level.
+			lineInArray = mhsr[newMHSR].resolved;
+			if ((lineInArray-curCycle) < hitLatency) {
+				lineInArray = curCycle + hitLatency;
+			}
+		}
+		else {
+			// Find the miss port to use for handling the miss.
+			newPort = FindNextPort(curCycle, &portAvail);
+
+			// Compute the time to load the new line from the next memory level.
+			// Added curCycle: RBRC 04/04/2015
+			lineInArray = (portAvail < curCycle) ? curCycle : portAvail;
+			//lineInArray = portAvail;
 
-		// Must wait for hit latency cycles before beginning line load.
-		if ((lineInArray-curCycle) < hitLatency) {
-			lineInArray = curCycle + hitLatency;
+			// Must wait for hit latency cycles before beginning line load.
+			if ((lineInArray-curCycle) < hitLatency) {
+				lineInArray = curCycle + hitLatency;
+			}
 		}
 
 		// See if line being replaced is itself still being loaded.
-		if (commit && (line !=NULL)) {
+		if (allocate && (line !=NULL)) {
 			busyMHSR = line->mhsr;
 			if (busyMHSR != -1) {
 				// Line being replaced is being loaded.  Must wait until this
@@ -281,58 +500,77 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 				}
 			}
 
-			// See if line is dirty.  Line must be written back, if dirty.
-			if (line->dirty) {
-        inc_counter_str((identifier+"_read_access_count").c_str());
-        if(nextLevel == NULL){
-				  lineInArray = lineInArray + missLatency;
-        } else {
-          // lineInArray is when the next level access will start.
-          // The next level does its calculation assuming lineinArray
-          // as it's access cycle and returns when the line becomes 
-          // available for access.
-          // Must wait for writeBack to be acknowledged, which happens
-          // after accessing the next level. It is assumed that writeback
-          // uses a seprate port to next level than the allocate port.
-				  lineInArray = nextLevel->Access(Tid,lineInArray,addr,true,&hit);
-          assert(lineInArray > curCycle);
-        }
-			}
+			// Line must be written back, if dirty (or moved to the victim
+			// cache or an exclusive next level).
+			lineInArray = Evict(Tid, lineInArray, oldAddr, line);
 		}
 
-		// Allocate miss port.
-		missPortAvail[newPort] = lineInArray + missSrvLatency;
+		if (!secondary) {
+			missStart = lineInArray;
 
-		// Add miss latency to access time.
-    if(nextLevel == NULL){
-  		lineInArray = lineInArray + missLatency;
-    } else {
-      // lineInArray is when the next level access will start.
-      // The next level does its calculation assuming lineinArray
-      // as it's access cycle and returns when the line becomes 
-      // available for access.
-      // This is always a read from the next level as this is a WBWA cache model. 
-  		lineInArray = nextLevel->Access(Tid,lineInArray,addr,false,&hit);
-      // Cannot miss in MHSR in the next level if the next level has
-      // as many or more MHSRs as this level. A miss in this level can
-      // be a hit or a miss in the next level. There can be numMHSR outstanding 
-      // misses in this level and hence fewer than or equal to numMHSR misses
-      // in the next level.
-      assert(lineInArray > curCycle);
-    }
+			// Add miss latency to access time.
+	    if(nextLevel == NULL){
+	  		if (memory)
+	  		  lineInArray = memory->Access(lineInArray, addr, false);
+	  		else
+	  		  lineInArray = lineInArray + missLatency;
+	    } else {
+	      // lineInArray is when the next level access will start.
+	      // The next level does its calculation assuming lineinArray
+	      // as it's access cycle and returns when the line becomes 
+	      // available for access.
+	      // This is always a read from the next level as this is a WBWA cache model. 
+	  		lineInArray = nextLevel->Access(Tid,lineInArray,addr,false,&hit);
+	      // The next level can run out of MHSRs (or target slots): its
+	      // MHSRs are shared by this level's misses, its writebacks and
+	      // prefetches, and by the other levels above it.  Undo this
+	      // level's allocation; the requester retries later, as for a
+	      // miss that found no free MHSR here.  (A victim already evicted
+	      // to make room stays evicted.)
+	      if (lineInArray == -1) {
+	        if (allocate) {
+	          array->invalidate(lineAddr);
+	          delete newLine;
+	        }
+	        if (isHit != NULL)
+	          (*isHit) = false;
+	        if (mhsrStatus != NULL)
+	          (*mhsrStatus) = MHSR_NONE_FREE;
+	        lastMiss = false;
+	        n_next_busy++;
+	        return(-1);
+	      }
+	      assert(lineInArray > curCycle);
+	      // An exclusive next level moved the line up: keep it dirty here,
+	      // or pass it further up if this level does not keep it either.
+	      if (nextLevel->lastDirty) {
+	        if (allocate)
+	          newLine->dirty = true;
+	        else
+	          lastDirty = true;
+	      }
+	    }
+
+			// Allocate miss port.
+			missPortAvail[newPort] = missStart + missSrvLatency;
+		}
 
 		// Free old cache line, allocate miss port and MHSR.
 		// NOTE: Slight simulation approximation error here.
 		//       MHSR is being allocated this cycle, but in reality, can not
 		//       be allocated until hitLat cycles later, when miss is
 		//       known.
-		if (commit && line) {
-			delete line;
+		if (!secondary) {
+			mhsr[newMHSR].resolved = lineInArray;
+			mhsr[newMHSR].busy = true;
+			mhsr[newMHSR].lineAddress = lineAddr;
+			mhsr[newMHSR].numTargets = 1;
+			mhsr[newMHSR].prefetch = false;
+			n_primary++;
+			missCycles += (lineInArray - curCycle);
+			inFlight.push(lineInArray);
 		}
-		mhsr[newMHSR].resolved = lineInArray;
-		mhsr[newMHSR].busy = true;
-		mhsr[newMHSR].lineAddress = lineAddr;
-    inc_counter_str((identifier+"_write_access_count").c_str());
+    stats->update_counter(ctrWriteAccess, 1);
 	}
 
 	if (isHit!=NULL) {
@@ -341,19 +579,492 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 
   //LOG(proc->lsu_log,proc->cycle,uint64_t(0),uint64_t(0),"Executed %s which %s resolve cycle %" PRIcycle "",isStore?"store":"load",isHit?"hit":"miss",(lineInArray+hitLatency));
 
+	// Below the L1, train on the demand miss stream.  Writes to this level
+	// are writebacks from the level above, not part of that stream.
+	if (prefetcher && !trainFromCore && commit && !isStore && (lastMiss || lastPfHit)) {
+		Train(Tid, curCycle, 0, addr);
+	}
+
+	if (!isStore && commit)
+		SampleLoadLatency(lineInArray + hitLatency - curCycle);
+
+	// Profile only accepted accesses: a refused one (-1) is retried.
+	if (profiler && commit)
+		profiler->Access(lineAddr);
+
 	return(lineInArray + hitLatency);
 }
 
+cycle_t CacheClass::TargetsFull(int busyMHSR, bool* isHit, mhsr_status_e* mhsrStatus)
+/*------------------------------------------------------------------------*\
+ | A secondary miss found its MHSR with no free target slot.  The level
+ |  closest to the core (retryTargetsFull) tells the LSU to retry.  Lower
+ |  levels can not refuse a request from the level above, so the access
+ |  instead waits for the fill and then hits in the array.
+\*------------------------------------------------------------------------*/
+{
+	n_targets_full++;
+
+	if (isHit != NULL)
+		(*isHit) = false;
+
+	if (retryTargetsFull) {
+		if (mhsrStatus != NULL)
+			(*mhsrStatus) = MHSR_TARGETS_FULL;
+		return(-1);
+	}
+
+	// Hit in the array once the line is there, plus the usual hit latency.
+	return((mhsr[busyMHSR].resolved + hitLatency) + hitLatency);
+}
+
+void CacheClass::set_mhsr_targets(unsigned int _maxTargets, bool _retryTargetsFull)
+{
+	maxTargets = _maxTargets;
+	retryTargetsFull = _retryTargetsFull;
+}
+
 void CacheClass::set_nextLevel(CacheClass* nLevel){
 	nextLevel = nLevel;
 }
 
+void CacheClass::set_memory(dram_t* _memory){
+	memory = _memory;
+}
+
+void CacheClass::set_prefetcher(prefetcher_t* _prefetcher, bool _trainFromCore){
+	prefetcher = _prefetcher;
+	trainFromCore = _trainFromCore;
+}
+
+void CacheClass::Train(unsigned int Tid, cycle_t curCycle, reg_t pc, reg_t addr)
+{
+	unsigned int i;
+
+	if (!prefetcher)
+		return;
+
+	pfCandidates.clear();
+	prefetcher->train(curCycle, pc, addr, lastMiss, lastPfHit, pfCandidates);
+	for (i=0; i<pfCandidates.size(); i++) {
+		Prefetch(Tid, curCycle, pfCandidates[i]);
+	}
+}
+
+cycle_t CacheClass::Prefetch(unsigned int Tid, cycle_t curCycle, reg_t addr, bool forStore)
+{
+	bool hit;
+	reg_t lineAddr;
+	reg_t oldAddr;
+	CacheLineClass* line;
+	CacheLineClass* newLine;
+	int newMHSR;
+	int busyMHSR;
+	int newPort;
+	cycle_t portAvail;
+	cycle_t lineInArray;
+	cycle_t fill;
+
+	lineAddr = ((addr >> lineSize) | (Tid << 30));
+
+	array->probe(lineAddr, &hit);
+	if (!hit && victimCache)
+		victimCache->probe(lineAddr, &hit);
+	busyMHSR = FindMHSR(lineAddr, curCycle);
+	if (hit || (busyMHSR != -1)) {
+		if (!forStore)
+			n_pf_redundant++;
+		return((busyMHSR != -1) ? mhsr[busyMHSR].resolved : curCycle);
+	}
+
+	if (NumFreeMHSRs(curCycle) <= (numMHSR / PF_MHSR_RESERVE)) {
+		if (!forStore)
+			n_pf_no_mhsr++;
+		return(-1);
+	}
+	newMHSR = FindFreeMHSR(curCycle);
+	assert(newMHSR != -1);
+
+	AdvanceOccupancy(curCycle);
+
+	// Same timing as a primary miss.
+	newPort = FindNextPort(curCycle, &portAvail);
+	lineInArray = (portAvail < curCycle) ? curCycle : portAvail;
+	if ((lineInArray-curCycle) < hitLatency) {
+		lineInArray = curCycle + hitLatency;
+	}
+
+	if (nextLevel == NULL) {
+		if (memory)
+			fill = memory->Access(lineInArray, addr, false);
+		else
+			fill = lineInArray + missLatency;
+	}
+	else {
+		fill = nextLevel->Access(Tid, lineInArray, addr, false, &hit);
+		if (fill == -1) {
+			if (!forStore)
+				n_pf_next_busy++;
+			return(-1);
+		}
+	}
+	missPortAvail[newPort] = lineInArray + missSrvLatency;
+
+	newLine = new CacheLineClass;
+	assert(newLine);
+	newLine -> mhsr = newMHSR;
+	newLine -> dirty = ((nextLevel != NULL) && nextLevel->lastDirty);
+	newLine -> prefetched = !forStore;
+	line = array->lookup(lineAddr, newLine, &hit, &oldAddr, true);
+
+	if (line) {
+		// The victim may itself still be loading.
+		if ((line->mhsr != -1) && (mhsr[line->mhsr].resolved > fill)) {
+			fill = mhsr[line->mhsr].resolved;
+		}
+		if (!line->prefetched && !forStore)
+			pfEvicted[oldAddr % PF_POLLUTION_ENTRIES] = oldAddr;
+		// A dirty victim is written back off the critical path of the prefetch.
+		Evict(Tid, lineInArray, oldAddr, line);
+	}
+
+	mhsr[newMHSR].resolved = fill;
+	mhsr[newMHSR].busy = true;
+	mhsr[newMHSR].lineAddress = lineAddr;
+	mhsr[newMHSR].numTargets = 0;
+	mhsr[newMHSR].prefetch = !forStore;
+	inFlight.push(fill);
+	if (!forStore) {
+		n_pf_issued++;
+		// Core-issued prefetches (e.g., FDIP into the I$) have no prefetcher to tell.
+		if (prefetcher)
+			prefetcher->fill(fill + hitLatency, addr);
+	}
+	return(fill);
+}
+
+cycle_t CacheClass::Evict(unsigned int Tid, cycle_t curCycle, reg_t victimAddr, CacheLineClass* victim)
+/*------------------------------------------------------------------------*\
+ | A valid line (victimAddr is its line address) has been replaced in the
+ |  array.  Back-invalidates it above if this level is inclusive, then moves
+ |  it into the victim cache or past this level (WriteBack).  Frees or
+ |  takes ownership of 'victim'.  Returns when the refill may proceed.
+\*------------------------------------------------------------------------*/
+{
+	CacheLineClass* old;
+	reg_t oldAddr;
+	bool hit;
+	cycle_t done;
+
+	if (victim->prefetched)
+		n_pf_useless++;
+
+	if (inclusion == INCL_INCLUSIVE) {
+		for (unsigned int i = 0; i < upperLevels.size(); i++)
+			upperLevels[i]->Invalidate((victimAddr << lineSize), (1 << lineSize), &n_back_inval, &n_back_inval_dirty);
+	}
+
+	if (victimCache) {
+		victim->mhsr = -1;
+		old = victimCache->lookup(victimAddr, victim, &hit, &oldAddr, true);
+		if (hit) {
+			// Already there (can not normally happen): merge.
+			old->dirty = (old->dirty || victim->dirty);
+			delete victim;
+		}
+		else {
+			n_vc_inserts++;
+			// The victim cache's own victim leaves, off the critical path.
+			if (old != NULL) {
+				if (old->dirty)
+					n_vc_writebacks++;
+				WriteBack(Tid, curCycle, oldAddr, old);
+				delete old;
+			}
+		}
+		return(curCycle);
+	}
+
+	done = WriteBack(Tid, curCycle, victimAddr, victim);
+	delete victim;
+	return(done);
+}
+
+cycle_t CacheClass::WriteBack(unsigned int Tid, cycle_t curCycle, reg_t victimAddr, CacheLineClass* victim)
+/*------------------------------------------------------------------------*\
+ | Send a line leaving this level to the next one.  Returns when a dirty
+ |  line's writeback has been acknowledged.
+\*------------------------------------------------------------------------*/
+{
+	bool hit;
+	cycle_t done;
+
+	// An exclusive next level is filled with every line evicted here.
+	if ((nextLevel != NULL) && (nextLevel->inclusion == INCL_EXCLUSIVE)) {
+		done = nextLevel->Insert(Tid, curCycle, (victimAddr << lineSize), victim->dirty);
+		return(victim->dirty ? done : curCycle);
+	}
+
+	if (!victim->dirty)
+		return(curCycle);
+
+	stats->update_counter(ctrReadAccess, 1);
+	if (nextLevel == NULL) {
+		if (memory)
+			return(memory->Access(curCycle, (victimAddr << lineSize), true));
+		return(curCycle + missLatency);
+	}
+
+	// curCycle is when the next level access will start.
+	// The next level does its calculation assuming curCycle
+	// as it's access cycle and returns when the line becomes
+	// available for access.
+	// Must wait for writeBack to be acknowledged, which happens
+	// after accessing the next level. It is assumed that writeback
+	// uses a seprate port to next level than the allocate port.
+	// A writeback refused by the next level (no free MHSR) is retried once
+	// an MHSR frees up, like a page walker's refused read.
+	while ((done = nextLevel->Access(Tid, curCycle, (victimAddr << lineSize), true, &hit)) == -1)
+		curCycle = nextLevel->RetryCycle(Tid, curCycle, (victimAddr << lineSize));
+	assert(done >= curCycle);
+	return(done);
+}
+
+cycle_t CacheClass::Insert(unsigned int Tid, cycle_t curCycle, reg_t addr, bool dirty)
+{
+	bool hit;
+	reg_t lineAddr;
+	reg_t oldAddr;
+	CacheLineClass* line;
+	CacheLineClass* newLine;
+
+	n_excl_inserts++;
+	lineAddr = ((addr >> lineSize) | (Tid << 30));
+
+	line = array->lookup(lineAddr, NULL, &hit, &oldAddr, false);
+	if (hit) {
+		if (dirty)
+			line->dirty = true;
+		return(curCycle + hitLatency);
+	}
+
+	newLine = new CacheLineClass;
+	assert(newLine);
+	newLine -> mhsr = -1;
+	newLine -> dirty = dirty;
+	newLine -> prefetched = false;
+	line = array->lookup(lineAddr, newLine, &hit, &oldAddr, true);
+	if (line != NULL)
+		Evict(Tid, curCycle + hitLatency, oldAddr, line);
+
+	return(curCycle + hitLatency);
+}
+
+void CacheClass::Invalidate(reg_t addr, unsigned int size, uint64_t* lines, uint64_t* dirtyLines)
+{
+	reg_t a;
+	reg_t lineAddr;
+	CacheLineClass* line;
+
+	for (a = ((addr >> lineSize) << lineSize); a < (addr + size); a += (1 << lineSize)) {
+		lineAddr = (a >> lineSize);
+		line = array->invalidate(lineAddr);
+		if ((line == NULL) && victimCache)
+			line = victimCache->invalidate(lineAddr);
+		if (line != NULL) {
+			(*lines)++;
+			if (line->dirty)
+				(*dirtyLines)++;
+			delete line;
+		}
+	}
+
+	for (unsigned int i = 0; i < upperLevels.size(); i++)
+		upperLevels[i]->Invalidate(addr, size, lines, dirtyLines);
+}
+
+void CacheClass::set_inclusion(incl_policy_e _inclusion){
+	inclusion = _inclusion;
+}
+
+void CacheClass::add_upper_level(CacheClass* upper){
+	upperLevels.push_back(upper);
+}
+
+void CacheClass::set_victim_cache(unsigned int entries, unsigned int latency){
+	assert(entries > 0);
+	victimCache = new_cache_array<CacheLineClass>(REPL_LRU, 1, entries);
+	vcEntries = entries;
+	vcLatency = latency;
+}
+
+void CacheClass::set_profiler(stack_dist_t* _profiler){
+	profiler = _profiler;
+}
+
+void CacheClass::dump_profile(FILE* fp, uint64_t num_insn){
+	if (profiler)
+		profiler->dump(fp, identifier.c_str(), num_insn);
+}
+
+int CacheClass::NumFreeMHSRs(cycle_t curCycle)
+{
+	int i;
+	int n = 0;
+
+	for (i=0; i<numMHSR; i++) {
+		if (!mhsr[i].busy || (mhsr[i].resolved < curCycle))
+			n++;
+	}
+	return(n);
+}
+
+cycle_t CacheClass::RetryCycle(unsigned int Tid, cycle_t curCycle, reg_t addr)
+{
+	reg_t lineAddr = ((addr >> lineSize) | (Tid << 30));
+	cycle_t retry = curCycle + 1;
+	cycle_t below;
+	int i;
+
+	// No free target slot: the line is in the array once its MHSR resolves.
+	i = FindMHSR(lineAddr, curCycle);
+	if ((i != -1) && retryTargetsFull && maxTargets && (mhsr[i].numTargets >= maxTargets))
+		return(mhsr[i].resolved);
+
+	// An MHSR is free from the cycle after it resolves.
+	if (NumFreeMHSRs(curCycle) == 0) {
+		retry = mhsr[0].resolved + 1;
+		for (i=1; i<numMHSR; i++) {
+			if (mhsr[i].resolved + 1 < retry)
+				retry = mhsr[i].resolved + 1;
+		}
+	}
+
+	// The miss may have been refused further down instead.
+	if (nextLevel != NULL) {
+		below = nextLevel->RetryCycle(Tid, curCycle, addr);
+		if (below > retry)
+			retry = below;
+	}
+	return(retry);
+}
+
+void CacheClass::dump_stats(FILE* fp)
+{
+	fprintf(fp, "%s REPLACEMENT (%s)\n", identifier.c_str(), repl_policy_name[array->policy()]);
+	array->dump_policy_stats(fp);
+
+	uint64_t busyCycles = 0;
+	uint64_t allCycles = 0;
+	uint64_t weighted = 0;
+	int i;
+	for (i=0; i<=numMHSR; i++) {
+		allCycles += occCycles[i];
+		weighted += (i * occCycles[i]);
+		if (i > 0)
+			busyCycles += occCycles[i];
+	}
+
+	fprintf(fp, "%s MHSRs (%d, max. targets per MHSR = ", identifier.c_str(), numMHSR);
+	if (maxTargets)
+		fprintf(fp, "%u)\n", maxTargets);
+	else
+		fprintf(fp, "unlimited)\n");
+	fprintf(fp, "  primary misses (MHSR allocated) = %" PRIu64 "\n", n_primary);
+	fprintf(fp, "  secondary misses (coalesced)    = %" PRIu64 " (%.2f%% of misses)\n",
+	        n_secondary, 100.0*(double)n_secondary/(double)(n_primary + n_secondary));
+	fprintf(fp, "     coalesced, line not in array = %" PRIu64 "\n", n_secondary_no_line);
+	fprintf(fp, "  no free MHSR (retry)            = %" PRIu64 "\n", n_mhsr_full);
+	if (nextLevel != NULL)
+		fprintf(fp, "  next level refused (retry)      = %" PRIu64 "\n", n_next_busy);
+	fprintf(fp, "  MHSR targets full               = %" PRIu64 " (%s)\n", n_targets_full, (retryTargetsFull ? "retry" : "wait for fill"));
+	fprintf(fp, "  avg. primary miss latency       = %.2f cycles\n", (double)missCycles/(double)n_primary);
+	fprintf(fp, "  cycles with >= 1 MHSR busy      = %" PRIu64 " (%.2f%%)\n", busyCycles, 100.0*(double)busyCycles/(double)allCycles);
+	fprintf(fp, "  avg. MHSR occupancy             = %.2f\n", (double)weighted/(double)allCycles);
+	fprintf(fp, "  MLP (avg. busy MHSRs when >= 1) = %.2f\n", (double)weighted/(double)busyCycles);
+	fprintf(fp, "  MHSR occupancy histogram (busy MHSRs, cycles):\n");
+	for (i=0; i<=numMHSR; i++) {
+		if (occCycles[i])
+			fprintf(fp, "    %3d %12" PRIu64 "\n", i, occCycles[i]);
+	}
+	fprintf(fp, "  targets per miss histogram (targets, misses; last bin is %d or more):\n", (MHSR_TARGET_HIST_BINS-1));
+	for (i=1; i<MHSR_TARGET_HIST_BINS; i++) {
+		if (targetsPerMiss->Bin(i))
+			fprintf(fp, "    %3d %12d\n", i, targetsPerMiss->Bin(i));
+	}
+
+	if (accessLatency->Samples()) {
+		static const double pct[] = {0.50, 0.90, 0.95, 0.99};
+		int last = (accessLatency->Bins() - 1);
+		int lo, hi, n, p;
+
+		fprintf(fp, "%s LOAD LATENCY (reads handled by this level)\n", identifier.c_str());
+		fprintf(fp, "  reads                           = %d\n", accessLatency->Samples());
+		fprintf(fp, "  avg. latency                    = %.2f cycles\n", accessLatency->Average());
+		for (i=0; i<(int)(sizeof(pct)/sizeof(pct[0])); i++) {
+			p = accessLatency->Percentile(pct[i]);
+			fprintf(fp, "  %2.0fth percentile                 = %s%d cycles\n", 100.0*pct[i], ((p == last) ? ">= " : ""), p);
+		}
+		fprintf(fp, "  latency histogram (cycles, reads; last bin is %d or more):\n", last);
+		for (lo=0, hi=0; lo<=last; lo=hi+1, hi=((2*lo-1 < last) ? (2*lo-1) : last)) {
+			for (n=0, i=lo; i<=hi; i++)
+				n += accessLatency->Bin(i);
+			if (n && (lo == hi))
+				fprintf(fp, "    %4d      %12d\n", lo, n);
+			else if (n)
+				fprintf(fp, "    %4d-%-4d %12d\n", lo, hi, n);
+		}
+	}
+
+	if (inclusion != INCL_NON_INCLUSIVE) {
+		fprintf(fp, "%s INCLUSION (%s)\n", identifier.c_str(), incl_policy_name[inclusion]);
+		if (inclusion == INCL_INCLUSIVE) {
+			fprintf(fp, "  back-invalidated lines above    = %" PRIu64 "\n", n_back_inval);
+			fprintf(fp, "     dirty                        = %" PRIu64 "\n", n_back_inval_dirty);
+		}
+		else {
+			fprintf(fp, "  read hits moved up              = %" PRIu64 "\n", n_excl_moved_up);
+			fprintf(fp, "  lines evicted above, inserted   = %" PRIu64 "\n", n_excl_inserts);
+		}
+	}
+
+	if (victimCache) {
+		fprintf(fp, "%s VICTIM CACHE (%u entries, %" PRIcycle " cycle(s))\n", identifier.c_str(), vcEntries, vcLatency);
+		fprintf(fp, "  probes (misses in %s)        = %" PRIu64 "\n", identifier.c_str(), n_vc_probes);
+		fprintf(fp, "  hits                            = %" PRIu64 " (%.2f%%)\n", n_vc_hits, 100.0*(double)n_vc_hits/(double)n_vc_probes);
+		fprintf(fp, "  insertions                      = %" PRIu64 "\n", n_vc_inserts);
+		fprintf(fp, "  dirty lines evicted (written back) = %" PRIu64 "\n", n_vc_writebacks);
+	}
+
+	// Prefetches from the attached prefetcher, or issued by the core (e.g., fetch-directed I$ prefetches).
+	uint64_t n_pf = (n_pf_issued + n_pf_redundant + n_pf_no_mhsr + n_pf_next_busy);
+	if (prefetcher || n_pf) {
+		if (prefetcher)
+			fprintf(fp, "%s PREFETCHER (%s, degree %u)\n", identifier.c_str(), pf_kind_name[prefetcher->kind()], prefetcher->get_degree());
+		else
+			fprintf(fp, "%s PREFETCHER (requests from the core)\n", identifier.c_str());
+		fprintf(fp, "  prefetch candidates             = %" PRIu64 "\n", n_pf);
+		fprintf(fp, "     issued                       = %" PRIu64 "\n", n_pf_issued);
+		fprintf(fp, "     dropped, present or in flight= %" PRIu64 "\n", n_pf_redundant);
+		fprintf(fp, "     dropped, no spare MHSR       = %" PRIu64 "\n", n_pf_no_mhsr);
+		fprintf(fp, "     dropped, next level busy     = %" PRIu64 "\n", n_pf_next_busy);
+		fprintf(fp, "  useful (hit by a demand access) = %" PRIu64 "\n", n_pf_useful);
+		fprintf(fp, "     late (demand waited on fill) = %" PRIu64 "\n", n_pf_late);
+		fprintf(fp, "  useless (evicted unused)        = %" PRIu64 "\n", n_pf_useless);
+		fprintf(fp, "  pollution (demand misses to lines evicted by prefetches) = %" PRIu64 "\n", n_pf_pollution);
+		fprintf(fp, "  accuracy   (useful / issued)                 = %.2f%%\n", 100.0*(double)n_pf_useful/(double)n_pf_issued);
+		fprintf(fp, "  coverage   (useful / (useful + primary misses)) = %.2f%%\n", 100.0*(double)n_pf_useful/(double)(n_pf_useful + n_primary));
+		fprintf(fp, "  timeliness (on-time / useful)                = %.2f%%\n", 100.0*(double)(n_pf_useful - n_pf_late)/(double)n_pf_useful);
+		if (prefetcher)
+			prefetcher->dump(fp);
+	}
+}
+
 int CacheClass::FindFreeMHSR(cycle_t curCycle)
 {
 	int i;
 	CacheLineClass* line;
 	bool hit;
-	reg_t oldAddr;
 
 	for (i=0; i<numMHSR; i++) {
 		if (!mhsr[i].busy) {
@@ -362,14 +1073,13 @@ int CacheClass::FindFreeMHSR(cycle_t curCycle)
 		}
 		if (mhsr[i].resolved < curCycle) {
 			// MHSR is finished.  Free it.
-			line = array.lookup(mhsr[i].lineAddress, NULL, &hit, &oldAddr, false);
+			line = array->probe(mhsr[i].lineAddress, &hit);
 			if (hit) {
 				if (line->mhsr == i) {
 					line->mhsr = -1;
 				}
 			}
-			mhsr[i].resolved = 0;
-			mhsr[i].busy = false;
+			FreeMHSR(i);
 			return(i);
 		}
 	}
@@ -378,6 +1088,73 @@ int CacheClass::FindFreeMHSR(cycle_t curCycle)
 	return(-1);
 }
 
+int CacheClass::FindMHSR(reg_t lineAddr, cycle_t curCycle)
+/*------------------------------------------------------------------------*\
+ | Returns the MHSR that is still loading lineAddr, or -1 if there is none.
+\*------------------------------------------------------------------------*/
+{
+	int i;
+
+	for (i=0; i<numMHSR; i++) {
+		if (mhsr[i].busy && (mhsr[i].lineAddress == lineAddr) && (mhsr[i].resolved > curCycle)) {
+			return(i);
+		}
+	}
+	return(-1);
+}
+
+void CacheClass::FreeMHSR(int i)
+{
+	targetsPerMiss->Increment(mhsr[i].numTargets);
+	mhsr[i].resolved = 0;
+	mhsr[i].busy = false;
+	mhsr[i].numTargets = 0;
+	mhsr[i].prefetch = false;
+}
+
+void CacheClass::AdvanceOccupancy(cycle_t curCycle)
+/*------------------------------------------------------------------------*\
+ | Charge the cycles since the last access to the number of MHSRs that
+ |  were outstanding during them.  No miss can be allocated between two
+ |  accesses, so occupancy only drops, as fills complete, in that interval.
+ |  Accesses to lower levels may arrive out of cycle order; those do not
+ |  move the occupancy clock backward.
+\*------------------------------------------------------------------------*/
+{
+	cycle_t next;
+	unsigned int occ;
+
+	while (!inFlight.empty() && (inFlight.top() <= occLastCycle))
+		inFlight.pop();
+
+	while (occLastCycle < curCycle) {
+		next = curCycle;
+		if (!inFlight.empty() && (inFlight.top() < next))
+			next = inFlight.top();
+
+		occ = ((inFlight.size() > (size_t)numMHSR) ? numMHSR : inFlight.size());
+		occCycles[occ] += (next - occLastCycle);
+		if (occ > 0) {
+			stats->update_counter(ctrMhsrBusyCycles, (unsigned int)(next - occLastCycle));
+			stats->update_counter(ctrMhsrOccupancy, (unsigned int)(occ * (next - occLastCycle)));
+		}
+		occLastCycle = next;
+
+		while (!inFlight.empty() && (inFlight.top() <= occLastCycle))
+			inFlight.pop();
+	}
+}
+
+void CacheClass::SampleLoadLatency(cycle_t latency)
+/*------------------------------------------------------------------------*\
+ | Add a read handled by this level to its load latency distribution.
+\*------------------------------------------------------------------------*/
+{
+	accessLatency->Increment((int)latency);
+	stats->update_counter(ctrLoadLatency, (unsigned int)latency);
+	stats->update_counter(ctrLoadLatencySamples, 1);
+}
+
 int CacheClass::FindNextPort(cycle_t curCycle, cycle_t* portAvail)
 {
 	int i;
@@ -18,28 +18,88 @@
  |  Number of outstanding misses
  |  Number of ports to backing store
  |  Backing store port reuse latency
+ |  Replacement policy (LRU, tree-PLRU, SRRIP, BRRIP, DRRIP, SHiP)
+ |  Data prefetcher (see prefetch.h)
+ |  Inclusion of the levels above (non-inclusive, inclusive, exclusive)
+ |  Victim cache (small, fully associative, between this level and the next)
  |
  | Fixed cache parameters:
- |  Replacement policy (LRU)
  |  Write policy (Write Back)
- |  Number of cache ports (unlimited)
+ |  Number of cache ports (unlimited; the LSU models L1 D$ ports and banks)
 \*--------------------------------------------------------------------------*/
 #include "decode.h"
 #include "cache.h"
 #include "histogram.h"
+#include "dram.h"
+#include "prefetch.h"
+#include "stackdist.h"
 #include <string.h>
+#include <queue>
+#include <vector>
+#include <functional>
 
 /*--------------------------------------------------------------------------*\
  | Miss Handleing Status Register provides multiple outstanding reads and
- |  writes.  Collapses requests for the same line.
+ |  writes.  Collapses requests for the same line: every access that misses
+ |  on a line while its MHSR is busy becomes a target of that MHSR, instead
+ |  of a new request to the next level.  The cache only models timing, so
+ |  the target list is kept as its length.
 \*--------------------------------------------------------------------------*/
 class MHSRClass {
 public:
 	reg_t lineAddress;    /* Line being loaded by MHSR.        */
 	int64_t   resolved;       /* When miss will be completed.      */
   bool  busy;          /*Whether MHSR is busy */
+	unsigned int numTargets; /* Accesses waiting on this MHSR (primary included). */
+	bool  prefetch;      /* Loading a prefetch no demand access has waited on yet. */
 };
 
+/*--------------------------------------------------------------------------*\
+ | Why Access() returned -1.
+\*--------------------------------------------------------------------------*/
+typedef enum {
+	MHSR_OK,            /* Access was handled.                            */
+	MHSR_NONE_FREE,     /* Primary miss, but no free MHSR.                */
+	MHSR_TARGETS_FULL   /* Secondary miss, but its MHSR has no free target. */
+} mhsr_status_e;
+
+#define MHSR_TARGET_HIST_BINS 17
+
+/* Load latency histogram: one bin per cycle; the last bin is this many
+ * cycles or more.                                                        */
+#define LOAD_LATENCY_HIST_BINS 1024
+
+/*--------------------------------------------------------------------------*\
+ | Inclusion of the levels above this one (the levels that name this one as
+ |  their nextLevel, see add_upper_level()).
+ |
+ |  non-inclusive  Lines are filled on demand at every level and evicted
+ |                 independently (no inclusion policy enforced).
+ |  inclusive      Every line above is also here: evicting a line here
+ |                 back-invalidates it in all levels above.
+ |  exclusive      Lines above are not here: a read hit moves the line up
+ |                 (it leaves this level), a read miss fills only the level
+ |                 above, and every line evicted above (clean or dirty) is
+ |                 inserted here.  Assumes the same line size as above.
+\*--------------------------------------------------------------------------*/
+typedef enum {
+	INCL_NON_INCLUSIVE = 0,
+	INCL_INCLUSIVE,
+	INCL_EXCLUSIVE,
+	NUM_INCL_POLICIES
+} incl_policy_e;
+
+static const char* const incl_policy_name[NUM_INCL_POLICIES] = {
+	"noninclusive", "inclusive", "exclusive"
+};
+
+/* Prefetches may only use an MHSR while more than 1/PF_MHSR_RESERVE of
+ * the MHSRs are free; the rest are left to demand misses.               */
+#define PF_MHSR_RESERVE 4
+
+/* Lines evicted by prefetch fills, to count the demand misses they cause. */
+#define PF_POLLUTION_ENTRIES 1024
+
 /*--------------------------------------------------------------------------*\
  | State maintained by a D-Cache line.
 \*--------------------------------------------------------------------------*/
@@ -48,9 +108,10 @@ public:
 	int mhsr;   /* Index of MHSR that is loading this line.        */
 	bool mhsrValid; /* -1 indicates that the line is not being loaded. */
 	bool dirty; /* Indicates the line is dirty.                    */
+	bool prefetched; /* Brought in by a prefetch, not yet used.     */
 };
 
-typedef cache<CacheLineClass> CacheArray;
+typedef cache_array_t<CacheLineClass> CacheArray;
 
 //Forward declaring class
 class pipeline_t;
@@ -62,7 +123,8 @@ public:
 	           int _hitLatency, int _missLatency,
 	           int _numMHSR, int _numMissSrvPorts, int _missSrvLatency,
 	           pipeline_t* _proc, const char* _identifier,
-             CacheClass* _nextLevel=NULL, int histLen = 50);
+             CacheClass* _nextLevel=NULL, repl_policy_e _replPolicy=REPL_LRU,
+             int histLen = LOAD_LATENCY_HIST_BINS);
 	/*------------------------------------------------------------------------*\
 	 | Constructor.  Allocates data structures and initializes D-cache state.
 	 |
@@ -81,6 +143,8 @@ public:
 	 |                  cycle (number of ports to the backing store.)
 	 |  missSrvLat     The number of cycles before a miss service port can be
 	 |                  reused (port pipeline latency).
+	 |  replPolicy     The replacement policy of the cache array.
+	 |  histLen        Bins of the load latency histogram (accessLatency).
 	\*------------------------------------------------------------------------*/
 
 	~CacheClass();
@@ -94,7 +158,8 @@ public:
 
 	cycle_t Access(unsigned int Tid /* ER 11/16/02 */,
 	               cycle_t curCycle, reg_t addr, bool isStore,
-	               bool* hit=NULL, bool probe=false, bool commit=true);
+	               bool* hit=NULL, bool probe=false, bool commit=true,
+	               mhsr_status_e* mhsrStatus=NULL);
 	/*------------------------------------------------------------------------*\
 	 | Access the data cache.  Determines how many cycles access will take.
 	 |
@@ -106,20 +171,115 @@ public:
 	 |
 	 | Returns the cycle when the access will complete.  Returns -1 if the
 	 |  access can not be handled, due to limited miss handleing status
-	 |  registers.
+	 |  registers; mhsrStatus (optional) then says whether no MHSR was free or
+	 |  the line's MHSR had no free target slot.  Either way, retry later.
+	\*------------------------------------------------------------------------*/
+
+	cycle_t RetryCycle(unsigned int Tid, cycle_t curCycle, reg_t addr);
+	/*------------------------------------------------------------------------*\
+	 | The cycle at which to retry an access to addr that Access() refused at
+	 |  curCycle: when the line's MHSR resolves (no free target slot), or when
+	 |  an MHSR frees up here and in the levels below.  For requesters that
+	 |  can not simply try again next cycle (writebacks, page walks).
 	\*------------------------------------------------------------------------*/
 
 	bool Probe(unsigned int Tid,cycle_t curCycle, reg_t addr1, unsigned int length);
-	HistogramClass* accessLatency;
+	HistogramClass* accessLatency;  /* Latency of the reads that this level handled. */
 	void set_nextLevel(CacheClass* nLevel);
+
+	void set_memory(dram_t* _memory);
+	/*------------------------------------------------------------------------*\
+	 | Attach a main memory model to the last level (no nextLevel).  Misses
+	 |  and writebacks then take the memory's latency instead of missLatency.
+	\*------------------------------------------------------------------------*/
+
+	void set_mhsr_targets(unsigned int _maxTargets, bool _retryTargetsFull);
+	/*------------------------------------------------------------------------*\
+	 | Limit the number of accesses that can wait on one MHSR (0: unlimited).
+	 |  retryTargetsFull: return -1 (retry) when the limit is hit; otherwise the
+	 |  access waits for the fill.  Only the level below the LSU can retry.
+	\*------------------------------------------------------------------------*/
+
+	void set_prefetcher(prefetcher_t* _prefetcher, bool _trainFromCore);
+	/*------------------------------------------------------------------------*\
+	 | Attach a data prefetcher (deleted with the cache).  trainFromCore: the
+	 |  core trains it through Train() (L1 D$, which knows the PC); otherwise
+	 |  the cache trains it with its own demand misses and prefetch hits.
+	\*------------------------------------------------------------------------*/
+
+	void Train(unsigned int Tid, cycle_t curCycle, reg_t pc, reg_t addr);
+	/*------------------------------------------------------------------------*\
+	 | Train the prefetcher with the access just made by Access() (which
+	 |  must not have returned -1), and issue the prefetches it asks for.
+	\*------------------------------------------------------------------------*/
+
+	cycle_t Prefetch(unsigned int Tid, cycle_t curCycle, reg_t addr, bool forStore=false);
+	/*------------------------------------------------------------------------*\
+	 | Load the line of addr into the cache, like a primary miss that no access
+	 |  waits on.  Dropped (returns -1) if no MHSR is spare or if the next level
+	 |  can not take the request.  Otherwise returns when the line will be in
+	 |  the array (curCycle if it is already there).
+	 |
+	 |  forStore   Read-for-ownership on behalf of a store (see lsu): not a
+	 |             prefetcher's request, so not counted in its measurements.
+	\*------------------------------------------------------------------------*/
+
+	void set_inclusion(incl_policy_e _inclusion);
+	void add_upper_level(CacheClass* upper);
+	/*------------------------------------------------------------------------*\
+	 | Inclusion policy of this level with respect to the levels above it,
+	 |  and the levels above it (whose nextLevel is this level).
+	\*------------------------------------------------------------------------*/
+
+	void set_victim_cache(unsigned int entries, unsigned int latency);
+	/*------------------------------------------------------------------------*\
+	 | Add a fully associative, LRU victim cache of 'entries' lines below
+	 |  this level.  Lines evicted from this level go into it; a miss that
+	 |  hits in it swaps the line back after 'latency' cycles, without an
+	 |  MHSR or an access to the next level.
+	\*------------------------------------------------------------------------*/
+
+	cycle_t Insert(unsigned int Tid, cycle_t curCycle, reg_t addr, bool dirty);
+	/*------------------------------------------------------------------------*\
+	 | A line evicted from the level above fills this (exclusive) level.
+	 |  The line comes with its data: nothing is read from the next level.
+	\*------------------------------------------------------------------------*/
+
+	void Invalidate(reg_t addr, unsigned int size, uint64_t* lines, uint64_t* dirtyLines);
+	/*------------------------------------------------------------------------*\
+	 | Back-invalidation from an inclusive level below: remove the lines in
+	 |  [addr, addr+size) from this level, its victim cache, and the levels
+	 |  above.  Counts the lines removed, and how many of them were dirty.
+	\*------------------------------------------------------------------------*/
+
+	void dump_stats(FILE* fp);
+	/*------------------------------------------------------------------------*\
+	 | Print this level's measurements (replacement policy decisions, ...).
+	\*------------------------------------------------------------------------*/
+
+	void set_profiler(stack_dist_t* _profiler);
+	void dump_profile(FILE* fp, uint64_t num_insn);
+	/*------------------------------------------------------------------------*\
+	 | Attach a stack-distance profiler (deleted with the cache) to the demand
+	 |  accesses of this level, and print its miss rate tables.
+	\*------------------------------------------------------------------------*/
 private:
 
   pipeline_t* proc;
 	int FindFreeMHSR(cycle_t curCycle);
+	int FindMHSR(reg_t lineAddr, cycle_t curCycle);
+	void FreeMHSR(int i);
+	cycle_t TargetsFull(int busyMHSR, bool* isHit, mhsr_status_e* mhsrStatus);
+	void AdvanceOccupancy(cycle_t curCycle);
+	void SampleLoadLatency(cycle_t latency);
+	int NumFreeMHSRs(cycle_t curCycle);
+	cycle_t Evict(unsigned int Tid, cycle_t curCycle, reg_t victimAddr, CacheLineClass* victim);
+	cycle_t WriteBack(unsigned int Tid, cycle_t curCycle, reg_t victimAddr, CacheLineClass* victim);
 	int FindNextPort(cycle_t curCycle, cycle_t* portAvail);
 
-	CacheArray  array;          /* The D-Cache array.                           */
+	CacheArray* array;          /* The D-Cache array.                           */
   CacheClass* nextLevel; 
+	dram_t*     memory;            /* Main memory below the LLC (may be NULL).   */
   std::string identifier;
 	int         lineSize;        /* D-Cache line size.  Must be a power of 2.    */
 //	cycle_t     lastCycle;         /* curCycle of last access.                     */
@@ -132,9 +292,69 @@ private:
 	MHSRClass*  mhsr;           /* The miss handling status registers.          */
 	int         numMissSrvPorts;       /* Number of miss ports available.              */
 	cycle_t     missSrvLatency;    /* Pipeline reuse latency for miss ports.       */
+	unsigned int maxTargets;       /* Max. accesses per MHSR (0: unlimited).       */
+	bool        retryTargetsFull;  /* Return -1 when an MHSR's targets are full.   */
+
+	/* MHSR occupancy: fill cycles of outstanding primary misses (min-heap),
+	 * and the number of cycles spent with 0..numMHSR MHSRs busy.           */
+	std::priority_queue<cycle_t, std::vector<cycle_t>, std::greater<cycle_t> > inFlight;
+	cycle_t     occLastCycle;
+	uint64_t*   occCycles;
+	HistogramClass* targetsPerMiss;
+
+	/* stats */
+	uint64_t    missCycles;        /* Sum of primary miss latencies.              */
+	uint64_t    n_primary;
+	uint64_t    n_secondary;
+	uint64_t    n_secondary_no_line;
+	uint64_t    n_targets_full;
+	uint64_t    n_mhsr_full;
+	uint64_t    n_next_busy;       /* Primary misses the next level refused.      */
+
+	/* Prefetching. */
+	prefetcher_t* prefetcher;
+	bool        trainFromCore;
+	bool        lastMiss;          /* Last Access() was a demand miss.            */
+	bool        lastPfHit;         /* ... or the first demand hit on a prefetch.  */
+	std::vector<reg_t> pfCandidates;
+	reg_t*      pfEvicted;         /* Valid lines evicted by prefetch fills.      */
+
+	uint64_t    n_pf_issued;
+	uint64_t    n_pf_redundant;    /* Line already present or in flight.          */
+	uint64_t    n_pf_no_mhsr;      /* No spare MHSR.                              */
+	uint64_t    n_pf_next_busy;    /* Next level refused it (no free MHSR).       */
+	uint64_t    n_pf_useful;       /* Prefetched lines hit by a demand access.    */
+	uint64_t    n_pf_late;         /* ... that were still in flight.              */
+	uint64_t    n_pf_useless;      /* Prefetched lines evicted unused.            */
+	uint64_t    n_pf_pollution;    /* Demand misses to lines a prefetch evicted.  */
+
+	/* Inclusion. */
+	incl_policy_e inclusion;
+	std::vector<CacheClass*> upperLevels;
+	uint64_t    n_back_inval;      /* Lines back-invalidated above.               */
+	uint64_t    n_back_inval_dirty;
+	uint64_t    n_excl_moved_up;   /* Exclusive: read hits that left this level.  */
+	uint64_t    n_excl_inserts;    /* Exclusive: lines evicted above, inserted.   */
+	bool        lastDirty;         /* Last Access() moved a dirty line up.        */
+
+	/* Victim cache. */
+	CacheArray* victimCache;
+	unsigned int vcEntries;
+	cycle_t     vcLatency;
+	uint64_t    n_vc_probes;       /* Misses that looked in the victim cache.     */
+	uint64_t    n_vc_hits;
+	uint64_t    n_vc_inserts;
+	uint64_t    n_vc_writebacks;   /* Dirty lines evicted from the victim cache.  */
+
+	/* Stack-distance profiler (NULL: off). */
+	stack_dist_t* profiler;
 
   stats_t* stats;
 
+  /* Handles of this cache's counters in the stats module (see stats.h). */
+  unsigned int ctrLoadLatency, ctrLoadLatencySamples, ctrMhsrBusyCycles, ctrMhsrOccupancy;
+  unsigned int ctrLoad, ctrStore, ctrLoadHit, ctrStoreHit, ctrLoadMiss, ctrStoreMiss, ctrReadAccess, ctrWriteAccess;
+
 };
 
 #endif //DCACHE_H
@@ -54,3 +54,28 @@ void pipeline_t::alu(unsigned int index) {
   state_t& state = *get_state();
   alu_op_fn(pay_buf, state);
 }
+
+
+// Execute a fused macro-op (see pipeline_t::fuse()): "index" is its second instruction, which carries the first one.
+// Execute the first instruction with the macro-op's source values, then the second one, whose source registers are the
+// first one's destination register or x0.  Both instructions' source and destination values are left in PAY for the checker.
+void pipeline_t::alu_fused(unsigned int index) {
+	unsigned int first = MOD((index + PAY.PAYLOAD_BUFFER_SIZE - 2), PAY.PAYLOAD_BUFFER_SIZE);
+	insn_t inst = PAY.buf[index].inst;
+
+	PAY.buf[first].A_value = PAY.buf[index].A_value;
+	PAY.buf[first].B_value = PAY.buf[index].B_value;
+	alu(first);
+
+	PAY.buf[index].A_value.dw = ((inst.rs1() == 0) ? 0 : PAY.buf[first].C_value.dw);
+	if (inst.opcode() == OP_BRANCH) {
+		PAY.buf[index].B_value.dw = ((inst.rs2() == 0) ? 0 : PAY.buf[first].C_value.dw);
+		alu(index);
+
+		// A branch has no destination register: the macro-op's destination register is the compare's.
+		PAY.buf[index].C_value = PAY.buf[first].C_value;
+	}
+	else {
+		alu(index);
+	}
+}
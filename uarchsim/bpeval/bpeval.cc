@@ -0,0 +1,383 @@
+// bpeval: trace-driven evaluation of the Fetch Unit's branch predictors, in seconds instead of a full pipeline run.
+//
+// The branch trace (see bptrace.h) is written by 721sim while fast-skipping (-s<n> --bptrace=<file>).  It is replayed through the
+// Fetch Unit's prediction model: the BTB (and L2 BTB), the branch queue, and the Fetch Unit's own branch predictor (bpred_t: the
+// gshare, TAGE or hashed perceptron conditional branch predictor and its add-ons, the gshare or ITTAGE indirect branch predictor,
+// and the RAS, with their speculative update, repair, and training).  The predictor options are 721sim's.
+//
+// The model follows fetchunit_t, without timing:
+// - Fetch1: Predict the fetch bundle at pc (the BTB assembles it), and speculatively update the pc, BHRs and RAS.
+// - Fetch2: Predecode the fetch bundle along the correct path.  A misfetch trains the BTB, and the bundle is repredicted.
+//   Otherwise, push the bundle's branches onto the branch queue.  If one was mispredicted (it is the last one: the correct path
+//   leaves the bundle after it), recover with bpred_t::mispredict(), like fetchunit_t::mispredict().
+// - Retire: Train the predictors with the oldest branch, once "delay" younger branches were predicted (--delay, 0: right away).
+// A redirect in the trace (trap, trap return) retires all branches and restarts fetch at the new pc, like fetchunit_t::flush().
+// Unlike the pipeline, wrong-path fetch bundles are never fetched, so they don't train the BTB or disturb the RAS.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cinttypes>
+#include <cassert>
+#include <chrono>
+#include <deque>
+#include <fesvr/option_parser.h>
+#include <gzstream.h>
+
+#include "processor.h"
+#include "decode.h"
+#include "config.h"
+
+#include "parameters.h"
+#include "fetchunit_types.h"
+#include "btb.h"
+#include "bpred.h"
+#include "bptrace.h"
+
+
+class bpeval_t {
+private:
+	// Fetch bundle constraints.
+	uint64_t instr_per_cycle;
+
+	// Number of younger branches predicted before a branch retires.
+	uint64_t delay;
+
+	// The correct path: records read ahead from the trace.
+	bptrace_reader_t trace;
+	std::deque<bptrace_rec_t> path;
+
+	// The Fetch Unit's state and components (see fetchunit.h and bpred.h).
+	uint64_t pc;
+	fetch_bundle_t *fetch_bundle;
+	btb_t btb;
+	bpred_t bp;
+	bq_t bq;
+	uint64_t in_flight;	// number of branches in the branch queue
+
+	// Measurements (the branch prediction measurements are bpred_t's).
+	uint64_t meas_bundles;		// # fetch bundles predicted (including repredicted ones)
+	uint64_t meas_btbmiss;		// # misfetched fetch bundles
+	uint64_t meas_btb_l2_hit;	// # fetch bundles with L2 BTB hits
+	uint64_t meas_redirect;		// # redirects
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	// Read ahead until the path holds at least "n" records.  Returns false at the end of the trace.
+	bool fill_path(uint64_t n);
+
+	// The same steps as their fetchunit_t counterparts.
+	void commit();
+	void redirect();
+
+public:
+	bpeval_t(const char *trace_file, uint64_t delay);
+	~bpeval_t();
+
+	void run();
+	void output(double seconds, FILE *fp);
+};
+
+
+bpeval_t::bpeval_t(const char *trace_file, uint64_t delay) : instr_per_cycle(FETCH_WIDTH),
+                                                            delay(delay),
+                                                            trace(trace_file),
+                                                            pc(0),
+                                                            btb(BTB_ENTRIES, FETCH_WIDTH, BTB_ASSOC, COND_BRANCH_PRED_PER_CYCLE, BTB_L2_ENTRIES, BTB_L2_ASSOC),
+                                                            bp(COND_BRANCH_PRED_PER_CYCLE, CBP_PC_LENGTH, CBP_BHR_LENGTH, IBP_PC_LENGTH, IBP_BHR_LENGTH,
+                                                               TAGE_KB, TAGE_TABLES, TAGE_MIN_HIST, TAGE_MAX_HIST, PERCEPTRON_KB, PERCEPTRON_TABLES, PERCEPTRON_MAX_HIST,
+                                                               LOOP_ENTRIES, SC_ENTRIES, ITTAGE_KB, ITTAGE_TABLES, ITTAGE_MIN_HIST, ITTAGE_MAX_HIST,
+                                                               RAS_SIZE, (delay + FETCH_WIDTH + 1)), // outcomes in flight: those of the branch queue (below)
+                                                            bq(delay + FETCH_WIDTH + 1), // the retired branches leave at most "delay" branches, then a fetch bundle pushes its branches
+                                                            in_flight(0)
+{
+   // The BTB does not set the exception bits: there are no fetch exceptions in a trace (a trap is a redirect).
+   fetch_bundle = new fetch_bundle_t[instr_per_cycle];
+   for (uint64_t i = 0; i < instr_per_cycle; i++)
+      fetch_bundle[i].exception = false;
+
+   meas_bundles = 0;
+   meas_btbmiss = 0;
+   meas_btb_l2_hit = 0;
+   meas_redirect = 0;
+}
+
+bpeval_t::~bpeval_t() {
+}
+
+bool bpeval_t::fill_path(uint64_t n) {
+   bptrace_rec_t rec;
+
+   while (path.size() < n) {
+      if (!trace.next(rec))
+         return(false);
+      path.push_back(rec);
+   }
+   return(true);
+}
+
+void bpeval_t::commit() {
+   uint64_t pred_tag;
+   bool pred_tag_phase;
+
+   bq.pop(pred_tag, pred_tag_phase);
+   in_flight--;
+   bp.commit(&bq.bq[pred_tag]);
+}
+
+// The path's next record is a redirect at pc: retire all branches and restart at the new pc.
+void bpeval_t::redirect() {
+   while (in_flight)
+      commit();
+   pc = path.front().next_pc;
+   path.pop_front();
+   if (bp.loop)
+      bp.loop->spec_reset();
+   meas_redirect++;
+}
+
+void bpeval_t::run() {
+   uint64_t cb_predictions;       // "m" conditional branch predictions packed into a uint64_t
+   uint64_t ib_predicted_target;  // predicted target from the indirect branch predictor
+   uint64_t ras_predicted_target; // predicted target from the return address stack
+   spec_update_t update;
+   cb_addon_t cb_addon;
+   fetch2_status_t status;        // the fetch bundle's context (pc, BHRs, RAS TOS prior to it)
+   bptrace_rec_t *rec;
+   uint64_t n;                    // number of slots of the fetch bundle on the correct path
+   uint64_t k;                    // number of records of the correct path in those slots
+   bool misfetch;
+   bool leave;                    // the correct path leaves the fetch bundle
+   bool done = false;
+
+   while (!done && fill_path(1)) {
+      // The sequential instruction stream stops at pc.
+      if (path.front().redirect && (path.front().pc == pc)) {
+         redirect();
+         continue;
+      }
+
+      //////////////////////////////////////////////////////
+      // Fetch1: predict the fetch bundle at pc.
+      //////////////////////////////////////////////////////
+      status.pc = pc;
+      status.cb_bhr = bp.cb_index.get_bhr();
+      status.ib_bhr = bp.ib_index.get_bhr();
+      status.ghist = bp.ghist.get_bhr();
+      status.ras_tos = bp.ras.get_tos();
+
+      cb_predictions = bp.cb_predict(pc, status.cb_bhr, status.ghist, &cb_addon);
+      ib_predicted_target = bp.ib_predict(pc, status.ib_bhr, status.ghist);
+      ras_predicted_target = bp.ras.peek();
+
+      if (btb.lookup(pc, cb_predictions, ib_predicted_target, ras_predicted_target, fetch_bundle, &update))
+         meas_btb_l2_hit++;
+      pc = update.next_pc;
+      bp.spec_update(&update, cb_predictions);
+      meas_bundles++;
+
+      //////////////////////////////////////////////////////
+      // Fetch2: predecode the fetch bundle along the correct path (cf. fetchunit_t::fetch2()).
+      //////////////////////////////////////////////////////
+      misfetch = false;
+      leave = false;
+      n = 0;
+      k = 0;
+      while ((n < instr_per_cycle) && fetch_bundle[n].valid && !leave) {
+         if (!fill_path(k + 1)) {
+            done = true;	// End of the trace.
+            break;
+         }
+         rec = &path[k];
+         if (rec->redirect && (rec->pc == fetch_bundle[n].pc))
+            break;	// The slot is not on the correct path.
+
+         if (!rec->redirect && (rec->pc == fetch_bundle[n].pc)) {
+            // A branch.
+            if (!fetch_bundle[n].branch ||
+                (fetch_bundle[n].branch_type != rec->branch_type) ||
+                ((rec->insn.opcode() != OP_JALR) && (fetch_bundle[n].branch_target != rec->branch_target))) {
+               misfetch = true;
+               btb.update(status.pc, n, rec->insn);
+               meas_btbmiss++;
+            }
+            leave = (rec->next_pc != INCREMENT_PC(rec->pc));
+            k++;
+         }
+         else if (fetch_bundle[n].branch) {
+            // A non-branch that the BTB identified as a branch.
+            misfetch = true;
+            btb.invalidate(status.pc, n);
+            meas_btbmiss++;
+         }
+         n++;
+      }
+      if (done)
+         break;
+
+      if (misfetch) {
+         // Roll back to just prior to the fetch bundle, to repredict it.
+         pc = status.pc;
+         bp.restore(status.cb_bhr, status.ib_bhr, status.ghist, status.ras_tos);
+         continue;
+      }
+
+      //////////////////////////////////////////////////////
+      // Push the branches onto the branch queue, and check their predictions.
+      //////////////////////////////////////////////////////
+      uint64_t pred_tag;
+      bool pred_tag_phase;
+      uint64_t fetch_cb_pos_in_entry = 0;
+      uint64_t my_cb_bhr = status.cb_bhr;
+      uint64_t my_ib_bhr = status.ib_bhr;
+      uint64_t my_ghist = status.ghist;
+      bool taken;
+
+      for (uint64_t pos = 0; pos < n; pos++) {
+         if (!fetch_bundle[pos].branch)
+            continue;
+         rec = &path.front();
+         assert(!rec->redirect && (rec->pc == fetch_bundle[pos].pc));
+
+         bq.push(pred_tag, pred_tag_phase);
+         in_flight++;
+         bq_entry_t *e = &bq.bq[pred_tag];
+         e->branch_type = fetch_bundle[pos].branch_type;
+         e->pc = fetch_bundle[pos].pc;
+         e->branch_target = fetch_bundle[pos].branch_target;
+         e->precise_cb_bhr = my_cb_bhr;
+         e->precise_ib_bhr = my_ib_bhr;
+         e->precise_ghist = my_ghist;
+         e->precise_ras_tos = status.ras_tos;
+         e->fetch_pc = status.pc;
+         e->fetch_cb_bhr = status.cb_bhr;
+         e->fetch_ib_bhr = status.ib_bhr;
+         e->fetch_ghist = status.ghist;
+         e->fetch_cb_pos_in_entry = 0;
+         e->loop_entry = -1;
+         e->misp = false;
+
+         taken = (fetch_bundle[pos].next_pc != INCREMENT_PC(fetch_bundle[pos].pc));
+         e->taken = taken;
+         e->next_pc = fetch_bundle[pos].next_pc;
+
+         if (e->branch_type == BTB_BRANCH) {
+            bp.cb_push(e, cb_addon, fetch_cb_pos_in_entry, taken);
+            fetch_cb_pos_in_entry++;
+            my_cb_bhr = bp.cb_index.update_my_bhr(my_cb_bhr, taken);
+            my_ib_bhr = bp.ib_index.update_my_bhr(my_ib_bhr, taken);
+            my_ghist = bp.ghist.update_my_bhr(my_ghist, taken);
+         }
+
+         // A mispredicted branch is the last one on the correct path in the fetch bundle.
+         if (e->next_pc != rec->next_pc) {
+            assert(pos == (n - 1));
+            bp.mispredict(bq, pred_tag, pred_tag_phase, rec->taken, rec->next_pc);
+            pc = rec->next_pc;
+         }
+         path.pop_front();
+      }
+
+      // The correct path stops being sequential within the fetch bundle: drop the rest of it (the redirect is handled next).
+      if (!leave && (n < instr_per_cycle) && fetch_bundle[n].valid) {
+         pc = fetch_bundle[n].pc;
+         bp.restore(my_cb_bhr, my_ib_bhr, my_ghist, status.ras_tos);
+      }
+
+      //////////////////////////////////////////////////////
+      // Retire the branches that are "delay" branches old.
+      //////////////////////////////////////////////////////
+      while (in_flight > delay)
+         commit();
+   }
+
+   while (in_flight)
+      commit();
+}
+
+void bpeval_t::output(double seconds, FILE *fp) {
+   uint64_t num_instr = trace.num_instr;
+   uint64_t all = (bp.meas_branch_n + bp.meas_jumpdir_n + bp.meas_calldir_n + bp.meas_jumpind_n + bp.meas_callind_n + bp.meas_jumpret_n);
+
+   fprintf(fp, "TRACE------------------------------------------------\n");
+   fprintf(fp, "Instructions = %lu, branches = %lu, redirects = %lu\n", num_instr, all, meas_redirect);
+   fprintf(fp, "Evaluation time = %.2f s (%.1f M instructions/s)\n", seconds, ((double)num_instr / seconds) / 1e6);
+   bp.output(num_instr, fp);
+   fprintf(fp, "BTB MEASUREMENTS-----------------------------------\n");
+   fprintf(fp, "Fetch bundles = %lu, misfetched (BTB misses) = %lu (%.2f%%)\n", meas_bundles, meas_btbmiss, 100.0 * ((double)meas_btbmiss / (double)meas_bundles));
+   if (BTB_L2_ENTRIES)
+      fprintf(fp, "Fetch bundles with L2 BTB hits = %lu\n", meas_btb_l2_hit);
+   bp.output_components(num_instr, fp);
+}
+
+
+static void help()
+{
+  fprintf(stderr, "usage: bpeval [options] <branch trace>\n");
+  fprintf(stderr, "Replays a branch trace (written by 721sim -s<n> --bptrace=<file>) through the Fetch Unit's branch predictors.\n");
+  fprintf(stderr, "Options (defaults and meaning as in 721sim):\n");
+  fprintf(stderr, "  --delay=<n>        Train the predictors with a branch after <n> younger branches were predicted (default 0)\n");
+  fprintf(stderr, "  --fw=<n>           <n> wide fetch\n");
+  fprintf(stderr, "  --mbp=<n>          Conditional branches per fetch bundle\n");
+  fprintf(stderr, "  --btbentries=<n>   BTB has a total of <n> entries\n");
+  fprintf(stderr, "  --btbassoc=<n>     BTB has a set-associativity of <n>\n");
+  fprintf(stderr, "  --btbl2=<n>[:<assoc>:<lat>]\tAdd an L2 BTB (<lat> is ignored)\n");
+  fprintf(stderr, "  --ras=<n>          RAS has <n> entries\n");
+  fprintf(stderr, "  --cbpPC=<n>, --cbpBHR=<n>, --ibpPC=<n>, --ibpBHR=<n>\tgshare predictors' PC and BHR lengths\n");
+  fprintf(stderr, "  --tage=<KB>[:<TABLES>:<MIN_HIST>:<MAX_HIST>]\n");
+  fprintf(stderr, "  --perceptron=<KB>[:<TABLES>:<MAX_HIST>]\n");
+  fprintf(stderr, "  --loop=<n>\n");
+  fprintf(stderr, "  --sc=<n>\n");
+  fprintf(stderr, "  --ittage=<KB>[:<TABLES>:<MIN_HIST>:<MAX_HIST>]\n");
+  exit(1);
+}
+
+static void config(const char* option, const char* config, const char* format, int expected, int max, unsigned int *a, unsigned int *b, unsigned int *c, unsigned int *d) {
+   int n = sscanf(config, format, a, b, c, d);
+   if ((n != expected) && (n != max)) {
+      fprintf(stderr, "Incorrect usage of --%s (see 721sim -h).\n", option);
+      exit(-1);
+   }
+}
+
+int main(int argc, char** argv)
+{
+  uint64_t delay = 0;
+  unsigned int unused;
+
+  option_parser_t parser;
+  parser.help(&help);
+  parser.option('h', 0, 0, [&](const char* s){help();});
+  parser.option(0, "delay", 1, [&](const char* s){delay = atoll(s);});
+  parser.option(0, "fw", 1, [&](const char* s){FETCH_WIDTH = atoi(s);});
+  parser.option(0, "mbp", 1, [&](const char* s){COND_BRANCH_PRED_PER_CYCLE = atoi(s);});
+  parser.option(0, "btbentries", 1, [&](const char* s){BTB_ENTRIES = atoi(s);});
+  parser.option(0, "btbassoc", 1, [&](const char* s){BTB_ASSOC = atoi(s);});
+  parser.option(0, "btbl2", 1, [&](const char* s){config("btbl2", s, "%u:%u:%u", 1, 3, &BTB_L2_ENTRIES, &BTB_L2_ASSOC, &BTB_L2_LATENCY, &unused);});
+  parser.option(0, "ras", 1, [&](const char* s){RAS_SIZE = atoi(s);});
+  parser.option(0, "cbpPC", 1, [&](const char* s){CBP_PC_LENGTH = atoi(s);});
+  parser.option(0, "cbpBHR", 1, [&](const char* s){CBP_BHR_LENGTH = atoi(s);});
+  parser.option(0, "ibpPC", 1, [&](const char* s){IBP_PC_LENGTH = atoi(s);});
+  parser.option(0, "ibpBHR", 1, [&](const char* s){IBP_BHR_LENGTH = atoi(s);});
+  parser.option(0, "tage", 1, [&](const char* s){config("tage", s, "%u:%u:%u:%u", 1, 4, &TAGE_KB, &TAGE_TABLES, &TAGE_MIN_HIST, &TAGE_MAX_HIST);});
+  parser.option(0, "perceptron", 1, [&](const char* s){config("perceptron", s, "%u:%u:%u", 1, 3, &PERCEPTRON_KB, &PERCEPTRON_TABLES, &PERCEPTRON_MAX_HIST, &unused);});
+  parser.option(0, "loop", 1, [&](const char* s){LOOP_ENTRIES = atoi(s);});
+  parser.option(0, "sc", 1, [&](const char* s){SC_ENTRIES = atoi(s);});
+  parser.option(0, "ittage", 1, [&](const char* s){config("ittage", s, "%u:%u:%u:%u", 1, 4, &ITTAGE_KB, &ITTAGE_TABLES, &ITTAGE_MIN_HIST, &ITTAGE_MAX_HIST);});
+
+  auto argv1 = parser.parse(argv);
+  if (!*argv1)
+    help();
+  if (TAGE_KB && PERCEPTRON_KB) {
+    fprintf(stderr, "--tage and --perceptron are mutually exclusive.\n");
+    exit(-1);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  bpeval_t eval(*argv1, delay);
+  eval.run();
+  std::chrono::duration<double> seconds = (std::chrono::steady_clock::now() - start);
+  eval.output(seconds.count(), stdout);
+  return 0;
+}
@@ -0,0 +1,466 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+
+#include "processor.h"
+#include "decode.h"
+#include "config.h"
+
+#include "bpred.h"
+
+bpred_t::bpred_t(uint64_t cond_branch_per_cycle,                // "m"
+                 uint64_t cb_pc_length, uint64_t cb_bhr_length, // gshare cond. br. predictor: pc length (index size), bhr length
+                 uint64_t ib_pc_length, uint64_t ib_bhr_length, // gshare indirect br. predictor: pc length (index size), bhr length
+                 uint64_t tage_kb,                              // TAGE cond. br. predictor: budget in KB (0: use the gshare predictor instead)
+                 uint64_t tage_tables,                          // TAGE: number of tagged tables
+                 uint64_t tage_min_hist, uint64_t tage_max_hist, // TAGE: shortest and longest history lengths
+                 uint64_t perceptron_kb,                        // hashed perceptron cond. br. predictor: budget in KB (0: gshare or TAGE)
+                 uint64_t perceptron_tables,                    // hashed perceptron: number of weight tables (including the bias table)
+                 uint64_t perceptron_max_hist,                  // hashed perceptron: history length
+                 uint64_t loop_entries,                         // loop predictor add-on: number of entries (0: none)
+                 uint64_t sc_entries,                           // statistical corrector add-on: entries per table (0: none)
+                 uint64_t ittage_kb,                            // ITTAGE indirect br. predictor: budget in KB (0: use the gshare predictor instead)
+                 uint64_t ittage_tables,                        // ITTAGE: number of tagged tables
+                 uint64_t ittage_min_hist, uint64_t ittage_max_hist, // ITTAGE: shortest and longest history lengths
+                 uint64_t ras_size,                             // # entries in the RAS
+                 uint64_t max_outcomes                          // max. number of conditional branch outcomes in flight (long global history size)
+                 ) : cond_branch_per_cycle(cond_branch_per_cycle),
+                     cb_index(cb_pc_length, cb_bhr_length),
+                     ghist(16), // 64K outcomes
+                     ib_index(ib_pc_length, ib_bhr_length),
+                     ras(ras_size)
+{
+   // Memory-allocate the conditional branch (cb) prediction table and indirect branch (ib) prediction table.
+   cb = new uint64_t[cb_index.table_size()];
+   ib = new uint64_t[ib_index.table_size()];
+
+   for (uint64_t i = 0; i < cb_index.table_size(); i++)
+      cb[i] = 0xaaaaaaaa; // Initialize counters to weakly-taken.
+
+   // Optionally replace the gshare conditional branch predictor with TAGE.
+   // The long global history must hold the longest history plus all outcomes in flight.
+   tage = NULL;
+   if (tage_kb)
+   {
+      tage = new tage_t(&ghist, cond_branch_per_cycle, tage_kb, tage_tables, tage_min_hist, tage_max_hist);
+      assert(ghist.size() > (tage->max_history() + max_outcomes));
+   }
+
+   // Or with the hashed perceptron (same requirement on the long global history).
+   perceptron = NULL;
+   if (perceptron_kb)
+   {
+      assert(!tage);
+      perceptron = new perceptron_t(&ghist, cond_branch_per_cycle, perceptron_kb, perceptron_tables, perceptron_max_hist);
+      assert(ghist.size() > (perceptron->max_history() + max_outcomes));
+   }
+
+   // Optional add-ons to the conditional branch predictor.
+   sc = (sc_entries ? new stat_corrector_t(&ghist, sc_entries, cond_branch_per_cycle) : NULL);
+   loop = (loop_entries ? new loop_predictor_t(loop_entries, cond_branch_per_cycle) : NULL);
+
+   // Optionally replace the gshare indirect branch predictor with ITTAGE (same requirement on the long global history).
+   ittage = NULL;
+   if (ittage_kb)
+   {
+      ittage = new ittage_t(&ghist, ittage_kb, ittage_tables, ittage_min_hist, ittage_max_hist);
+      assert(ghist.size() > (ittage->max_history() + max_outcomes));
+   }
+
+   // Initialize measurements.
+
+   meas_branch_n = 0;  // # branches
+   meas_jumpdir_n = 0; // # jumps, direct
+   meas_calldir_n = 0; // # calls, direct
+   meas_jumpind_n = 0; // # jumps, indirect
+   meas_callind_n = 0; // # calls, indirect
+   meas_jumpret_n = 0; // # jumps, return
+
+   meas_branch_m = 0;  // # mispredicted branches
+
+   meas_cb_main_n = 0;
+   meas_cb_main_m = 0;
+   meas_cb_sc_n = 0;
+   meas_cb_sc_m = 0;
+   meas_cb_loop_n = 0;
+   meas_cb_loop_m = 0;
+   meas_jumpind_m = 0; // # mispredicted jumps, indirect
+   meas_callind_m = 0; // # mispredicted calls, indirect
+   meas_jumpret_m = 0; // # mispredicted jumps, return
+
+   meas_jumpind_seq = 0; // # jump-indirect instructions whose targets were the next sequential PC
+}
+
+bpred_t::~bpred_t()
+{
+}
+
+uint64_t bpred_t::cb_predict(uint64_t pc, uint64_t cb_bhr, uint64_t hist, cb_addon_t *addon)
+{
+   uint64_t cb_predictions;
+   uint64_t predictions;
+   uint64_t ctr;
+   bool taken;
+   bool loop_taken;
+
+   // Get "m" predictions from the conditional branch predictor (gshare, TAGE or perceptron).
+   // "m" two-bit counters are packed into a uint64_t.
+   cb_predictions = (tage ? tage->predict(pc, hist) : (perceptron ? perceptron->predict(pc, hist) : cb[cb_index.index(pc, cb_bhr)]));
+   predictions = cb_predictions;
+
+   // Apply the add-ons (statistical corrector, loop predictor), if any.
+   addon->main = cb_predictions;
+   addon->sc = 0;
+   addon->loop = 0;
+   addon->loop_taken = 0;
+   addon->loop_used = 0;
+
+   if (!sc && !loop)
+      return (cb_predictions);
+
+   for (uint64_t i = 0; i < cond_branch_per_cycle; i++)
+   {
+      ctr = ((cb_predictions >> (i << 1)) & 3);
+      taken = (ctr >= 2);
+
+      // The statistical corrector may revert a low-confidence (weak counter) main prediction.
+      if (sc && sc->revert(pc, hist, i, taken, ((ctr == 1) || (ctr == 2))))
+      {
+         taken = !taken;
+         addon->sc |= (1ULL << i);
+      }
+
+      // A confident loop predictor overrides, if it has been more accurate than the main predictor (and corrector) when they disagreed.
+      if (loop && loop->predict(pc, i, loop_taken))
+      {
+         addon->loop |= (1ULL << i);
+         if (loop_taken)
+            addon->loop_taken |= (1ULL << i);
+         if (loop->useful())
+         {
+            taken = loop_taken;
+            addon->loop_used |= (1ULL << i);
+         }
+      }
+
+      // An overriding prediction replaces the 2-bit counter with a strong one.
+      if (((addon->sc | addon->loop_used) >> i) & 1)
+         predictions = ((predictions & ~(3ULL << (i << 1))) | ((uint64_t)(taken ? 3 : 0) << (i << 1)));
+   }
+   return (predictions);
+}
+
+uint64_t bpred_t::ib_predict(uint64_t pc, uint64_t ib_bhr, uint64_t hist)
+{
+   // Gshare or ITTAGE.  The target is only used if the fetch bundle ends at a jump indirect or call indirect.
+   return (ittage ? ittage->predict(pc, hist) : ib[ib_index.index(pc, ib_bhr)]);
+}
+
+void bpred_t::spec_update(spec_update_t *update, uint64_t cb_predictions)
+{
+   // Speculatively update the BHRs.
+   bool taken;
+   for (uint64_t i = 0; i < update->num_cb; i++)
+   {
+      // The low two bits of cb_predictions correspond to the next two-bit counter to examine (because we shift it right, subsequently).
+      // From this two-bit counter, set the taken flag, accordingly.
+      taken = ((cb_predictions & 3) >= 2);
+
+      // Shift out the used-up 2-bit counter, to set up the next conditional branch.
+      cb_predictions = (cb_predictions >> 2);
+
+      // Update the BHRs of the conditional branch predictor and indirect branch predictor.
+      cb_index.update_bhr(taken);
+      ib_index.update_bhr(taken);
+      ghist.update_bhr(taken);
+   }
+
+   // Speculatively update the RAS.
+   if (update->pop_ras)
+   {
+      assert(!update->push_ras);
+      ras.pop();
+   }
+   if (update->push_ras)
+   {
+      assert(!update->pop_ras);
+      ras.push(update->push_ras_pc);
+   }
+}
+
+void bpred_t::restore(uint64_t cb_bhr, uint64_t ib_bhr, uint64_t hist, uint64_t ras_tos)
+{
+   cb_index.set_bhr(cb_bhr);
+   ib_index.set_bhr(ib_bhr);
+   ghist.set_bhr(hist);
+   ras.set_tos(ras_tos);
+}
+
+void bpred_t::cb_push(bq_entry_t *e, const cb_addon_t &addon, uint64_t pos, bool taken)
+{
+   uint64_t ctr;
+
+   // Record this conditional branch's position within the conditional branch prediction bundle.
+   e->fetch_cb_pos_in_entry = pos;
+
+   // Record how the add-ons changed the prediction, and speculatively advance the loop predictor's iteration count.
+   ctr = ((addon.main >> (pos << 1)) & 3);
+   e->cb_main_taken = (ctr >= 2);
+   e->cb_main_weak = ((ctr == 1) || (ctr == 2));
+   e->cb_sc = ((addon.sc >> pos) & 1);
+   e->cb_loop = ((addon.loop >> pos) & 1);
+   e->cb_loop_taken = ((addon.loop_taken >> pos) & 1);
+   e->cb_loop_used = ((addon.loop_used >> pos) & 1);
+   if (loop)
+      loop->spec_update(e->fetch_pc, pos, taken, e->loop_entry, e->loop_iter);
+}
+
+void bpred_t::mispredict(bq_t &bq, uint64_t pred_tag, bool pred_tag_phase, bool taken, uint64_t next_pc)
+{
+   // 1. Roll-back the branch queue to the mispredicted branch's entry.
+   //    Then push the branch back onto it.
+
+   // First undo the loop predictor's speculative updates by the mispredicted branch and all younger branches, youngest first.
+   // The mispredicted branch's update is redone with its correct outcome, below.
+   if (loop)
+   {
+      uint64_t squash_pred_tag;
+      bool squash_pred_tag_phase;
+      bq.mark(squash_pred_tag, squash_pred_tag_phase);
+      do
+      {
+         bq.step_back(squash_pred_tag, squash_pred_tag_phase);
+         loop->spec_restore(bq.bq[squash_pred_tag].loop_entry, bq.bq[squash_pred_tag].loop_iter);
+      } while ((squash_pred_tag != pred_tag) || (squash_pred_tag_phase != pred_tag_phase));
+   }
+
+   bq.rollback(pred_tag, pred_tag_phase, true);
+
+   uint64_t temp_pred_tag;
+   bool temp_pred_tag_phase;
+   bq.push(temp_pred_tag, temp_pred_tag_phase); // Need to push the branch back onto the branch queue.
+   assert((temp_pred_tag == pred_tag) && (temp_pred_tag_phase == pred_tag_phase));
+
+   // 2. Correct the mispredicted branch's information in its branch queue entry.
+
+   bq_entry_t *e = &bq.bq[pred_tag];
+
+   assert(e->next_pc != next_pc);
+   e->next_pc = next_pc;
+
+   if (e->branch_type == BTB_BRANCH)
+      assert(e->taken != taken);
+
+   e->taken = taken;
+
+   // 3. Restore checkpointed global histories and the RAS (as best we can for RAS).
+
+   restore(e->precise_cb_bhr, e->precise_ib_bhr, e->precise_ghist, e->precise_ras_tos);
+
+   // If the resolved branch is a conditional branch, don't forget to include its corrected outcome
+   // in the BHRs that will kick off predictions after this resolved branch.
+   if (e->branch_type == BTB_BRANCH)
+   {
+      cb_index.update_bhr(taken);
+      ib_index.update_bhr(taken);
+      ghist.update_bhr(taken);
+
+      // Likewise, redo its speculative update of the loop predictor with its corrected outcome.
+      if (loop)
+         loop->spec_update(e->fetch_pc, e->fetch_cb_pos_in_entry, taken, e->loop_entry, e->loop_iter);
+   }
+
+   // 4. Note that the branch was mispredicted (for measuring mispredictions at retirement).
+
+   e->misp = true;
+}
+
+void bpred_t::flush(const bq_entry_t *e)
+{
+   restore(e->precise_cb_bhr, e->precise_ib_bhr, e->precise_ghist, e->precise_ras_tos);
+
+   // No branches are in flight: the loop predictor's speculative iteration counts are its retired ones.
+   if (loop)
+      loop->spec_reset();
+}
+
+void bpred_t::commit(const bq_entry_t *e)
+{
+   // Update the conditional branch predictor or indirect branch predictor.
+   // Update measurements.
+   uint64_t *cb_counters; // FYI: The compiler forbids declaring these four local variables inside "case BTB_BRANCH:".
+   uint64_t shamt;
+   uint64_t mask;
+   uint64_t ctr;
+   switch (e->branch_type)
+   {
+   case BTB_BRANCH:
+      if (tage)
+      {
+         // TAGE re-references itself using the same context that was used by the fetch bundle that this branch was a part of.
+         tage->update(e->fetch_pc, e->fetch_ghist, e->fetch_cb_pos_in_entry, e->taken);
+      }
+      else if (perceptron)
+      {
+         // Likewise, the perceptron re-references the weights of the branch's lane in the rows selected by the bundle's context.
+         perceptron->update(e->fetch_pc, e->fetch_ghist, e->fetch_cb_pos_in_entry, e->taken);
+      }
+      else
+      {
+         // Re-reference the conditional branch predictor, using the same context that was used by
+         // the fetch bundle that this branch was a part of.
+         // Using this original context, we re-reference the same "m" counters from the conditional branch predictor.
+         // "m" two-bit counters are packed into a uint64_t.
+         cb_counters = &(cb[cb_index.index(e->fetch_pc, e->fetch_cb_bhr)]);
+
+         // Prepare for reading and writing the 2-bit counter that was used to predict this branch.
+         // We need a shift-amount ("shamt") and a mask ("mask") that can be used to read/write just that counter.
+         // "shamt" = the branch's position in the entry times 2, for 2-bit counters.
+         // "mask" = (3 << shamt).
+         shamt = (e->fetch_cb_pos_in_entry << 1);
+         mask = (3ULL << shamt);
+
+         // Extract a local copy of the 2-bit counter that was used to predict this branch.
+         ctr = (((*cb_counters) & mask) >> shamt);
+
+         // Increment or decrement the local copy of the 2-bit counter, based on the branch's outcome.
+         if (e->taken)
+         {
+            if (ctr < 3)
+               ctr++;
+         }
+         else
+         {
+            if (ctr > 0)
+               ctr--;
+         }
+
+         // Write the modified local copy of the 2-bit counter back into the predictor's entry.
+         *cb_counters = (((*cb_counters) & (~mask)) | (ctr << shamt));
+      }
+
+      // Train the add-ons, with the same context.
+      if (sc)
+         sc->update(e->fetch_pc, e->fetch_ghist, e->fetch_cb_pos_in_entry, e->cb_main_taken, e->cb_main_weak, e->taken);
+      if (loop)
+         loop->update(e->fetch_pc, e->fetch_cb_pos_in_entry, e->taken, (e->cb_main_taken != e->cb_sc), e->cb_loop, e->cb_loop_taken);
+
+      // Update measurements.
+      meas_branch_n++;
+      if (e->misp)
+         meas_branch_m++;
+
+      // Which component provided the final prediction.
+      if (e->cb_loop_used)
+      {
+         meas_cb_loop_n++;
+         if (e->misp)
+            meas_cb_loop_m++;
+      }
+      else if (e->cb_sc)
+      {
+         meas_cb_sc_n++;
+         if (e->misp)
+            meas_cb_sc_m++;
+      }
+      else
+      {
+         meas_cb_main_n++;
+         if (e->misp)
+            meas_cb_main_m++;
+      }
+      break;
+
+   case BTB_JUMP_DIRECT:
+      // Update measurements.
+      meas_jumpdir_n++;
+      assert(!e->misp);
+      break;
+
+   case BTB_CALL_DIRECT:
+      // Update measurements.
+      meas_calldir_n++;
+      assert(!e->misp);
+      break;
+
+   case BTB_JUMP_INDIRECT:
+   case BTB_CALL_INDIRECT:
+      // Re-reference the indirect branch predictor, using the same context that was used by
+      // the fetch bundle that this branch was a part of.
+      if (ittage)
+         ittage->update(e->fetch_pc, e->fetch_ghist, e->next_pc, (e->branch_type == BTB_CALL_INDIRECT));
+      else
+         ib[ib_index.index(e->fetch_pc, e->fetch_ib_bhr)] = e->next_pc;
+
+      // Update measurements.
+      if (e->branch_type == BTB_JUMP_INDIRECT)
+      {
+         meas_jumpind_n++;
+         if (e->misp)
+            meas_jumpind_m++;
+
+         // Check for, and count, an unconditional jump to the next sequential pc (can happen for first case of a switch() statement).
+         if (!e->taken)
+            meas_jumpind_seq++;
+      }
+      else
+      {
+         meas_callind_n++;
+         if (e->misp)
+            meas_callind_m++;
+      }
+      break;
+
+   case BTB_RETURN:
+      // Update measurements.
+      meas_jumpret_n++;
+      if (e->misp)
+         meas_jumpret_m++;
+      break;
+
+   default:
+      assert(0);
+      break;
+   }
+}
+
+#define BP_OUTPUT(fp, str, n, m, i) \
+   fprintf((fp), "%s%10lu %10lu %5.2lf%% %5.2lf\n", (str), (n), (m), 100.0 * ((double)(m) / (double)(n)), 1000.0 * ((double)(m) / (double)(i)))
+
+void bpred_t::output(uint64_t num_instr, FILE *fp)
+{
+   uint64_t all = (meas_branch_n + meas_jumpdir_n + meas_calldir_n + meas_jumpind_n + meas_callind_n + meas_jumpret_n);
+   uint64_t all_misp = (meas_branch_m + meas_jumpind_m + meas_callind_m + meas_jumpret_m);
+   fprintf(fp, "BRANCH PREDICTION MEASUREMENTS---------------------\n");
+   fprintf(fp, "Type                      n          m     mr  mpki\n");
+   BP_OUTPUT(fp, "All              ", all, all_misp, num_instr);
+   BP_OUTPUT(fp, "Branch           ", meas_branch_n, meas_branch_m, num_instr);
+   BP_OUTPUT(fp, "Jump Direct      ", meas_jumpdir_n, (uint64_t)0, num_instr);
+   BP_OUTPUT(fp, "Call Direct      ", meas_calldir_n, (uint64_t)0, num_instr);
+   BP_OUTPUT(fp, "Jump Indirect    ", meas_jumpind_n, meas_jumpind_m, num_instr);
+   BP_OUTPUT(fp, "Call Indirect    ", meas_callind_n, meas_callind_m, num_instr);
+   BP_OUTPUT(fp, "Return           ", meas_jumpret_n, meas_jumpret_m, num_instr);
+   fprintf(fp, "(Number of Jump Indirects whose target was the next sequential PC = %lu)\n", meas_jumpind_seq);
+}
+
+void bpred_t::output_components(uint64_t num_instr, FILE *fp)
+{
+   if (sc || loop)
+   {
+      fprintf(fp, "CONDITIONAL BRANCH PREDICTOR COMPONENTS------------\n");
+      fprintf(fp, "Final prediction from     n          m     mr  mpki\n");
+      BP_OUTPUT(fp, "Main predictor   ", meas_cb_main_n, meas_cb_main_m, num_instr);
+      BP_OUTPUT(fp, "Stat. corrector  ", meas_cb_sc_n, meas_cb_sc_m, num_instr);
+      BP_OUTPUT(fp, "Loop predictor   ", meas_cb_loop_n, meas_cb_loop_m, num_instr);
+      if (sc)
+         sc->output(fp);
+      if (loop)
+         loop->output(fp);
+   }
+   if (tage)
+      tage->output(fp);
+   if (perceptron)
+      perceptron->output(fp);
+   if (ittage)
+      ittage->output(fp);
+}
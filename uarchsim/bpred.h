@@ -0,0 +1,126 @@
+#include "fetchunit_types.h"
+#include "bq.h"
+#include "gshare.h"
+#include "ghist.h"
+#include "tage.h"
+#include "ittage.h"
+#include "perceptron.h"
+#include "looppred.h"
+#include "statcorr.h"
+#include "ras.h"
+
+// The Fetch Unit's branch prediction model: the conditional branch predictor (gshare, TAGE or hashed perceptron) and its add-ons,
+// the indirect branch predictor (gshare or ITTAGE), the RAS, and the speculative update, repair, and training of all of them.
+//
+// It is shared by fetchunit_t and the trace-driven evaluator (bpeval), so that both predict, repair, and train the predictors the same way.
+// Its user owns the pc, the BTB, and the branch queue; this class fills in and reads the predictor fields of the branch queue entries.
+class bpred_t
+{
+public:
+    // Number of conditional branch predictions per fetch bundle ("m").
+    uint64_t cond_branch_per_cycle;
+
+    // Gshare predictor for conditional branches.
+    uint64_t *cb;
+    gshare_index_t cb_index;
+
+    // Long global history, checkpointed and restored alongside the gshare BHRs.
+    ghist_t ghist;
+
+    // TAGE predictor for conditional branches: replaces the gshare predictor if enabled (NULL: gshare).
+    tage_t *tage;
+
+    // Hashed perceptron predictor for conditional branches: replaces the gshare predictor if enabled (NULL: gshare or TAGE).
+    perceptron_t *perceptron;
+
+    // Optional add-ons to the conditional branch predictor, gshare, TAGE or perceptron (NULL: not used).
+    // The statistical corrector may revert low-confidence predictions, and then the loop predictor may override predictions.
+    stat_corrector_t *sc;
+    loop_predictor_t *loop;
+
+    // Gshare predictor for indirect branches.
+    uint64_t *ib;
+    gshare_index_t ib_index;
+
+    // ITTAGE predictor for indirect branches: replaces the gshare predictor if enabled (NULL: gshare).  It uses the long global history, too.
+    ittage_t *ittage;
+
+    // Return address stack for predicting return targets.
+    ras_t ras;
+
+    // Measurements, at retirement.
+    uint64_t meas_branch_n;  // # branches
+    uint64_t meas_jumpdir_n; // # jumps, direct
+    uint64_t meas_calldir_n; // # calls, direct
+    uint64_t meas_jumpind_n; // # jumps, indirect
+    uint64_t meas_callind_n; // # calls, indirect
+    uint64_t meas_jumpret_n; // # jumps, return
+
+    uint64_t meas_branch_m;  // # mispredicted branches
+
+    uint64_t meas_cb_main_n; // # branches whose final prediction came from the main predictor (gshare, TAGE or perceptron),
+    uint64_t meas_cb_main_m; //   # ... mispredicted
+    uint64_t meas_cb_sc_n;   // # ... from the statistical corrector (reverted main prediction),
+    uint64_t meas_cb_sc_m;
+    uint64_t meas_cb_loop_n; // # ... from the loop predictor.
+    uint64_t meas_cb_loop_m;
+    uint64_t meas_jumpind_m; // # mispredicted jumps, indirect
+    uint64_t meas_callind_m; // # mispredicted calls, indirect
+    uint64_t meas_jumpret_m; // # mispredicted jumps, return
+
+    uint64_t meas_jumpind_seq; // # jump-indirect instructions whose targets were the next sequential PC
+
+    bpred_t(uint64_t cond_branch_per_cycle,                // "m"
+            uint64_t cb_pc_length, uint64_t cb_bhr_length, // gshare cond. br. predictor: pc length (index size), bhr length
+            uint64_t ib_pc_length, uint64_t ib_bhr_length, // gshare indirect br. predictor: pc length (index size), bhr length
+            uint64_t tage_kb,                              // TAGE cond. br. predictor: budget in KB (0: use the gshare predictor instead)
+            uint64_t tage_tables,                          // TAGE: number of tagged tables
+            uint64_t tage_min_hist, uint64_t tage_max_hist, // TAGE: shortest and longest history lengths
+            uint64_t perceptron_kb,                        // hashed perceptron cond. br. predictor: budget in KB (0: gshare or TAGE)
+            uint64_t perceptron_tables,                    // hashed perceptron: number of weight tables (including the bias table)
+            uint64_t perceptron_max_hist,                  // hashed perceptron: history length
+            uint64_t loop_entries,                         // loop predictor add-on: number of entries (0: none)
+            uint64_t sc_entries,                           // statistical corrector add-on: entries per table (0: none)
+            uint64_t ittage_kb,                            // ITTAGE indirect br. predictor: budget in KB (0: use the gshare predictor instead)
+            uint64_t ittage_tables,                        // ITTAGE: number of tagged tables
+            uint64_t ittage_min_hist, uint64_t ittage_max_hist, // ITTAGE: shortest and longest history lengths
+            uint64_t ras_size,                             // # entries in the RAS
+            uint64_t max_outcomes);                        // max. number of conditional branch outcomes in flight (long global history size)
+    ~bpred_t();
+
+    // Predict the fetch bundle {pc, BHRs}: the conditional branch predictor's "m" predictions, packed into a uint64_t, after the add-ons
+    // (statistical corrector, loop predictor).  How the add-ons changed them is recorded in "addon".
+    uint64_t cb_predict(uint64_t pc, uint64_t cb_bhr, uint64_t hist, cb_addon_t *addon);
+
+    // The indirect branch predictor's predicted target for the fetch bundle {pc, BHRs}.
+    uint64_t ib_predict(uint64_t pc, uint64_t ib_bhr, uint64_t hist);
+
+    // Speculatively update the BHRs and RAS, based on the assembled fetch bundle.  The caller updates its pc.
+    void spec_update(spec_update_t *update, uint64_t cb_predictions);
+
+    // Restore the BHRs and RAS, e.g., to just prior to a misfetched fetch bundle.
+    void restore(uint64_t cb_bhr, uint64_t ib_bhr, uint64_t hist, uint64_t ras_tos);
+
+    // A conditional branch at position "pos" of its conditional branch prediction bundle, predicted "taken", was pushed onto the branch queue
+    // as entry "e" (its fetch_pc is set): record how the add-ons changed its prediction, and speculatively advance the loop predictor's iteration count.
+    void cb_push(bq_entry_t *e, const cb_addon_t &addon, uint64_t pos, bool taken);
+
+    // A mispredicted branch was detected.
+    // 1. Roll-back the branch queue to the mispredicted branch's entry, undoing the loop predictor's speculative updates.
+    // 2. Correct the mispredicted branch's information in its branch queue entry.
+    // 3. Restore checkpointed global histories and the RAS (as best we can for RAS), including the branch's corrected outcome.
+    // 4. Note that the branch was mispredicted (for measuring mispredictions at retirement).
+    // The caller restores its pc.
+    void mispredict(bq_t &bq, uint64_t pred_tag, bool pred_tag_phase, bool taken, uint64_t next_pc);
+
+    // Complete squash: restore the BHRs and RAS to the precise state at branch queue entry "e" (the head), and reset the loop predictor's
+    // speculative iteration counts (no branches are in flight).
+    void flush(const bq_entry_t *e);
+
+    // Train the predictors with the retired branch "e", popped from the branch queue, and update measurements.
+    void commit(const bq_entry_t *e);
+
+    // Output the branch prediction measurements, and the predictor components' measurements.
+    void output(uint64_t num_instr, FILE *fp);
+    void output_components(uint64_t num_instr, FILE *fp);
+};
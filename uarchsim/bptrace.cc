@@ -0,0 +1,169 @@
+#include <cinttypes>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <gzstream.h>
+
+#include "processor.h"
+#include "decode.h"
+#include "config.h"
+
+#include "fetchunit_types.h"
+#include "btb.h"
+#include "bptrace.h"
+
+
+// The pc of the first retired instruction is recorded as a redirect.
+bptrace_writer_t::bptrace_writer_t(const char *file) {
+   out.open(file);
+   if (!out.good()) {
+      fprintf(stderr, "Could not open the branch trace file %s.\n", file);
+      exit(-1);
+   }
+   next_pc = 0;
+   skip = 0;
+
+   meas_instr = 0;
+   meas_branch = 0;
+   meas_redirect = 0;
+}
+
+bptrace_writer_t::~bptrace_writer_t() {
+   out.close();
+   fprintf(stderr, "Branch trace: %" PRIu64 " instructions, %" PRIu64 " branches, %" PRIu64 " redirects\n", meas_instr, meas_branch, meas_redirect);
+}
+
+void bptrace_writer_t::put_varint(uint64_t x) {
+   while (x >= 0x80) {
+      out.put((char)((x & 0x7f) | 0x80));
+      x = (x >> 7);
+   }
+   out.put((char)x);
+}
+
+void bptrace_writer_t::retire(uint64_t pc, insn_t insn, uint64_t next_pc) {
+   btb_branch_type_e branch_type;
+   uint64_t target;
+   bool taken;
+   uint64_t bits;
+
+   meas_instr++;
+
+   // This instruction does not follow the previous one (the previous one trapped, or returned from a trap).
+   if (pc != this->next_pc) {
+      out.put((char)BPTRACE_REDIRECT);
+      put_varint(skip);
+      put_varint(pc);
+      skip = 0;
+      meas_redirect++;
+   }
+
+   switch (insn.opcode()) {
+      case OP_JAL:
+      case OP_JALR:
+      case OP_BRANCH:
+         break;
+
+      default:
+         // A non-branch is implied by the next record.  If it does not fall through (e.g., a trap return), the next record is a redirect.
+         skip++;
+         this->next_pc = INCREMENT_PC(pc);
+         return;
+   }
+
+   branch_type = btb_t::decode(insn, pc, target);
+   taken = (next_pc != INCREMENT_PC(pc));
+
+   out.put((char)(branch_type | (taken ? BPTRACE_TAKEN : 0)));
+   put_varint(skip);
+   bits = insn.bits();
+   for (unsigned int i = 0; i < 4; i++)
+      out.put((char)(bits >> (i << 3)));
+   if ((branch_type == BTB_JUMP_INDIRECT) || (branch_type == BTB_CALL_INDIRECT) || (branch_type == BTB_RETURN)) {
+      for (unsigned int i = 0; i < 8; i++)
+         out.put((char)(next_pc >> (i << 3)));
+   }
+
+   skip = 0;
+   this->next_pc = next_pc;
+   meas_branch++;
+}
+
+
+bptrace_reader_t::bptrace_reader_t(const char *file) {
+   in.open(file);
+   if (!in.good()) {
+      fprintf(stderr, "Could not open the branch trace file %s.\n", file);
+      exit(-1);
+   }
+   next_pc = 0;
+   num_instr = 0;
+}
+
+bptrace_reader_t::~bptrace_reader_t() {
+   in.close();
+}
+
+bool bptrace_reader_t::get_varint(uint64_t &x) {
+   int c;
+   unsigned int shamt = 0;
+
+   x = 0;
+   do {
+      if ((c = in.get()) == EOF)
+         return(false);
+      x |= ((uint64_t)(c & 0x7f) << shamt);
+      shamt += 7;
+   } while (c & 0x80);
+   return(true);
+}
+
+bool bptrace_reader_t::next(bptrace_rec_t &rec) {
+   int flags;
+   int c;
+   uint64_t skip;
+   uint64_t bits;
+
+   if (((flags = in.get()) == EOF) || !get_varint(skip))
+      return(false);
+   num_instr += skip;
+
+   if (flags & BPTRACE_REDIRECT) {
+      rec.redirect = true;
+      rec.pc = (next_pc + (skip << 2));
+      if (!get_varint(rec.next_pc))
+         return(false);
+      next_pc = rec.next_pc;
+      return(true);
+   }
+
+   rec.redirect = false;
+   rec.pc = (next_pc + (skip << 2));
+
+   bits = 0;
+   for (unsigned int i = 0; i < 4; i++) {
+      if ((c = in.get()) == EOF)
+         return(false);
+      bits |= ((uint64_t)(c & 0xff) << (i << 3));
+   }
+   rec.insn = insn_t(bits);
+   rec.branch_type = btb_t::decode(rec.insn, rec.pc, rec.branch_target);
+   assert(rec.branch_type == (btb_branch_type_e)(flags & BPTRACE_TYPE));
+   rec.taken = (flags & BPTRACE_TAKEN);
+
+   if ((rec.branch_type == BTB_JUMP_INDIRECT) || (rec.branch_type == BTB_CALL_INDIRECT) || (rec.branch_type == BTB_RETURN)) {
+      rec.next_pc = 0;
+      for (unsigned int i = 0; i < 8; i++) {
+         if ((c = in.get()) == EOF)
+            return(false);
+         rec.next_pc |= ((uint64_t)(c & 0xff) << (i << 3));
+      }
+   }
+   else {
+      rec.next_pc = (rec.taken ? rec.branch_target : INCREMENT_PC(rec.pc));
+   }
+
+   num_instr++;
+   next_pc = rec.next_pc;
+   return(true);
+}
@@ -0,0 +1,67 @@
+
+// Branch trace: the retired instruction stream of a program, reduced to its branches, for evaluating the Fetch Unit's branch
+// predictors without the pipeline (see bpeval/bpeval.cc).  It is written while fast-skipping (sim_t::run_fast(), --bptrace).
+//
+// The trace is a gzip-compressed stream of records, one per retired branch, plus one per redirect: a retired instruction that does
+// not follow its predecessor (trap, trap return).  The non-branch instructions between branches are implied, so a record is
+// usually 6 bytes before compression:
+// - flags (1 byte): bits 0-2: btb_branch_type_e, bit 3: taken, bit 7: redirect record.
+// - Branch record: the number of non-branch instructions before the branch (varint), the branch instruction (4 bytes), and,
+//   for indirect branches and returns only, the target (8 bytes).  The direct branches' targets are decoded from the instruction.
+// - Redirect record: the number of non-branch instructions before the redirect (varint), and the pc of the next instruction (varint).
+#define BPTRACE_TYPE		0x07
+#define BPTRACE_TAKEN		0x08
+#define BPTRACE_REDIRECT	0x80
+
+// A record, as read back.
+typedef
+struct {
+   bool redirect;                  // Redirect record: only pc and next_pc are valid.
+   uint64_t pc;                    // PC of the branch.  Redirect: pc at which the instruction stream stops being sequential.
+   insn_t insn;                    // The branch instruction.
+   btb_branch_type_e branch_type;  // Its type.
+   uint64_t branch_target;         // Its taken target (not valid for indirect branches).
+   bool taken;                     // Its direction (taken: next_pc is not the next sequential pc).
+   uint64_t next_pc;               // PC of the next retired instruction.
+} bptrace_rec_t;
+
+
+class bptrace_writer_t {
+private:
+	ogzstream out;
+	uint64_t next_pc;	// PC of the next instruction, if it follows the previous one.
+	uint64_t skip;		// Number of non-branch instructions since the previous record.
+
+	// Measurements.
+	uint64_t meas_instr;
+	uint64_t meas_branch;
+	uint64_t meas_redirect;
+
+	void put_varint(uint64_t x);
+
+public:
+	bptrace_writer_t(const char *file);
+	~bptrace_writer_t();
+
+	// An instruction retired: its pc, the instruction, and the pc of the next instruction.
+	void retire(uint64_t pc, insn_t insn, uint64_t next_pc);
+};
+
+
+class bptrace_reader_t {
+private:
+	igzstream in;
+	uint64_t next_pc;	// PC of the next instruction, if it follows the previous one.
+
+	bool get_varint(uint64_t &x);
+
+public:
+	bptrace_reader_t(const char *file);
+	~bptrace_reader_t();
+
+	// Number of instructions retired up to and including the last record read.
+	uint64_t num_instr;
+
+	// Read the next record.  Returns false at the end of the trace.
+	bool next(bptrace_rec_t &rec);
+};
@@ -99,6 +99,15 @@ void bq_t::mark(uint64_t &pred_tag, bool &pred_tag_phase) {
    pred_tag_phase = tail_phase;
 }
 
+void bq_t::step_back(uint64_t &pred_tag, bool &pred_tag_phase) {
+   // Step the given index back by one entry (toward the head), e.g., to walk from the tail (see mark()) to an older entry.
+   if (pred_tag == 0) {
+      pred_tag = size;
+      pred_tag_phase = !pred_tag_phase;
+   }
+   pred_tag--;
+}
+
 uint64_t bq_t::flush() {
    // Make the branch queue empty by setting the tail to the head.
    tail = head;
@@ -1,19 +1,24 @@
 
 class bq_entry_t {
 public:
-	// The type of branch.
+	// The type of branch, its pc, and its taken target (not valid for indirect branches).
+	// The pc and taken target are needed by the trace cache's fill unit, at retirement.
 	btb_branch_type_e branch_type;
+	uint64_t pc;
+	uint64_t branch_target;
 
 	// Precise information at this point in the instruction stream.
 	uint64_t precise_cb_bhr;  // Precise BHR (all prior branches included) to which we can restore the BHR of the conditional branch predictor (cb).
 	uint64_t precise_ib_bhr;  // Precise BHR (all prior branches included) to which we can restore the BHR of the indirect branch predictor (ib).
 	uint64_t precise_ras_tos; // Precise TOS index at this point in the instruction stream.
+	uint64_t precise_ghist;   // Precise position of the long global history (ghist) used by TAGE.
 
 	// Information that was used to get the prediction.
 	// A critical rule in branch prediction, is to always train the predictor entry from where the prediction was gotten (whether prediction was correct or not).
 	uint64_t fetch_pc;		// PC that was used for indexing the conditional and indirect branch predictors for this prediction.
 	uint64_t fetch_cb_bhr;		// BHR that was used for indexing the conditional branch predictor for this prediction.
 	uint64_t fetch_ib_bhr;		// BHR that was used for indexing the indirect branch predictor for this prediction.
+	uint64_t fetch_ghist;		// Position of the long global history that was used by TAGE for this prediction.
 	uint64_t fetch_cb_pos_in_entry; // In general, the conditional branch predictor can supply a bundle of m branch predictions from a single entry.
 					// This variable is the position of this prediction within the entry.
 
@@ -21,8 +26,23 @@ public:
 	bool taken;		// For conditional branches.
 	uint64_t next_pc;
 
+	// Add-ons to the conditional branch predictor (see looppred.h and statcorr.h): how they changed the prediction, for training
+	// them and measuring which component provided the final prediction.  And the loop predictor entry speculatively updated by this
+	// branch (-1: none) with its previous speculative iteration count, for repairing the loop predictor on a misprediction.
+	bool cb_main_taken;	// The main predictor's prediction, before the add-ons.
+	bool cb_main_weak;	// The main predictor's 2-bit counter was weak.
+	bool cb_sc;		// The statistical corrector reverted the main prediction.
+	bool cb_loop;		// The loop predictor was confident,
+	bool cb_loop_taken;	// predicted taken,
+	bool cb_loop_used;	// and provided the final prediction.
+	int64_t loop_entry;
+	uint64_t loop_iter;
+
 	// This flag indicates whether or not the branch was mispredicted.  It is needed for measuring mispredictions at retirement.
 	bool misp;
+
+	// The branch is low-confidence and unresolved (see fetchunit_t::fetch1(), fetch gating).
+	bool low_conf;
 };
 
 
@@ -45,6 +65,7 @@ public:
 	void pop(uint64_t &pred_tag, bool &pred_tag_phase);
 	void rollback(uint64_t pred_tag, bool pred_tag_phase, bool do_checks);
 	void mark(uint64_t &pred_tag, bool &pred_tag_phase);
+	void step_back(uint64_t &pred_tag, bool &pred_tag_phase);
 	uint64_t flush();
 };
 
@@ -10,7 +10,7 @@
 #include "btb.h"
 
 
-btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle) {
+btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle, uint64_t l2_entries, uint64_t l2_assoc) {
    this->banks = banks;
    this->sets = (num_entries/(banks*assoc));
    this->assoc = assoc;
@@ -21,19 +21,22 @@ btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond
 
    log2banks = (uint64_t) log2((double)banks);
    log2sets = (uint64_t) log2((double)sets);
+   bank_mask = (banks - 1);
+   set_mask = (sets - 1);
 
-   // Allocate the 3D array.
-   btb = new btb_entry_t **[banks];
+   // Allocate the 3D array, flattened.
+   btb = new btb_entry_t[banks * sets * assoc];
    for (uint64_t b = 0; b < banks; b++) {
-      btb[b] = new btb_entry_t *[sets];
       for (uint64_t s = 0; s < sets; s++) {
-         btb[b][s] = new btb_entry_t[assoc];
 	 for (uint64_t way = 0; way < assoc; way++) {
-	    btb[b][s][way].valid = false;
-	    btb[b][s][way].lru = way;
+	    entry(b, s, way)->valid = false;
+	    entry(b, s, way)->lru = way;
 	 }
       }
    }
+
+   // Allocate the second-level BTB, if any.
+   l2 = (l2_entries ? new btb_t(l2_entries, banks, l2_assoc, cond_branch_per_cycle) : NULL);
 }
 
 
@@ -47,6 +50,8 @@ btb_t::~btb_t() {
 // cb_predictions: A uint64_t packed with "m" 2-bit counters for predicting conditional branches.
 // ib_predicted_target: Predicted target for a jump indirect or call indirect, if the fetch bundle ends with this type of branch instruction.
 // ras_predicted_target: Predicted target for a return, if the fetch bundle ends with this type of branch instruction.
+// touch: If false, the lookup does not update the LRU state or move L2 BTB hits into this BTB (used by the run-ahead predictor of the
+//        fetch target queue, which predicts bundles that the Fetch1 stage looks up again later).
 //
 // this->banks: "n", the number of BTB banks, which the Fetch Unit had set equal to the maximum-length sequential fetch bundle.
 // this->cond_branch_per_cycle: "m", the maximum number of conditional branches allowed in a fetch bundle.
@@ -61,11 +66,16 @@ btb_t::~btb_t() {
 //    - How many conditional branches are in the assembled fetch bundle, to know how many predictions to shift into its BHRs.
 //    - Whether or not it needs to pop the RAS.
 //    - Whether or not it needs to push the RAS, and, if so, which pc to push onto the RAS.
-void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update) {
+//
+// Return value: The number of branches in the bundle that missed in this BTB and hit in the L2 BTB.  If non-zero, the Fetch Unit
+// models the L2 BTB's extra latency.
+uint64_t btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update, bool touch) {
    uint64_t btb_bank;
    uint64_t btb_pc;
    uint64_t set;
    uint64_t way;
+   btb_entry_t *e;
+   uint64_t l2_hits = 0;
    bool taken;
    uint64_t num_cond_branch = 0;
    bool terminated = false;
@@ -87,14 +97,29 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
       convert(pc, pos, btb_bank, btb_pc);
 
       // Search for the instruction in its bank.
+      e = NULL;
       if (search(btb_bank, btb_pc, set, way)) {
          // BTB hit.  The BTB coordinates of this branch are {btb_bank, set, way}.
-         bundle[pos].branch = true;
-         bundle[pos].branch_type = btb[btb_bank][set][way].branch_type;
-         bundle[pos].branch_target = btb[btb_bank][set][way].target;
+         e = entry(btb_bank, set, way);
 
          // Update LRU.
-	 update_lru(btb_bank, set, way);
+	 if (touch)
+	    update_lru(btb_bank, set, way);
+      }
+      else if (l2 && l2->search(btb_bank, btb_pc, set, way)) {
+         // L2 BTB hit.  Move the branch into this BTB.
+         e = l2->entry(btb_bank, set, way);
+	 if (touch) {
+	    l2->update_lru(btb_bank, set, way);
+	    write(btb_bank, btb_pc, e->branch_type, e->target);
+	 }
+	 l2_hits++;
+      }
+
+      if (e) {
+         bundle[pos].branch = true;
+         bundle[pos].branch_type = e->branch_type;
+         bundle[pos].branch_target = e->target;
 
 	 // (1) Determine the instruction's next_pc field (i.e., pc of the next instruction, which may be in the same bundle or at the start of the next bundle).
 	 // (2) Determine if this is the last instruction in the bundle.
@@ -113,7 +138,7 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 	       cb_predictions = (cb_predictions >> 2);
 
 	       // (1) Determine the instruction's next_pc field.
-	       bundle[pos].next_pc = (taken ?  btb[btb_bank][set][way].target : INCREMENT_PC(bundle[pos].pc));
+	       bundle[pos].next_pc = (taken ?  e->target : INCREMENT_PC(bundle[pos].pc));
 
 	       // (2) Determine if this is the last instruction in the bundle.
 	       //     End the fetch bundle at any taken branch or at the maximum number of conditional branches.
@@ -124,7 +149,7 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 
 	    case BTB_JUMP_DIRECT:
 	       // (1) Determine the instruction's next_pc field.
-	       bundle[pos].next_pc = btb[btb_bank][set][way].target;
+	       bundle[pos].next_pc = e->target;
 
 	       // (2) Determine if this is the last instruction in the bundle.
 	       //     End the fetch bundle at any taken branch or at the maximum number of conditional branches.
@@ -133,7 +158,7 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 
 	    case BTB_CALL_DIRECT:
 	       // (1) Determine the instruction's next_pc field.
-	       bundle[pos].next_pc = btb[btb_bank][set][way].target;
+	       bundle[pos].next_pc = e->target;
 
 	       // (2) Determine if this is the last instruction in the bundle.
 	       //     End the fetch bundle at any taken branch or at the maximum number of conditional branches.
@@ -212,6 +237,8 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
       bundle[pos].valid = false;
       pos++;
    }
+
+   return(l2_hits);
 }
 
 
@@ -228,6 +255,7 @@ void btb_t::update(uint64_t pc, uint64_t pos, insn_t insn) {
    uint64_t way;
    uint64_t new_target;
    btb_branch_type_e new_branch_type;
+   btb_entry_t *e;
 
    // decode the branch for it's type and taken target information
    new_branch_type = btb_t::decode(insn, (pc + (pos << 2)), new_target);
@@ -239,42 +267,31 @@ void btb_t::update(uint64_t pc, uint64_t pos, insn_t insn) {
    // If it hits, assert that the reason for updating the entry is that the branch type changed or non-indirect branch's target changed
    // (self-modifying code or BTB was trained with data on the wrong-path beyond the text segment).
    bool btb_hit = search(btb_bank, btb_pc, set, way);
+   e = entry(btb_bank, set, way);
    if (btb_hit)
-     assert((btb[btb_bank][set][way].branch_type != new_branch_type) ||
-            ((insn.opcode() != OP_JALR) && (btb[btb_bank][set][way].target != new_target)));
+     assert((e->branch_type != new_branch_type) ||
+            ((insn.opcode() != OP_JALR) && (e->target != new_target)));
 
-   // The entry's metadata:
-   btb[btb_bank][set][way].valid = true;
-   btb[btb_bank][set][way].tag = (btb_pc >> log2sets);
-   update_lru(btb_bank, set, way); // Update LRU.
+   write(btb_bank, btb_pc, new_branch_type, new_target);
 
-   // The entry's payload:
-   btb[btb_bank][set][way].branch_type = new_branch_type;
-   btb[btb_bank][set][way].target = new_target;
+   // Train the L2 BTB, too.
+   if (l2)
+      l2->write(btb_bank, btb_pc, new_branch_type, new_target);
 }
 
 void btb_t::invalidate(uint64_t pc, uint64_t pos) {
    uint64_t btb_bank;
    uint64_t btb_pc;
-   uint64_t set;
-   uint64_t way;
    
    convert(pc, pos, btb_bank, btb_pc);   // convert {pc, pos} to {btb_bank, btb_pc}
    
-   // Search for the instruction in its bank.
-   // The BTB entry to invalidate is at coordinates {btb_bank, set, way}.
    // The pipeline should not invalidate an entry that doesn't exist.
-   bool btb_hit = search(btb_bank, btb_pc, set, way);
+   bool btb_hit = remove(btb_bank, btb_pc);
    assert(btb_hit);
-   
-   // Invalidate the entry and make it the LRU way of the set.
-   btb[btb_bank][set][way].valid = false;
-   
-   for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][set][i].lru > btb[btb_bank][set][way].lru)
-         btb[btb_bank][set][i].lru--;
-   }
-   btb[btb_bank][set][way].lru = assoc - 1;
+
+   // The L2 BTB may or may not still have the branch.
+   if (l2)
+      l2->remove(btb_bank, btb_pc);
 }
 
 ////////////////////////////////////
@@ -294,7 +311,7 @@ void btb_t::convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb
    //      If 0, instr. is at (pc>>2)+0; if 1, instr. is at (pc>>2)+1; if 2, instr. is at (pc>>2)+2; etc.          "(pc >> 2) + pos"
    // banks: We asserted that this must be a power-of-2.
    //        Thus, BTB bank selection can be done by taking the instr. pc, "(pc >> 2) + pos", and masking it with "(banks - 1)".
-   btb_bank = (((pc >> 2) + pos) & (banks - 1));
+   btb_bank = (((pc >> 2) + pos) & bank_mask);
 
    // Discard the low two bits and the bank selection bits that follow it, from the instruction's PC.
    // The bank selection bits are implied by which bank is referenced.
@@ -306,20 +323,21 @@ void btb_t::convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb
 // It outputs the "set" and "way" of either (a) the branch's entry (hit) or (b) the LRU entry (which can be used by the caller for replacement).
 bool btb_t::search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &way) {
    // Break up btb_pc into index and tag.
-   uint64_t index = (btb_pc & (sets - 1));
+   uint64_t index = (btb_pc & set_mask);
    uint64_t tag = (btb_pc >> log2sets);
+   btb_entry_t *s = entry(btb_bank, index, 0);
 
    // Search the indexed set.
    bool hit = false;
    uint64_t hit_way = assoc; // out-of-bounds
    uint64_t lru_way = assoc; // out-of-bounds
    for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][index][i].valid && (btb[btb_bank][index][i].tag == tag)) {
+      if (s[i].valid && (s[i].tag == tag)) {
          hit = true;
 	 hit_way = i;
 	 break;
       }
-      else if (btb[btb_bank][index][i].lru == (assoc - 1)) {
+      else if (s[i].lru == (assoc - 1)) {
          lru_way = i;
       }
    }
@@ -333,12 +351,54 @@ bool btb_t::search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &
 
 
 void btb_t::update_lru(uint64_t btb_bank, uint64_t set, uint64_t way) {
+   btb_entry_t *s = entry(btb_bank, set, 0);
+
    // Make "way" most-recently-used.
    for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][set][i].lru < btb[btb_bank][set][way].lru)
-         btb[btb_bank][set][i].lru++;
+      if (s[i].lru < s[way].lru)
+         s[i].lru++;
+   }
+   s[way].lru = 0;
+}
+
+
+// Write the branch "btb_pc" into bank "btb_bank": its entry if it hits, or else the LRU entry of its set.
+void btb_t::write(uint64_t btb_bank, uint64_t btb_pc, btb_branch_type_e branch_type, uint64_t target) {
+   uint64_t set;
+   uint64_t way;
+   btb_entry_t *e;
+
+   search(btb_bank, btb_pc, set, way);
+   e = entry(btb_bank, set, way);
+
+   // The entry's metadata:
+   e->valid = true;
+   e->tag = (btb_pc >> log2sets);
+   update_lru(btb_bank, set, way); // Update LRU.
+
+   // The entry's payload:
+   e->branch_type = branch_type;
+   e->target = target;
+}
+
+
+// Invalidate the branch "btb_pc" in bank "btb_bank" and make its entry the LRU way of the set.  Returns false if it isn't in the BTB.
+bool btb_t::remove(uint64_t btb_bank, uint64_t btb_pc) {
+   uint64_t set;
+   uint64_t way;
+   btb_entry_t *s;
+
+   if (!search(btb_bank, btb_pc, set, way))
+      return(false);
+
+   s = entry(btb_bank, set, 0);
+   s[way].valid = false;
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (s[i].lru > s[way].lru)
+         s[i].lru--;
    }
-   btb[btb_bank][set][way].lru = 0;
+   s[way].lru = assoc - 1;
+   return(true);
 }
 
 
@@ -17,14 +17,21 @@ struct {
 class btb_t {
 private:
 	// The BTB has three dimensions: number of banks, number of sets per bank, and associativity (number of ways per set).
-	// btb[bank][set][way]
-	btb_entry_t ***btb;
+	// They are flattened into one contiguous array: the ways of set "set" of bank "bank" start at btb[((bank << log2sets) | set) * assoc].
+	btb_entry_t *btb;
 	uint64_t banks;
 	uint64_t sets;
 	uint64_t assoc;
 
 	uint64_t log2banks; // number of pc bits that selects the bank
 	uint64_t log2sets;  // number of pc bits that selects the set within a bank
+	uint64_t bank_mask; // banks - 1
+	uint64_t set_mask;  // sets - 1
+
+	// Optional second-level BTB (NULL: none).  It has the same banks as this one, but more sets and/or ways.
+	// It is searched for the slots that miss in this BTB: a hit supplies the branch (after extra latency, which the Fetch Unit models)
+	// and moves it into this BTB.  Both levels are trained, and invalidated, together.
+	btb_t *l2;
 
 	uint64_t cond_branch_per_cycle; // "m": maximum number of conditional branches in a fetch bundle.
 
@@ -36,12 +43,18 @@ private:
 	void convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb_pc);
 	bool search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &way);
 	void update_lru(uint64_t btb_bank, uint64_t set, uint64_t way);
-	
+	void write(uint64_t btb_bank, uint64_t btb_pc, btb_branch_type_e branch_type, uint64_t target);
+	bool remove(uint64_t btb_bank, uint64_t btb_pc);
+
+	inline btb_entry_t *entry(uint64_t btb_bank, uint64_t set, uint64_t way) {
+	   return(&btb[(((btb_bank << log2sets) | set) * assoc) + way]);
+	}
 
 public:
-	btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle);
+	btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle,
+	      uint64_t l2_entries = 0, uint64_t l2_assoc = 0);
 	~btb_t();
-        void lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
+        uint64_t lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update, bool touch = true);
 	void update(uint64_t pc, uint64_t pos, insn_t insn);
 	void invalidate(uint64_t pc, uint64_t pos);
 	static btb_branch_type_e decode(insn_t insn, uint64_t pc, uint64_t &target);
@@ -3,6 +3,8 @@
 #pragma interface
 #include <cstdio>
 #include <cassert>
+#include <cstring>
+#include <cinttypes>
 #include "common.h"
 #include "decode.h"
 
@@ -10,24 +12,497 @@
 #define	INVALID		-1
 
 
+///////////////////////
+// REPLACEMENT POLICIES
+///////////////////////
+//
+// The replacement policy is a compile-time template parameter of cache<T,P>.
+// Every policy class provides the same interface:
+//
+//   P(size, assoc)              allocate per-set replacement state
+//   reset()                     return to the power-on state (cache flush)
+//   hit(set, way, id)           a lookup hit in (set, way); probe() does not call it
+//   victim(set)                 choose the way to replace; must NOT modify state,
+//                               because lookups with replace=false also ask for it
+//   fill(set, way, id, valid)   a new line 'id' replaces (set, way); 'valid' says
+//                               whether the line being evicted was a valid line
+//   invalidate(set, way)        (set, way) was invalidated; return it to the
+//                               state of an empty way so that its next fill
+//                               starts from the power-on state
+//   dump(fp)                    print the policy's decision statistics
+//
+// Runtime selection (per cache level) is done once, at construction, through
+// cache_array_t<T> and new_cache_array<T>() below.
+
+typedef enum {
+	REPL_LRU = 0,	// true LRU (O(assoc) counters)
+	REPL_PLRU,	// tree pseudo-LRU (assoc-1 bits per set)
+	REPL_SRRIP,	// static RRIP (Jaleel et al., ISCA 2010)
+	REPL_BRRIP,	// bimodal RRIP
+	REPL_DRRIP,	// dynamic RRIP: SRRIP vs. BRRIP set-dueling
+	REPL_SHIP,	// SHiP: signature-based hit prediction on top of SRRIP
+	NUM_REPL_POLICIES
+} repl_policy_e;
+
+static const char* const repl_policy_name[NUM_REPL_POLICIES] = {"lru", "plru", "srrip", "brrip", "drrip", "ship"};
+
+// Returns the policy whose name matches 's', or NUM_REPL_POLICIES if none does.
+static inline repl_policy_e repl_policy_from_name(const char* s) {
+	unsigned int i;
+	for (i = 0; i < (unsigned int)NUM_REPL_POLICIES; i++)
+		if (strcmp(s, repl_policy_name[i]) == 0)
+			return((repl_policy_e)i);
+	return(NUM_REPL_POLICIES);
+}
+
+
+// True LRU.  This is the original policy of cache<T>: way 'assoc-1' of the
+// LRU stack is the victim, and both hits and fills move a way to the MRU position.
+class lru_policy_t {
+private:
+	unsigned int size;
+	unsigned int assoc;
+	unsigned int* lru;	// lru[set*assoc + way]: 0 is MRU, assoc-1 is LRU
+
+	void promote(unsigned int set, unsigned int way) {
+		unsigned int* s = &lru[set*assoc];
+		unsigned int i;
+		for (i = 0; i < assoc; i++) {
+			if (s[i] < s[way]) {
+				s[i] += 1;
+			}
+		}
+		s[way] = 0;
+	}
+
+	void demote(unsigned int set, unsigned int way) {
+		unsigned int* s = &lru[set*assoc];
+		unsigned int i;
+		for (i = 0; i < assoc; i++) {
+			if (s[i] > s[way]) {
+				s[i] -= 1;
+			}
+		}
+		s[way] = (assoc-1);
+	}
+
+public:
+	lru_policy_t(unsigned int size, unsigned int assoc) : size(size), assoc(assoc) {
+		lru = new unsigned int[size*assoc];
+		reset();
+	}
+	~lru_policy_t() { delete [] lru; }
+
+	static repl_policy_e policy() { return(REPL_LRU); }
+
+	void reset() {
+		unsigned int i, j;
+		for (i = 0; i < size; i++)
+			for (j = 0; j < assoc; j++)
+				lru[i*assoc + j] = j;
+	}
+
+	void hit(unsigned int set, unsigned int way, reg_t id) { promote(set, way); }
+
+	unsigned int victim(unsigned int set) {
+		unsigned int* s = &lru[set*assoc];
+		unsigned int i;
+		for (i = 0; i < assoc; i++) {
+			if (s[i] == (assoc-1)) {	// least-recently used
+				return(i);
+			}
+		}
+		assert(0);
+		return(0);
+	}
+
+	void fill(unsigned int set, unsigned int way, reg_t id, bool valid) { promote(set, way); }
+
+	void invalidate(unsigned int set, unsigned int way) { demote(set, way); }
+
+	void dump(FILE* fp) { }
+};
+
+
+// Tree pseudo-LRU.  Each set has a binary tree of assoc-1 bits; a bit points
+// toward the subtree holding the pseudo-LRU way.  Hits and fills flip the bits
+// on the path to the accessed way so that they point away from it.
+class plru_policy_t {
+private:
+	unsigned int size;
+	unsigned int assoc;
+	unsigned char* tree;	// tree[set*assoc + node], node 1..assoc-1 (node 0 unused)
+
+	// Point the bits on the path to 'way' away from it (toward == false),
+	// or toward it (toward == true, which makes it the next victim).
+	void touch(unsigned int set, unsigned int way, bool toward = false) {
+		unsigned char* t = &tree[set*assoc];
+		unsigned int node = 1;
+		unsigned int lo = 0;
+		unsigned int half = (assoc >> 1);
+		while (half > 0) {
+			if (way < (lo + half)) {	// way is in the left subtree: point right
+				t[node] = (toward ? 0 : 1);
+				node = (node << 1);
+			}
+			else {				// way is in the right subtree: point left
+				t[node] = (toward ? 1 : 0);
+				node = ((node << 1) | 1);
+				lo += half;
+			}
+			half = (half >> 1);
+		}
+	}
+
+public:
+	plru_policy_t(unsigned int size, unsigned int assoc) : size(size), assoc(assoc) {
+		assert(IsPow2(assoc));	// tree-PLRU needs a complete binary tree
+		tree = new unsigned char[size*assoc];
+		reset();
+	}
+	~plru_policy_t() { delete [] tree; }
+
+	static repl_policy_e policy() { return(REPL_PLRU); }
+
+	void reset() { memset(tree, 0, size*assoc); }
+
+	void hit(unsigned int set, unsigned int way, reg_t id) { touch(set, way); }
+
+	unsigned int victim(unsigned int set) {
+		unsigned char* t = &tree[set*assoc];
+		unsigned int node = 1;
+		unsigned int lo = 0;
+		unsigned int half = (assoc >> 1);
+		while (half > 0) {
+			if (t[node]) {
+				node = ((node << 1) | 1);
+				lo += half;
+			}
+			else {
+				node = (node << 1);
+			}
+			half = (half >> 1);
+		}
+		return(lo);
+	}
+
+	void fill(unsigned int set, unsigned int way, reg_t id, bool valid) { touch(set, way); }
+
+	void invalidate(unsigned int set, unsigned int way) { touch(set, way, true); }
+
+	void dump(FILE* fp) { }
+};
+
+
+// Common state of the RRIP family: a 2-bit re-reference prediction value (RRPV)
+// per line.  RRPV 0 means "re-referenced soon", RRIP_MAX means "distant".
+// Hits promote to 0.  The victim is the first way with RRPV == RRIP_MAX; if there
+// is none, all RRPVs in the set are aged until one reaches RRIP_MAX.  victim() only
+// computes the way that aging would produce, and age() applies it at fill time.
+#define RRIP_BITS	2
+#define RRIP_MAX	((1 << RRIP_BITS) - 1)
+#define RRIP_LONG	(RRIP_MAX - 1)
+
+// BRRIP inserts at RRIP_LONG once every BRRIP_EPSILON fills, at RRIP_MAX otherwise.
+#define BRRIP_EPSILON	32
+
+class rrip_base_t {
+protected:
+	unsigned int size;
+	unsigned int assoc;
+	unsigned char* rrpv;	// rrpv[set*assoc + way]
+
+	// stats
+	uint64_t n_aging;		// fills that had to age the set first
+	uint64_t n_insert_long;		// fills inserted at RRIP_LONG
+	uint64_t n_insert_distant;	// fills inserted at RRIP_MAX
+
+	void age(unsigned int set, unsigned int way) {
+		unsigned char* s = &rrpv[set*assoc];
+		unsigned int delta = (RRIP_MAX - s[way]);
+		unsigned int i;
+		if (delta) {
+			n_aging++;
+			for (i = 0; i < assoc; i++)
+				s[i] += delta;
+		}
+	}
+
+	void insert(unsigned int set, unsigned int way, unsigned int value) {
+		rrpv[set*assoc + way] = value;
+		if (value == RRIP_MAX)
+			n_insert_distant++;
+		else
+			n_insert_long++;
+	}
+
+	// Bimodal throttle shared by BRRIP and the BRRIP side of DRRIP.
+	unsigned int brrip_ctr;
+	unsigned int brrip_value() {
+		brrip_ctr = ((brrip_ctr + 1) % BRRIP_EPSILON);
+		return((brrip_ctr == 0) ? RRIP_LONG : RRIP_MAX);
+	}
+
+public:
+	rrip_base_t(unsigned int size, unsigned int assoc) : size(size), assoc(assoc) {
+		rrpv = new unsigned char[size*assoc];
+		reset();
+		n_aging = 0;
+		n_insert_long = 0;
+		n_insert_distant = 0;
+		brrip_ctr = 0;
+	}
+	~rrip_base_t() { delete [] rrpv; }
+
+	void reset() { memset(rrpv, RRIP_MAX, size*assoc); }
+
+	void hit(unsigned int set, unsigned int way, reg_t id) { rrpv[set*assoc + way] = 0; }
+
+	// An empty way must be at RRIP_MAX: age() of a way filled from any lower
+	// RRPV would push the rest of the set past RRIP_MAX.
+	void invalidate(unsigned int set, unsigned int way) { rrpv[set*assoc + way] = RRIP_MAX; }
+
+	unsigned int victim(unsigned int set) {
+		unsigned char* s = &rrpv[set*assoc];
+		unsigned int oldest = 0;
+		unsigned int i;
+		for (i = 0; i < assoc; i++) {
+			if (s[i] == RRIP_MAX)
+				return(i);
+			if (s[i] > s[oldest])
+				oldest = i;
+		}
+		return(oldest);
+	}
+
+	void dump(FILE* fp) {
+		uint64_t fills = (n_insert_long + n_insert_distant);
+		fprintf(fp, "  fills that aged the set     = %" PRIu64 " (%.2f%%)\n", n_aging, 100.0*(double)n_aging/(double)fills);
+		fprintf(fp, "  inserted at long RRPV       = %" PRIu64 " (%.2f%%)\n", n_insert_long, 100.0*(double)n_insert_long/(double)fills);
+		fprintf(fp, "  inserted at distant RRPV    = %" PRIu64 " (%.2f%%)\n", n_insert_distant, 100.0*(double)n_insert_distant/(double)fills);
+	}
+};
+
+class srrip_policy_t : public rrip_base_t {
+public:
+	srrip_policy_t(unsigned int size, unsigned int assoc) : rrip_base_t(size, assoc) { }
+	static repl_policy_e policy() { return(REPL_SRRIP); }
+
+	void fill(unsigned int set, unsigned int way, reg_t id, bool valid) {
+		age(set, way);
+		insert(set, way, RRIP_LONG);
+	}
+};
+
+class brrip_policy_t : public rrip_base_t {
+public:
+	brrip_policy_t(unsigned int size, unsigned int assoc) : rrip_base_t(size, assoc) { }
+	static repl_policy_e policy() { return(REPL_BRRIP); }
+
+	void fill(unsigned int set, unsigned int way, reg_t id, bool valid) {
+		age(set, way);
+		insert(set, way, brrip_value());
+	}
+};
+
+
+// DRRIP set-dueling.  One set out of every DRRIP_DUEL_PERIOD is an SRRIP leader,
+// the next one is a BRRIP leader, and the rest follow the policy selected by the
+// MSB of a saturating PSEL counter.  A miss (fill) in an SRRIP leader counts
+// against SRRIP (PSEL++), a miss in a BRRIP leader counts against BRRIP (PSEL--).
+#define DRRIP_DUEL_PERIOD	32
+#define DRRIP_PSEL_BITS		10
+#define DRRIP_PSEL_MAX		((1 << DRRIP_PSEL_BITS) - 1)
+
+class drrip_policy_t : public rrip_base_t {
+private:
+	unsigned int psel;
+
+	// stats
+	uint64_t n_srrip_leader_fills;
+	uint64_t n_brrip_leader_fills;
+	uint64_t n_follower_srrip_fills;
+	uint64_t n_follower_brrip_fills;
+
+public:
+	drrip_policy_t(unsigned int size, unsigned int assoc) : rrip_base_t(size, assoc) {
+		psel = ((DRRIP_PSEL_MAX + 1) >> 1);
+		n_srrip_leader_fills = 0;
+		n_brrip_leader_fills = 0;
+		n_follower_srrip_fills = 0;
+		n_follower_brrip_fills = 0;
+	}
+	static repl_policy_e policy() { return(REPL_DRRIP); }
+
+	void fill(unsigned int set, unsigned int way, reg_t id, bool valid) {
+		unsigned int slot = (set % DRRIP_DUEL_PERIOD);
+		bool use_brrip;
+
+		age(set, way);
+
+		if (slot == 0) {		// SRRIP leader
+			n_srrip_leader_fills++;
+			if (psel < DRRIP_PSEL_MAX) psel++;
+			use_brrip = false;
+		}
+		else if (slot == 1) {		// BRRIP leader
+			n_brrip_leader_fills++;
+			if (psel > 0) psel--;
+			use_brrip = true;
+		}
+		else {				// follower
+			use_brrip = (psel > (DRRIP_PSEL_MAX >> 1));
+			if (use_brrip)
+				n_follower_brrip_fills++;
+			else
+				n_follower_srrip_fills++;
+		}
+
+		insert(set, way, (use_brrip ? brrip_value() : RRIP_LONG));
+	}
+
+	void dump(FILE* fp) {
+		rrip_base_t::dump(fp);
+		fprintf(fp, "  SRRIP leader-set fills      = %" PRIu64 "\n", n_srrip_leader_fills);
+		fprintf(fp, "  BRRIP leader-set fills      = %" PRIu64 "\n", n_brrip_leader_fills);
+		fprintf(fp, "  follower fills using SRRIP  = %" PRIu64 "\n", n_follower_srrip_fills);
+		fprintf(fp, "  follower fills using BRRIP  = %" PRIu64 "\n", n_follower_brrip_fills);
+		fprintf(fp, "  final PSEL                  = %u (followers use %s)\n", psel, ((psel > (DRRIP_PSEL_MAX >> 1)) ? "BRRIP" : "SRRIP"));
+	}
+};
+
+
+// SHiP (Wu et al., MICRO 2011) on top of SRRIP.  The cache is not given the PC of
+// the access, so this is the SHiP-Mem variant: the signature is a hash of the
+// memory region (SHIP_REGION_SHIFT low line-address bits dropped).  A table of
+// saturating counters (SHCT) learns whether lines with a given signature get
+// re-referenced before eviction; lines whose counter is 0 are inserted at the
+// distant RRPV, all others at the long RRPV.
+#define SHIP_SHCT_BITS		14
+#define SHIP_SHCT_MAX		7
+#define SHIP_REGION_SHIFT	8
+
+class ship_policy_t : public rrip_base_t {
+private:
+	unsigned char* shct;		// signature history counter table
+	uint16_t* signature;		// signature[set*assoc + way]
+	bool* reused;			// reused[set*assoc + way]: hit since fill
+
+	// stats
+	uint64_t n_predicted_dead;	// fills with SHCT == 0
+	uint64_t n_reused_evictions;	// valid evictions of lines that hit since their fill
+	uint64_t n_dead_evictions;	// valid evictions of lines that never hit
+
+	static uint16_t sign(reg_t id) {
+		reg_t region = (id >> SHIP_REGION_SHIFT);
+		return((uint16_t)((region ^ (region >> SHIP_SHCT_BITS)) & ((1 << SHIP_SHCT_BITS) - 1)));
+	}
+
+public:
+	ship_policy_t(unsigned int size, unsigned int assoc) : rrip_base_t(size, assoc) {
+		shct = new unsigned char[1 << SHIP_SHCT_BITS];
+		signature = new uint16_t[size*assoc];
+		reused = new bool[size*assoc];
+		memset(shct, 1, (1 << SHIP_SHCT_BITS));
+		memset(signature, 0, size*assoc*sizeof(uint16_t));
+		memset(reused, 0, size*assoc*sizeof(bool));
+		n_predicted_dead = 0;
+		n_reused_evictions = 0;
+		n_dead_evictions = 0;
+	}
+	~ship_policy_t() {
+		delete [] shct;
+		delete [] signature;
+		delete [] reused;
+	}
+	static repl_policy_e policy() { return(REPL_SHIP); }
+
+	void hit(unsigned int set, unsigned int way, reg_t id) {
+		unsigned int i = (set*assoc + way);
+		rrpv[i] = 0;
+		if (!reused[i]) {
+			reused[i] = true;
+			if (shct[signature[i]] < SHIP_SHCT_MAX)
+				shct[signature[i]]++;
+		}
+	}
+
+	void fill(unsigned int set, unsigned int way, reg_t id, bool valid) {
+		unsigned int i = (set*assoc + way);
+		uint16_t sig = sign(id);
+
+		// Train on the outgoing line.
+		if (valid) {
+			if (reused[i]) {
+				n_reused_evictions++;
+			}
+			else {
+				n_dead_evictions++;
+				if (shct[signature[i]] > 0)
+					shct[signature[i]]--;
+			}
+		}
+
+		age(set, way);
+		signature[i] = sig;
+		reused[i] = false;
+		if (shct[sig] == 0) {
+			n_predicted_dead++;
+			insert(set, way, RRIP_MAX);
+		}
+		else {
+			insert(set, way, RRIP_LONG);
+		}
+	}
+
+	void dump(FILE* fp) {
+		rrip_base_t::dump(fp);
+		fprintf(fp, "  fills predicted dead (SHCT=0) = %" PRIu64 "\n", n_predicted_dead);
+		fprintf(fp, "  evictions: reused = %" PRIu64 ", never reused = %" PRIu64 "\n", n_reused_evictions, n_dead_evictions);
+	}
+};
+
+
 ///////////////////////
 // STANDARD CACHE
 ///////////////////////
+
+// Policy-independent view of a cache<T,P>, so that a level can pick its
+// replacement policy at run time while each cache<T,P> is still specialized
+// for its policy at compile time.
 template<class T>
-class cache {
+class cache_array_t {
+public:
+	virtual ~cache_array_t() { }
+	virtual void flush() = 0;
+	virtual T* lookup(reg_t id, T* contents,
+	                  bool* hit, reg_t* old_id,
+	                  bool replace,
+	                  bool use_raw_index = false,
+	                  unsigned int raw_index = 0) = 0;
+	virtual T* probe(reg_t id, bool* hit) = 0;
+	virtual T* invalidate(reg_t id) = 0;
+	virtual repl_policy_e policy() = 0;
+	virtual void dump_policy_stats(FILE* fp) = 0;
+};
+
+template<class T, class P = lru_policy_t>
+class cache : public cache_array_t<T> {
 private:
 	// The cache is a 2-D array of entries, each entry
-	// is a tag + lru + pointer to object of type T.
+	// is a tag + pointer to object of type T.
+	// Replacement state is kept by the policy object.
 
 	typedef
 	struct {
 		reg_t tag;
-		unsigned int lru;
 		T* contents;
 	} entry;
 
 	entry**	C;
 
+	P repl;
+
 
 public:
 	// size = number of entries deep
@@ -37,9 +512,13 @@ public:
 
 	// stats
 	unsigned int num_misses;
+	uint64_t num_hits;
+	uint64_t num_fills;		// misses with replace=true
+	uint64_t num_valid_evictions;	// fills that displaced a valid line
+	uint64_t num_invalidations;	// lines removed by invalidate()
 
 	// constructor
-	cache(unsigned int size, unsigned int assoc) {
+	cache(unsigned int size, unsigned int assoc) : repl(size, assoc) {
 		unsigned int i,j;
 
 		// First ensure that 'size' is a power of 2.
@@ -50,7 +529,6 @@ public:
 			C[i] = new entry[assoc];
 			for (j = 0; j < assoc; j++) {
 				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
 				C[i][j].contents = (T*)NULL;
 			}
 		}
@@ -58,6 +536,10 @@ public:
 		this->size = size;
 		this->assoc = assoc;
 		this->num_misses = 0;
+		this->num_hits = 0;
+		this->num_fills = 0;
+		this->num_valid_evictions = 0;
+		this->num_invalidations = 0;
 	}
 
 	// destructor
@@ -79,10 +561,10 @@ public:
 		for (i = 0; i < size; i++) {
 			for (j = 0; j < assoc; j++) {
 				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
 				C[i][j].contents = (T*)NULL;
 			}
 		}
+		repl.reset();
 	}
 
 
@@ -100,20 +582,64 @@ public:
 	          bool replace,
 	          bool use_raw_index = false,
 	          unsigned int raw_index = 0);
+
+	// Tag check only: returns the contents of object 'id' (NULL if it is
+	// not present) without counting a hit or a miss and without touching
+	// the replacement state.  For bookkeeping probes that are not accesses.
+	T* probe(reg_t id, bool* hit) {
+		unsigned int index = MOD(id, size);
+
+		for (unsigned int i = 0; i < assoc; i++) {
+			if (C[index][i].tag == id) {
+				*hit = true;
+				return(C[index][i].contents);
+			}
+		}
+		*hit = false;
+		return((T*)NULL);
+	}
+
+	// Remove object 'id' from the cache, if present.  Returns the
+	// pointer to its contents (NULL if it was not present); the
+	// way becomes invalid and is the next one filled in its set.
+	T* invalidate(reg_t id) {
+		unsigned int index = MOD(id, size);
+		T* old_contents;
+
+		for (unsigned int i = 0; i < assoc; i++) {
+			if (C[index][i].tag == id) {
+				old_contents = C[index][i].contents;
+				C[index][i].tag = INVALID;
+				C[index][i].contents = (T*)NULL;
+				repl.invalidate(index, i);
+				num_invalidations += 1;
+				return(old_contents);
+			}
+		}
+		return((T*)NULL);
+	}
+
+	repl_policy_e policy() { return(P::policy()); }
+
+	void dump_policy_stats(FILE* fp) {
+		fprintf(fp, "  hits = %" PRIu64 ", misses = %u, fills = %" PRIu64 ", evictions of valid lines = %" PRIu64 ", invalidations = %" PRIu64 "\n",
+		        num_hits, num_misses, num_fills, num_valid_evictions, num_invalidations);
+		repl.dump(fp);
+	}
 };
 
 
-template<class T>
-T* cache<T>::lookup(reg_t id, T* contents,
-                    bool* hit, reg_t* old_id,
-                    bool replace,
-                    bool use_raw_index, unsigned int raw_index) {
+template<class T, class P>
+T* cache<T,P>::lookup(reg_t id, T* contents,
+                      bool* hit, reg_t* old_id,
+                      bool replace,
+                      bool use_raw_index, unsigned int raw_index) {
 	unsigned int index;
 	entry* set;
 	unsigned int i;
 	bool found;
 	unsigned int hit_way;
-	int replace_way;
+	unsigned int replace_way;
 	T* old_contents;
 
 	index = MOD((use_raw_index ? raw_index : id), size);
@@ -132,14 +658,10 @@ T* cache<T>::lookup(reg_t id, T* contents,
 
 	if (found) {
 		hit_way = i;
+		num_hits += 1;
 
-		// Update LRU state.
-		for (i = 0; i < assoc; i++) {
-			if (set[i].lru < set[hit_way].lru) {
-				set[i].lru += 1;
-			}
-		}
-		set[hit_way].lru = 0;
+		// Update replacement state.
+		repl.hit(index, hit_way, id);
 
 		// Set outputs of function.
 		*hit = true;
@@ -150,35 +672,31 @@ T* cache<T>::lookup(reg_t id, T* contents,
 		// record the miss
 		num_misses += 1;
 
-		// Find replacement entry, and update LRU state.
-		replace_way = -1;
-		if (replace) {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-					set[i].lru = 0;
-				}
-				else {
-					set[i].lru += 1;
-				}
-			}
-		}
-		else {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-				}
+		// Find replacement entry: an invalid way if there is one,
+		// otherwise the policy's victim.  (True LRU always
+		// ranks invalid ways last, so this does not change it.)
+		replace_way = assoc;
+		for (i = 0; i < assoc; i++) {
+			if (set[i].tag == (reg_t)INVALID) {
+				replace_way = i;
+				break;
 			}
 		}
-		assert(replace_way != -1);
+		if (replace_way == assoc)
+			replace_way = repl.victim(index);
+		assert(replace_way < assoc);
 
 		// Set outputs of function.
 		*hit = false;
 		*old_id = set[replace_way].tag;
 		old_contents = set[replace_way].contents;
 
-		// Perform the actual replacement.
+		// Perform the actual replacement, and update replacement state.
 		if (replace) {
+			num_fills += 1;
+			if (set[replace_way].tag != (reg_t)INVALID)
+				num_valid_evictions += 1;
+			repl.fill(index, replace_way, id, (set[replace_way].tag != (reg_t)INVALID));
 			set[replace_way].tag = id;
 			set[replace_way].contents = contents;
 		}
@@ -188,4 +706,19 @@ T* cache<T>::lookup(reg_t id, T* contents,
 }
 
 
+// Allocate a cache array of T with the replacement policy selected at run time.
+template<class T>
+cache_array_t<T>* new_cache_array(repl_policy_e policy, unsigned int size, unsigned int assoc) {
+	switch (policy) {
+		case REPL_LRU:   return(new cache<T, lru_policy_t>(size, assoc));
+		case REPL_PLRU:  return(new cache<T, plru_policy_t>(size, assoc));
+		case REPL_SRRIP: return(new cache<T, srrip_policy_t>(size, assoc));
+		case REPL_BRRIP: return(new cache<T, brrip_policy_t>(size, assoc));
+		case REPL_DRRIP: return(new cache<T, drrip_policy_t>(size, assoc));
+		case REPL_SHIP:  return(new cache<T, ship_policy_t>(size, assoc));
+		default:         assert(0); return((cache_array_t<T>*)NULL);
+	}
+}
+
+
 #endif //CACHE_H
@@ -0,0 +1,211 @@
+/*--------------------------------------------------------------------------*\
+ | dram.cc
+ |
+ | Main memory timing model behind the last-level cache.  See dram.h.
+\*--------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+
+#include "common.h"
+#include "dram.h"
+
+#define DRAM_MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+dram_t::dram_t(unsigned int _channels, unsigned int _ranks, unsigned int _banks,
+               unsigned int _rowSize, bool _openPage, unsigned int _lineSize,
+               unsigned int _tRCD, unsigned int _tCAS, unsigned int _tRP, unsigned int _tRAS,
+               unsigned int _tBURST, unsigned int _tREFI, unsigned int _tRFC, unsigned int _tCTRL)
+	: channels(_channels),
+	  ranks(_ranks),
+	  banks(_banks),
+	  lineSize(_lineSize),
+	  openPage(_openPage),
+	  tRCD(_tRCD), tCAS(_tCAS), tRP(_tRP), tRAS(_tRAS),
+	  tBURST(_tBURST), tREFI(_tREFI), tRFC(_tRFC), tCTRL(_tCTRL)
+{
+	unsigned int i;
+
+	assert(IsPow2(channels) && IsPow2(ranks) && IsPow2(banks));
+	assert(_rowSize >= lineSize);
+	assert((tREFI == 0) || (tRFC < tREFI));
+
+	log2channels = (unsigned int) log2((double)channels);
+	log2ranks    = (unsigned int) log2((double)ranks);
+	log2banks    = (unsigned int) log2((double)banks);
+	log2cols     = (_rowSize - lineSize);
+
+	bank = new dram_bank_t[channels*ranks*banks];
+	for (i = 0; i < channels*ranks*banks; i++) {
+		bank[i].openRow = -1;
+		bank[i].colReady = 0;
+		bank[i].actCycle = 0;
+		bank[i].ready = 0;
+		bank[i].refreshEpoch = 0;
+		bank[i].prevRow = -1;
+		bank[i].prevColReady = 0;
+		bank[i].prevClose = 0;
+	}
+
+	busFree = new cycle_t[channels];
+	for (i = 0; i < channels; i++) {
+		busFree[i] = 0;
+	}
+
+	n_reads = 0;
+	n_writes = 0;
+	n_row_hits = 0;
+	n_row_empty = 0;
+	n_row_conflicts = 0;
+	n_frfcfs_bypass = 0;
+	n_refresh_stalls = 0;
+	queueCycles = 0;
+	busWaitCycles = 0;
+	latencyCycles = 0;
+}
+
+dram_t::~dram_t()
+{
+	delete [] bank;
+	delete [] busFree;
+}
+
+cycle_t dram_t::Access(cycle_t curCycle, reg_t addr, bool isWrite)
+{
+	reg_t line;
+	unsigned int ch, rk, bk;
+	int64_t row;
+	dram_bank_t* b;
+	cycle_t t;
+	cycle_t first;       /* First command issued for this request. */
+	cycle_t act;
+	cycle_t pre;
+	cycle_t colStart;
+	cycle_t dataStart;
+	cycle_t dataEnd;
+
+	if (isWrite)
+		n_writes++;
+	else
+		n_reads++;
+
+	// Address mapping:
+	//  open-page:   | row | rank | bank | column | channel | line offset |
+	//  closed-page: | row | column | rank | bank | channel | line offset |
+	line = (addr >> lineSize);
+	ch = (line & (channels-1));
+	line = (line >> log2channels);
+	if (openPage)
+		line = (line >> log2cols);
+	bk = (line & (banks-1));
+	line = (line >> log2banks);
+	rk = (line & (ranks-1));
+	line = (line >> log2ranks);
+	if (!openPage)
+		line = (line >> log2cols);
+	row = (int64_t)line;
+
+	b = &bank[(ch*ranks + rk)*banks + bk];
+
+	// Request reaches the controller.
+	t = curCycle + tCTRL;
+
+	// Refresh: the last tRFC cycles of every tREFI interval belong to the
+	// refresh of the rank.  A refresh precharges all banks of the rank.
+	if (tREFI) {
+		cycle_t phase = (t % tREFI);
+		if (phase >= (tREFI - tRFC)) {
+			t += (tREFI - phase);
+			n_refresh_stalls++;
+		}
+		if ((uint64_t)(t / tREFI) != b->refreshEpoch) {
+			b->refreshEpoch = (uint64_t)(t / tREFI);
+			b->openRow = -1;
+			b->prevRow = -1;
+		}
+	}
+
+	if (openPage && (row == b->openRow)) {
+		// Row hit.
+		n_row_hits++;
+		colStart = DRAM_MAX(t, b->colReady);
+		first = colStart;
+	}
+	else if (openPage && (row == b->prevRow) &&
+	         ((DRAM_MAX(t, b->prevColReady) + tBURST) <= b->prevClose)) {
+		// FR-FCFS: the row is still open until the precharge of an older,
+		// queued row miss.  Serve this row hit first.
+		n_row_hits++;
+		n_frfcfs_bypass++;
+		colStart = DRAM_MAX(t, b->prevColReady);
+		first = colStart;
+		b->prevColReady = colStart + tBURST;
+	}
+	else {
+		if (!openPage || (b->openRow == -1)) {
+			// Bank is precharged.
+			n_row_empty++;
+			act = DRAM_MAX(t, b->ready);
+			first = act;
+		}
+		else {
+			// Row conflict: precharge the open row first.
+			n_row_conflicts++;
+			pre = DRAM_MAX(DRAM_MAX(t, b->ready), DRAM_MAX(b->actCycle + tRAS, b->colReady));
+			b->prevRow = b->openRow;
+			b->prevColReady = b->colReady;
+			b->prevClose = pre;
+			act = pre + tRP;
+			first = pre;
+		}
+		colStart = act + tRCD;
+		b->actCycle = act;
+		b->openRow = row;
+	}
+
+	// Column-to-column spacing is one burst.
+	b->colReady = colStart + tBURST;
+
+	if (openPage) {
+		b->ready = colStart;
+	}
+	else {
+		// Auto-precharge after the column access.
+		b->ready = DRAM_MAX(colStart + tBURST, b->actCycle + tRAS) + tRP;
+		b->openRow = -1;
+	}
+
+	// Data transfer on the channel's bus.
+	dataStart = DRAM_MAX(colStart + tCAS, busFree[ch]);
+	dataEnd = dataStart + tBURST;
+	busFree[ch] = dataEnd;
+
+	queueCycles += (first - (curCycle + tCTRL));
+	busWaitCycles += (dataStart - (colStart + tCAS));
+	latencyCycles += (dataEnd - curCycle);
+
+	return(dataEnd);
+}
+
+void dram_t::dump_stats(FILE* fp, uint64_t num_cycles)
+{
+	uint64_t n = (n_reads + n_writes);
+	uint64_t bytes = (n << lineSize);
+	double peak = ((double)channels * (double)(1 << lineSize) / (double)tBURST);
+
+	fprintf(fp, "DRAM MEASUREMENTS----------------------------------\n");
+	fprintf(fp, "  %u channel(s) x %u rank(s) x %u bank(s), %s-page policy\n", channels, ranks, banks, (openPage ? "open" : "closed"));
+	fprintf(fp, "  reads            = %" PRIu64 "\n", n_reads);
+	fprintf(fp, "  writes           = %" PRIu64 "\n", n_writes);
+	fprintf(fp, "  row hits         = %" PRIu64 " (%.2f%%)\n", n_row_hits, 100.0*(double)n_row_hits/(double)n);
+	fprintf(fp, "     FR-FCFS hits served ahead of an older row miss = %" PRIu64 "\n", n_frfcfs_bypass);
+	fprintf(fp, "  row empty        = %" PRIu64 " (%.2f%%)\n", n_row_empty, 100.0*(double)n_row_empty/(double)n);
+	fprintf(fp, "  row conflicts    = %" PRIu64 " (%.2f%%)\n", n_row_conflicts, 100.0*(double)n_row_conflicts/(double)n);
+	fprintf(fp, "  refresh stalls   = %" PRIu64 "\n", n_refresh_stalls);
+	fprintf(fp, "  avg. latency     = %.2f cycles (incl. %" PRIcycle " controller cycles)\n", (double)latencyCycles/(double)n, tCTRL);
+	fprintf(fp, "  avg. bank queueing delay = %.2f cycles\n", (double)queueCycles/(double)n);
+	fprintf(fp, "  avg. bus queueing delay  = %.2f cycles\n", (double)busWaitCycles/(double)n);
+	fprintf(fp, "  bandwidth        = %.3f bytes/cycle (%.2f%% of peak %.3f bytes/cycle)\n",
+	        (double)bytes/(double)num_cycles, 100.0*((double)bytes/(double)num_cycles)/peak, peak);
+}
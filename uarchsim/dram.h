@@ -0,0 +1,117 @@
+#ifndef DRAM_H
+#define DRAM_H
+/*--------------------------------------------------------------------------*\
+ | dram.h
+ |
+ | Main memory timing model behind the last-level cache.
+ | Like CacheClass, it keeps only time-stamps: Access() is told when a
+ |  request arrives and returns the cycle its data transfer completes.
+ |
+ | Organization:
+ |  Channels, each with its own data bus and ranks; ranks with banks.
+ |  Each bank has a row buffer, managed with an open-page or closed-page
+ |  (auto-precharge) policy.
+ |
+ | Address mapping (low to high bits):
+ |  open-page:   line offset, channel, column (line within row), bank,
+ |               rank, row.  Consecutive lines interleave across channels
+ |               and then stay in the same row, to exploit row hits.
+ |  closed-page: line offset, channel, bank, rank, column, row.
+ |               Consecutive lines interleave across channels and banks,
+ |               to overlap their activates.
+ |
+ | Timing parameters (all in core cycles):
+ |  tRCD   activate to column command
+ |  tCAS   column command to first data
+ |  tRP    precharge to activate
+ |  tRAS   activate to precharge (minimum row open time)
+ |  tBURST data bus occupancy of one line (bus bandwidth)
+ |  tREFI  refresh interval, per rank
+ |  tRFC   refresh cycle time (rank unavailable, rows closed)
+ |  tCTRL  fixed controller + interconnect latency, each way combined
+ |
+ | Scheduling:
+ |  Requests to a bank are served first-come-first-served, except that a
+ |  request to the row that is still open while an older request to a
+ |  different row waits for its precharge (FR-FCFS: first-ready) is
+ |  served from the open row, if its column access fits before that
+ |  precharge.  The older request is never delayed by this, since its
+ |  completion time has already been returned to the cache.
+\*--------------------------------------------------------------------------*/
+#include <cinttypes>
+#include <cstdio>
+#include "decode.h"
+
+class dram_bank_t {
+public:
+	int64_t  openRow;      /* Row in the row buffer, -1 if precharged.        */
+	cycle_t  colReady;     /* Next column command to the open row.           */
+	cycle_t  actCycle;     /* Last activate (for tRAS).                      */
+	cycle_t  ready;        /* Bank can start a new activate/precharge.       */
+	uint64_t refreshEpoch; /* tREFI epoch of the last access.                */
+
+	/* FR-FCFS: the row that was open before the last row switch, and the
+	 * cycle of the precharge that closes it.                                */
+	int64_t  prevRow;
+	cycle_t  prevColReady;
+	cycle_t  prevClose;
+};
+
+class dram_t {
+public:
+	dram_t(unsigned int _channels, unsigned int _ranks, unsigned int _banks,
+	       unsigned int _rowSize, bool _openPage, unsigned int _lineSize,
+	       unsigned int _tRCD, unsigned int _tCAS, unsigned int _tRP, unsigned int _tRAS,
+	       unsigned int _tBURST, unsigned int _tREFI, unsigned int _tRFC, unsigned int _tCTRL);
+	/*------------------------------------------------------------------------*\
+	 | Constructor.
+	 |
+	 |  channels, ranks, banks   Organization (each must be a power of 2).
+	 |  rowSize                  log2 of the row buffer size in bytes.
+	 |  openPage                 true: open-page, false: closed-page policy.
+	 |  lineSize                 log2 of the size of a request in bytes
+	 |                            (the line size of the last-level cache).
+	 |  tRCD ... tCTRL           Timing, in core cycles (see above).
+	\*------------------------------------------------------------------------*/
+
+	~dram_t();
+
+	cycle_t Access(cycle_t curCycle, reg_t addr, bool isWrite);
+	/*------------------------------------------------------------------------*\
+	 | A line read (fill) or write (writeback) arrives at the memory
+	 |  controller in cycle curCycle.  Returns the cycle when its data
+	 |  transfer has completed.
+	\*------------------------------------------------------------------------*/
+
+	void dump_stats(FILE* fp, uint64_t num_cycles);
+
+private:
+	unsigned int channels;
+	unsigned int ranks;
+	unsigned int banks;
+	unsigned int lineSize;
+	unsigned int log2channels;
+	unsigned int log2cols;       /* Lines per row.                           */
+	unsigned int log2banks;
+	unsigned int log2ranks;
+	bool         openPage;
+
+	cycle_t tRCD, tCAS, tRP, tRAS, tBURST, tREFI, tRFC, tCTRL;
+
+	dram_bank_t* bank;           /* bank[(channel*ranks + rank)*banks + bank] */
+	cycle_t*     busFree;        /* Data bus of each channel.                */
+
+	/* stats */
+	uint64_t n_reads;
+	uint64_t n_writes;
+	uint64_t n_row_hits;         /* Column access to the open row.           */
+	uint64_t n_row_empty;        /* Bank was precharged: activate only.      */
+	uint64_t n_row_conflicts;    /* Another row was open: precharge first.   */
+	uint64_t n_frfcfs_bypass;    /* Row hits served ahead of a queued miss.  */
+	uint64_t n_refresh_stalls;   /* Requests that arrived during a refresh.  */
+	uint64_t queueCycles;        /* Arrival to first command (bank busy).    */
+	uint64_t busWaitCycles;      /* Data ready but bus busy.                 */
+	uint64_t latencyCycles;      /* Arrival to completion, incl. tCTRL.      */
+};
+
+#endif //DRAM_H
@@ -130,7 +130,10 @@ void pipeline_t::execute(unsigned int lane_number) {
       {
         // Execute the ALU-type instruction on the ALU.
         try {
-          alu(index);
+          if (PAY.buf[index].fused)
+            alu_fused(index);
+          else
+            alu(index);
         }
         // Catch exceptions thrown by the ALU.
         catch (trap_t &t) {
@@ -322,4 +325,10 @@ void pipeline_t::execute(unsigned int lane_number) {
       REN->set_complete(PAY.buf[index].Checkpoint_ID);
       // FIX_ME #18b END
     }
+
+    // Replay the D$ accesses of stores that lost D$ port/bank arbitration.
+    LSU.store_replay(cycle);
+
+    // Write committed stores from the store buffer into the D$.
+    LSU.sb_drain(cycle);
   }
@@ -17,6 +17,10 @@ void pipeline_t::fetch() {
    // It will get clocked in the next cycle and that models repredicting the misfetched bundle in the next cycle.
 
    if (FetchUnit->fetch2(DECODE))	// The DECODE[] pipeline register is passed in so that the Fetch2 stage can advance its bundle to the Decode stage.
-      FetchUnit->fetch1(cycle);		// The current cycle is passed in so that the Fetch1 stage can model the cycle at which an instruction cache miss resolves.
+      FetchUnit->fetch1(cycle, REN->free_checkpoints());	// The current cycle is passed in so that the Fetch1 stage can model the cycle at which an instruction cache miss resolves,
+							// and the renamer's free checkpoints are passed in for fetch gating.
+
+   // A bundle that Fetch2 just advanced to the Decode stage skips it if the micro-op cache supplied all of its decoded instructions.
+   decode_bypass();
 
 }			// fetch()
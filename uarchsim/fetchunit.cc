@@ -6,14 +6,38 @@
 
 fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,                      // "n"
                          uint64_t cond_branch_per_cycle,                // "m"
+                         uint64_t bundles_per_cycle,                    // fetch bundles per cycle (1 or 2)
                          uint64_t btb_entries,                          // total number of entries in the BTB
                          uint64_t btb_assoc,                            // set-associativity of the BTB
+                         uint64_t btb_l2_entries,                       // total number of entries in the L2 BTB (0: no L2 BTB)
+                         uint64_t btb_l2_assoc,                         // set-associativity of the L2 BTB
+                         uint64_t btb_l2_latency,                       // extra fetch cycles (bubbles) when a branch misses in the BTB and hits in the L2 BTB
                          uint64_t cb_pc_length, uint64_t cb_bhr_length, // gshare cond. br. predictor: pc length (index size), bhr length
                          uint64_t ib_pc_length, uint64_t ib_bhr_length, // gshare indirect br. predictor: pc length (index size), bhr length
+                         uint64_t tage_kb,                              // TAGE cond. br. predictor: budget in KB (0: use the gshare predictor instead)
+                         uint64_t tage_tables,                          // TAGE: number of tagged tables
+                         uint64_t tage_min_hist, uint64_t tage_max_hist, // TAGE: shortest and longest history lengths
+                         uint64_t perceptron_kb,                        // hashed perceptron cond. br. predictor: budget in KB (0: gshare or TAGE)
+                         uint64_t perceptron_tables,                    // hashed perceptron: number of weight tables (including the bias table)
+                         uint64_t perceptron_max_hist,                  // hashed perceptron: history length
+                         uint64_t loop_entries,                          // loop predictor add-on: number of entries (0: none)
+                         uint64_t sc_entries,                            // statistical corrector add-on: entries per table (0: none)
+                         uint64_t ittage_kb,                            // ITTAGE indirect br. predictor: budget in KB (0: use the gshare predictor instead)
+                         uint64_t ittage_tables,                        // ITTAGE: number of tagged tables
+                         uint64_t ittage_min_hist, uint64_t ittage_max_hist, // ITTAGE: shortest and longest history lengths
                          uint64_t ras_size,                             // # entries in the RAS
                          uint64_t bq_size,                              // branch queue size (max. number of outstanding branches)
+                         uint64_t ftq_size,                             // fetch target queue size (0: no fetch-directed instruction prefetching)
                          bool tc_enable,                                // enable trace cache
                          bool tc_perfect,                               // perfect trace cache (only relevant if trace cache is enabled)
+                         uint64_t tc_entries,                           // real trace cache: total number of traces
+                         uint64_t tc_assoc,                             // real trace cache: set-associativity
+                         uint64_t uop_entries,                          // micro-op cache: total number of lines (0: no micro-op cache)
+                         uint64_t uop_assoc,                            // micro-op cache: set-associativity
+                         uint64_t uop_switch_penalty,                   // micro-op cache: fetch cycles (bubbles) to switch from it to the decoders
+                         uint64_t gate_chkpts,                          // fetch gating: gate while fewer checkpoints are free (0: off)
+                         uint64_t gate_lowconf,                         // fetch gating: gate while at least this many low-confidence branches are unresolved (0: off)
+                         bool gate_throttle,                            // fetch gating: fetch every other cycle instead of stopping
                          bool bp_perfect,                               // perfect branch prediction
                          bool ic_perfect,                               // perfect instruction cache
                          uint64_t ic_sets,                              // I$ sets
@@ -31,6 +55,7 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,                      // "n"
                          payload *PAY                                   // (1) Payload of fetched instructions. (2) Provides a function that serves as a perfect branch predictor.
                          ) : instr_per_cycle(instr_per_cycle),
                              cond_branch_per_cycle(cond_branch_per_cycle),
+                             bundles_per_cycle(bundles_per_cycle),
                              PAY(PAY),
                              proc(proc),
                              fetch_active(true),
@@ -38,93 +63,106 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,                      // "n"
                              ic(ic_perfect, mmu, instr_per_cycle,
                                 ic_sets, ic_assoc, ic_line_size, ic_hit_latency, ic_miss_latency, ic_num_MHSRs, ic_miss_srv_ports, ic_miss_srv_latency, proc, L2C),
                              ic_miss(false),
-                             btb(btb_entries, instr_per_cycle, btb_assoc, cond_branch_per_cycle),
+                             btb(btb_entries, instr_per_cycle, btb_assoc, cond_branch_per_cycle, btb_l2_entries, btb_l2_assoc),
+                             btb_l2(btb_l2_entries > 0),
+                             btb_l2_latency(btb_l2_latency),
+                             btb_l2_resume_cycle(0),
                              tc_enable(tc_enable),
-                             tc(tc_perfect, mmu, cond_branch_per_cycle, instr_per_cycle),
-                             cb_index(cb_pc_length, cb_bhr_length),
-                             ib_index(ib_pc_length, ib_bhr_length),
-                             ras(ras_size),
+                             tc(tc_perfect, mmu, cond_branch_per_cycle, instr_per_cycle, tc_entries, tc_assoc),
+                             uop_switch_penalty(uop_switch_penalty),
+                             uop_mode(false),
+                             uop_resume_cycle(0),
+                             gate_chkpts(gate_chkpts),
+                             gate_lowconf(gate_lowconf),
+                             gate_throttle(gate_throttle),
+                             lowconf_inflight(0),
+                             wrong_path(false),
+                             // The long global history must hold the outcomes in flight: those of the branches in the branch queue,
+                             // the bundle(s) in the Fetch2 stage, and the bundles the run-ahead predictor queued in the FTQ.
+                             bp(cond_branch_per_cycle, cb_pc_length, cb_bhr_length, ib_pc_length, ib_bhr_length,
+                                tage_kb, tage_tables, tage_min_hist, tage_max_hist, perceptron_kb, perceptron_tables, perceptron_max_hist,
+                                loop_entries, sc_entries, ittage_kb, ittage_tables, ittage_min_hist, ittage_max_hist,
+                                ras_size, (bq_size + ((ftq_size + bundles_per_cycle) * cond_branch_per_cycle))),
                              bp_perfect(bp_perfect),
+                             ftq_size(ftq_size),
+                             ftq_resync(true),
                              bq(bq_size)
 {
 
    // Memory-allocate the fetch bundle from the instruction cache + BTB or from the trace cache.
    fetch_bundle = new fetch_bundle_t[instr_per_cycle];
 
-   // Memory-allocate the conditional branch (cb) prediction table and indirect branch (ib) prediction table.
-   cb = new uint64_t[cb_index.table_size()];
-   ib = new uint64_t[ib_index.table_size()];
-
-   for (uint64_t i = 0; i < cb_index.table_size(); i++)
-      cb[i] = 0xaaaaaaaa; // Initialize counters to weakly-taken.
-
-   // Memory-allocate FETCH2, the pipeline register between the Fetch1 and Fetch2 stages.
-   FETCH2 = new pipeline_register[instr_per_cycle];
+   // Optional micro-op cache.  Its lines hold the instructions of a fetch bundle, so the trace cache's bundles bypass it.
+   uc = (uop_entries ? new uop_cache_t(instr_per_cycle, uop_entries, uop_assoc) : NULL);
 
+   // Memory-allocate FETCH2, the pipeline register between the Fetch1 and Fetch2 stages: one fetch bundle for each one fetched per cycle.
    // Initialize the Fetch2 stage's status.
-   fetch2_status.valid = false;
+   assert((bundles_per_cycle >= 1) && (bundles_per_cycle <= MAX_FETCH_BUNDLES));
+   for (uint64_t b = 0; b < bundles_per_cycle; b++)
+   {
+      FETCH2[b] = new pipeline_register[instr_per_cycle];
+      fetch2_status[b].valid = false;
+   }
+
+   // Memory-allocate the run-ahead predictor's fetch bundle.  Its exception bits stay clear: only the I$ sets them.
+   ra_bundle = new fetch_bundle_t[instr_per_cycle];
+   for (uint64_t i = 0; i < instr_per_cycle; i++)
+      ra_bundle[i].exception = false;
 
    // This assertion is required because BTB bank selection assumes a power-of-two number of BTB banks.
    assert(IsPow2(instr_per_cycle));
 
    // Initialize measurements.
 
-   meas_branch_n = 0;  // # branches
-   meas_jumpdir_n = 0; // # jumps, direct
-   meas_calldir_n = 0; // # calls, direct
-   meas_jumpind_n = 0; // # jumps, indirect
-   meas_callind_n = 0; // # calls, indirect
-   meas_jumpret_n = 0; // # jumps, return
-
-   meas_branch_m = 0;  // # mispredicted branches
-   meas_jumpind_m = 0; // # mispredicted jumps, indirect
-   meas_callind_m = 0; // # mispredicted calls, indirect
-   meas_jumpret_m = 0; // # mispredicted jumps, return
-
-   meas_jumpind_seq = 0; // # jump-indirect instructions whose targets were the next sequential PC
-
    meas_btbmiss = 0; // # of btb misses, i.e., number of discarded fetch bundles (idle fetch cycles) due to a btb miss within the bundle
+   meas_btb_l2_hit = 0;
+   meas_btb_l2_bubbles = 0;
+
+   meas_uop_switch = 0;
+   meas_uop_bubbles = 0;
+
+   meas_fetch_cycles = 0;
+   meas_fetch_bundles = 0;
+   meas_fetch_instr = 0;
+   meas_fetch_bank_conflict = 0;
+   meas_fetch_loop_stop = 0;
+   meas_fetch_wp_instr = 0;
+
+   meas_gate_chkpts = 0;
+   meas_gate_lowconf = 0;
+   meas_gate_cycles = 0;
+   meas_gate_wp_cycles = 0;
+
+   meas_ftq_cycles = 0;
+   meas_ftq_occupancy = 0;
+   meas_ftq_full = 0;
+   meas_ftq_fetched = 0;
+   meas_ftq_hit = 0;
+   meas_ftq_flush = 0;
+   meas_ftq_pf_lines = 0;
 }
 
 fetchunit_t::~fetchunit_t()
 {
 }
 
-void fetchunit_t::spec_update(spec_update_t *update, uint64_t cb_predictions)
+void fetchunit_t::set_itlb(tlb_t *itlb)
 {
-   // Speculatively update the pc with the predicted pc of the next fetch bundle.
-   pc = update->next_pc;
-
-   // Speculatively update the BHRs.
-   bool taken;
-   for (uint64_t i = 0; i < update->num_cb; i++)
-   {
-      // The low two bits of cb_predictions correspond to the next two-bit counter to examine (because we shift it right, subsequently).
-      // From this two-bit counter, set the taken flag, accordingly.
-      taken = ((cb_predictions & 3) >= 2);
-
-      // Shift out the used-up 2-bit counter, to set up the next conditional branch.
-      cb_predictions = (cb_predictions >> 2);
+   ic.set_tlb(itlb);
+}
 
-      // Update the BHRs of the conditional branch predictor and indirect branch predictor.
-      cb_index.update_bhr(taken);
-      ib_index.update_bhr(taken);
-   }
+void fetchunit_t::uop_fill(uint64_t index)
+{
+   if (PAY->buf[index].uop_fill)
+      uc->fill(PAY->buf[index].uop_start_pc, PAY->buf[index].uop_pos, &(PAY->buf[index]));
+}
 
-   // Speculatively update the RAS.
-   if (update->pop_ras)
-   {
-      assert(!update->push_ras);
-      ras.pop();
-   }
-   if (update->push_ras)
-   {
-      assert(!update->pop_ras);
-      ras.push(update->push_ras_pc);
-   }
+void fetchunit_t::dump_profile(FILE *fp, uint64_t num_instr)
+{
+   ic.dump_profile(fp, num_instr);
 }
 
-void fetchunit_t::transfer_fetch_bundle()
+void fetchunit_t::transfer_fetch_bundle(cycle_t cycle, uint64_t b)
 {
    uint64_t pos;   // instruction's position in the fetch bundle
    uint64_t index; // PAY index
@@ -142,6 +180,7 @@ void fetchunit_t::transfer_fetch_bundle()
       PAY->buf[index].branch = fetch_bundle[pos].branch;
       PAY->buf[index].branch_type = fetch_bundle[pos].branch_type;
       PAY->buf[index].branch_target = fetch_bundle[pos].branch_target;
+      PAY->buf[index].fetch_cycle = cycle;
       PAY->buf[index].fflags = 0; // fflags field is always cleaned for newly fetched instructions
 
       // CPR: Initialize chkpt_id to something greater than the largest valid chkpt_id.
@@ -171,6 +210,14 @@ void fetchunit_t::transfer_fetch_bundle()
          }
       }
 
+      // The micro-op cache supplies the fields set by the Decode stage on a hit; otherwise the Decode stage fills them into it.
+      PAY->buf[index].uop_hit = fetch2_status[b].uop_hit;
+      PAY->buf[index].uop_fill = (uc && !fetch2_status[b].tc_hit && !fetch2_status[b].uop_hit);
+      PAY->buf[index].uop_start_pc = fetch2_status[b].pc;
+      PAY->buf[index].uop_pos = pos;
+      if (fetch2_status[b].uop_hit)
+         uc->read(fetch2_status[b].pc, pos, &(PAY->buf[index]));
+
       //////////////////////////////////////////////////////
       // map_to_actual()
       //////////////////////////////////////////////////////
@@ -179,42 +226,192 @@ void fetchunit_t::transfer_fetch_bundle()
       // NOTE: Even when NOPs are injected, successfully mapping to actual is not a problem,
       // as the NOP instructions will never be committed.
       PAY->map_to_actual(proc, index);
+      wrong_path = !PAY->buf[index].good_instruction;
 
       //////////////////////////////////////////////////////
       // Put the PAY index into the FETCH2 pipeline register.
       //////////////////////////////////////////////////////
-      assert(!FETCH2[pos].valid);
-      FETCH2[pos].valid = true;
-      FETCH2[pos].index = index;
+      assert(!FETCH2[b][pos].valid);
+      FETCH2[b][pos].valid = true;
+      FETCH2[b][pos].index = index;
 
       // Go to the next instruction.
       pos++;
    }
 
    // Assert that the fetch bundle has at least one instruction.
-   assert(FETCH2[0].valid);
+   assert(FETCH2[b][0].valid);
 }
 
-void fetchunit_t::squash_fetch2()
+void fetchunit_t::squash_fetch2(uint64_t first)
 {
-   fetch2_status.valid = false;
-   for (uint64_t i = 0; i < instr_per_cycle; i++)
-      FETCH2[i].valid = false;
+   for (uint64_t b = first; b < bundles_per_cycle; b++)
+   {
+      fetch2_status[b].valid = false;
+      for (uint64_t i = 0; i < instr_per_cycle; i++)
+         FETCH2[b][i].valid = false;
+   }
+}
+
+void fetchunit_t::ftq_flush()
+{
+   if (!ftq.empty())
+      meas_ftq_flush++;
+   ftq.clear();
+   ftq_resync = true;
+}
+
+// The run-ahead predictor predicts one fetch bundle per cycle, like the Fetch1 stage (see fetch1() for the prediction steps).
+void fetchunit_t::ftq_predict(cycle_t cycle)
+{
+   // Restart from the Fetch1 stage's state: the next bundle it fetches is the first one queued.
+   if (ftq_resync)
+   {
+      ftq.clear();
+      ra_pc = pc;
+      ra_cb_bhr = bp.cb_index.get_bhr();
+      ra_ib_bhr = bp.ib_index.get_bhr();
+      ra_ghist = bp.ghist.get_bhr();
+      ra_ras.clear();
+      ra_ras_tos = bp.ras.get_tos();
+      ftq_resync = false;
+   }
+
+   meas_ftq_cycles++;
+   meas_ftq_occupancy += ftq.size();
+
+   // Don't run ahead of a serializing instruction: the Fetch1 stage restarts from a new pc after it retires.
+   if (!fetch_active)
+      return;
+
+   if (ftq.size() == ftq_size)
+   {
+      meas_ftq_full++;
+      return;
+   }
+
+   // Predict the bundle at ra_pc with the run-ahead predictor's own BHRs and RAS.
+   cb_addon_t cb_addon;
+   uint64_t cb_predictions = bp.cb_predict(ra_pc, ra_cb_bhr, ra_ghist, &cb_addon);
+   uint64_t ib_predicted_target = bp.ib_predict(ra_pc, ra_ib_bhr, ra_ghist);
+   uint64_t ras_predicted_target = (!ra_ras.empty() ? ra_ras.back() : bp.ras.peek(ra_ras_tos));
+   spec_update_t update;
+
+   btb.lookup(ra_pc, cb_predictions, ib_predicted_target, ras_predicted_target, ra_bundle, &update, false);
+
+   // Queue the bundle and prefetch its lines.
+   ftq.push_back(ra_pc);
+   meas_ftq_pf_lines += ic.prefetch(cycle, ra_pc);
+
+   // Advance the run-ahead predictor past the bundle (cf. bpred_t::spec_update()).
+   bool taken;
+   for (uint64_t i = 0; i < update.num_cb; i++)
+   {
+      taken = ((cb_predictions & 3) >= 2);
+      cb_predictions = (cb_predictions >> 2);
+      ra_cb_bhr = bp.cb_index.update_my_bhr(ra_cb_bhr, taken);
+      ra_ib_bhr = bp.ib_index.update_my_bhr(ra_ib_bhr, taken);
+      ra_ghist = bp.ghist.update_my_bhr(ra_ghist, taken);
+   }
+   if (update.pop_ras)
+   {
+      if (!ra_ras.empty())
+         ra_ras.pop_back();
+      else
+         bp.ras.pop(ra_ras_tos);
+   }
+   if (update.push_ras)
+      ra_ras.push_back(update.push_ras_pc);
+   ra_pc = update.next_pc;
 }
 
 // Fetch1 pipeline stage.
-void fetchunit_t::fetch1(cycle_t cycle)
+void fetchunit_t::fetch1(cycle_t cycle, uint64_t free_chkpts)
 {
    // Stall if any of the following conditions hold:
-   // 1. The Fetch2 bundle hasn't advanced.
+   // 1. The Fetch2 bundle(s) haven't advanced.
    // 2. Instruction fetching is disabled until a serializing instruction (fetch exception, amo, or csr instruction) retires.
    // 3. The Fetch1 stage is waiting for an instruction cache miss to resolve.
-   if (fetch2_status.valid || !fetch_active || (ic_miss && (cycle < ic_miss_resolve_cycle)))
+   // 4. The Fetch1 stage is waiting for the L2 BTB to supply a branch of the previous fetch bundle.
+   // 5. The Fetch1 stage is switching from the micro-op cache to the decoders.
+   if (fetch2_status[0].valid || !fetch_active || (ic_miss && (cycle < ic_miss_resolve_cycle)) || (cycle < btb_l2_resume_cycle) || (cycle < uop_resume_cycle))
+   {
+      if (cycle < btb_l2_resume_cycle)
+         meas_btb_l2_bubbles++;
+      if (cycle < uop_resume_cycle)
+         meas_uop_bubbles++;
+
+      // The run-ahead predictor doesn't stall with the Fetch1 stage.
+      if (ftq_size)
+         ftq_predict(cycle);
       return;
+   }
 
    // If we *were* waiting for an instruction cache miss to resolve, we are no longer waiting.
    ic_miss = false;
 
+   // Fetch gating: don't fetch while the renamer is short of checkpoints or the in-flight path holds many unresolved low-confidence
+   // branches, as the instructions fetched are likely to be squashed or to stall in the Rename stage anyway.  Throttled fetch still
+   // proceeds on odd cycles.
+   bool gate_c = (gate_chkpts && (free_chkpts < gate_chkpts));
+   bool gate_l = (gate_lowconf && (lowconf_inflight >= gate_lowconf));
+   if ((gate_c || gate_l) && (!gate_throttle || !(cycle & 1)))
+   {
+      if (gate_c)
+         meas_gate_chkpts++;
+      if (gate_l)
+         meas_gate_lowconf++;
+      meas_gate_cycles++;
+      if (wrong_path)
+         meas_gate_wp_cycles++;
+
+      if (ftq_size)
+         ftq_predict(cycle);
+      return;
+   }
+
+   // Fetch up to "bundles_per_cycle" fetch bundles.
+   // The second fetch bundle starts at the first one's predicted next pc: the branch predictor, trace cache, and instruction cache + BTB
+   // are searched a second time, after the pc, BHRs, and RAS were speculatively updated for the first bundle.  It is not fetched if:
+   // - The first bundle was not fetched (instruction cache miss).
+   // - The first bundle had branches supplied by the L2 BTB (the next bundle waits for the L2 BTB).
+   // - The first bundle switched from the micro-op cache to the decoders (the next bundle waits for the switch).
+   // - The instruction cache lines of the two bundles conflict in its banks (see ic_t::bank_conflict()).
+   // - The first bundle has branches that hit in the loop predictor.  Their speculative iteration counts are only advanced in the
+   //   Fetch2 stage, so the second bundle (typically the next iteration of the same loop) would be predicted with stale counts.
+   for (uint64_t b = 0; b < bundles_per_cycle; b++)
+   {
+      if (b > 0)
+      {
+         if ((cycle < btb_l2_resume_cycle) || (cycle < uop_resume_cycle))
+            break;
+
+         if (!fetch2_status[b - 1].tc_hit && ic.bank_conflict(fetch2_status[b - 1].pc, pc))
+         {
+            meas_fetch_bank_conflict++;
+            break;
+         }
+
+         if (bp.loop && fetch2_status[b - 1].cb_addon.loop)
+         {
+            meas_fetch_loop_stop++;
+            break;
+         }
+      }
+
+      if (!fetch1_bundle(cycle, b))
+         break;
+   }
+
+   // The run-ahead predictor predicts after the Fetch1 stage, so that a bundle is never prefetched in the cycle it is fetched.
+   if (ftq_size)
+      ftq_predict(cycle);
+}
+
+// Predict and supply fetch bundle "b" of this cycle (see fetch1()).
+// Returns false if the fetch bundle could not be supplied (instruction cache miss).
+bool fetchunit_t::fetch1_bundle(cycle_t cycle, uint64_t b)
+{
    ///////////////////////////////////////////////////////////////////////////////////////////////////////////
    // Search all the structures "in parallel".
    // - real branch predictor or perfect branch predictor (including conditional branch predictor,
@@ -230,6 +427,9 @@ void fetchunit_t::fetch1(cycle_t cycle)
    // This guides speculatively updating the pc, BHRs, and RAS, after accessing the trace cache and instruction cache + BTB.
    spec_update_t update;
 
+   // How the conditional branch predictor's add-ons changed its predictions.
+   cb_addon_t cb_addon;
+
    // Access the branch predictor.
    if (bp_perfect)
    {
@@ -238,20 +438,22 @@ void fetchunit_t::fetch1(cycle_t cycle)
       PAY->predict(proc, pc, instr_per_cycle, cb_predictions, indirect_target);
       ib_predicted_target = indirect_target;
       ras_predicted_target = indirect_target;
+      cb_addon.main = cb_predictions;
+      cb_addon.sc = cb_addon.loop = cb_addon.loop_taken = cb_addon.loop_used = 0;
    }
    else
    {
       // Real branch predictor.
 
-      // Get "m" predictions from the conditional branch predictor.
+      // Get "m" predictions from the conditional branch predictor (gshare, TAGE or perceptron), after its add-ons (statistical corrector, loop predictor), if any.
       // "m" two-bit counters are packed into a uint64_t.
-      cb_predictions = cb[cb_index.index(pc)];
+      cb_predictions = bp.cb_predict(pc, bp.cb_index.get_bhr(), bp.ghist.get_bhr(), &cb_addon);
 
-      // Get a predicted target from the indirect branch predictor.  It is only used if the fetch bundle ends at a jump indirect or call indirect.
-      ib_predicted_target = ib[ib_index.index(pc)];
+      // Get a predicted target from the indirect branch predictor (gshare or ITTAGE).  It is only used if the fetch bundle ends at a jump indirect or call indirect.
+      ib_predicted_target = bp.ib_predict(pc, bp.ib_index.get_bhr(), bp.ghist.get_bhr());
 
       // Get a predicted target from the return address stack.  This is only a peek: it is popped only if ultimately used.
-      ras_predicted_target = ras.peek();
+      ras_predicted_target = bp.ras.peek();
    }
 
    // Access the trace cache.
@@ -283,7 +485,35 @@ void fetchunit_t::fetch1(cycle_t cycle)
       // Nevertheless, conceptually, the instruction cache and BTB are searched in parallel.
 
       if (!ic_miss)
-         btb.lookup(pc, cb_predictions, ib_predicted_target, ras_predicted_target, fetch_bundle, &update);
+      {
+         // Branches that missed in the BTB but hit in the L2 BTB delay the next fetch bundle.
+         if (btb.lookup(pc, cb_predictions, ib_predicted_target, ras_predicted_target, fetch_bundle, &update) && btb_l2_latency)
+         {
+            btb_l2_resume_cycle = (cycle + 1 + btb_l2_latency);
+            meas_btb_l2_hit++;
+         }
+      }
+   }
+
+   // Access the micro-op cache with the fetch bundle formed by the instruction cache + BTB.  It hits if it holds all of the
+   // bundle's instructions, decoded.  A fetch bundle with a fetch exception is left to the decoders.
+   bool uop_hit = false;
+   if (uc && !tc_hit && !ic_miss)
+   {
+      uint64_t length = 0;
+      bool exception = false;
+      while ((length < instr_per_cycle) && fetch_bundle[length].valid)
+         exception |= fetch_bundle[length++].exception;
+      uop_hit = (!exception && uc->lookup(pc, length));
+
+      // Switching from the micro-op cache to the decoders: the next fetch bundle waits uop_switch_penalty cycles.
+      if (uop_mode && !uop_hit)
+      {
+         meas_uop_switch++;
+         if (uop_switch_penalty)
+            uop_resume_cycle = (cycle + 1 + uop_switch_penalty);
+      }
+      uop_mode = uop_hit;
    }
 
    if (tc_hit || !ic_miss)
@@ -296,24 +526,47 @@ void fetchunit_t::fetch1(cycle_t cycle)
       // A misfetch is when the fetch bundle came from the instruction cache + BTB, but the BTB hits were flawed.
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      fetch2_status.valid = true;
-      fetch2_status.pc = pc;
-      fetch2_status.cb_bhr = cb_index.get_bhr();
-      fetch2_status.ib_bhr = ib_index.get_bhr();
-      fetch2_status.ras_tos = ras.get_tos();
-      fetch2_status.pay_checkpoint = PAY->checkpoint();
-      fetch2_status.tc_hit = tc_hit;
+      fetch2_status[b].valid = true;
+      fetch2_status[b].pc = pc;
+      fetch2_status[b].cb_bhr = bp.cb_index.get_bhr();
+      fetch2_status[b].ib_bhr = bp.ib_index.get_bhr();
+      fetch2_status[b].ghist = bp.ghist.get_bhr();
+      fetch2_status[b].ras_tos = bp.ras.get_tos();
+      fetch2_status[b].pay_checkpoint = PAY->checkpoint();
+      fetch2_status[b].tc_hit = tc_hit;
+      fetch2_status[b].uop_hit = uop_hit;
+      fetch2_status[b].cb_addon = cb_addon;
 
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
       // Transfer the fetch bundle to PAY->buf[] and push PAY indices into the FETCH2 pipeline register.
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-      transfer_fetch_bundle();
+      transfer_fetch_bundle(cycle, b);
 
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
       // Speculatively update the pc, BHRs, and RAS.
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
-      spec_update(&update, cb_predictions);
+      pc = update.next_pc;
+      bp.spec_update(&update, cb_predictions);
+
+      ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+      // Pop the FTQ head if this is the bundle it predicted; otherwise the run-ahead predictor is on another path.
+      ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+      if (ftq_size)
+      {
+         meas_ftq_fetched++;
+         if (!ftq.empty() && (ftq.front() == fetch2_status[b].pc))
+         {
+            ftq.pop_front();
+            meas_ftq_hit++;
+         }
+         else
+         {
+            ftq_flush();
+         }
+      }
    }
+
+   return (tc_hit || !ic_miss);
 }
 
 // Fetch2 pipeline stage.
@@ -327,11 +580,13 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[])
    bool serialize; // if true, a serializing instruction was found in the fetch bundle
    bool misfetch;  // if true, the instruction cache supplied a misfetched bundle (details below)
    bool is_branch_insn;
+   uint64_t b;     // fetch bundle in the Fetch2 stage (0: the first one fetched)
+   uint64_t d;     // position of instruction in the DECODE pipeline register
 
    // Do nothing if there isn't a fetch bundle in the Fetch2 stage.
-   if (!fetch2_status.valid)
+   if (!fetch2_status[0].valid)
    {
-      assert(!FETCH2[0].valid);
+      assert(!FETCH2[0][0].valid);
       return (true);
    }
 
@@ -356,172 +611,187 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[])
    // d. Return "false" from this function, to signal to the caller that it should NOT call fetchunit_t::fetch1()
    //    after this call to fetchunit_t::fetch2().  Rather, it should wait until the next cycle.
 
-   pos = 0;
-   exception = false;
-   serialize = false;
+   // With two fetch bundles per cycle, check them in fetch order.  A misfetch in the second bundle does not affect the first one.
    misfetch = false;
-   while ((pos < instr_per_cycle) && FETCH2[pos].valid)
+   for (b = 0; (b < bundles_per_cycle) && fetch2_status[b].valid && !misfetch; b++)
    {
-      // If we had set exception or serialize in the previous iteration,
-      // the instruction for this iteration should be invalid and we should have exited the loop.
-      assert(!exception);
-      assert(!serialize);
-
-      // get PAY index
-      index = FETCH2[pos].index;
-
-      if (PAY->buf[index].trap.valid())
+      pos = 0;
+      exception = false;
+      serialize = false;
+      while ((pos < instr_per_cycle) && FETCH2[b][pos].valid)
       {
-         // The instruction triggered an exception during its fetch stage, therefore has a valid trap information.
-         exception = true;
-
-         // If the offending instruction is not in the last possible slot,
-         // assert that the next slot is invalid.
-         if ((pos + 1) < instr_per_cycle)
-            assert(!FETCH2[pos + 1].valid);
+         // If we had set exception or serialize in the previous iteration,
+         // the instruction for this iteration should be invalid and we should have exited the loop.
+         assert(!exception);
+         assert(!serialize);
 
-         // Make the Fetch1 stage idle.  It will become active again when the offending instruction reaches head of Active List.
-         fetch_active = false;
-      }
+         // get PAY index
+         index = FETCH2[b][pos].index;
 
-      switch (PAY->buf[index].inst.opcode())
-      {
-      case OP_AMO:
-      case OP_SYSTEM:
-         // case OP_MISC_MEM:  // FIX_ME: Make fence a serializing instruction, add fence flag to Active List, and reference this flag to full squash at Retire stage.
-         serialize = true;
-
-         // If the serializing instruction is not in the last possible slot,
-         // make the next slot invalid.
-         if ((pos + 1) < instr_per_cycle)
-            FETCH2[pos + 1].valid = false;
-
-         // Make the Fetch1 stage idle.  It will become active again when the serializing instruction reaches head of Active List.
-         fetch_active = false;
-
-         // Since we discarded subsequent instructions in the fetch bundle and stalled fetch, also discard the excess instructions in PAY.
-         PAY->rollback(index);
+         if (PAY->buf[index].trap.valid())
+         {
+            // The instruction triggered an exception during its fetch stage, therefore has a valid trap information.
+            exception = true;
 
-         is_branch_insn = false;
-         break;
+            // If the offending instruction is not in the last possible slot,
+            // assert that the next slot is invalid.
+            if ((pos + 1) < instr_per_cycle)
+               assert(!FETCH2[b][pos + 1].valid);
 
-      case OP_JAL:
-      case OP_JALR:
-      case OP_BRANCH:
-         is_branch_insn = true;
-         break;
+            // Make the Fetch1 stage idle.  It will become active again when the offending instruction reaches head of Active List.
+            fetch_active = false;
+         }
 
-      default:
-         is_branch_insn = false;
-         break;
-      }
+         switch (PAY->buf[index].inst.opcode())
+         {
+         case OP_AMO:
+         case OP_SYSTEM:
+            // case OP_MISC_MEM:  // FIX_ME: Make fence a serializing instruction, add fence flag to Active List, and reference this flag to full squash at Retire stage.
+            serialize = true;
+
+            // If the serializing instruction is not in the last possible slot,
+            // make the next slot invalid.
+            if ((pos + 1) < instr_per_cycle)
+               FETCH2[b][pos + 1].valid = false;
+
+            // Make the Fetch1 stage idle.  It will become active again when the serializing instruction reaches head of Active List.
+            fetch_active = false;
+
+            // Since we discarded subsequent instructions in the fetch bundle and stalled fetch, also discard the excess instructions in PAY.
+            PAY->rollback(index);
+
+            is_branch_insn = false;
+            break;
+
+         case OP_JAL:
+         case OP_JALR:
+         case OP_BRANCH:
+            is_branch_insn = true;
+            break;
+
+         default:
+            is_branch_insn = false;
+            break;
+         }
 
-      // Check the branch information from the BTB or TC.
-      if (fetch2_status.tc_hit)
-      {
-         // The fetch bundle came from the trace cache.
-         // The trace cache should always be correct in identifying branches in the fetch bundle.
-         assert(PAY->buf[index].branch == is_branch_insn);
-      }
-      else
-      {
-         // The fetch bundle came from the BTB + I$.
-         if (is_branch_insn)
+         // Check the branch information from the BTB or TC.
+         if (fetch2_status[b].tc_hit)
          {
-            // Actually a branch instruction.
-            btb_branch_type_e real_branch_type;
-            uint64_t real_target;
-            real_branch_type = btb_t::decode(PAY->buf[index].inst, PAY->buf[index].pc, real_target);
-
-            if (!PAY->buf[index].branch ||
-                (PAY->buf[index].branch_type != real_branch_type) ||
-                ((PAY->buf[index].inst.opcode() != OP_JALR) && (PAY->buf[index].branch_target != real_target)))
-            {
-               // The fetch bundle came from the instruction cache and this branch was missed by the BTB -OR- the branch type and/or target was mispredicted.
-               // The type and/or target may change due to either of two reasons:
-               // 1. Self-modifying code (unlikely in SPEC).
-               // 2. The BTB is caching a non-instruction (data) corresponding to a "PC" that is not in the text segment, and the data changed.
-               //    Note, the BTB is trained speculatively. If it is trained with bundles down the wrong path of a branch (particularly indirect branches), it can be trained
-               //    with a "PC" that falls somewhere outside the text segment. Our proxy kernel marks heap pages as RWX, so no fetch exception is triggered.
-               // Note: The branch_target from the BTB is not valid for indirect branches (OP_JALR); therefore, gate the branch_target check for indirect branches.
-               misfetch = true;
-
-               // Train the BTB for this branch.
-               // The update interface takes in the start PC of the fetch bundle and the position of the branch within it.
-               btb.update(fetch2_status.pc, pos, PAY->buf[index].inst);
-
-               // Update BTB misses.
-               // Note: This is a "speculative" measurement, i.e, it includes BTB misses of instructions down the wrong path after mispredicted branches.
-               // It's hard to measure btb misses for only correct-path instructions because they aren't posted in the branch queue (due to misfetch).
-               meas_btbmiss++;
-            }
+            // The fetch bundle came from the trace cache.
+            // The trace cache should always be correct in identifying branches in the fetch bundle.
+            assert(PAY->buf[index].branch == is_branch_insn);
          }
          else
          {
-            // Actually NOT a branch instruction.
-            if (PAY->buf[index].branch)
+            // The fetch bundle came from the BTB + I$.
+            if (is_branch_insn)
             {
-               // A non-branch was misidentified by the BTB as a branch.
-               // This occasionally happens if the memory content at the "PC" previously encoded a branch (and the BTB was trained for that),
-               // but it changed and now no longer encodes a branch.
-               // It is possible for the same reasons why a branch's type and/or target could be misidentified.
-               misfetch = true;
-
-               // The pipeline should invalidate the incorrect BTB entry.
-               btb.invalidate(fetch2_status.pc, pos);
-
-               // Update BTB misses
-               meas_btbmiss++;
+               // Actually a branch instruction.
+               btb_branch_type_e real_branch_type;
+               uint64_t real_target;
+               real_branch_type = btb_t::decode(PAY->buf[index].inst, PAY->buf[index].pc, real_target);
+
+               if (!PAY->buf[index].branch ||
+                   (PAY->buf[index].branch_type != real_branch_type) ||
+                   ((PAY->buf[index].inst.opcode() != OP_JALR) && (PAY->buf[index].branch_target != real_target)))
+               {
+                  // The fetch bundle came from the instruction cache and this branch was missed by the BTB -OR- the branch type and/or target was mispredicted.
+                  // The type and/or target may change due to either of two reasons:
+                  // 1. Self-modifying code (unlikely in SPEC).
+                  // 2. The BTB is caching a non-instruction (data) corresponding to a "PC" that is not in the text segment, and the data changed.
+                  //    Note, the BTB is trained speculatively. If it is trained with bundles down the wrong path of a branch (particularly indirect branches), it can be trained
+                  //    with a "PC" that falls somewhere outside the text segment. Our proxy kernel marks heap pages as RWX, so no fetch exception is triggered.
+                  // Note: The branch_target from the BTB is not valid for indirect branches (OP_JALR); therefore, gate the branch_target check for indirect branches.
+                  misfetch = true;
+
+                  // Train the BTB for this branch.
+                  // The update interface takes in the start PC of the fetch bundle and the position of the branch within it.
+                  btb.update(fetch2_status[b].pc, pos, PAY->buf[index].inst);
+
+                  // Update BTB misses.
+                  // Note: This is a "speculative" measurement, i.e, it includes BTB misses of instructions down the wrong path after mispredicted branches.
+                  // It's hard to measure btb misses for only correct-path instructions because they aren't posted in the branch queue (due to misfetch).
+                  meas_btbmiss++;
+               }
+            }
+            else
+            {
+               // Actually NOT a branch instruction.
+               if (PAY->buf[index].branch)
+               {
+                  // A non-branch was misidentified by the BTB as a branch.
+                  // This occasionally happens if the memory content at the "PC" previously encoded a branch (and the BTB was trained for that),
+                  // but it changed and now no longer encodes a branch.
+                  // It is possible for the same reasons why a branch's type and/or target could be misidentified.
+                  misfetch = true;
+
+                  // The pipeline should invalidate the incorrect BTB entry.
+                  btb.invalidate(fetch2_status[b].pc, pos);
+
+                  // Update BTB misses
+                  meas_btbmiss++;
+               }
             }
          }
-      }
 
-      pos++;
-   }
+         pos++;
+      }
 
-   if (misfetch)
-   {
-      // It's possible to have a misfetched bundle containing an exception or serializing instruction.
-      // This can happen in the loop, above, if the exception or serializing instruction is after the
-      // first BTB-missed branch.
-      //
-      // If so, set fetch_active back to true.
-      fetch_active = true;
-
-      // a. Train the BTB for the missing branches.
-      // DONE in the loop above.
-
-      // b. Squash the misfetched bundle in the Fetch2 stage.
-      squash_fetch2();
-
-      // c. Rollback the Fetch1 stage to what its state was just prior to the misfetched bundle -- in order to repredict it.
-      pc = fetch2_status.pc;
-      cb_index.set_bhr(fetch2_status.cb_bhr);
-      ib_index.set_bhr(fetch2_status.ib_bhr);
-      ras.set_tos(fetch2_status.ras_tos);
-      PAY->restore(fetch2_status.pay_checkpoint);
-
-      // d. Return "false" from this function, to signal to the caller that it should NOT call fetchunit_t::fetch1()
-      //    after this call to fetchunit_t::fetch2().  Rather, it should wait until the next cycle.
-      return (false);
+      if (misfetch)
+      {
+         // It's possible to have a misfetched bundle containing an exception or serializing instruction.
+         // This can happen in the loop, above, if the exception or serializing instruction is after the
+         // first BTB-missed branch.
+         //
+         // If so, set fetch_active back to true.
+         fetch_active = true;
+
+         // a. Train the BTB for the missing branches.
+         // DONE in the loop above.
+
+         // b. Squash the misfetched bundle (and the fetch bundle after it, if any) in the Fetch2 stage.
+         squash_fetch2(b);
+
+         // c. Rollback the Fetch1 stage to what its state was just prior to the misfetched bundle -- in order to repredict it.
+         pc = fetch2_status[b].pc;
+         bp.restore(fetch2_status[b].cb_bhr, fetch2_status[b].ib_bhr, fetch2_status[b].ghist, fetch2_status[b].ras_tos);
+         PAY->restore(fetch2_status[b].pay_checkpoint);
+         btb_l2_resume_cycle = 0;
+         uop_resume_cycle = 0;
+         ic_miss = false;	// a second fetch bundle's I$ miss, if any, is on the squashed path
+         ftq_flush();
+
+         // d. Return "false" from this function (below).
+      }
+      else if ((exception || serialize) && ((b + 1) < bundles_per_cycle) && fetch2_status[b + 1].valid)
+      {
+         // No instructions follow an exception or serializing instruction: squash the fetch bundle after this one.
+         // A serializing instruction already discarded the instructions after it from PAY.
+         if (exception)
+            PAY->restore(fetch2_status[b + 1].pay_checkpoint);
+         squash_fetch2(b + 1);
+      }
    }
 
    //////////////////////////////////////////////////////////////////////////////////
    // Step 2:
    //
    // If the decode bundle in the Decode stage has not advanced,
-   // stall by returning true immediately.
+   // stall by returning immediately.
    //
    // On the other hand, if the decode bundle in the Decode stage has advanced:
-   // a. Transfer the fetch bundle from FETCH2 to DECODE.
+   // a. Transfer the fetch bundle(s) from FETCH2 to DECODE.
    // b. Push branches onto the branch queue.
    // c. Reset fetch2_status.
-   // d. Return true.
+   //
+   // Return "false" if there was a misfetch, to signal to the caller that it should NOT call fetchunit_t::fetch1()
+   // after this call to fetchunit_t::fetch2().  Rather, it should wait until the next cycle.
+   // Otherwise return "true".
    //////////////////////////////////////////////////////////////////////////////////
 
-   // Stall if the decode bundle in the Decode stage hasn't advanced.
-   if (DECODE[0].valid)
-      return (true);
+   // Stall if the decode bundle in the Decode stage hasn't advanced (or a misfetch squashed the only fetch bundle).
+   if (DECODE[0].valid || !fetch2_status[0].valid)
+      return (!misfetch);
 
    // a. Transfer the fetch bundle from FETCH2 to DECODE.
    // b. Push branches onto the branch queue.
@@ -529,77 +799,105 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[])
    bool taken;                         // taken/not-taken prediction for the current conditional branch (where we are at in the fetch bundle)
    uint64_t pred_tag;                  // pred_tag is the index into the branch queue for the newly pushed branch
    bool pred_tag_phase;                // this will get appended to pred_tag so that the user interacts with the Fetch Unit via a single number
-   uint64_t fetch_cb_pos_in_entry = 0; // Identifies this conditional branch's position within the conditional branch prediction bundle.
-
-   // Recreate a precise BHR at each branch queue entry, starting with the fetch2_status' BHR that is just prior to the fetch bundle.
-   uint64_t my_cb_bhr = fetch2_status.cb_bhr;
-   uint64_t my_ib_bhr = fetch2_status.ib_bhr;
+   uint64_t fetch_cb_pos_in_entry;     // Identifies this conditional branch's position within the conditional branch prediction bundle.
 
-   pos = 0;
-   while ((pos < instr_per_cycle) && FETCH2[pos].valid)
+   d = 0;
+   for (b = 0; (b < bundles_per_cycle) && fetch2_status[b].valid; b++)
    {
-      assert(!DECODE[pos].valid);
-      DECODE[pos].valid = true;
-      DECODE[pos].index = FETCH2[pos].index;
-      FETCH2[pos].valid = false;
-
-      // get PAY index
-      index = FETCH2[pos].index;
-
-      if (PAY->buf[index].branch)
+      // Recreate a precise BHR at each branch queue entry, starting with the fetch2_status' BHR that is just prior to the fetch bundle.
+      fetch_cb_pos_in_entry = 0;
+      uint64_t my_cb_bhr = fetch2_status[b].cb_bhr;
+      uint64_t my_ib_bhr = fetch2_status[b].ib_bhr;
+      uint64_t my_ghist = fetch2_status[b].ghist;
+
+      pos = 0;
+      while ((pos < instr_per_cycle) && FETCH2[b][pos].valid)
       {
-         // Push an entry into the branch queue.
-         // This merely allocates the entry; below, we set the entry's contents.
-         bq.push(pred_tag, pred_tag_phase);
-
-         // Merge the pred_tag and pred_tag_phase into a single pred_tag, and assign it to the instruction.
-         PAY->buf[index].pred_tag = ((pred_tag << 1) | (pred_tag_phase ? 1 : 0));
-
-         // Set up context-related fields in the new branch queue entry.
-         bq.bq[pred_tag].branch_type = PAY->buf[index].branch_type;
-         bq.bq[pred_tag].precise_cb_bhr = my_cb_bhr;
-         bq.bq[pred_tag].precise_ib_bhr = my_ib_bhr;
-         bq.bq[pred_tag].precise_ras_tos = fetch2_status.ras_tos; // FIX_ME: unsure about this, if bundle ends in a return.
-         bq.bq[pred_tag].fetch_pc = fetch2_status.pc;
-         bq.bq[pred_tag].fetch_cb_bhr = fetch2_status.cb_bhr;
-         bq.bq[pred_tag].fetch_ib_bhr = fetch2_status.ib_bhr;
-         bq.bq[pred_tag].fetch_cb_pos_in_entry = 0; // Only relevant for conditional branches, so it may be other than 0 for them.
-
-         // Initialize the misp. flag to indicate, as far as we know at this point, the branch is not mispredicted.
-         bq.bq[pred_tag].misp = false;
-
-         // Record the prediction.
-         taken = (PAY->buf[index].next_pc != INCREMENT_PC(PAY->buf[index].pc));
-         bq.bq[pred_tag].taken = taken;
-         bq.bq[pred_tag].next_pc = PAY->buf[index].next_pc;
-
-         // If this is a conditional branch:
-         // - Record its position within the conditional branch prediction bundle (fetch_cb_pos_in_entry).
-         // - Update the precise BHRs.
-         if (PAY->buf[index].branch_type == BTB_BRANCH)
-         {
-            // Record this conditional branch's position within the conditional branch prediction bundle.
-            bq.bq[pred_tag].fetch_cb_pos_in_entry = fetch_cb_pos_in_entry;
+         assert(!DECODE[d].valid);
+         DECODE[d].valid = true;
+         DECODE[d].index = FETCH2[b][pos].index;
+         FETCH2[b][pos].valid = false;
 
-            // Increment the position to set up for the next conditional branch in the conditional branch prediction bundle.
-            fetch_cb_pos_in_entry++;
+         // get PAY index
+         index = FETCH2[b][pos].index;
+         if (!PAY->buf[index].good_instruction)
+            meas_fetch_wp_instr++;
 
-            // Update "my" BHRs of the conditional branch predictor and indirect branch predictor.
-            // This does NOT affect the predictors' BHRs, which were already speculatively updated in the Fetch1 stage.
-            my_cb_bhr = cb_index.update_my_bhr(my_cb_bhr, taken);
-            my_ib_bhr = ib_index.update_my_bhr(my_ib_bhr, taken);
+         if (PAY->buf[index].branch)
+         {
+            // Push an entry into the branch queue.
+            // This merely allocates the entry; below, we set the entry's contents.
+            bq.push(pred_tag, pred_tag_phase);
+
+            // Merge the pred_tag and pred_tag_phase into a single pred_tag, and assign it to the instruction.
+            PAY->buf[index].pred_tag = ((pred_tag << 1) | (pred_tag_phase ? 1 : 0));
+
+            // Set up context-related fields in the new branch queue entry.
+            bq.bq[pred_tag].branch_type = PAY->buf[index].branch_type;
+            bq.bq[pred_tag].pc = PAY->buf[index].pc;
+            bq.bq[pred_tag].branch_target = PAY->buf[index].branch_target;
+            bq.bq[pred_tag].precise_cb_bhr = my_cb_bhr;
+            bq.bq[pred_tag].precise_ib_bhr = my_ib_bhr;
+            bq.bq[pred_tag].precise_ghist = my_ghist;
+            bq.bq[pred_tag].precise_ras_tos = fetch2_status[b].ras_tos; // FIX_ME: unsure about this, if bundle ends in a return.
+            bq.bq[pred_tag].fetch_pc = fetch2_status[b].pc;
+            bq.bq[pred_tag].fetch_cb_bhr = fetch2_status[b].cb_bhr;
+            bq.bq[pred_tag].fetch_ib_bhr = fetch2_status[b].ib_bhr;
+            bq.bq[pred_tag].fetch_ghist = fetch2_status[b].ghist;
+            bq.bq[pred_tag].fetch_cb_pos_in_entry = 0; // Only relevant for conditional branches, so it may be other than 0 for them.
+            bq.bq[pred_tag].loop_entry = -1;           // Only conditional branches update the loop predictor.
+
+            // Initialize the misp. flag to indicate, as far as we know at this point, the branch is not mispredicted.
+            bq.bq[pred_tag].misp = false;
+            bq.bq[pred_tag].low_conf = false;
+
+            // Record the prediction.
+            taken = (PAY->buf[index].next_pc != INCREMENT_PC(PAY->buf[index].pc));
+            bq.bq[pred_tag].taken = taken;
+            bq.bq[pred_tag].next_pc = PAY->buf[index].next_pc;
+
+            // If this is a conditional branch:
+            // - Record its position within the conditional branch prediction bundle (fetch_cb_pos_in_entry).
+            // - Update the precise BHRs.
+            if (PAY->buf[index].branch_type == BTB_BRANCH)
+            {
+               // Record its position within the conditional branch prediction bundle and how the add-ons changed its prediction,
+               // and speculatively advance the loop predictor's iteration count.
+               bp.cb_push(&bq.bq[pred_tag], fetch2_status[b].cb_addon, fetch_cb_pos_in_entry, taken);
+
+               // The branch is low-confidence if its final prediction came from a weak counter of the main predictor (fetch gating).
+               if (!bp_perfect && bq.bq[pred_tag].cb_main_weak && !bq.bq[pred_tag].cb_loop_used)
+               {
+                  bq.bq[pred_tag].low_conf = true;
+                  lowconf_inflight++;
+               }
+
+               // Increment the position to set up for the next conditional branch in the conditional branch prediction bundle.
+               fetch_cb_pos_in_entry++;
+
+               // Update "my" BHRs of the conditional branch predictor and indirect branch predictor.
+               // This does NOT affect the predictors' BHRs, which were already speculatively updated in the Fetch1 stage.
+               my_cb_bhr = bp.cb_index.update_my_bhr(my_cb_bhr, taken);
+               my_ib_bhr = bp.ib_index.update_my_bhr(my_ib_bhr, taken);
+               my_ghist = bp.ghist.update_my_bhr(my_ghist, taken);
+            }
          }
+
+         // Go to next instruction in the fetch bundle.
+         pos++;
+         d++;
       }
 
-      // Go to next instruction in the fetch bundle.
-      pos++;
+      // c. Reset fetch2_status.
+      fetch2_status[b].valid = false;
+      meas_fetch_bundles++;
    }
 
-   // c. Reset fetch2_status.
-   fetch2_status.valid = false;
+   // Measure the instructions delivered to the Decode stage.
+   meas_fetch_cycles++;
+   meas_fetch_instr += d;
 
-   // d. Return true.
-   return (true);
+   return (!misfetch);
 }
 
 // A mispredicted branch was detected.
@@ -617,47 +915,32 @@ void fetchunit_t::mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next
    uint64_t pred_tag = (branch_pred_tag >> 1);
    bool pred_tag_phase = (((branch_pred_tag & 1) == 1) ? true : false);
 
-   // 1. Roll-back the branch queue to the mispredicted branch's entry.
-   //    Then push the branch back onto it.
-
-   bq.rollback(pred_tag, pred_tag_phase, true);
-
-   uint64_t temp_pred_tag;
-   bool temp_pred_tag_phase;
-   bq.push(temp_pred_tag, temp_pred_tag_phase); // Need to push the branch back onto the branch queue.
-   assert((temp_pred_tag == pred_tag) && (temp_pred_tag_phase == pred_tag_phase));
-
-   // 2. Correct the mispredicted branch's information in its branch queue entry.
-
-   assert(bq.bq[pred_tag].next_pc != next_pc);
-   bq.bq[pred_tag].next_pc = next_pc;
-
-   if (bq.bq[pred_tag].branch_type == BTB_BRANCH)
-      assert(bq.bq[pred_tag].taken != taken);
-
-   bq.bq[pred_tag].taken = taken;
-
-   // 3. Restore checkpointed global histories and the RAS (as best we can for RAS).
-
-   cb_index.set_bhr(bq.bq[pred_tag].precise_cb_bhr);
-   ib_index.set_bhr(bq.bq[pred_tag].precise_ib_bhr);
-   ras.set_tos(bq.bq[pred_tag].precise_ras_tos);
-
-   // If the resolved branch is a conditional branch, don't forget to include its corrected outcome
-   // in the BHRs that will kick off predictions after this resolved branch.
-   if (bq.bq[pred_tag].branch_type == BTB_BRANCH)
+   // The mispredicted branch is resolved and all younger branches are squashed: they no longer count as unresolved low-confidence branches.
+   if (lowconf_inflight)
    {
-      cb_index.update_bhr(taken);
-      ib_index.update_bhr(taken);
+      uint64_t squash_pred_tag;
+      bool squash_pred_tag_phase;
+      bq.mark(squash_pred_tag, squash_pred_tag_phase);
+      do
+      {
+         bq.step_back(squash_pred_tag, squash_pred_tag_phase);
+         if (bq.bq[squash_pred_tag].low_conf)
+         {
+            bq.bq[squash_pred_tag].low_conf = false;
+            lowconf_inflight--;
+         }
+      } while ((squash_pred_tag != pred_tag) || (squash_pred_tag_phase != pred_tag_phase));
    }
 
-   // 4. Note that the branch was mispredicted (for measuring mispredictions at retirement).
-
-   bq.bq[pred_tag].misp = true;
+   // 1.-4. Roll-back the branch queue, correct the branch's entry, restore the BHRs and RAS, and note the misprediction.
+   bp.mispredict(bq, pred_tag, pred_tag_phase, taken, next_pc);
 
-   // 5. Restore the pc.
+   // 5. Restore the pc.  The fetch bundles after the branch are squashed, so stop waiting for the L2 BTB or a micro-op cache switch.
 
    pc = next_pc;
+   btb_l2_resume_cycle = 0;
+   uop_resume_cycle = 0;
+   wrong_path = false;
 
    // 6. Go active again, whether or not currently active (restore fetch_active).
 
@@ -666,6 +949,20 @@ void fetchunit_t::mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next
    // 7. Squash the fetch2_status register and FETCH2 pipeline register.
 
    squash_fetch2();
+
+   // Restart the run-ahead predictor from the corrected path.
+   ftq_flush();
+}
+
+void fetchunit_t::resolve(uint64_t branch_pred_tag)
+{
+   uint64_t pred_tag = (branch_pred_tag >> 1);
+
+   if (bq.bq[pred_tag].low_conf)
+   {
+      bq.bq[pred_tag].low_conf = false;
+      lowconf_inflight--;
+   }
 }
 
 // Commit the indicated branch from the branch queue.
@@ -677,103 +974,23 @@ void fetchunit_t::commit()
    bool pred_tag_phase;
    bq.pop(pred_tag, pred_tag_phase);
 
+   // The branch is resolved by now.
+   if (bq.bq[pred_tag].low_conf)
+   {
+      bq.bq[pred_tag].low_conf = false;
+      lowconf_inflight--;
+   }
+
    // Assert that the branch_pred_tag (pred_tag of the branch being committed from the pipeline) corresponds to the popped branch queue entry.
    //*@*assert(branch_pred_tag == ((pred_tag << 1) | (pred_tag_phase ? 1 : 0)));
 
    // Update the conditional branch predictor or indirect branch predictor.
    // Update measurements.
-   uint64_t *cb_counters; // FYI: The compiler forbids declaring these four local variables inside "case BTB_BRANCH:".
-   uint64_t shamt;
-   uint64_t mask;
-   uint64_t ctr;
-   switch (bq.bq[pred_tag].branch_type)
-   {
-   case BTB_BRANCH:
-      // Re-reference the conditional branch predictor, using the same context that was used by
-      // the fetch bundle that this branch was a part of.
-      // Using this original context, we re-reference the same "m" counters from the conditional branch predictor.
-      // "m" two-bit counters are packed into a uint64_t.
-      cb_counters = &(cb[cb_index.index(bq.bq[pred_tag].fetch_pc, bq.bq[pred_tag].fetch_cb_bhr)]);
-
-      // Prepare for reading and writing the 2-bit counter that was used to predict this branch.
-      // We need a shift-amount ("shamt") and a mask ("mask") that can be used to read/write just that counter.
-      // "shamt" = the branch's position in the entry times 2, for 2-bit counters.
-      // "mask" = (3 << shamt).
-      shamt = (bq.bq[pred_tag].fetch_cb_pos_in_entry << 1);
-      mask = (3 << shamt);
+   bp.commit(&bq.bq[pred_tag]);
 
-      // Extract a local copy of the 2-bit counter that was used to predict this branch.
-      ctr = (((*cb_counters) & mask) >> shamt);
-
-      // Increment or decrement the local copy of the 2-bit counter, based on the branch's outcome.
-      if (bq.bq[pred_tag].taken)
-      {
-         if (ctr < 3)
-            ctr++;
-      }
-      else
-      {
-         if (ctr > 0)
-            ctr--;
-      }
-
-      // Write the modified local copy of the 2-bit counter back into the predictor's entry.
-      *cb_counters = (((*cb_counters) & (~mask)) | (ctr << shamt));
-
-      // Update measurements.
-      meas_branch_n++;
-      if (bq.bq[pred_tag].misp)
-         meas_branch_m++;
-      break;
-
-   case BTB_JUMP_DIRECT:
-      // Update measurements.
-      meas_jumpdir_n++;
-      assert(!bq.bq[pred_tag].misp);
-      break;
-
-   case BTB_CALL_DIRECT:
-      // Update measurements.
-      meas_calldir_n++;
-      assert(!bq.bq[pred_tag].misp);
-      break;
-
-   case BTB_JUMP_INDIRECT:
-   case BTB_CALL_INDIRECT:
-      // Re-reference the indirect branch predictor, using the same context that was used by
-      // the fetch bundle that this branch was a part of.
-      ib[ib_index.index(bq.bq[pred_tag].fetch_pc, bq.bq[pred_tag].fetch_ib_bhr)] = bq.bq[pred_tag].next_pc;
-
-      // Update measurements.
-      if (bq.bq[pred_tag].branch_type == BTB_JUMP_INDIRECT)
-      {
-         meas_jumpind_n++;
-         if (bq.bq[pred_tag].misp)
-            meas_jumpind_m++;
-
-         // Check for, and count, an unconditional jump to the next sequential pc (can happen for first case of a switch() statement).
-         if (!bq.bq[pred_tag].taken)
-            meas_jumpind_seq++;
-      }
-      else
-      {
-         meas_callind_n++;
-         if (bq.bq[pred_tag].misp)
-            meas_callind_m++;
-      }
-      break;
-
-   case BTB_RETURN:
-      // Update measurements.
-      meas_jumpret_n++;
-      if (bq.bq[pred_tag].misp)
-         meas_jumpret_m++;
-      break;
-
-   default:
-      assert(0);
-      break;
-   }
+   // Feed the retired branch (and the non-branches before it) to the trace cache's fill unit.
+   if (tc_enable)
+      tc.fill(bq.bq[pred_tag].pc, bq.bq[pred_tag].branch_type, bq.bq[pred_tag].branch_target, bq.bq[pred_tag].taken, bq.bq[pred_tag].next_pc);
 }
 
 // Complete squash.
@@ -789,14 +1006,15 @@ void fetchunit_t::flush(uint64_t pc)
 
    // 1. Roll-back the branch queue to the head entry.
    pred_tag = bq.flush(); // "pred_tag" is the index of the head entry.
+   lowconf_inflight = 0;
 
    // 2. Restore checkpointed global histories and the RAS (as best we can for RAS).
-   cb_index.set_bhr(bq.bq[pred_tag].precise_cb_bhr);
-   ib_index.set_bhr(bq.bq[pred_tag].precise_ib_bhr);
-   ras.set_tos(bq.bq[pred_tag].precise_ras_tos);
+   //    No branches are in flight: the loop predictor's speculative iteration counts are its retired ones.
+   bp.flush(&bq.bq[pred_tag]);
 
    // 3. Restore the pc.
    this->pc = pc;
+   wrong_path = false;
 
    // 4. Go active again, whether or not currently active (restore fetch_active).
    fetch_active = true;
@@ -804,31 +1022,71 @@ void fetchunit_t::flush(uint64_t pc)
    // 5. Squash the fetch2_status register and FETCH2 pipeline register.
    squash_fetch2();
 
-   // 6. Reset ic_miss (discard pending I$ misses).
+   // 6. Reset ic_miss (discard pending I$ misses), and stop waiting for the L2 BTB or a micro-op cache switch.
    ic_miss = false;
-}
+   btb_l2_resume_cycle = 0;
+   uop_resume_cycle = 0;
 
-// Output all branch prediction measurements.
+   // Restart the run-ahead predictor from the new pc.
+   ftq_flush();
 
-#define BP_OUTPUT(fp, str, n, m, i) \
-   fprintf((fp), "%s%10lu %10lu %5.2lf%% %5.2lf\n", (str), (n), (m), 100.0 * ((double)(m) / (double)(n)), 1000.0 * ((double)(m) / (double)(i)))
+   // Retirement continues at the new pc: restart the trace cache's fill unit there.
+   if (tc_enable)
+      tc.fill_restart(pc);
+}
 
+// Output all branch prediction measurements.
 void fetchunit_t::output(uint64_t num_instr, uint64_t num_cycles, FILE *fp)
 {
-   uint64_t all = (meas_branch_n + meas_jumpdir_n + meas_calldir_n + meas_jumpind_n + meas_callind_n + meas_jumpret_n);
-   uint64_t all_misp = (meas_branch_m + meas_jumpind_m + meas_callind_m + meas_jumpret_m);
-   fprintf(fp, "BRANCH PREDICTION MEASUREMENTS---------------------\n");
-   fprintf(fp, "Type                      n          m     mr  mpki\n");
-   BP_OUTPUT(fp, "All              ", all, all_misp, num_instr);
-   BP_OUTPUT(fp, "Branch           ", meas_branch_n, meas_branch_m, num_instr);
-   BP_OUTPUT(fp, "Jump Direct      ", meas_jumpdir_n, (uint64_t)0, num_instr);
-   BP_OUTPUT(fp, "Call Direct      ", meas_calldir_n, (uint64_t)0, num_instr);
-   BP_OUTPUT(fp, "Jump Indirect    ", meas_jumpind_n, meas_jumpind_m, num_instr);
-   BP_OUTPUT(fp, "Call Indirect    ", meas_callind_n, meas_callind_m, num_instr);
-   BP_OUTPUT(fp, "Return           ", meas_jumpret_n, meas_jumpret_m, num_instr);
-   fprintf(fp, "(Number of Jump Indirects whose target was the next sequential PC = %lu)\n", meas_jumpind_seq);
+   bp.output(num_instr, fp);
    fprintf(fp, "BTB MEASUREMENTS-----------------------------------\n");
    fprintf(fp, "BTB misses (fetch cycles squashed due to a BTB miss) = %lu (%.2f%% of all cycles)\n", meas_btbmiss, 100.0 * ((double)meas_btbmiss / (double)num_cycles));
+   if (btb_l2)
+   {
+      fprintf(fp, "Fetch bundles with L2 BTB hits = %lu\n", meas_btb_l2_hit);
+      fprintf(fp, "L2 BTB bubbles (fetch cycles waiting for the L2 BTB) = %lu (%.2f%% of all cycles)\n", meas_btb_l2_bubbles, 100.0 * ((double)meas_btb_l2_bubbles / (double)num_cycles));
+   }
+   fprintf(fp, "FETCH MEASUREMENTS (%lu fetch bundle%s per cycle)-------\n", bundles_per_cycle, ((bundles_per_cycle > 1) ? "s" : ""));
+   fprintf(fp, "Cycles delivering fetch bundles to Decode = %lu\n", meas_fetch_cycles);
+   fprintf(fp, "Avg. fetch bundles per delivering cycle = %.2f\n", ((double)meas_fetch_bundles / (double)meas_fetch_cycles));
+   fprintf(fp, "Avg. instructions per delivering cycle = %.2f\n", ((double)meas_fetch_instr / (double)meas_fetch_cycles));
+   if (bundles_per_cycle > 1)
+   {
+      fprintf(fp, "Second fetch bundles blocked by I$ bank conflicts = %lu\n", meas_fetch_bank_conflict);
+      if (bp.loop)
+         fprintf(fp, "Second fetch bundles blocked by the loop predictor = %lu\n", meas_fetch_loop_stop);
+   }
+   fprintf(fp, "Wrong-path instructions delivered to Decode = %lu (%.2f%% of all delivered)\n", meas_fetch_wp_instr, 100.0 * ((double)meas_fetch_wp_instr / (double)meas_fetch_instr));
+   if (gate_chkpts || gate_lowconf)
+   {
+      // A gated cycle on the wrong path avoids fetching about as many wrong-path instructions as an average delivering cycle.
+      fprintf(fp, "FETCH GATING MEASUREMENTS (%s)-------------------\n", (gate_throttle ? "throttle" : "stop"));
+      fprintf(fp, "Gated cycles = %lu (%.2f%% of all cycles)\n", meas_gate_cycles, 100.0 * ((double)meas_gate_cycles / (double)num_cycles));
+      if (gate_chkpts)
+         fprintf(fp, "  with fewer than %lu free checkpoints = %lu\n", gate_chkpts, meas_gate_chkpts);
+      if (gate_lowconf)
+         fprintf(fp, "  with at least %lu unresolved low-confidence branches = %lu\n", gate_lowconf, meas_gate_lowconf);
+      fprintf(fp, "Gated cycles on the wrong path = %lu (%.2f%% of gated cycles)\n", meas_gate_wp_cycles, 100.0 * ((double)meas_gate_wp_cycles / (double)meas_gate_cycles));
+      fprintf(fp, "Wrong-path instructions avoided (estimated) = %.0f\n", ((double)meas_gate_wp_cycles * ((double)meas_fetch_instr / (double)meas_fetch_cycles)));
+   }
+   if (ftq_size)
+   {
+      fprintf(fp, "FTQ MEASUREMENTS (%lu entries)-----------------------\n", ftq_size);
+      fprintf(fp, "Avg. FTQ occupancy = %.2f bundles\n", ((double)meas_ftq_occupancy / (double)meas_ftq_cycles));
+      fprintf(fp, "Cycles with a full FTQ = %lu (%.2f%%)\n", meas_ftq_full, 100.0 * ((double)meas_ftq_full / (double)meas_ftq_cycles));
+      fprintf(fp, "Fetched bundles that were the FTQ head = %lu of %lu (%.2f%%)\n", meas_ftq_hit, meas_ftq_fetched, 100.0 * ((double)meas_ftq_hit / (double)meas_ftq_fetched));
+      fprintf(fp, "FTQ flushes = %lu\n", meas_ftq_flush);
+      fprintf(fp, "Lines of queued bundles not in the I$ (prefetch candidates) = %lu\n", meas_ftq_pf_lines);
+      fprintf(fp, "(Prefetches issued, useful, late, and coverage: see l1_ic PREFETCHER in the cache measurements.)\n");
+   }
+   bp.output_components(num_instr, fp);
+   if (tc_enable)
+      tc.output(num_instr, fp);
+   if (uc)
+   {
+      uc->output(fp);
+      fprintf(fp, "Switches to the decoders = %lu, switch bubbles = %lu (%.2f%% of all cycles)\n", meas_uop_switch, meas_uop_bubbles, 100.0 * ((double)meas_uop_bubbles / (double)num_cycles));
+   }
 }
 
 void fetchunit_t::setPC(uint64_t pc)
@@ -1,12 +1,16 @@
 
+#include <deque>
+#include <vector>
 #include "fetchunit_types.h"
 #include "btb.h"
-#include "bq.h"
-#include "gshare.h"
-#include "ras.h"
+#include "bpred.h"
 #include "perfectbp.h"
 #include "ic.h"
 #include "tc.h"
+#include "uopcache.h"
+
+// Maximum number of fetch bundles per cycle.
+#define MAX_FETCH_BUNDLES 2
 
 // Forward declaring pipeline_t class.
 class pipeline_t;
@@ -18,6 +22,10 @@ private:
     uint64_t instr_per_cycle;
     uint64_t cond_branch_per_cycle;
 
+    // Number of fetch bundles per cycle (1 or 2).  With 2, the Fetch1 stage predicts and fetches two consecutive fetch bundles
+    // per cycle (see fetch1()), and the Fetch2 stage holds both and passes both to the Decode stage.
+    uint64_t bundles_per_cycle;
+
     // The PAY buffer holds the payload of each in-flight instruction in the pipeline.
     payload *PAY;
     pipeline_t *proc; // This is needed by PAY->map_to_actual() and PAY->predict().
@@ -50,6 +58,12 @@ private:
     // fetch bundle among multiple choices.
     btb_t btb;
 
+    // Optional L2 BTB (inside btb_t).  If a branch misses in the BTB and hits in the L2 BTB, the bundle is still fetched, but the
+    // Fetch1 stage waits btb_l2_latency cycles (bubbles) before fetching the next bundle, as it would for the L2 BTB to supply the branch.
+    bool btb_l2;
+    uint64_t btb_l2_latency;
+    cycle_t btb_l2_resume_cycle;
+
     // Trace Cache
     //
     // The trace selection policy MUST be as follows; you may add additional constraints, e.g., related
@@ -65,74 +79,150 @@ private:
     bool tc_enable;
     tc_t tc;
 
-    // Gshare predictor for conditional branches.
-    uint64_t *cb;
-    gshare_index_t cb_index;
-
-    // Gshare predictor for indirect branches.
-    uint64_t *ib;
-    gshare_index_t ib_index;
-
-    // Return address stack for predicting return targets.
-    ras_t ras;
+    // Micro-op cache (NULL: none).  It is looked up with each fetch bundle formed by the instruction cache + BTB, and filled by the
+    // Decode stage (see uop_fill()).  A fetch bundle that hits carries its decoded fields from the Fetch1 stage on, and skips the
+    // Decode stage (see pipeline_t::decode_bypass()).  Switching from the micro-op cache back to the decoders costs uop_switch_penalty
+    // fetch cycles (bubbles) after the first fetch bundle that misses.
+    uop_cache_t *uc;
+    uint64_t uop_switch_penalty;
+    bool uop_mode;                // The last fetch bundle looked up hit in the micro-op cache.
+    cycle_t uop_resume_cycle;
+
+    // Fetch gating.  The Fetch1 stage is gated while the renamer has fewer than gate_chkpts free checkpoints (0: off), or while at
+    // least gate_lowconf low-confidence branches are unresolved (0: off).  A conditional branch is low-confidence if its final prediction
+    // came from a weak 2-bit counter of the main predictor (not overridden by the loop predictor).  Gated fetch is either stopped or,
+    // with gate_throttle, throttled to every other cycle.
+    uint64_t gate_chkpts;
+    uint64_t gate_lowconf;
+    bool gate_throttle;
+    uint64_t lowconf_inflight;    // # unresolved low-confidence branches in the branch queue
+    bool wrong_path;              // The last instruction fetched is on the wrong path (oracle, for measurements only).
+
+    // Branch predictor: conditional and indirect branch predictors, their add-ons, and the RAS (shared with bpeval, see bpred.h).
+    bpred_t bp;
 
     // Perfect branch predictor. Note: PAY->predict() serves as the perfect branch predictor.
     bool bp_perfect;
 
+    // Fetch Target Queue (FTQ) for fetch-directed instruction prefetching (FDIP).
+    //
+    // A run-ahead copy of the branch predictor predicts one fetch bundle per cycle, ahead of the Fetch1 stage, and queues the
+    // bundles' start pcs in the FTQ.  The lines of each queued bundle are prefetched into the instruction cache, so the predictor
+    // keeps running (and prefetching) while the Fetch1 stage waits for an instruction cache miss.
+    //
+    // The run-ahead predictor reads the same BTB and prediction tables as the Fetch1 stage, but has its own pc, BHRs, and RAS
+    // (pushes are kept in ra_ras; returns past them read the real RAS below its TOS at the restart), so it never disturbs the Fetch1 stage's
+    // speculative state.  The Fetch1 stage still predicts each bundle that it fetches: if it fetches the FTQ head, the head is popped;
+    // otherwise (the run-ahead predictor took another path, e.g., its tables were trained in between) and after a misfetch,
+    // misprediction, or complete squash, the FTQ is flushed and the run-ahead predictor restarts from the Fetch1 stage's state.
+    uint64_t ftq_size;            // FTQ entries (0: no FTQ)
+    std::deque<uint64_t> ftq;     // Start pcs of the predicted fetch bundles.  The head is the next bundle the Fetch1 stage should fetch.
+    bool ftq_resync;              // Restart the run-ahead predictor from the Fetch1 stage's state.
+    uint64_t ra_pc;               // Run-ahead predictor: pc of the next bundle to predict,
+    uint64_t ra_cb_bhr;           //                      BHRs,
+    uint64_t ra_ib_bhr;
+    uint64_t ra_ghist;
+    std::vector<uint64_t> ra_ras; //                      return addresses it pushed,
+    uint64_t ra_ras_tos;          //                      and the real RAS's TOS for returns past them.
+    fetch_bundle_t *ra_bundle;    //                      Its fetch bundle (BTB part only).
+
+    // FTQ measurements.
+    uint64_t meas_ftq_cycles;     // # cycles
+    uint64_t meas_ftq_occupancy;  // sum of FTQ occupancy over the cycles
+    uint64_t meas_ftq_full;       // # cycles the run-ahead predictor stalled because the FTQ was full
+    uint64_t meas_ftq_fetched;    // # fetched bundles
+    uint64_t meas_ftq_hit;        // # fetched bundles that were the FTQ head
+    uint64_t meas_ftq_flush;      // # times a non-empty FTQ was flushed
+    uint64_t meas_ftq_pf_lines;   // # lines of queued bundles that missed the I$ tag probe, i.e., prefetch candidates
+
     ////////////////////////////////////////////////////////////////
     // Fetch2 Stage.
     ////////////////////////////////////////////////////////////////
 
-    // Pipeline register between the Fetch1 and Fetch2 stages.
-    pipeline_register *FETCH2;
+    // Pipeline register between the Fetch1 and Fetch2 stages: FETCH2[b] holds the b'th fetch bundle of the cycle.
+    pipeline_register *FETCH2[MAX_FETCH_BUNDLES];
 
-    // Information about the fetch bundle in the Fetch2 stage.
-    fetch2_status_t fetch2_status;
+    // Information about the fetch bundle(s) in the Fetch2 stage.
+    fetch2_status_t fetch2_status[MAX_FETCH_BUNDLES];
 
     // Branch queue for keeping track of all outstanding branch predictions.
     bq_t bq;
 
     // Measurements.
-    uint64_t meas_branch_n;  // # branches
-    uint64_t meas_jumpdir_n; // # jumps, direct
-    uint64_t meas_calldir_n; // # calls, direct
-    uint64_t meas_jumpind_n; // # jumps, indirect
-    uint64_t meas_callind_n; // # calls, indirect
-    uint64_t meas_jumpret_n; // # jumps, return
+    uint64_t meas_btbmiss; // # of btb misses, i.e., number of discarded fetch bundles (idle fetch cycles) due to a btb miss within the bundle
+    uint64_t meas_btb_l2_hit;     // # of fetched bundles with branches that missed in the BTB and hit in the L2 BTB
+    uint64_t meas_btb_l2_bubbles; // # of cycles the Fetch1 stage waited for the L2 BTB
 
-    uint64_t meas_branch_m;  // # mispredicted branches
-    uint64_t meas_jumpind_m; // # mispredicted jumps, indirect
-    uint64_t meas_callind_m; // # mispredicted calls, indirect
-    uint64_t meas_jumpret_m; // # mispredicted jumps, return
+    uint64_t meas_uop_switch;     // # of switches from the micro-op cache to the decoders
+    uint64_t meas_uop_bubbles;    // # of cycles the Fetch1 stage waited for a switch to the decoders
 
-    uint64_t meas_jumpind_seq; // # jump-indirect instructions whose targets were the next sequential PC
+    uint64_t meas_fetch_cycles;        // # of cycles the Fetch2 stage passed fetch bundles to the Decode stage
+    uint64_t meas_fetch_bundles;       // # of fetch bundles passed to the Decode stage
+    uint64_t meas_fetch_instr;         // # of instructions passed to the Decode stage
+    uint64_t meas_fetch_bank_conflict; // # of cycles a second fetch bundle was not fetched due to an I$ bank conflict
+    uint64_t meas_fetch_loop_stop;     // # of cycles a second fetch bundle was not fetched because the first one hit in the loop predictor
+    uint64_t meas_fetch_wp_instr;      // # of wrong-path instructions passed to the Decode stage
 
-    uint64_t meas_btbmiss; // # of btb misses, i.e., number of discarded fetch bundles (idle fetch cycles) due to a btb miss within the bundle
+    uint64_t meas_gate_chkpts;    // # of cycles fetch was gated because few checkpoints were free,
+    uint64_t meas_gate_lowconf;   // # ... because many low-confidence branches were unresolved (both may hold in a cycle),
+    uint64_t meas_gate_cycles;    // # ... in all (throttled: only the cycles fetch was skipped),
+    uint64_t meas_gate_wp_cycles; //   # ... while fetch was on the wrong path.
 
     ////////////////////////////
     // Private functions.
     ////////////////////////////
 
-    // Function for speculatively updating the pc, BHRs, and RAS, based on the assembled fetch bundle.
-    void spec_update(spec_update_t *update, uint64_t cb_predictions);
+    // Function for predicting and supplying the b'th fetch bundle of the cycle (see fetch1()).
+    bool fetch1_bundle(cycle_t cycle, uint64_t b);
 
-    // Function for transferring the fetch bundle into (1) the PAY buffer and (2) the FETCH2 pipeline register.
-    void transfer_fetch_bundle();
+    // Function for transferring the fetch bundle, fetched in the given cycle, into (1) the PAY buffer and (2) the b'th fetch bundle of the FETCH2 pipeline register.
+    void transfer_fetch_bundle(cycle_t cycle, uint64_t b);
 
     // Function for squashing the Fetch2 stage, i.e., invalidate all instructions in the FETCH2 pipeline register and reset fetch2_status.
-    void squash_fetch2();
+    // Only the fetch bundles from the first'th one on are squashed.
+    void squash_fetch2(uint64_t first = 0);
+
+    // FTQ functions.
+    // ftq_predict(): The run-ahead predictor predicts the next fetch bundle, queues it in the FTQ, and prefetches its lines.
+    // ftq_flush(): Discard the FTQ and restart the run-ahead predictor from the Fetch1 stage's (restored) state.
+    void ftq_predict(cycle_t cycle);
+    void ftq_flush();
 
 public:
     fetchunit_t(uint64_t instr_per_cycle,                      // "n"
                 uint64_t cond_branch_per_cycle,                // "m"
+                uint64_t bundles_per_cycle,                    // fetch bundles per cycle (1 or 2)
                 uint64_t btb_entries,                          // total number of entries in the BTB
                 uint64_t btb_assoc,                            // set-associativity of the BTB
+                uint64_t btb_l2_entries,                       // total number of entries in the L2 BTB (0: no L2 BTB)
+                uint64_t btb_l2_assoc,                         // set-associativity of the L2 BTB
+                uint64_t btb_l2_latency,                       // extra fetch cycles (bubbles) when a branch misses in the BTB and hits in the L2 BTB
                 uint64_t cb_pc_length, uint64_t cb_bhr_length, // gshare cond. br. predictor: pc length (index size), bhr length
                 uint64_t ib_pc_length, uint64_t ib_bhr_length, // gshare indirect br. predictor: pc length (index size), bhr length
+                uint64_t tage_kb,                              // TAGE cond. br. predictor: budget in KB (0: use the gshare predictor instead)
+                uint64_t tage_tables,                          // TAGE: number of tagged tables
+                uint64_t tage_min_hist, uint64_t tage_max_hist, // TAGE: shortest and longest history lengths
+                uint64_t perceptron_kb,                        // hashed perceptron cond. br. predictor: budget in KB (0: gshare or TAGE)
+                uint64_t perceptron_tables,                    // hashed perceptron: number of weight tables (including the bias table)
+                uint64_t perceptron_max_hist,                  // hashed perceptron: history length
+                uint64_t loop_entries,                          // loop predictor add-on: number of entries (0: none)
+                uint64_t sc_entries,                            // statistical corrector add-on: entries per table (0: none)
+                uint64_t ittage_kb,                            // ITTAGE indirect br. predictor: budget in KB (0: use the gshare predictor instead)
+                uint64_t ittage_tables,                        // ITTAGE: number of tagged tables
+                uint64_t ittage_min_hist, uint64_t ittage_max_hist, // ITTAGE: shortest and longest history lengths
                 uint64_t ras_size,                             // # entries in the RAS
                 uint64_t bq_size,                              // branch queue size (max. number of outstanding branches)
+                uint64_t ftq_size,                             // fetch target queue size (0: no fetch-directed instruction prefetching)
                 bool tc_enable,                                // enable trace cache
                 bool tc_perfect,                               // perfect trace cache (only relevant if trace cache is enabled)
+                uint64_t tc_entries,                           // real trace cache: total number of traces
+                uint64_t tc_assoc,                             // real trace cache: set-associativity
+                uint64_t uop_entries,                          // micro-op cache: total number of lines (0: no micro-op cache)
+                uint64_t uop_assoc,                            // micro-op cache: set-associativity
+                uint64_t uop_switch_penalty,                   // micro-op cache: fetch cycles (bubbles) to switch from it to the decoders
+                uint64_t gate_chkpts,                          // fetch gating: gate while fewer checkpoints are free (0: off)
+                uint64_t gate_lowconf,                         // fetch gating: gate while at least this many low-confidence branches are unresolved (0: off)
+                bool gate_throttle,                            // fetch gating: fetch every other cycle instead of stopping
                 bool bp_perfect,                               // perfect branch prediction
                 bool ic_perfect,                               // perfect instruction cache
                 uint64_t ic_sets,                              // I$ sets
@@ -150,11 +240,12 @@ public:
                 payload *PAY);                                 // (1) Payload of fetched instructions. (2) Provides a function that serves as a perfect branch predictor.
     ~fetchunit_t();
 
-    // Predict and supply a fetch bundle from either the instruction cache + BTB or the trace cache.
+    // Predict and supply a fetch bundle (or two) from either the instruction cache + BTB or the trace cache.
     // The fetch bundle is placed in the FETCH2 pipeline register that separates the Fetch1 and Fetch2 stages.
     // Checkpoint (in fetch2_status) and then speculatively update the Fetch1 stage's pc, BHRs, etc., to set up for the next fetch cycle.
-    // The caller of fetch1() passes in the current cycle so that the Fetch1 stage can model the cycle at which an instruction cache miss resolves.
-    void fetch1(cycle_t cycle);
+    // The caller of fetch1() passes in the current cycle so that the Fetch1 stage can model the cycle at which an instruction cache miss resolves,
+    // and the renamer's number of free checkpoints for fetch gating.
+    void fetch1(cycle_t cycle, uint64_t free_chkpts);
 
     // Fetch2 pipeline stage.
     // If it returns true: call fetchunit_t::fetch1() after.
@@ -184,6 +275,9 @@ public:
     // 7. Squash the fetch2_status register and FETCH2 pipeline register.
     void mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next_pc);
 
+    // A correctly predicted branch was resolved: it no longer counts as an unresolved low-confidence branch (fetch gating).
+    void resolve(uint64_t branch_pred_tag);
+
     // Commit the indicated branch from the branch queue.
     // We assert that it is at the head.
     // void commit(uint64_t branch_pred_tag);
@@ -195,9 +289,19 @@ public:
     // 3. Restore the pc.
     // 4. Go active again, whether or not currently active (restore fetch_active).
     // 5. Squash the fetch2_status register and FETCH2 pipeline register.
-    // 6. Reset ic_miss (discard pending I$ misses).
+    // 6. Reset ic_miss (discard pending I$ misses), and stop waiting for the L2 BTB or a micro-op cache switch.
     void flush(uint64_t pc);
 
+    // The Decode stage decoded the instruction at PAY index "index": fill it into the micro-op cache, if any,
+    // if its fetch bundle came from the instruction cache and missed in the micro-op cache.
+    void uop_fill(uint64_t index);
+
+    // Attach the instruction TLB (NULL: translation is free) to the instruction cache.
+    void set_itlb(tlb_t *itlb);
+
+    // Print the I$ stack-distance profile, if any (--sdp).
+    void dump_profile(FILE *fp, uint64_t num_instr);
+
     // Output all branch prediction measurements.
     void output(uint64_t num_instr, uint64_t num_cycles, FILE *fp);
 
@@ -31,15 +31,29 @@ struct {
 } fetch_bundle_t;
 
 
+// How the add-ons to the conditional branch predictor (loop predictor, statistical corrector) changed its "m" predictions.
+typedef
+struct {
+	uint64_t main;			// The main predictor's (gshare or TAGE) "m" packed 2-bit counters, before the add-ons.
+	uint64_t sc;			// Bit i: the statistical corrector reverted the i'th main prediction.
+	uint64_t loop;			// Bit i: the loop predictor was confident about the i'th conditional branch,
+	uint64_t loop_taken;		//        predicted it taken,
+	uint64_t loop_used;		//        and provided the final prediction.
+} cb_addon_t;
+
+
 typedef
 struct {
 	bool valid;			// There is a fetch bundle in the Fetch2 stage.
 	uint64_t pc;			// PC of the fetch bundle.
 	uint64_t cb_bhr;		// Conditional branch predictor's BHR prior to the fetch bundle.
 	uint64_t ib_bhr;		// Indirect branch predictor's BHR prior to the fetch bundle.
+	uint64_t ghist;			// Position of the long global history (TAGE) prior to the fetch bundle.
 	uint64_t ras_tos;		// TOS pointer into the RAS prior to the fetch bundle.
 	uint64_t pay_checkpoint;	// Checkpoint of where PAY was at, prior to the fetch bundle.
 	bool tc_hit;			// If true, the fetch bundle came from the trace cache, else it came from the instruction cache.
+	bool uop_hit;			// If true, the fetch bundle (from the instruction cache) hit in the micro-op cache.
+	cb_addon_t cb_addon;		// How the conditional branch predictor's add-ons changed its predictions for the fetch bundle.
 } fetch2_status_t;
 
 
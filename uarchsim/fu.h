@@ -12,4 +12,14 @@ typedef enum {
 	NUMBER_FU_TYPES
 } fu_type;
 
+// Macro-op fusion rules (see pipeline_t::fuse()).  FUSION (parameters.h) is a bit mask of them.
+typedef enum {
+	FUSE_LUI,	// lui rd + addi(w) rd,rd: load a 32-bit immediate
+	FUSE_AUIPC,	// auipc rd + jalr rd,rd: pc-relative call or jump
+	FUSE_CMPBR,	// slt(i)(u) rd + beq/bne rd,x0: compare and branch
+	NUM_FUSE_RULES
+} fuse_rule_e;
+
+static const char* const fuse_rule_name[NUM_FUSE_RULES] = {"lui", "auipc", "cmpbr"};
+
 #endif //FU_H
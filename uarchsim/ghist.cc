@@ -0,0 +1,70 @@
+#include <cinttypes>
+#include <cassert>
+#include "ghist.h"
+
+ghist_t::ghist_t(uint64_t log2_size) {
+   assert(log2_size >= 6);
+   word_mask = ((1ULL << (log2_size - 6)) - 1);
+   buf = new uint64_t[word_mask + 1];
+   for (uint64_t i = 0; i <= word_mask; i++)
+      buf[i] = 0;
+   pos = 0;
+}
+
+ghist_t::~ghist_t() {
+}
+
+uint64_t ghist_t::size() {
+   return((word_mask + 1) << 6);
+}
+
+uint64_t ghist_t::bits(uint64_t p, uint64_t n) {
+   uint64_t word = ((p >> 6) & word_mask);
+   uint64_t offset = (p & 63);
+   uint64_t x = (buf[word] >> offset);
+
+   if ((offset + n) > 64)
+      x |= (buf[(word + 1) & word_mask] << (64 - offset));
+   return(x & ((1ULL << n) - 1));
+}
+
+// Function to update the history.
+void ghist_t::update_bhr(bool taken) {
+   pos = update_my_bhr(pos, taken);
+}
+
+// Function to update a user-provided position.
+uint64_t ghist_t::update_my_bhr(uint64_t my_pos, bool taken) {
+   uint64_t word = ((my_pos >> 6) & word_mask);
+   uint64_t bit = (1ULL << (my_pos & 63));
+
+   buf[word] = (taken ? (buf[word] | bit) : (buf[word] & ~bit));
+   return(my_pos + 1);
+}
+
+// Functions to get and set the position, e.g., for checkpoint/restore purposes.
+
+uint64_t ghist_t::get_bhr() {
+   return(pos);
+}
+
+void ghist_t::set_bhr(uint64_t pos) {
+   this->pos = pos;
+}
+
+// Fold the "length" outcomes before position p into "width" bits, by xor-ing consecutive "width"-bit chunks.
+// Positions before the first outcome (p < length) wrap around the buffer, which is initially all not-taken.
+uint64_t ghist_t::fold(uint64_t p, uint64_t length, uint64_t width) {
+   uint64_t x = 0;
+   uint64_t q = (p - length);
+
+   assert((width > 0) && (width <= 32));
+   while (length >= width) {
+      x ^= bits(q, width);
+      q += width;
+      length -= width;
+   }
+   if (length)
+      x ^= bits(q, length);
+   return(x);
+}
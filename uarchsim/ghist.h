@@ -0,0 +1,38 @@
+
+// Long global branch history for the TAGE-style predictors.
+//
+// gshare_index_t keeps its BHR in a uint64_t, which is checkpointed whole.  The tagged predictors use histories hundreds of branches
+// long, so here the history is a circular bit buffer and its state is just the position of the next outcome (the number of outcomes
+// so far).  Checkpointing the history is saving the position, and restoring it is setting the position back: the outcomes before it
+// are still in the buffer, provided the buffer is longer than the longest history used plus the maximum number of outcomes
+// in flight (see bpred_t::bpred_t()).
+//
+// The get/set/update functions mirror those of gshare_index_t, so a position is checkpointed alongside each BHR.
+class ghist_t {
+private:
+	uint64_t *buf;		// the outcomes, one bit each: outcome at position p is bit (p & 63) of word ((p >> 6) & word_mask)
+	uint64_t word_mask;
+	uint64_t pos;		// position of the next outcome
+
+	// Get "n" (at most 32) outcomes starting at position p; the outcome at p is the lsb.
+	uint64_t bits(uint64_t p, uint64_t n);
+
+public:
+	ghist_t(uint64_t log2_size);	// the buffer holds 2^log2_size outcomes (log2_size >= 6)
+	~ghist_t();
+
+	uint64_t size();
+
+	// Function to update the history.
+	void update_bhr(bool taken);
+
+	// Function to update a user-provided position: writes the outcome at that position and returns the next position.
+	uint64_t update_my_bhr(uint64_t my_pos, bool taken);
+
+	// Functions to get and set the position, e.g., for checkpoint/restore purposes.
+	uint64_t get_bhr();
+	void set_bhr(uint64_t pos);
+
+	// Fold (xor) the "length" outcomes before position p into "width" (at most 32) bits.
+	uint64_t fold(uint64_t p, uint64_t length, uint64_t width);
+};
@@ -179,6 +179,35 @@ double HistogramClass::Variance()
 	return( ( samp * sumSq - ((double) sum) * sum ) / (samp * samp) );
 }
 
+int HistogramClass::Percentile(double fraction)
+/*------------------------------------------------------------------------*\
+ | Returns the smallest bin such that at least 'fraction' (0..1) of the
+ |  samples are in it or in lower bins.  A result of Bins()-1 means the
+ |  percentile is in the last bin, i.e., that value or higher.
+\*------------------------------------------------------------------------*/
+{
+	double target;
+	long long cum;
+	int i;
+
+	target = fraction * Samples();
+	for (cum=0, i=0; i<(len-1); i++) {
+		cum = cum + hist[i];
+		if ((double)cum >= target) {
+			return(i);
+		}
+	}
+	return(len-1);
+}
+
+int HistogramClass::Bins()
+/*------------------------------------------------------------------------*\
+ | Returns the number of bins in the histogram.
+\*------------------------------------------------------------------------*/
+{
+	return(len);
+}
+
 void HistogramClass::Print(FILE* fp, unsigned int norm_value)
 /*------------------------------------------------------------------------*\
  | Prints out the histogram data to the output stream specified.
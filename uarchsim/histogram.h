@@ -93,6 +93,18 @@ public:
 	 | SumSq().
 	\*------------------------------------------------------------------------*/
 
+	int Percentile(double fraction);
+	/*------------------------------------------------------------------------*\
+	 | Returns the smallest bin such that at least 'fraction' (0..1) of the
+	 |  samples are in it or in lower bins.  A result of Bins()-1 means the
+	 |  percentile is in the last bin, i.e., that value or higher.
+	\*------------------------------------------------------------------------*/
+
+	int Bins();
+	/*------------------------------------------------------------------------*\
+	 | Returns the number of bins in the histogram.
+	\*------------------------------------------------------------------------*/
+
 	void Print(FILE* fp, unsigned int norm_value = 0);
 	/*------------------------------------------------------------------------*\
 	 | Prints out the histogram data to the output stream specified.
@@ -2,8 +2,10 @@
 #include "mmu.h"
 
 #include "CacheClass.h"
+#include "parameters.h"
 #include "fetchunit_types.h"
 #include "ic.h"
+#include "tlb.h"
 
 
 ic_t::ic_t(bool perfect,
@@ -22,8 +24,13 @@ ic_t::ic_t(bool perfect,
    this->perfect = perfect;
    this->mmu = mmu;
    IC = new CacheClass(sets, assoc, line_size, hit_latency, miss_latency, num_MHSRs, miss_srv_ports, miss_srv_latency, proc, "l1_ic", L2C);
+   if (L2C)
+      L2C->add_upper_level(IC);
+   if (SDP_MIN_SETS)
+      IC->set_profiler(new stack_dist_t(line_size, SDP_MIN_SETS, SDP_MAX_SETS, SDP_MAX_ASSOC));
    this->line_size = line_size;
    this->fetch_width = fetch_width;
+   itlb = (tlb_t *)NULL;
 
    // fetch_width: number of instructions in a full fetch bundle.
    // line_size: log2 the line size (where line size is in bytes).
@@ -38,6 +45,10 @@ ic_t::ic_t(bool perfect,
 ic_t::~ic_t() {
 }
 
+void ic_t::dump_profile(FILE *fp, uint64_t num_instr) {
+   IC->dump_profile(fp, num_instr);
+}
+
 // Inputs:
 // 1. cycle: This is the current cycle.
 // 2. pc: This is the start PC of the fetch bundle.
@@ -51,18 +62,42 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
    uint64_t line1, line2;
    bool hit1, hit2;
    cycle_t resolve_cycle1, resolve_cycle2;
+   cycle_t tlb_ready;
+
+   //////////////////////////////////////////////////////
+   // Model ITLB misses.
+   //////////////////////////////////////////////////////
+
+   if (itlb) {
+      // Translate the page of each line fetched (the second line may be in the next page).
+      tlb_ready = itlb->Translate(cycle, pc);
+      line2 = (pc >> line_size) + 1;
+      if (itlb->vpn(line2 << line_size) != itlb->vpn(pc))
+         tlb_ready = MAX(tlb_ready, itlb->Translate(cycle, (line2 << line_size)));
+
+      if (tlb_ready > cycle) {
+         miss_resolve_cycle = tlb_ready;
+         return(false);	// ITLB miss: treated like an I$ miss that resolves when the translation is available.
+      }
+   }
 
    //////////////////////////////////////////////////////
    // Model I$ misses.
    //////////////////////////////////////////////////////
 
    if (!perfect) {
-      // Model an interleaved I$ with two banks: fetch two consecutive lines, starting with the line that the pc falls within.
+      // Model an interleaved I$ (IC_BANKS banks): fetch two consecutive lines, starting with the line that the pc falls within.
       line1 = (pc >> line_size);
       line2 = (pc >> line_size) + 1;
       resolve_cycle1 = IC->Access(0, cycle, (line1 << line_size), false, &hit1);
       resolve_cycle2 = IC->Access(0, cycle, (line2 << line_size), false, &hit2);
 
+      // The L2 may refuse a line (no free MHSR): retry it the next cycle.
+      if (resolve_cycle1 == -1)
+         resolve_cycle1 = (cycle + 1);
+      if (resolve_cycle2 == -1)
+         resolve_cycle2 = (cycle + 1);
+
       if (!hit1 || !hit2) {
          miss_resolve_cycle = MAX((hit1 ? (cycle_t)0 : resolve_cycle1), (hit2 ? (cycle_t)0 : resolve_cycle2));
          assert(miss_resolve_cycle > cycle);
@@ -93,3 +128,53 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
 
    return(true);	// I$ hit, and the miss_resolve_cycle is a dont-care.
 }
+
+// Inputs:
+// 1. pc1: This is the start PC of the first fetch bundle of the cycle.
+// 2. pc2: This is the start PC of the second fetch bundle of the cycle.
+//
+// Each bundle accesses two consecutive lines, in two different banks.  Both bundles may access the same line (one read serves both),
+// but not two different lines in the same bank.
+bool ic_t::bank_conflict(uint64_t pc1, uint64_t pc2) {
+   uint64_t line1, line2;
+
+   if (perfect)
+      return(false);
+
+   line1 = (pc1 >> line_size);
+   line2 = (pc2 >> line_size);
+   for (uint64_t i = 0; i < 2; i++)
+      for (uint64_t j = 0; j < 2; j++)
+         if (((line1 + i) != (line2 + j)) && (((line1 + i) % IC_BANKS) == ((line2 + j) % IC_BANKS)))
+            return(true);
+   return(false);
+}
+
+// Inputs:
+// 1. cycle: This is the current cycle.
+// 2. pc: This is the start PC of a fetch bundle that the Fetch1 stage is predicted to fetch later.
+//
+// The same two lines as lookup() are prefetched.  A line is skipped if it is already in the I$ (a tag probe, which
+// filters most requests), or if its page is not yet translated by the ITLB (the translation is started, though).
+// Lines being loaded, and prefetches the I$ drops for lack of MHSRs, are counted in the I$'s own prefetch measurements.
+unsigned int ic_t::prefetch(cycle_t cycle, uint64_t pc) {
+   uint64_t line[2];
+   bool hit;
+   unsigned int n = 0;
+
+   if (perfect)
+      return(0);
+
+   line[0] = (pc >> line_size);
+   line[1] = (pc >> line_size) + 1;
+   for (unsigned int i = 0; i < 2; i++) {
+      IC->Access(0, cycle, (line[i] << line_size), false, &hit, true);
+      if (hit)
+         continue;
+      n++;
+      if (itlb && (itlb->Translate(cycle, (line[i] << line_size)) > cycle))
+         continue;
+      IC->Prefetch(0, cycle, (line[i] << line_size));
+   }
+   return(n);
+}
@@ -1,4 +1,9 @@
 
+class tlb_t;
+
+// Number of I$ banks.  Lines are interleaved across the banks, so the two consecutive lines of a fetch bundle are always in different banks.
+#define IC_BANKS	4
+
 class ic_t {
 private:
 	bool perfect;		// If true, I$ always hits.
@@ -6,6 +11,7 @@ private:
 	CacheClass *IC;		// Instruction cache.
 	uint64_t line_size;	// Log2 of line size (where line size is in bytes).
 	uint64_t fetch_width;	// Number of instructions in a full fetch bundle. We assert that (fetch_width == (1 << (line_size - 2))). The 2 is for a 4-byte instr.
+	tlb_t *itlb;		// Instruction TLB (NULL: translation is free).
 
 public:
 	ic_t(bool perfect, 
@@ -23,5 +29,18 @@ public:
 	     CacheClass *L2C);
 	~ic_t();
 
+	void set_tlb(tlb_t *itlb) { this->itlb = itlb; }
+
+	// Print the I$ stack-distance profile, if any (--sdp).
+	void dump_profile(FILE *fp, uint64_t num_instr);
+
 	bool lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &miss_resolve_cycle);
+
+	// Two fetch bundles per cycle: returns true if lookup() of pc2 would access a bank that lookup() of pc1 accesses for a different line,
+	// so they cannot both be fetched in the same cycle.
+	bool bank_conflict(uint64_t pc1, uint64_t pc2);
+
+	// Fetch-directed prefetch: start loading the lines that lookup() of the same pc will access.
+	// Returns the number of those lines that were not in the I$ (and were handed to it as prefetches).
+	unsigned int prefetch(cycle_t cycle, uint64_t pc);
 };
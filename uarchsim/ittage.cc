@@ -0,0 +1,247 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+#include <cmath>
+#include "ghist.h"
+#include "ittage.h"
+
+ittage_t::ittage_t(ghist_t *ghist, uint64_t budget_kb, uint64_t num_tables, uint64_t min_hist, uint64_t max_hist) {
+   uint64_t budget_bits = (budget_kb << 13);
+   uint64_t entry_bits;
+   uint64_t i;
+
+   this->ghist = ghist;
+
+   assert((num_tables >= 2) && (num_tables <= ITTAGE_MAX_TABLES));
+   assert((min_hist >= 1) && (min_hist < max_hist));
+   this->num_tables = num_tables;
+
+   // Geometric history lengths, from min_hist (table 0) to max_hist (the last table).
+   // Tag widths increase with history length, from 9 to 15 bits: a wrong target costs as much as a wrong direction, so tags are longer than TAGE's.
+   for (i = 0; i < num_tables; i++) {
+      hist_length[i] = (uint64_t)(min_hist * pow((double)max_hist / (double)min_hist, (double)i / (double)(num_tables - 1)) + 0.5);
+      if ((i > 0) && (hist_length[i] <= hist_length[i-1]))
+         hist_length[i] = (hist_length[i-1] + 1);
+      tag_bits[i] = (9 + ((6 * i) / (num_tables - 1)));
+   }
+
+   // Size the tables from the budget: the largest log_size such that the tagged tables (2^log_size entries each, with a 64-bit
+   // target, a 2-bit confidence counter, a 2-bit useful counter and a tag) and the base table (2^log_size 64-bit targets) fit.
+   entry_bits = 64;
+   for (i = 0; i < num_tables; i++)
+      entry_bits += (64 + 2 + 2 + tag_bits[i]);
+   log_size = 0;
+   while ((entry_bits << (log_size + 1)) <= budget_bits)
+      log_size++;
+   assert(log_size >= 4);	// budget too small
+
+   base_mask = ((1ULL << log_size) - 1);
+   base = new uint64_t[base_mask + 1];
+   for (i = 0; i <= base_mask; i++)
+      base[i] = 0;
+
+   for (i = 0; i < num_tables; i++) {
+      table[i] = new ittage_entry_t[1ULL << log_size];
+      for (uint64_t j = 0; j < (1ULL << log_size); j++) {
+         table[i][j].target = 0;
+         table[i][j].tag = 0;
+         table[i][j].ctr = 0;
+         table[i][j].u = 0;
+      }
+   }
+
+   use_alt_on_na = 0;
+   num_updates = 0;
+   rand_state = 0x9E3779B97F4A7C15ULL;
+
+   for (i = 0; i <= ITTAGE_MAX_TABLES; i++) {
+      meas_provider[0][i] = meas_provider[1][i] = 0;
+      meas_provider_m[0][i] = meas_provider_m[1][i] = 0;
+   }
+   meas_use_alt = 0;
+   meas_alloc = 0;
+   meas_alloc_fail = 0;
+}
+
+ittage_t::~ittage_t() {
+}
+
+uint64_t ittage_t::max_history() {
+   return(hist_length[num_tables - 1]);
+}
+
+void ittage_t::lookup(uint64_t pc, uint64_t hist, ittage_lookup_t &l) {
+   uint64_t key = (pc >> 2);
+   uint64_t index_mask = ((1ULL << log_size) - 1);
+   uint64_t i;
+   ittage_entry_t *e;
+
+   l.base_index = (key & base_mask);
+   for (i = 0; i < num_tables; i++) {
+      l.index[i] = ((key ^ (key >> (log_size - (i % log_size))) ^ ghist->fold(hist, hist_length[i], log_size)) & index_mask);
+      l.tag[i] = ((key ^ ghist->fold(hist, hist_length[i], tag_bits[i]) ^ (ghist->fold(hist, hist_length[i], tag_bits[i] - 1) << 1)) & ((1ULL << tag_bits[i]) - 1));
+   }
+
+   // The provider is the hitting table with the longest history, and the alternate is the hitting table with the next longest history.
+   l.provider = num_tables;
+   l.alt = num_tables;
+   for (i = num_tables; i > 0; i--) {
+      if (table[i-1][l.index[i-1]].tag == l.tag[i-1]) {
+         if (l.provider == num_tables) {
+            l.provider = (i - 1);
+         }
+         else {
+            l.alt = (i - 1);
+            break;
+         }
+      }
+   }
+
+   l.alt_target = ((l.alt < num_tables) ? table[l.alt][l.index[l.alt]].target : base[l.base_index]);
+   if (l.provider < num_tables) {
+      e = &(table[l.provider][l.index[l.provider]]);
+      l.provider_target = e->target;
+      l.use_alt = ((e->ctr == 0) && (use_alt_on_na >= 0));
+      l.target = (l.use_alt ? l.alt_target : l.provider_target);
+   }
+   else {
+      l.provider_target = l.alt_target;
+      l.use_alt = false;
+      l.target = l.alt_target;
+   }
+}
+
+uint64_t ittage_t::random() {
+   rand_state ^= (rand_state << 13);
+   rand_state ^= (rand_state >> 7);
+   rand_state ^= (rand_state << 17);
+   return(rand_state);
+}
+
+uint64_t ittage_t::predict(uint64_t pc, uint64_t hist) {
+   ittage_lookup_t l;
+
+   lookup(pc, hist, l);
+   return(l.target);
+}
+
+void ittage_t::update(uint64_t pc, uint64_t hist, uint64_t target, bool call) {
+   ittage_lookup_t l;
+   ittage_entry_t *e;
+   uint64_t i;
+
+   // Re-reference the predictor with the same context that was used to predict the branch.
+   lookup(pc, hist, l);
+
+   // Measurements.
+   i = ((l.provider < num_tables) ? l.provider : ITTAGE_MAX_TABLES);
+   meas_provider[call ? 1 : 0][i]++;
+   if (l.target != target)
+      meas_provider_m[call ? 1 : 0][i]++;
+   if (l.use_alt)
+      meas_use_alt++;
+
+   // Learn whether to trust zero-confidence (newly allocated) providers.
+   if ((l.provider < num_tables) && (table[l.provider][l.index[l.provider]].ctr == 0) && (l.provider_target != l.alt_target)) {
+      if (l.alt_target == target) {
+         if (use_alt_on_na < 7)
+	    use_alt_on_na++;
+      }
+      else if ((l.provider_target == target) && (use_alt_on_na > -8)) {
+         use_alt_on_na--;
+      }
+   }
+
+   // Allocate on a misprediction, in one of the tables with a longer history than the provider whose entry is not useful:
+   // the shortest such table, or with probability 1/2 the next shortest one, to spread allocations.
+   // If all of the entries are useful, age them instead.
+   if ((l.target != target) && ((l.provider == num_tables) || (l.provider < (num_tables - 1)))) {
+      uint64_t start = ((l.provider == num_tables) ? 0 : (l.provider + 1));
+      uint64_t victim = num_tables;
+
+      for (i = start; i < num_tables; i++) {
+         if (table[i][l.index[i]].u == 0) {
+	    if (victim == num_tables) {
+	       victim = i;
+	       if (random() & 1)
+	          break;
+	    }
+	    else {
+	       victim = i;
+	       break;
+	    }
+	 }
+      }
+
+      if (victim == num_tables) {
+	 meas_alloc_fail++;
+         for (i = start; i < num_tables; i++)
+	    table[i][l.index[i]].u--;
+      }
+      else {
+	 meas_alloc++;
+         e = &(table[victim][l.index[victim]]);
+	 e->tag = l.tag[victim];
+	 e->target = target;
+	 e->ctr = 0;
+	 e->u = 0;
+      }
+   }
+
+   // Update the provider: gain confidence in a correct target; lose confidence in a wrong one, and replace it once confidence is zero.
+   if (l.provider < num_tables) {
+      e = &(table[l.provider][l.index[l.provider]]);
+      if (e->target == target) {
+         if (e->ctr < 3)
+	    e->ctr++;
+      }
+      else if (e->ctr > 0) {
+         e->ctr--;
+      }
+      else {
+         e->target = target;
+      }
+
+      // The provider is useful if it was right where the alternate was wrong.
+      if (l.provider_target != l.alt_target) {
+         if ((l.provider_target == target) && (e->u < 3))
+	    e->u++;
+	 else if ((l.provider_target != target) && (e->u > 0))
+	    e->u--;
+      }
+   }
+
+   // The base table always learns the last target.
+   if ((l.provider == num_tables) || (l.target != target))
+      base[l.base_index] = target;
+
+   // Graceful reset: periodically halve all useful counters, so that stale entries become replaceable.
+   num_updates++;
+   if ((num_updates & ((1ULL << ITTAGE_U_RESET_PERIOD) - 1)) == 0) {
+      for (i = 0; i < num_tables; i++)
+         for (uint64_t j = 0; j < (1ULL << log_size); j++)
+	    table[i][j].u >>= 1;
+   }
+}
+
+#define ITTAGE_MR(n, m) (100.0 * ((double)(m) / (double)(n)))
+
+void ittage_t::output(FILE *fp) {
+   uint64_t bits = (64ULL << log_size);
+
+   for (uint64_t i = 0; i < num_tables; i++)
+      bits += ((64 + 2 + 2 + tag_bits[i]) << log_size);
+
+   fprintf(fp, "ITTAGE MEASUREMENTS (%lu tagged tables x %lu entries, %.1f KB)----\n", num_tables, ((uint64_t)1 << log_size), (double)bits / 8192.0);
+   fprintf(fp, "                      |------ Jump Indirect ------| |------ Call Indirect ------|\n");
+   fprintf(fp, "Provider   hist  tag           n          m     mr          n          m     mr\n");
+   fprintf(fp, "base          0    0  %10lu %10lu %5.2lf%% %10lu %10lu %5.2lf%%\n",
+           meas_provider[0][ITTAGE_MAX_TABLES], meas_provider_m[0][ITTAGE_MAX_TABLES], ITTAGE_MR(meas_provider[0][ITTAGE_MAX_TABLES], meas_provider_m[0][ITTAGE_MAX_TABLES]),
+           meas_provider[1][ITTAGE_MAX_TABLES], meas_provider_m[1][ITTAGE_MAX_TABLES], ITTAGE_MR(meas_provider[1][ITTAGE_MAX_TABLES], meas_provider_m[1][ITTAGE_MAX_TABLES]));
+   for (uint64_t i = 0; i < num_tables; i++)
+      fprintf(fp, "T%-2lu      %5lu %4lu  %10lu %10lu %5.2lf%% %10lu %10lu %5.2lf%%\n", i + 1, hist_length[i], tag_bits[i],
+              meas_provider[0][i], meas_provider_m[0][i], ITTAGE_MR(meas_provider[0][i], meas_provider_m[0][i]),
+              meas_provider[1][i], meas_provider_m[1][i], ITTAGE_MR(meas_provider[1][i], meas_provider_m[1][i]));
+   fprintf(fp, "Final predictions from the alternate (zero-confidence provider) = %lu\n", meas_use_alt);
+   fprintf(fp, "Allocations = %lu, failed allocations = %lu\n", meas_alloc, meas_alloc_fail);
+}
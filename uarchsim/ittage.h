@@ -0,0 +1,89 @@
+
+#define ITTAGE_MAX_TABLES	16
+#define ITTAGE_U_RESET_PERIOD	18	// log2 of the number of updates between graceful resets of the useful counters
+
+// One entry of an ITTAGE tagged table.
+typedef
+struct {
+   uint64_t target;
+   uint16_t tag;
+   uint8_t ctr;    // 2-bit confidence counter
+   uint8_t u;      // 2-bit useful counter
+} ittage_entry_t;
+
+// The result of looking up an indirect branch target prediction.
+typedef
+struct {
+   uint64_t base_index;
+   uint64_t index[ITTAGE_MAX_TABLES];
+   uint64_t tag[ITTAGE_MAX_TABLES];
+   uint64_t provider;	// table that provided the prediction (num_tables: none, i.e., the base table)
+   uint64_t alt;	// next table that hit, after the provider (num_tables: none, i.e., the base table)
+   uint64_t provider_target;
+   uint64_t alt_target;
+   bool use_alt;	// the provider's confidence is zero (newly allocated), and the alternate target was used instead
+   uint64_t target;	// final prediction
+} ittage_lookup_t;
+
+
+// ITTAGE indirect branch target predictor: a tagless base table of targets plus "num_tables" tagged tables of full targets,
+// indexed with geometrically increasing lengths of global history (A. Seznec, "A 64-Kbytes ITTAGE indirect branch predictor").
+//
+// It is a drop-in replacement for the gshare predictor of indirect branches, so it keeps the Fetch Unit's prediction model:
+// one lookup per fetch bundle, with the bundle's pc and the global history prior to the bundle, supplies the target used if the
+// bundle ends at a jump indirect or call indirect.  The predictor is trained at retirement with the same {pc, history} context.
+//
+// The global history is the ghist_t shared with TAGE, which the Fetch Unit checkpoints and restores (so it is repaired on a
+// misprediction, see fetchunit_t::mispredict()).  Like the gshare BHRs, it holds conditional branch outcomes only.
+class ittage_t {
+private:
+	ghist_t *ghist;
+
+	// Base predictor: the last target of each (bundle) pc.
+	uint64_t *base;
+	uint64_t base_mask;
+
+	// Tagged tables.
+	uint64_t num_tables;
+	uint64_t log_size;			// log2 of the number of entries in each tagged table
+	ittage_entry_t *table[ITTAGE_MAX_TABLES];
+	uint64_t hist_length[ITTAGE_MAX_TABLES];	// table 0 uses the shortest history
+	uint64_t tag_bits[ITTAGE_MAX_TABLES];
+
+	// The alternate target is used instead of a zero-confidence (newly allocated) provider's target, if this 4-bit signed counter is >= 0.
+	int8_t use_alt_on_na;
+
+	// Graceful reset of the useful counters, every 2^ITTAGE_U_RESET_PERIOD updates.
+	uint64_t num_updates;
+
+	// Pseudo-random number generator for choosing among tables for allocation.
+	uint64_t rand_state;
+
+	// Measurements, at retirement, for jump indirects [0] and call indirects [1].
+	uint64_t meas_provider[2][ITTAGE_MAX_TABLES + 1];	// # predictions provided by each tagged table (the last one counts the base table)
+	uint64_t meas_provider_m[2][ITTAGE_MAX_TABLES + 1];	// # ... that were wrong
+	uint64_t meas_use_alt;					// # final predictions that were the alternate target
+	uint64_t meas_alloc;					// # entries allocated
+	uint64_t meas_alloc_fail;				// # mispredictions that could not allocate an entry
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	void lookup(uint64_t pc, uint64_t hist, ittage_lookup_t &l);
+	uint64_t random();
+
+public:
+	ittage_t(ghist_t *ghist, uint64_t budget_kb, uint64_t num_tables, uint64_t min_hist, uint64_t max_hist);
+	~ittage_t();
+
+	uint64_t max_history();
+
+	// Get the predicted target for the fetch bundle at pc, using the history prior to the bundle (position "hist" in ghist).
+	uint64_t predict(uint64_t pc, uint64_t hist);
+
+	// Train the predictor with the target of the jump indirect or call indirect that ended the fetch bundle {pc, hist}.
+	void update(uint64_t pc, uint64_t hist, uint64_t target, bool call);
+
+	void output(FILE *fp);
+};
@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+#include "looppred.h"
+
+loop_predictor_t::loop_predictor_t(uint64_t entries, uint64_t m) {
+   sets = (entries / LOOP_ASSOC);
+   assert((sets > 0) && ((sets & (sets - 1)) == 0));
+   table = new loop_entry_t[sets * LOOP_ASSOC];
+   for (uint64_t i = 0; i < (sets * LOOP_ASSOC); i++)
+      table[i].valid = false;
+
+   pos_bits = 0;
+   while ((1ULL << pos_bits) < m)
+      pos_bits++;
+
+   use = 0;
+   meas_alloc = 0;
+   meas_reset = 0;
+}
+
+loop_predictor_t::~loop_predictor_t() {
+}
+
+loop_entry_t *loop_predictor_t::search(uint64_t pc, uint64_t pos, uint64_t &tag) {
+   uint64_t key = (((pc >> 2) << pos_bits) | pos);
+   uint64_t set = (key & (sets - 1));
+   loop_entry_t *e;
+
+   tag = ((key / sets) & 0x3fff);	// 14-bit tags
+   for (uint64_t way = 0; way < LOOP_ASSOC; way++) {
+      e = &(table[(set * LOOP_ASSOC) + way]);
+      if (e->valid && (e->tag == tag))
+         return(e);
+   }
+   return(NULL);
+}
+
+bool loop_predictor_t::predict(uint64_t pc, uint64_t pos, bool &taken) {
+   uint64_t tag;
+   loop_entry_t *e = search(pc, pos, tag);
+
+   if (!e || (e->conf < LOOP_CONF_MAX))
+      return(false);
+   taken = (((e->spec_iter + 1) > e->past_iter) ? !e->dir : e->dir);
+   return(true);
+}
+
+bool loop_predictor_t::useful() {
+   return(use >= 0);
+}
+
+void loop_predictor_t::spec_update(uint64_t pc, uint64_t pos, bool taken, int64_t &entry, uint64_t &iter) {
+   uint64_t tag;
+   loop_entry_t *e = search(pc, pos, tag);
+
+   if (!e) {
+      entry = -1;
+      return;
+   }
+   entry = (e - table);
+   iter = e->spec_iter;
+   e->spec_iter = ((taken == e->dir) ? (e->spec_iter + 1) : 0);
+}
+
+void loop_predictor_t::spec_restore(int64_t entry, uint64_t iter) {
+   // The entry may have been reallocated to another loop since; its speculative count is then resynchronized by spec_reset() or the next exit.
+   if (entry >= 0)
+      table[entry].spec_iter = iter;
+}
+
+void loop_predictor_t::spec_reset() {
+   for (uint64_t i = 0; i < (sets * LOOP_ASSOC); i++)
+      table[i].spec_iter = table[i].ret_iter;
+}
+
+void loop_predictor_t::update(uint64_t pc, uint64_t pos, bool taken, bool main_taken, bool confident, bool loop_taken) {
+   uint64_t tag;
+   loop_entry_t *e = search(pc, pos, tag);
+
+   // Learn whether to trust the loop predictor over the main predictor.
+   if (confident && (loop_taken != main_taken)) {
+      if (loop_taken == taken) {
+         if (use < 63)
+	    use++;
+      }
+      else if (use > -64) {
+         use--;
+      }
+   }
+
+   if (e) {
+      if (taken == e->dir) {
+         e->ret_iter++;
+	 if ((e->conf > 0) && (e->ret_iter > e->past_iter)) {
+	    // The loop ran longer than its trip count.
+	    meas_reset++;
+	    e->conf = 0;
+	 }
+      }
+      else {
+         // Loop exit.
+	 if ((e->past_iter > 0) && (e->ret_iter == e->past_iter)) {
+	    if (e->conf < LOOP_CONF_MAX)
+	       e->conf++;
+	    if (e->age < 7)
+	       e->age++;
+	 }
+	 else {
+	    if (e->conf > 0)
+	       meas_reset++;
+	    e->past_iter = e->ret_iter;
+	    e->conf = 0;
+	    if (e->past_iter == 0) {
+	       // Not a loop branch: it did not go in "dir" before going the other way.  Free the entry.
+	       e->valid = false;
+	       return;
+	    }
+	 }
+         e->ret_iter = 0;
+      }
+   }
+   else if (taken != main_taken) {
+      // Allocate on a misprediction by the main predictor: the branch may be a loop exit, so "dir" is the other direction.
+      uint64_t key = (((pc >> 2) << pos_bits) | pos);
+      uint64_t set = (key & (sets - 1));
+      loop_entry_t *victim = NULL;
+
+      for (uint64_t way = 0; way < LOOP_ASSOC; way++) {
+         e = &(table[(set * LOOP_ASSOC) + way]);
+	 if (!e->valid || (e->age == 0)) {
+	    victim = e;
+	    break;
+	 }
+      }
+      if (victim) {
+         meas_alloc++;
+         victim->valid = true;
+	 victim->tag = tag;
+	 victim->dir = !taken;
+	 victim->past_iter = 0;
+	 victim->ret_iter = 0;
+	 victim->spec_iter = 0;
+	 victim->conf = 0;
+	 victim->age = 7;
+      }
+      else {
+         for (uint64_t way = 0; way < LOOP_ASSOC; way++)
+	    table[(set * LOOP_ASSOC) + way].age--;
+      }
+   }
+}
+
+void loop_predictor_t::output(FILE *fp) {
+   uint64_t confident = 0;
+
+   for (uint64_t i = 0; i < (sets * LOOP_ASSOC); i++)
+      if (table[i].valid && (table[i].conf == LOOP_CONF_MAX))
+         confident++;
+   fprintf(fp, "Loop predictor: %lu entries (%lu-way), %lu allocated, %lu lost confidence, %lu confident at the end, %s\n",
+           (sets * LOOP_ASSOC), (uint64_t)LOOP_ASSOC, meas_alloc, meas_reset, confident, (useful() ? "in use" : "not in use"));
+}
@@ -0,0 +1,77 @@
+
+#define LOOP_ASSOC	4
+#define LOOP_CONF_MAX	3	// confidence at which the loop predictor predicts
+
+// One loop predictor entry.
+typedef
+struct {
+   bool valid;
+   uint64_t tag;
+   bool dir;            // direction of the branch within the loop (the exit is the other direction)
+   uint64_t past_iter;  // trip count: number of "dir" outcomes before the exit, in the last run of the loop
+   uint64_t ret_iter;   // number of "dir" outcomes retired in the current run
+   uint64_t spec_iter;  // ... and speculatively fetched (>= ret_iter)
+   uint64_t conf;       // number of consecutive runs with the same trip count (up to LOOP_CONF_MAX)
+   uint64_t age;        // replacement: decremented when allocation finds no free entry
+} loop_entry_t;
+
+
+// Loop predictor add-on to the conditional branch predictor (as in L-TAGE: A. Seznec, "A 256 Kbits L-TAGE branch predictor").
+//
+// Each entry learns the trip count of a loop branch: how many times it goes in one direction before it exits in the other.
+// Once the same trip count has repeated LOOP_CONF_MAX times, the loop predictor predicts the branch from its iteration count,
+// overriding the main predictor (if the loop predictor has been more accurate than the main predictor when they disagreed).
+//
+// Like the main predictors, it predicts the bundle's i'th conditional branch from the bundle's pc combined with i.
+//
+// The iteration count must be speculative, since many iterations of a loop may be in flight.  Each conditional branch pushed
+// onto the branch queue (fetchunit_t::fetch2()) advances its entry's speculative count and records the previous count in its
+// branch queue entry.  A misprediction undoes the updates of the squashed branches, youngest first (spec_restore()), and a
+// complete squash resets the speculative counts to the retired counts.  The retired counts and trip counts are trained at retirement.
+class loop_predictor_t {
+private:
+	loop_entry_t *table;
+	uint64_t sets;
+	uint64_t pos_bits;	// number of bits used to combine the position of a prediction with the pc
+
+	// The loop predictor is used only if this 7-bit signed counter is >= 0: it counts whether the loop predictor or the main predictor
+	// was right when they disagreed.
+	int64_t use;
+
+	// Measurements.
+	uint64_t meas_alloc;	// # entries allocated
+	uint64_t meas_reset;	// # entries that lost their confidence, because a run did not match the trip count
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	loop_entry_t *search(uint64_t pc, uint64_t pos, uint64_t &tag);
+
+public:
+	loop_predictor_t(uint64_t entries, uint64_t m);
+	~loop_predictor_t();
+
+	// Predict the pos'th conditional branch of the fetch bundle at pc.  Returns true if confident, with the prediction in "taken".
+	bool predict(uint64_t pc, uint64_t pos, bool &taken);
+
+	// Whether the confident predictions should override the main predictor.
+	bool useful();
+
+	// Speculative update by a conditional branch pushed onto the branch queue, with its predicted (or, after a misprediction, corrected) outcome.
+	// "entry" and "iter" record the updated entry (or -1 if none) and its previous speculative count, for spec_restore().
+	void spec_update(uint64_t pc, uint64_t pos, bool taken, int64_t &entry, uint64_t &iter);
+
+	// Undo a speculative update.
+	void spec_restore(int64_t entry, uint64_t iter);
+
+	// After a complete squash, no branches are in flight: the speculative counts are the retired counts.
+	void spec_reset();
+
+	// Train with the outcome of a retired conditional branch.
+	// "main_taken" is the prediction of the main predictor (after the statistical corrector), "confident" and "loop_taken" are the
+	// loop predictor's prediction at fetch.
+	void update(uint64_t pc, uint64_t pos, bool taken, bool main_taken, bool confident, bool loop_taken);
+
+	void output(FILE *fp);
+};
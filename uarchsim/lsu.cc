@@ -119,6 +119,18 @@ bool lsu::ld_violation(unsigned int sq_index,
 void lsu::set_l2_cache(CacheClass *l2_dc)
 {
     DC->set_nextLevel(l2_dc);
+    if (l2_dc)
+        l2_dc->add_upper_level(DC);
+}
+
+void lsu::set_dtlb(tlb_t *dtlb)
+{
+    DTLB = dtlb;
+}
+
+CacheClass *lsu::get_dcache()
+{
+    return (DC);
 }
 
 lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t *_mmu, pipeline_t *_proc) : proc(_proc),
@@ -137,7 +149,32 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t *_m
                         L1_DC_MISS_SRV_LATENCY,
                         _proc,
                         "l1_dc",
-                        _proc->L2C);
+                        _proc->L2C,
+                        (repl_policy_e)L1_DC_REPL_POLICY);
+    DC->set_mhsr_targets(L1_DC_MHSR_TARGETS, true);
+    if (L1_DC_PREFETCHER != PF_NONE)
+        DC->set_prefetcher(new_prefetcher((pf_kind_e)L1_DC_PREFETCHER, L1_DC_LINE_SIZE, L1_DC_PF_DEGREE), true);
+    if (L1_DC_VICTIM_ENTRIES)
+        DC->set_victim_cache(L1_DC_VICTIM_ENTRIES, L1_DC_VICTIM_LATENCY);
+    if (SDP_MIN_SETS)
+        DC->set_profiler(new stack_dist_t(L1_DC_LINE_SIZE, SDP_MIN_SETS, SDP_MAX_SETS, SDP_MAX_ASSOC));
+
+    // Set by the pipeline when there is a DTLB (set_dtlb()).
+    DTLB = (tlb_t *)NULL;
+
+    // D$ port and bank arbitration.
+    dc_arb_cycle = -1;
+    dc_ports_used = 0;
+    dc_bank_cycle = new cycle_t[MAX(L1_DC_BANKS, 1)];
+    dc_bank_line = new reg_t[MAX(L1_DC_BANKS, 1)];
+    for (unsigned int i = 0; i < MAX(L1_DC_BANKS, 1); i++)
+    {
+        dc_bank_cycle[i] = -1;
+        dc_bank_line[i] = 0;
+    }
+
+    // Store buffer initialization.
+    sb_size = STORE_BUFFER_SIZE;
 
     // LQ initialization.
     this->lq_size = lq_size;
@@ -178,11 +215,81 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t *_m
     n_false_stall = 0;
     n_load_violation = 0;
     n_cpr_deadlock_kluge = 0;
+    n_mhsr_none_free_l = 0;
+    n_mhsr_none_free_s = 0;
+    n_mhsr_targets_full_l = 0;
+    n_mhsr_targets_full_s = 0;
+    n_dc_bank_conflict_l = 0;
+    n_dc_bank_conflict_s = 0;
+    n_dc_port_conflict_l = 0;
+    n_dc_port_conflict_s = 0;
+    n_dc_bank_conflict_events = 0;
+    n_dc_port_conflict_events = 0;
+    n_dtlb_miss_l = 0;
+    n_dtlb_miss_s = 0;
+    ckpt_load_misses = 0;
+    ckpt_miss_hist = new HistogramClass(CKPT_MISS_HIST_BINS);
+    n_sb_forward = 0;
+    n_sb_alloc = 0;
+    n_sb_coalesced = 0;
+    n_sb_drain_hits = 0;
+    n_sb_drain_misses = 0;
+    n_sb_drain_retries = 0;
+    n_sb_full_stalls = 0;
+    n_rfo_issued = 0;
+    n_rfo_present = 0;
+    n_rfo_dropped = 0;
+    n_rfo_redundant = 0;
+    n_rfo_timely = 0;
+    n_rfo_late = 0;
+    n_rfo_lost = 0;
+    sb_occupancy = 0;
+    sb_cycles = 0;
+    sb_stall_cycle = -1;
 }
 
 lsu::~lsu()
 {
     delete DC;
+    delete[] dc_bank_cycle;
+    delete[] dc_bank_line;
+    delete ckpt_miss_hist;
+}
+
+dc_arb_e lsu::dc_arbitrate(cycle_t cycle, reg_t addr)
+{
+    unsigned int bank;
+    reg_t line;
+
+    if (cycle != dc_arb_cycle)
+    {
+        dc_arb_cycle = cycle;
+        dc_ports_used = 0;
+    }
+
+    if (L1_DC_PORTS && (dc_ports_used >= L1_DC_PORTS))
+    {
+        n_dc_port_conflict_events++;
+        return (DC_ARB_PORT_CONFLICT);
+    }
+
+    if (L1_DC_BANKS > 1)
+    {
+        // Banks are interleaved on 2^L1_DC_BANK_INTERLEAVE bytes. A bank reads or writes
+        // one line per cycle: a second access to the same line is served by the same read.
+        bank = (unsigned int)((addr >> L1_DC_BANK_INTERLEAVE) & (L1_DC_BANKS - 1));
+        line = (addr >> L1_DC_LINE_SIZE);
+        if ((dc_bank_cycle[bank] == cycle) && (dc_bank_line[bank] != line))
+        {
+            n_dc_bank_conflict_events++;
+            return (DC_ARB_BANK_CONFLICT);
+        }
+        dc_bank_cycle[bank] = cycle;
+        dc_bank_line[bank] = line;
+    }
+
+    dc_ports_used++;
+    return (DC_ARB_GRANT);
 }
 
 bool lsu::stall(unsigned int bundle_load, unsigned int bundle_store)
@@ -242,6 +349,14 @@ void lsu::dispatch(bool load,
         LQ[lq_tail].stat_load_violation = false;
         LQ[lq_tail].stat_late_store_match = false;
         LQ[lq_tail].stat_cpr_deadlock_kluge = false;
+        LQ[lq_tail].stat_mhsr_none_free = false;
+        LQ[lq_tail].stat_mhsr_targets_full = false;
+        LQ[lq_tail].stat_dc_bank_conflict = false;
+        LQ[lq_tail].stat_dc_port_conflict = false;
+        LQ[lq_tail].stat_sb_forward = false;
+        LQ[lq_tail].stat_dtlb_miss = false;
+        LQ[lq_tail].dc_replay = false;
+        LQ[lq_tail].tlb_ready = 0;
 
 #ifdef RISCV_MICRO_DEBUG
         LOG(proc->lsu_log, proc->cycle, proc->PAY.buf[pay_index].sequence, proc->PAY.buf[pay_index].pc, "Dispatching load lq entry %u", lq_tail);
@@ -285,6 +400,16 @@ void lsu::dispatch(bool load,
         SQ[sq_tail].stat_load_violation = false;
         SQ[sq_tail].stat_late_store_match = false;
         SQ[sq_tail].stat_cpr_deadlock_kluge = false;
+        SQ[sq_tail].stat_mhsr_none_free = false;
+        SQ[sq_tail].stat_mhsr_targets_full = false;
+        SQ[sq_tail].stat_dc_bank_conflict = false;
+        SQ[sq_tail].stat_dc_port_conflict = false;
+        SQ[sq_tail].stat_sb_forward = false;
+        SQ[sq_tail].stat_dtlb_miss = false;
+        SQ[sq_tail].dc_replay = false;
+        SQ[sq_tail].rfo_ready = -1;
+        SQ[sq_tail].rfo_fetched = false;
+        SQ[sq_tail].tlb_ready = 0;
 
 #ifdef RISCV_MICRO_DEBUG
         LOG(proc->lsu_log, proc->cycle, proc->PAY.buf[pay_index].sequence, proc->PAY.buf[pay_index].pc, "Dispatching store sq entry %u", sq_tail);
@@ -376,16 +501,31 @@ void lsu::store_addr(cycle_t cycle,
         }
     }
 
-    if (!PERFECT_DCACHE)
-    {
-        bool hit;
-        SQ[sq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, true, &hit);
-        SQ[sq_index].missed = !hit;
+    // Translate the store address.
+    SQ[sq_index].tlb_ready = (DTLB ? DTLB->Translate(cycle, addr) : cycle);
+    if (SQ[sq_index].tlb_ready > cycle)
+        SQ[sq_index].stat_dtlb_miss = true;
 
-        if (!hit)
-            inc_counter(spec_store_miss_count);
-        if (SQ[sq_index].miss_resolve_cycle == -1)
-            inc_counter(store_mhsr_miss_count);
+    // With a store buffer, the store writes the D$ after it commits (sb_drain()).
+    // A read-for-ownership may bring the line in meanwhile, if the store's translation is available.
+    // Without one, a store whose translation missed in the DTLB accesses the D$ from store_replay().
+    if (!PERFECT_DCACHE && !sb_size)
+    {
+        if (SQ[sq_index].tlb_ready > cycle)
+            SQ[sq_index].dc_replay = true;
+        else
+            store_access(cycle, sq_index);
+    }
+    else if (!PERFECT_DCACHE && STORE_RFO && (SQ[sq_index].tlb_ready <= cycle))
+    {
+        SQ[sq_index].rfo_ready = DC->Prefetch(Tid, cycle, addr, true);
+        SQ[sq_index].rfo_fetched = (SQ[sq_index].rfo_ready > cycle);
+        if (SQ[sq_index].rfo_ready == -1)
+            n_rfo_dropped++;
+        else if (SQ[sq_index].rfo_fetched)
+            n_rfo_issued++;
+        else
+            n_rfo_present++;
     }
 
 #ifdef RISCV_MICRO_DEBUG
@@ -394,6 +534,77 @@ void lsu::store_addr(cycle_t cycle,
 #endif
 }
 
+bool lsu::dc_grant_load(cycle_t cycle, unsigned int lq_index)
+{
+    dc_arb_e arb = dc_arbitrate(cycle, LQ[lq_index].addr);
+
+    if (arb == DC_ARB_GRANT)
+        return (true);
+
+    // Same as a refused miss: the load stalls until load_unstall() gets it into the D$.
+    LQ[lq_index].missed = true;
+    LQ[lq_index].miss_resolve_cycle = -1;
+    if (arb == DC_ARB_BANK_CONFLICT)
+        LQ[lq_index].stat_dc_bank_conflict = true;
+    else
+        LQ[lq_index].stat_dc_port_conflict = true;
+    return (false);
+}
+
+void lsu::store_access(cycle_t cycle, unsigned int sq_index)
+{
+    bool hit;
+    mhsr_status_e mhsr_status;
+    dc_arb_e arb;
+
+    // A store that loses D$ arbitration is replayed by store_replay().
+    arb = dc_arbitrate(cycle, SQ[sq_index].addr);
+    SQ[sq_index].dc_replay = (arb != DC_ARB_GRANT);
+    if (arb == DC_ARB_BANK_CONFLICT)
+        SQ[sq_index].stat_dc_bank_conflict = true;
+    else if (arb == DC_ARB_PORT_CONFLICT)
+        SQ[sq_index].stat_dc_port_conflict = true;
+    if (SQ[sq_index].dc_replay)
+        return;
+
+    SQ[sq_index].miss_resolve_cycle = DC->Access(Tid, cycle, SQ[sq_index].addr, true, &hit, false, true, &mhsr_status);
+    SQ[sq_index].missed = !hit;
+    if (SQ[sq_index].miss_resolve_cycle != -1)
+        DC->Train(Tid, cycle, proc->PAY.buf[SQ[sq_index].pay_index].pc, SQ[sq_index].addr);
+
+    if (!hit)
+        inc_counter(spec_store_miss_count);
+    if (SQ[sq_index].miss_resolve_cycle == -1)
+    {
+        inc_counter(store_mhsr_miss_count);
+        if (mhsr_status == MHSR_TARGETS_FULL)
+            SQ[sq_index].stat_mhsr_targets_full = true;
+        else
+            SQ[sq_index].stat_mhsr_none_free = true;
+    }
+}
+
+void lsu::store_replay(cycle_t cycle)
+{
+    // Replay the stores that lost D$ arbitration or whose translation has become available,
+    // oldest first, until one loses again.
+    unsigned int scan = sq_head;
+    bool scan_phase = sq_head_phase;
+    while (!((scan == sq_tail) && (scan_phase == sq_tail_phase)))
+    {
+        assert(SQ[scan].valid);
+        if (SQ[scan].dc_replay && (cycle >= SQ[scan].tlb_ready))
+        {
+            store_access(cycle, scan);
+            if (SQ[scan].dc_replay)
+                break;
+        }
+        scan = MOD_S((scan + 1), sq_size);
+        if (scan == 0) // wrap-around, i.e., phase change
+            scan_phase = !scan_phase;
+    }
+}
+
 void lsu::store_value(unsigned int sq_index, reg_t value)
 {
     assert(SQ[sq_index].valid);
@@ -421,11 +632,24 @@ bool lsu::load_addr(cycle_t cycle,
     dump_lq(proc, lq_index, proc->lsu_log);
 #endif
 
-    if (!PERFECT_DCACHE)
+    // Translate the load address. A load whose translation missed in the DTLB stalls like a
+    // refused D$ miss, and load_unstall() accesses the D$ once the translation is available.
+    LQ[lq_index].tlb_ready = (DTLB ? DTLB->Translate(cycle, addr) : cycle);
+    if (LQ[lq_index].tlb_ready > cycle)
+    {
+        LQ[lq_index].missed = true;
+        LQ[lq_index].miss_resolve_cycle = -1;
+        LQ[lq_index].stat_dtlb_miss = true;
+    }
+    // A load that loses D$ arbitration is replayed by load_unstall().
+    else if (!PERFECT_DCACHE && dc_grant_load(cycle, lq_index))
     {
         bool hit;
-        LQ[lq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, false, &hit);
+        mhsr_status_e mhsr_status;
+        LQ[lq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, false, &hit, false, true, &mhsr_status);
         LQ[lq_index].missed = !hit;
+        if (LQ[lq_index].miss_resolve_cycle != -1)
+            DC->Train(Tid, cycle, proc->PAY.buf[LQ[lq_index].pay_index].pc, addr);
         if (!hit)
         {
             inc_counter(spec_load_miss_count);
@@ -433,6 +657,10 @@ bool lsu::load_addr(cycle_t cycle,
         if (LQ[lq_index].miss_resolve_cycle == -1)
         {
             inc_counter(load_mhsr_miss_count);
+            if (mhsr_status == MHSR_TARGETS_FULL)
+                LQ[lq_index].stat_mhsr_targets_full = true;
+            else
+                LQ[lq_index].stat_mhsr_none_free = true;
         }
     }
 
@@ -454,13 +682,25 @@ bool lsu::load_unstall(cycle_t cycle, unsigned int &pay_index, reg_t &value)
         assert(LQ[scan].valid);
         if (LQ[scan].addr_avail && !LQ[scan].value_avail)
         {
-            // If this load did not get an MHSR during initial execution, access the D$ again.
-            if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1))
+            // If this load did not get an MHSR (or a target slot in the line's MHSR), lost D$ arbitration,
+            // or was waiting for its translation, during initial execution, access the D$ again.
+            if (LQ[scan].missed && (LQ[scan].miss_resolve_cycle == -1) && (cycle >= LQ[scan].tlb_ready) && PERFECT_DCACHE)
+            {
+                LQ[scan].missed = false;
+            }
+            else if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1) && (cycle >= LQ[scan].tlb_ready) && dc_grant_load(cycle, scan))
             {
                 bool hit;
+                mhsr_status_e mhsr_status;
                 assert(LQ[scan].addr_avail);
-                LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit);
+                LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit, false, true, &mhsr_status);
                 LQ[scan].missed = !hit;
+                if (LQ[scan].miss_resolve_cycle != -1)
+                    DC->Train(Tid, cycle, proc->PAY.buf[LQ[scan].pay_index].pc, LQ[scan].addr);
+                if (mhsr_status == MHSR_TARGETS_FULL)
+                    LQ[scan].stat_mhsr_targets_full = true;
+                else if (mhsr_status == MHSR_NONE_FREE)
+                    LQ[scan].stat_mhsr_none_free = true;
             }
 
             // Check if load is unstalled.
@@ -608,7 +848,8 @@ void lsu::execute_load(cycle_t cycle,
         LQ[lq_index].value_avail = true;
     }
     // If either a hit or a miss and the line has already been loaded
-    else if (!(LQ[lq_index].missed && (cycle < LQ[lq_index].miss_resolve_cycle)))
+    else if (!(LQ[lq_index].missed && ((LQ[lq_index].miss_resolve_cycle == -1) || (cycle < LQ[lq_index].miss_resolve_cycle))) ||
+             sb_forward(lq_index))
     {
         // Load data from memory.
         // MMU takes care of checking whether memory within bounds, throws exception otherwise.
@@ -820,6 +1061,23 @@ void lsu::train(bool load)
             n_stall_miss_l++;
         if (LQ[lq_head].stat_cpr_deadlock_kluge)
             n_cpr_deadlock_kluge++;
+        if (LQ[lq_head].stat_mhsr_none_free)
+            n_mhsr_none_free_l++;
+        if (LQ[lq_head].stat_mhsr_targets_full)
+            n_mhsr_targets_full_l++;
+        if (LQ[lq_head].stat_dc_bank_conflict)
+            n_dc_bank_conflict_l++;
+        if (LQ[lq_head].stat_dc_port_conflict)
+            n_dc_port_conflict_l++;
+        if (LQ[lq_head].stat_sb_forward)
+            n_sb_forward++;
+        if (LQ[lq_head].stat_dtlb_miss)
+            n_dtlb_miss_l++;
+        if (LQ[lq_head].missed)
+        {
+            ckpt_load_misses++;
+            inc_counter(retired_load_miss_count);
+        }
     }
     else
     {
@@ -828,6 +1086,16 @@ void lsu::train(bool load)
 
         // STATS
         n_store++;
+        if (SQ[sq_head].stat_mhsr_none_free)
+            n_mhsr_none_free_s++;
+        if (SQ[sq_head].stat_mhsr_targets_full)
+            n_mhsr_targets_full_s++;
+        if (SQ[sq_head].stat_dc_bank_conflict)
+            n_dc_bank_conflict_s++;
+        if (SQ[sq_head].stat_dc_port_conflict)
+            n_dc_port_conflict_s++;
+        if (SQ[sq_head].stat_dtlb_miss)
+            n_dtlb_miss_s++;
     }
 }
 
@@ -900,6 +1168,10 @@ bool lsu::commit(bool load, bool atomic_op)
                 //    the exception and thus block the Retire stage from calling this commit function for the store.
                 assert(0);
             }
+
+            // The store writes the D$ from the store buffer.
+            if (sb_size)
+                sb_insert();
         }
 
         // Invalidate the entry.
@@ -919,6 +1191,191 @@ bool lsu::commit(bool load, bool atomic_op)
     return (atomic_success);
 }
 
+void lsu::retire_checkpoint()
+{
+    ckpt_miss_hist->Increment(ckpt_load_misses);
+    ckpt_load_misses = 0;
+    inc_counter(retired_chkpt_count);
+}
+
+bool lsu::retire_blocked(uint64_t chkpt_id)
+{
+    // The loads of the oldest checkpoint are at the head of the LQ.
+    unsigned int scan = lq_head;
+    bool scan_phase = lq_head_phase;
+    while (!((scan == lq_tail) && (scan_phase == lq_tail_phase)))
+    {
+        assert(LQ[scan].valid);
+        if (proc->PAY.buf[LQ[scan].pay_index].Checkpoint_ID != chkpt_id)
+            break;
+        if (LQ[scan].addr_avail && !LQ[scan].value_avail && LQ[scan].missed)
+            return (true);
+        scan = MOD_S((scan + 1), lq_size);
+        if (scan == 0) // wrap-around, i.e., phase change
+            scan_phase = !scan_phase;
+    }
+    return (false);
+}
+
+bool lsu::sb_stall(cycle_t cycle)
+{
+    reg_t line;
+
+    if (!sb_size || (SB.size() < sb_size))
+        return (false);
+
+    // A full store buffer still accepts a store that coalesces into a waiting entry.
+    assert(sq_length > 0);
+    line = (SQ[sq_head].addr >> L1_DC_LINE_SIZE);
+    for (std::deque<sb_entry>::iterator it = SB.begin(); it != SB.end(); it++)
+        if (!it->issued && (it->line == line))
+            return (false);
+
+    if (sb_stall_cycle != cycle)
+    {
+        sb_stall_cycle = cycle;
+        n_sb_full_stalls++;
+    }
+    return (true);
+}
+
+void lsu::sb_insert()
+{
+    reg_t line = (SQ[sq_head].addr >> L1_DC_LINE_SIZE);
+    unsigned int offset = (unsigned int)(SQ[sq_head].addr & ((1 << L1_DC_LINE_SIZE) - 1));
+    std::deque<sb_entry>::reverse_iterator it;
+    sb_entry e;
+
+    // Coalesce into the youngest entry of the line that has not been sent to the D$.
+    for (it = SB.rbegin(); it != SB.rend(); it++)
+    {
+        if (!it->issued && (it->line == line))
+            break;
+    }
+
+    if (it == SB.rend())
+    {
+        assert(SB.size() < sb_size);
+        e.line = line;
+        e.bytes.assign((1 << L1_DC_LINE_SIZE), false);
+        e.issued = false;
+        e.done = 0;
+        e.rfo_ready = -1;
+        e.rfo_fetched = false;
+        SB.push_back(e);
+        it = SB.rbegin();
+        n_sb_alloc++;
+    }
+    else
+    {
+        n_sb_coalesced++;
+    }
+
+    for (unsigned int i = 0; i < SQ[sq_head].size; i++)
+        it->bytes[offset + i] = true;
+    it->pc = proc->PAY.buf[SQ[sq_head].pay_index].pc;
+    // Keep the first RFO of the entry's stores, unless a later one is the one that fetched the line.
+    if ((it->rfo_ready == -1) || (SQ[sq_head].rfo_fetched && !it->rfo_fetched))
+    {
+        it->rfo_ready = SQ[sq_head].rfo_ready;
+        it->rfo_fetched = SQ[sq_head].rfo_fetched;
+    }
+}
+
+void lsu::sb_drain(cycle_t cycle)
+{
+    std::deque<sb_entry>::iterator it;
+    bool hit;
+    mhsr_status_e mhsr_status;
+    cycle_t done;
+
+    if (!sb_size)
+        return;
+
+    sb_occupancy += SB.size();
+    sb_cycles++;
+
+    // Free the oldest entries once their D$ write has completed.
+    while (!SB.empty() && SB.front().issued && (SB.front().done <= cycle))
+        SB.pop_front();
+
+    // Send the oldest waiting entry to the D$. Several entries may miss at once, each in its own MHSR.
+    for (it = SB.begin(); it != SB.end(); it++)
+    {
+        if (!it->issued)
+            break;
+    }
+    if (it == SB.end())
+        return;
+
+    if (PERFECT_DCACHE)
+    {
+        it->issued = true;
+        it->done = cycle;
+        n_sb_drain_hits++;
+        return;
+    }
+
+    if (dc_arbitrate(cycle, (it->line << L1_DC_LINE_SIZE)) != DC_ARB_GRANT)
+    {
+        n_sb_drain_retries++;
+        return;
+    }
+
+    done = DC->Access(Tid, cycle, (it->line << L1_DC_LINE_SIZE), true, &hit, false, true, &mhsr_status);
+    if (done == -1)
+    {
+        n_sb_drain_retries++;
+        return;
+    }
+    DC->Train(Tid, cycle, it->pc, (it->line << L1_DC_LINE_SIZE));
+
+    it->issued = true;
+    it->done = done;
+    if (hit)
+        n_sb_drain_hits++;
+    else
+        n_sb_drain_misses++;
+
+    // Only RFOs that fetched the line can be timely: a hit on a line that was already present is not their doing.
+    if (it->rfo_ready != -1)
+    {
+        if (!it->rfo_fetched)
+            n_rfo_redundant++;
+        else if (hit)
+            n_rfo_timely++;
+        else if (cycle < it->rfo_ready)
+            n_rfo_late++;
+        else
+            n_rfo_lost++;
+    }
+}
+
+bool lsu::sb_forward(unsigned int lq_index)
+{
+    reg_t line = (LQ[lq_index].addr >> L1_DC_LINE_SIZE);
+    unsigned int offset = (unsigned int)(LQ[lq_index].addr & ((1 << L1_DC_LINE_SIZE) - 1));
+    std::deque<sb_entry>::iterator it;
+    unsigned int i;
+    bool covered;
+
+    if (!sb_size)
+        return (false);
+
+    // Every byte of the load must have been written by a committed store still in the store buffer.
+    for (i = 0; i < LQ[lq_index].size; i++)
+    {
+        covered = false;
+        for (it = SB.begin(); (it != SB.end()) && !covered; it++)
+            covered = ((it->line == line) && it->bytes[offset + i]);
+        if (!covered)
+            return (false);
+    }
+
+    LQ[lq_index].stat_sb_forward = true;
+    return (true);
+}
+
 void lsu::flush()
 {
     // Flush LQ.
@@ -969,6 +1426,11 @@ void lsu::copy_mem(char **master_mem_table)
 }
 
 // STATS
+void lsu::dump_profile(FILE *fp, uint64_t num_insn)
+{
+    DC->dump_profile(fp, num_insn);
+}
+
 void lsu::dump_stats(FILE *fp)
 {
     int addr_stall = (n_true_stall + n_false_stall);
@@ -1005,16 +1467,110 @@ void lsu::dump_stats(FILE *fp)
     fprintf(fp, "cpr deadlock kluge = %d (%.2f%%)\n",
             n_cpr_deadlock_kluge,
             100.0 * (double)n_cpr_deadlock_kluge / (double)n_load);
+    fprintf(fp, "  MHSR retry: none free    = %d (%.2f%%)\n",
+            n_mhsr_none_free_l,
+            100.0 * (double)n_mhsr_none_free_l / (double)n_load);
+    fprintf(fp, "  MHSR retry: targets full = %d (%.2f%%)\n",
+            n_mhsr_targets_full_l,
+            100.0 * (double)n_mhsr_targets_full_l / (double)n_load);
 
     fprintf(fp, "STORES (retired)\n");
     fprintf(fp, "  stores           = %d\n", n_store);
     fprintf(fp, "  miss stall       = %d (%.2f%%)\n",
             n_stall_miss_s,
             100.0 * (double)n_stall_miss_s / (double)n_store);
+    fprintf(fp, "  MHSR refused: none free    = %d (%.2f%%)\n",
+            n_mhsr_none_free_s,
+            100.0 * (double)n_mhsr_none_free_s / (double)n_store);
+    fprintf(fp, "  MHSR refused: targets full = %d (%.2f%%)\n",
+            n_mhsr_targets_full_s,
+            100.0 * (double)n_mhsr_targets_full_s / (double)n_store);
+
+    if (L1_DC_PORTS || (L1_DC_BANKS > 1))
+    {
+        fprintf(fp, "D$ PORTS/BANKS (%u port(s), %u bank(s))\n", L1_DC_PORTS, MAX(L1_DC_BANKS, 1));
+        fprintf(fp, "  loads replayed: bank conflict  = %d (%.2f%%)\n",
+                n_dc_bank_conflict_l,
+                100.0 * (double)n_dc_bank_conflict_l / (double)n_load);
+        fprintf(fp, "  loads replayed: port conflict  = %d (%.2f%%)\n",
+                n_dc_port_conflict_l,
+                100.0 * (double)n_dc_port_conflict_l / (double)n_load);
+        fprintf(fp, "  stores replayed: bank conflict = %d (%.2f%%)\n",
+                n_dc_bank_conflict_s,
+                100.0 * (double)n_dc_bank_conflict_s / (double)n_store);
+        fprintf(fp, "  stores replayed: port conflict = %d (%.2f%%)\n",
+                n_dc_port_conflict_s,
+                100.0 * (double)n_dc_port_conflict_s / (double)n_store);
+        fprintf(fp, "  arbitration losses (all, incl. replays): bank = %" PRIu64 ", port = %" PRIu64 "\n",
+                n_dc_bank_conflict_events, n_dc_port_conflict_events);
+    }
+
+    if (DTLB)
+    {
+        fprintf(fp, "DTLB\n");
+        fprintf(fp, "  loads waited for translation  = %d (%.2f%%)\n",
+                n_dtlb_miss_l,
+                100.0 * (double)n_dtlb_miss_l / (double)n_load);
+        fprintf(fp, "  stores waited for translation = %d (%.2f%%)\n",
+                n_dtlb_miss_s,
+                100.0 * (double)n_dtlb_miss_s / (double)n_store);
+    }
+
+    if (sb_size)
+    {
+        fprintf(fp, "STORE BUFFER (%u entries)\n", sb_size);
+        fprintf(fp, "  entries allocated          = %" PRIu64 "\n", n_sb_alloc);
+        fprintf(fp, "  stores coalesced           = %" PRIu64 " (%.2f%%)\n",
+                n_sb_coalesced,
+                100.0 * (double)n_sb_coalesced / (double)(n_sb_alloc + n_sb_coalesced));
+        fprintf(fp, "  D$ writes: hits            = %" PRIu64 "\n", n_sb_drain_hits);
+        fprintf(fp, "  D$ writes: misses          = %" PRIu64 "\n", n_sb_drain_misses);
+        fprintf(fp, "  D$ write retries           = %" PRIu64 "\n", n_sb_drain_retries);
+        fprintf(fp, "  avg. occupancy             = %.2f\n", (double)sb_occupancy / (double)sb_cycles);
+        fprintf(fp, "  bulk commit stalls (full)  = %" PRIu64 " cycles\n", n_sb_full_stalls);
+        fprintf(fp, "  loads forwarded (D$ miss)  = %d (%.2f%%)\n",
+                n_sb_forward,
+                100.0 * (double)n_sb_forward / (double)n_load);
+        if (STORE_RFO)
+        {
+            uint64_t n_rfo_drained = (n_rfo_timely + n_rfo_late + n_rfo_lost);
+            fprintf(fp, "  RFO at store address: requested = %" PRIu64 ", line present = %" PRIu64 ", dropped = %" PRIu64 "\n",
+                    n_rfo_issued, n_rfo_present, n_rfo_dropped);
+            fprintf(fp, "  RFO redundant (present)    = %" PRIu64 " (drains not counted below)\n",
+                    n_rfo_redundant);
+            fprintf(fp, "  RFO timely (hit at drain)  = %" PRIu64 " (%.2f%%)\n",
+                    n_rfo_timely,
+                    100.0 * (double)n_rfo_timely / (double)n_rfo_drained);
+            fprintf(fp, "  RFO late (in flight)       = %" PRIu64 " (%.2f%%)\n",
+                    n_rfo_late,
+                    100.0 * (double)n_rfo_late / (double)n_rfo_drained);
+            fprintf(fp, "  RFO lost (evicted)         = %" PRIu64 " (%.2f%%)\n",
+                    n_rfo_lost,
+                    100.0 * (double)n_rfo_lost / (double)n_rfo_drained);
+        }
+    }
+
+    if (ckpt_miss_hist->Samples())
+    {
+        uint64_t overlapped = (ckpt_miss_hist->Sum() - (uint64_t)ckpt_miss_hist->Bin(1));
+        fprintf(fp, "CHECKPOINT INTERVALS (D$ misses of the retired loads)\n");
+        fprintf(fp, "  retired checkpoints        = %d\n", ckpt_miss_hist->Samples());
+        fprintf(fp, "  avg. misses per checkpoint = %.2f\n", ckpt_miss_hist->Average());
+        fprintf(fp, "  misses in checkpoints with >= 2 misses = %.2f%%\n",
+                100.0 * (double)overlapped / (double)ckpt_miss_hist->Sum());
+        fprintf(fp, "  histogram (misses, checkpoints; last bin is %d or more):\n", (CKPT_MISS_HIST_BINS - 1));
+        for (int i = 0; i < CKPT_MISS_HIST_BINS; i++)
+        {
+            if (ckpt_miss_hist->Bin(i))
+                fprintf(fp, "    %3d %12d\n", i, ckpt_miss_hist->Bin(i));
+        }
+    }
 
     fprintf(fp, "MDP quick stats\n");
     fprintf(fp, "  false stalls     = %d\n", n_false_stall);
     fprintf(fp, "  load violations  = %d\n", n_load_violation);
+
+    DC->dump_stats(fp);
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -48,13 +48,56 @@ typedef struct
   bool stat_load_violation;                  // A load executed before an older conflicting store.
   bool stat_late_store_match;                // A stalled load observed an address match with a late-arriving older store.
   bool stat_cpr_deadlock_kluge;
+  bool stat_mhsr_none_free;                  // D$ miss had to retry: no free MHSR.
+  bool stat_mhsr_targets_full;               // D$ miss had to retry: the line's MHSR had no free target.
+  bool stat_dc_bank_conflict;                // D$ access had to replay: its bank was busy with a different line.
+  bool stat_dc_port_conflict;                // D$ access had to replay: all D$ ports were busy.
+  bool stat_sb_forward;                      // Load missed in the D$ and received its value from the store buffer.
+  bool stat_dtlb_miss;                       // Load or store waited for its translation (DTLB miss).
+
+  // Cycle when the DTLB has the translation of the address (valid if addr_avail).
+  cycle_t tlb_ready;
+
+  // Store lost D$ arbitration and has not accessed the D$ yet.
+  bool dc_replay;
+
+  // Cycle when the store's read-for-ownership brings its line into the D$ (-1: none).
+  cycle_t rfo_ready;
+
+  // The read-for-ownership fetched the line (false: the line was already in the D$).
+  bool rfo_fetched;
 } lsq_entry;
 
+// Single entry in the post-retirement store buffer: the committed stores to one line.
+typedef struct
+{
+  reg_t line;              // Line address.
+  std::vector<bool> bytes; // Bytes of the line written by the stores in this entry.
+  reg_t pc;                // PC of the youngest store in this entry (trains the D$ prefetcher).
+  bool issued;             // The entry has been sent to the D$; it no longer accepts stores.
+  cycle_t done;            // Cycle when the D$ write completes (valid if issued).
+  cycle_t rfo_ready;       // Cycle when a read-for-ownership of the stores brings the line in (-1: none).
+  bool rfo_fetched;        // That read-for-ownership fetched the line (false: it was already present).
+} sb_entry;
+
+// Outcome of arbitrating for a D$ port and bank.
+typedef enum
+{
+  DC_ARB_GRANT,
+  DC_ARB_BANK_CONFLICT,
+  DC_ARB_PORT_CONFLICT
+} dc_arb_e;
+
 // Forward declaring classes
 class mmu_t;
 class pipeline_t;
 class CacheClass;
 class stats_t;
+class tlb_t;
+class HistogramClass;
+
+// Checkpoint interval histogram: D$ misses of the loads retired with one checkpoint (last bin: this many or more).
+#define CKPT_MISS_HIST_BINS 33
 
 class lsu
 {
@@ -89,12 +132,29 @@ private:
   bool sq_head_phase;
   bool sq_tail_phase;
 
+  //////////////////////////
+  // Store Buffer
+  //////////////////////////
+  // Committed stores wait here, coalesced by line, until they are written into the D$.
+  // Only timing is modeled: the store value is written into memory at commit.
+  std::deque<sb_entry> SB; // Oldest entry at the front.
+  unsigned int sb_size;    // 0: no store buffer, stores access the D$ when their address is computed.
+
   //////////////////////////
   // Data Cache
   //////////////////////////
   CacheClass *DC;
   unsigned int Tid;
 
+  // Data TLB (NULL: translation is free).
+  tlb_t *DTLB;
+
+  // D$ ports and banks (L1_DC_PORTS, L1_DC_BANKS): the accesses granted in the current cycle.
+  cycle_t dc_arb_cycle;
+  unsigned int dc_ports_used;
+  cycle_t *dc_bank_cycle; // Last cycle in which each bank was granted.
+  reg_t *dc_bank_line;    // Line that each bank is reading/writing in that cycle.
+
   /////////////////////////////////////////////////////////////
   // Memory dependence predictor (MDP)
   /////////////////////////////////////////////////////////////
@@ -130,6 +190,53 @@ private:
   // Count how often there was a conflicting store and load, of different sizes, in the same checkpoint interval.
   unsigned int n_cpr_deadlock_kluge;
 
+  // Number of retired loads (l) or stores (s) whose D$ miss was refused, either for lack of a
+  // free MHSR or because the MHSR of the line had no free target slot.
+  unsigned int n_mhsr_none_free_l;
+  unsigned int n_mhsr_none_free_s;
+  unsigned int n_mhsr_targets_full_l;
+  unsigned int n_mhsr_targets_full_s;
+
+  // Number of retired loads (l) or stores (s) that lost D$ arbitration at least once, to a
+  // different line in the same bank or for lack of a free D$ port.
+  unsigned int n_dc_bank_conflict_l;
+  unsigned int n_dc_bank_conflict_s;
+  unsigned int n_dc_port_conflict_l;
+  unsigned int n_dc_port_conflict_s;
+
+  // Store buffer measurements.
+  unsigned int n_sb_forward;         // Retired loads that missed in the D$ and forwarded from the store buffer.
+  uint64_t n_sb_alloc;               // Entries allocated.
+  uint64_t n_sb_coalesced;           // Committed stores merged into an existing entry.
+  uint64_t n_sb_drain_hits;          // Entries written into the D$ that hit...
+  uint64_t n_sb_drain_misses;        // ...and that missed.
+  uint64_t n_sb_drain_retries;       // Drain attempts refused by the D$ (no MHSR) or that lost D$ arbitration.
+  uint64_t n_sb_full_stalls;         // Cycles in which bulk commit stalled because the store buffer was full.
+  uint64_t sb_occupancy;             // Sum of the number of entries over the cycles drained.
+  uint64_t sb_cycles;
+  cycle_t sb_stall_cycle;            // Last cycle counted in n_sb_full_stalls.
+
+  // Read-for-ownership measurements (STORE_RFO).
+  uint64_t n_rfo_issued;             // Stores whose address requested their line...
+  uint64_t n_rfo_present;            // ...that was already in the D$ or in flight.
+  uint64_t n_rfo_dropped;            // Requests dropped: no spare MHSR, or the L2 was busy.
+  uint64_t n_rfo_redundant;          // Store buffer entries whose RFOs all found their line present.
+  uint64_t n_rfo_timely;             // Store buffer entries whose RFO-fetched line was in the D$ when they drained...
+  uint64_t n_rfo_late;               // ...that was still in flight...
+  uint64_t n_rfo_lost;               // ...or that had been evicted again.
+
+  // Number of retired loads (l) or stores (s) that waited for their translation (DTLB miss).
+  unsigned int n_dtlb_miss_l;
+  unsigned int n_dtlb_miss_s;
+
+  // D$ misses of the retired loads of each checkpoint interval (misses that the window overlapped).
+  unsigned int ckpt_load_misses; // Loads retired so far with the oldest checkpoint that missed.
+  HistogramClass *ckpt_miss_hist;
+
+  // Number of D$ arbitration losses, including replays and squashed loads/stores.
+  uint64_t n_dc_bank_conflict_events;
+  uint64_t n_dc_port_conflict_events;
+
   //////////////////////////
   //  Private functions
   //////////////////////////
@@ -160,6 +267,23 @@ private:
                     unsigned int lq_index, bool lq_index_phase,
                     unsigned int &load_entry);
 
+  // Arbitrate for a D$ port and for the bank of 'addr' in this cycle.
+  // Accesses to the same line share the bank.
+  dc_arb_e dc_arbitrate(cycle_t cycle, reg_t addr);
+
+  // Arbitrate for the D$ access of the load in LQ entry 'lq_index'. If it loses, the load
+  // is marked as waiting for the D$ and false is returned.
+  bool dc_grant_load(cycle_t cycle, unsigned int lq_index);
+
+  // Access the D$ for the store in SQ entry 'sq_index'.
+  void store_access(cycle_t cycle, unsigned int sq_index);
+
+  // Check whether the committed stores in the store buffer cover the load in LQ entry 'lq_index'.
+  bool sb_forward(unsigned int lq_index);
+
+  // Write the store at the head of the SQ into the store buffer.
+  void sb_insert();
+
   // Allocate a chunk of memory.
   char *mem_newblock(void);
 
@@ -168,6 +292,8 @@ public:
   ~lsu();
 
   void set_l2_cache(CacheClass *l2_dc);
+  void set_dtlb(tlb_t *dtlb);
+  CacheClass *get_dcache(); // the L1 D$ (the page table walker reads PTEs through it)
 
   bool stall(unsigned int bundle_load, unsigned int bundle_store);
 
@@ -189,6 +315,13 @@ public:
                  // reg_t back_data, // LWL/LWR
                  reg_t &value);
   bool load_unstall(cycle_t cycle, unsigned int &pay_index, reg_t &value);
+  void store_replay(cycle_t cycle);
+
+  // Post-retirement store buffer.
+  // sb_stall(): true if bulk commit must wait to commit a store because the store buffer is full.
+  // sb_drain(): free the entries whose D$ write has completed and send the oldest waiting entry to the D$.
+  bool sb_stall(cycle_t cycle);
+  void sb_drain(cycle_t cycle);
 
   void checkpoint(unsigned int &chkpt_lq_tail, bool &chkpt_lq_tail_phase,
                   unsigned int &chkpt_sq_tail, bool &chkpt_sq_tail_phase);
@@ -198,6 +331,11 @@ public:
   void train(bool load);
   bool commit(bool load, bool atomic_op);
 
+  // retire_checkpoint(): the oldest checkpoint has retired; close its interval's miss count.
+  // retire_blocked(): true if a load of checkpoint chkpt_id is still waiting for the D$ (a miss, or a D$ access to replay).
+  void retire_checkpoint();
+  bool retire_blocked(uint64_t chkpt_id);
+
   void flush();
 
   void copy_mem(char **master_mem_table);
@@ -205,6 +343,7 @@ public:
   // STATS
   void set_stats(stats_t *_stats) { this->stats = _stats; }
   void dump_stats(FILE *fp);
+  void dump_profile(FILE *fp, uint64_t num_insn); // D$ stack-distance profile, if any (--sdp)
 
   void dump_lq(pipeline_t *proc, unsigned int index, FILE *file = stderr);
   void dump_sq(pipeline_t *proc, unsigned int index, FILE *file = stderr);
@@ -15,6 +15,10 @@
 #include <algorithm>
 #include "debug.h"
 #include "parameters.h"
+#include "cache.h"
+#include "prefetch.h"
+#include "CacheClass.h"
+#include "fu.h"
 #include <signal.h>
 
 static void help()
@@ -30,19 +34,32 @@ static void help()
   fprintf(stderr, "  -m<n>              Provide <n> MB of target memory\n");
   fprintf(stderr, "  -p<n>              Simulate <n> processors\n");
   fprintf(stderr, "  -s<n>              Fast skip <n> instructions before microarchitectural simulation\n");
+  fprintf(stderr, "  --bptrace=<file>   With -s: write the branches of the fast-skipped instructions to the branch trace <file>.gz (for bpeval)\n");
   fprintf(stderr, "  --perf=<pbp>,<pdc>,<pic>,<ptc>\tEach of pbp (perf. branch pred.), pdc (perf. D$), pic (perf. I$), and ptc (perf. T$), are 0 or 1\n");
   fprintf(stderr, "  --cp=<n>           <n> branch checkpoints for mispredict recovery\n");
+  fprintf(stderr, "  --misphot=<n>      At exit, list the <n> branches that lost the most cycles to mispredictions (0: off, default)\n");
 
   fprintf(stderr, "  --bq=<n>           Branch queue (all branches b/w fetch and retire) has <n> entries\n");
   fprintf(stderr, "  --btbentries=<n>   BTB has a total of <n> entries\n");
   fprintf(stderr, "  --btbassoc=<n>     BTB has a set-associativity of <n>\n");
+  fprintf(stderr, "  --btbl2=<n>[:<assoc>:<lat>]\tAdd an L2 BTB with a total of <n> entries (0: none), set-associativity <assoc>, and <lat> extra fetch cycles on an L2 BTB hit\n");
   fprintf(stderr, "  --ras=<n>          RAS has <n> entries\n");
   fprintf(stderr, "  --mbp=<n>          The conditional branch predictor (whether real or perfect) can predict a maximum of <n> conditional branches per cycle\n");
   fprintf(stderr, "  --cbpPC=<n>        The gshare-indexed conditional branch predictor uses <n> bits of PC\n");
   fprintf(stderr, "  --cbpBHR=<n>       The gshare-indexed conditional branch predictor uses <n> bits of BHR\n");
   fprintf(stderr, "  --ibpPC=<n>        The gshare-indexed indirect branch predictor uses <n> bits of PC\n");
   fprintf(stderr, "  --ibpBHR=<n>       The gshare-indexed indirect branch predictor uses <n> bits of BHR\n");
+  fprintf(stderr, "  --tage=<KB>[:<TABLES>:<MIN_HIST>:<MAX_HIST>]\tReplace the gshare conditional branch predictor with a <KB> KB TAGE predictor (0: gshare) with <TABLES> tagged tables and geometric history lengths from <MIN_HIST> to <MAX_HIST>\n");
+  fprintf(stderr, "  --perceptron=<KB>[:<TABLES>:<MAX_HIST>]\tReplace the gshare conditional branch predictor with a <KB> KB hashed perceptron (0: gshare) with <TABLES> weight tables over <MAX_HIST> outcomes of global history\n");
+  fprintf(stderr, "  --loop=<n>         Add a loop predictor with <n> entries (4-way) to the conditional branch predictor (0: none)\n");
+  fprintf(stderr, "  --sc=<n>           Add a statistical corrector with <n>-entry tables to the conditional branch predictor (0: none)\n");
+  fprintf(stderr, "  --ittage=<KB>[:<TABLES>:<MIN_HIST>:<MAX_HIST>]\tReplace the gshare indirect branch predictor with a <KB> KB ITTAGE predictor (0: gshare) with <TABLES> tagged tables and geometric history lengths from <MIN_HIST> to <MAX_HIST>\n");
   fprintf(stderr, "  -t                 Enable trace cache\n");
+  fprintf(stderr, "  --tcentries=<n>    Trace cache (if real) has a total of <n> traces\n");
+  fprintf(stderr, "  --tcassoc=<n>      Trace cache (if real) has a set-associativity of <n>\n");
+  fprintf(stderr, "  --ftq=<n>          The branch predictor runs up to <n> fetch bundles ahead of the I$, prefetching their lines (0: off)\n");
+  fprintf(stderr, "  --uopcache=<n>[:<assoc>:<penalty>]\tMicro-op cache of <n> fetch bundles (0: none), set-associativity <assoc>, and <penalty> fetch cycles to switch back to the decoders\n");
+  fprintf(stderr, "  --gate=<chkpts>:<lowconf>[:<throttle>]\tGate fetch while fewer than <chkpts> checkpoints are free (0: off) or at least <lowconf> low-confidence branches are unresolved (0: off); <throttle>=1 fetches every other cycle instead of stopping\n");
 
   fprintf(stderr, "  --fq=<n>           Fetch queue has <n> entries\n");
   fprintf(stderr, "  --al=<n>           Active List has <n> entries\n");
@@ -51,22 +68,42 @@ static void help()
   fprintf(stderr, "  --iqnp=<n>         Issue Queue has <n> partitions for round-robin partition-based priority adjustment\n");
   fprintf(stderr, "  -a                 Enable pre-steering in dispatch stage (override dynamic lane steering at issue stage)\n");
   fprintf(stderr, "  -b                 Enable ideal age-based scheduling (override position-based scheduling)\n");
+  fprintf(stderr, "  --fusion=<rules>   Macro-op fusion in the Decode Stage: comma-separated rules among lui (lui+addi), auipc (auipc+jalr), cmpbr (slt+beq/bne), or all, or none (default)\n");
   fprintf(stderr, "  --lsq=<n>          Load/Store Queue has <n> entries\n");
+  fprintf(stderr, "  --sb=<n>           Post-retirement store buffer has <n> write-combining entries (0: none, default; stores write the D$ when their address is computed)\n");
+  fprintf(stderr, "  --rfo=<0|1>        With --sb: request a store's line into the D$ (spare MHSRs only) as soon as its address is computed\n");
   fprintf(stderr, "  --disambig=<mdp_model>,<mdp_ctr_max>\t<mdp_model>: 0 (always pred. conflict), 1 (always pred. no conflict), 2 (MDP-sticky), 3 (MDP-ctr), 4 (oracle). <mdp_ctr_max>: max counter value for MDP-ctr.\n");
   fprintf(stderr, "  --fw=<n>           <n> wide fetch\n");
+  fprintf(stderr, "  --fetchbundles=<n> Fetch <n> (1 or 2) consecutive fetch bundles per cycle (decode width is <n> times the fetch width)\n");
   fprintf(stderr, "  --dw=<n>           <n> wide dispatch\n");
   fprintf(stderr, "  --iw=<n>           <n> wide issue / <n> execution lanes\n");
   fprintf(stderr, "  --rw=<n>           <n> wide retire\n");
-  fprintf(stderr, "  --phase=<n>        Phase interval is <n>\n");
+  fprintf(stderr, "  --phase=<n>        Dump phase counters and rates to phase.<date>.log every <n> retired instructions (0: no phase log, default)\n");
   fprintf(stderr, "  --lane=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is a bit vector indicating which lanes support that instruction type.\n");
   fprintf(stderr, "  --lat=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is an unsigned integer indicating the latency of that instruction type.\n");
   fprintf(stderr, "  -u                 Shortcut to configure universal lanes. Equivalent to: --lane=0xffff:0xffff:0xffff:0xffff:0xffff:0xffff:0xffff --lat=1:1:1:1:1:1:1\n");
   fprintf(stderr, "  --L2L3exist=a,b\tEnable (a=1) or disable (a=0) the L2 cache. Enable (b=1) or disable (b=0) the L3 cache.\n");
   fprintf(stderr, "  --IC=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>\tConfigure L1 I$. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
-  fprintf(stderr, "  --DC=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>\tConfigure L1 D$. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
-  fprintf(stderr, "  --L2=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>\tConfigure L2 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
-  fprintf(stderr, "  --L3=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>\tConfigure L3 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
+  fprintf(stderr, "  --DC=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>[:<POLICY>]\tConfigure L1 D$. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
+  fprintf(stderr, "  --L2=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>[:<POLICY>]\tConfigure L2 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
+  fprintf(stderr, "  --L3=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>[:<POLICY>]\tConfigure L3 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
+  fprintf(stderr, "                     <POLICY> is the replacement policy: lru (default), plru, srrip, brrip, drrip, ship. plru requires a power-of-2 <ASSOC>.\n");
   fprintf(stderr, "  --MEMLAT=<latency>\tConfigure a fixed miss penalty for a miss in the LLC.\n");
+  fprintf(stderr, "  --mhsrtargets=<DC>:<L2>:<L3>\tMax. number of accesses coalesced into one MHSR of each level (0: unlimited). The D$ asks the LSU to retry when full.\n");
+  fprintf(stderr, "  --pf=<DC>:<L2>\tData prefetcher of the L1 D$ (trained by loads/stores) and of the L2 $ (trained by its misses): none (default), nextline, stride, stream, bo.\n");
+  fprintf(stderr, "  --pfdegree=<DC>:<L2>\tMax. prefetches per trigger (stride: strides ahead, stream: lines ahead; bo always issues one).\n");
+  fprintf(stderr, "  --inclusion=<L2>:<L3>\tInclusion of the levels above the L2 $ and the L3 $: noninclusive (default), inclusive (back-invalidation), exclusive (filled by evictions from above).\n");
+  fprintf(stderr, "  --victimcache=<ENTRIES>:<LATENCY>\tFully associative victim cache between the L1 D$ and the L2 $ (ENTRIES=0: none, default).\n");
+  fprintf(stderr, "  --dcbanks=<PORTS>:<BANKS>:<INTERLEAVE>\tL1 D$ ports (0: unlimited, default) and banks (0: not banked, default), interleaved every <INTERLEAVE> bytes. Loads/stores that lose arbitration are replayed.\n");
+  fprintf(stderr, "  --dram=<CHANNELS>:<RANKS>:<BANKS>:<ROWSIZE>:<open|closed>\tReplace the fixed LLC miss penalty with a banked DRAM model. Counts must be power-of-2. <ROWSIZE> in bytes, power-of-2.\n");
+  fprintf(stderr, "  --dramtiming=<tRCD>:<tCAS>:<tRP>:<tRAS>:<tBURST>:<tCTRL>\tDRAM timing, in core cycles. Implies --dram.\n");
+  fprintf(stderr, "  --dramrefresh=<tREFI>:<tRFC>\tDRAM refresh interval and refresh cycle time, in core cycles (tREFI=0: no refresh). Implies --dram.\n");
+  fprintf(stderr, "  --itlb=<ENTRIES>:<ASSOC>\tL1 instruction TLB (ENTRIES=0: none, translation is free, default). Power-of-2.\n");
+  fprintf(stderr, "  --dtlb=<ENTRIES>:<ASSOC>\tL1 data TLB (ENTRIES=0: none, translation is free, default). Power-of-2.\n");
+  fprintf(stderr, "  --l2tlb=<ENTRIES>:<ASSOC>:<LATENCY>\tShared L2 TLB behind the ITLB and DTLB (ENTRIES=0: none, default). Power-of-2.\n");
+  fprintf(stderr, "  --ptw=<WALKERS>:<PWC_ENTRIES>\tConcurrent page table walks and entries per page walk cache (0: none).\n");
+  fprintf(stderr, "  --pagesize=<BYTES>\tPage size for the TLBs, power-of-2 (default 4096).\n");
+  fprintf(stderr, "  --sdp=<MIN_SETS>:<MAX_SETS>:<MAX_ASSOC>\tProfile LRU stack distances at each cache level; miss rates of every sets x ways up to these go to the sdp log.\n");
   exit(1);
 }
 
@@ -211,6 +248,20 @@ static void set_disambig_flags(const char* config) {
    }
 }
 
+// Translate the optional <POLICY> field of --DC/--L2/--L3 into a repl_policy_e.
+static unsigned int config_repl_policy(const char* option, const char* name, unsigned int assoc) {
+   repl_policy_e policy = repl_policy_from_name(name);
+   if (policy == NUM_REPL_POLICIES) {
+      fprintf(stderr, "--%s: unknown replacement policy (%s). Must be one of: lru, plru, srrip, brrip, drrip, ship.\n", option, name);
+      exit(-1);
+   }
+   if ((policy == REPL_PLRU) && !IsPow2(assoc)) {
+      fprintf(stderr, "--%s: plru replacement requires a power-of-2 associativity (%u).\n", option, assoc);
+      exit(-1);
+   }
+   return((unsigned int)policy);
+}
+
 static void config_IC(const char* config) {
    unsigned int temp_size, temp_blocksize;
    if (sscanf(config, "%u:%u:%u:%u", &temp_size, &L1_IC_ASSOC, &temp_blocksize, &L1_IC_NUM_MHSRs) != 4) {
@@ -236,8 +287,10 @@ static void config_IC(const char* config) {
 
 static void config_DC(const char* config) {
    unsigned int temp_size, temp_blocksize;
-   if (sscanf(config, "%u:%u:%u:%u", &temp_size, &L1_DC_ASSOC, &temp_blocksize, &L1_DC_NUM_MHSRs) != 4) {
-      fprintf(stderr, "Incorrect usage of --DC=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>.\n");
+   char temp_policy[16];
+   int n = sscanf(config, "%u:%u:%u:%u:%15s", &temp_size, &L1_DC_ASSOC, &temp_blocksize, &L1_DC_NUM_MHSRs, temp_policy);
+   if ((n != 4) && (n != 5)) {
+      fprintf(stderr, "Incorrect usage of --DC=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>[:<POLICY>].\n");
       exit(-1);
    }
    else {
@@ -254,13 +307,17 @@ static void config_DC(const char* config) {
          fprintf(stderr, "--DC: DC derived # sets (%u) must be a power-of-2.\n", L1_DC_SETS);
          exit(-1);
       }
+      if (n == 5)
+         L1_DC_REPL_POLICY = config_repl_policy("DC", temp_policy, L1_DC_ASSOC);
    }
 }
 
 static void config_L2(const char* config) {
    unsigned int temp_size, temp_blocksize;
-   if (sscanf(config, "%u:%u:%u:%u:%u", &temp_size, &L2_ASSOC, &temp_blocksize, &L2_NUM_MHSRs, &L2_HIT_LATENCY) != 5) {
-      fprintf(stderr, "Incorrect usage of --L2=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>.\n");
+   char temp_policy[16];
+   int n = sscanf(config, "%u:%u:%u:%u:%u:%15s", &temp_size, &L2_ASSOC, &temp_blocksize, &L2_NUM_MHSRs, &L2_HIT_LATENCY, temp_policy);
+   if ((n != 5) && (n != 6)) {
+      fprintf(stderr, "Incorrect usage of --L2=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>[:<POLICY>].\n");
       exit(-1);
    }
    else {
@@ -277,13 +334,17 @@ static void config_L2(const char* config) {
          fprintf(stderr, "--L2: L2 derived # sets (%u) must be a power-of-2.\n", L2_SETS);
          exit(-1);
       }
+      if (n == 6)
+         L2_REPL_POLICY = config_repl_policy("L2", temp_policy, L2_ASSOC);
    }
 }
 
 static void config_L3(const char* config) {
    unsigned int temp_size, temp_blocksize;
-   if (sscanf(config, "%u:%u:%u:%u:%u", &temp_size, &L3_ASSOC, &temp_blocksize, &L3_NUM_MHSRs, &L3_HIT_LATENCY) != 5) {
-      fprintf(stderr, "Incorrect usage of --L3=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>.\n");
+   char temp_policy[16];
+   int n = sscanf(config, "%u:%u:%u:%u:%u:%15s", &temp_size, &L3_ASSOC, &temp_blocksize, &L3_NUM_MHSRs, &L3_HIT_LATENCY, temp_policy);
+   if ((n != 5) && (n != 6)) {
+      fprintf(stderr, "Incorrect usage of --L3=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>[:<POLICY>].\n");
       exit(-1);
    }
    else {
@@ -300,6 +361,280 @@ static void config_L3(const char* config) {
          fprintf(stderr, "--L3: L3 derived # sets (%u) must be a power-of-2.\n", L3_SETS);
          exit(-1);
       }
+      if (n == 6)
+         L3_REPL_POLICY = config_repl_policy("L3", temp_policy, L3_ASSOC);
+   }
+}
+
+static void config_mhsr_targets(const char* config) {
+   if (sscanf(config, "%u:%u:%u", &L1_DC_MHSR_TARGETS, &L2_MHSR_TARGETS, &L3_MHSR_TARGETS) != 3) {
+      fprintf(stderr, "Incorrect usage of --mhsrtargets=<DC>:<L2>:<L3>.\n");
+      exit(-1);
+   }
+}
+
+static unsigned int config_prefetcher(const char* name) {
+   pf_kind_e kind = pf_kind_from_name(name);
+   if (kind == NUM_PF_KINDS) {
+      fprintf(stderr, "--pf: unknown prefetcher (%s). Must be one of: none, nextline, stride, stream, bo.\n", name);
+      exit(-1);
+   }
+   return((unsigned int)kind);
+}
+
+static void config_pf(const char* config) {
+   char temp_dc[16], temp_l2[16];
+   if (sscanf(config, "%15[^:]:%15s", temp_dc, temp_l2) != 2) {
+      fprintf(stderr, "Incorrect usage of --pf=<DC>:<L2>.\n");
+      exit(-1);
+   }
+   L1_DC_PREFETCHER = config_prefetcher(temp_dc);
+   L2_PREFETCHER = config_prefetcher(temp_l2);
+}
+
+static void config_pf_degree(const char* config) {
+   if ((sscanf(config, "%u:%u", &L1_DC_PF_DEGREE, &L2_PF_DEGREE) != 2) || !L1_DC_PF_DEGREE || !L2_PF_DEGREE) {
+      fprintf(stderr, "Incorrect usage of --pfdegree=<DC>:<L2>. Degrees must be at least 1.\n");
+      exit(-1);
+   }
+}
+
+static unsigned int config_incl(const char* name) {
+   for (unsigned int i = 0; i < (unsigned int)NUM_INCL_POLICIES; i++)
+      if (!strcmp(name, incl_policy_name[i]))
+         return(i);
+   fprintf(stderr, "--inclusion: unknown inclusion policy (%s). Must be one of: noninclusive, inclusive, exclusive.\n", name);
+   exit(-1);
+}
+
+static void config_inclusion(const char* config) {
+   char temp_l2[16], temp_l3[16];
+   if (sscanf(config, "%15[^:]:%15s", temp_l2, temp_l3) != 2) {
+      fprintf(stderr, "Incorrect usage of --inclusion=<L2>:<L3>.\n");
+      exit(-1);
+   }
+   L2_INCLUSION = config_incl(temp_l2);
+   L3_INCLUSION = config_incl(temp_l3);
+}
+
+static void config_victim_cache(const char* config) {
+   if (sscanf(config, "%u:%u", &L1_DC_VICTIM_ENTRIES, &L1_DC_VICTIM_LATENCY) != 2) {
+      fprintf(stderr, "Incorrect usage of --victimcache=<ENTRIES>:<LATENCY>.\n");
+      exit(-1);
+   }
+}
+
+static void config_dc_banks(const char* config) {
+   unsigned int temp_interleave;
+   if (sscanf(config, "%u:%u:%u", &L1_DC_PORTS, &L1_DC_BANKS, &temp_interleave) != 3) {
+      fprintf(stderr, "Incorrect usage of --dcbanks=<PORTS>:<BANKS>:<INTERLEAVE>.\n");
+      exit(-1);
+   }
+   if ((L1_DC_BANKS && !IsPow2(L1_DC_BANKS)) || !IsPow2(temp_interleave)) {
+      fprintf(stderr, "--dcbanks: banks (%u) and interleave (%u) must be powers-of-2.\n", L1_DC_BANKS, temp_interleave);
+      exit(-1);
+   }
+   L1_DC_BANK_INTERLEAVE = (unsigned int) log2((double)temp_interleave);
+}
+
+static void config_dram(const char* config) {
+   char temp_policy[16];
+   unsigned int temp_rowsize;
+   if (sscanf(config, "%u:%u:%u:%u:%15s", &DRAM_CHANNELS, &DRAM_RANKS, &DRAM_BANKS, &temp_rowsize, temp_policy) != 5) {
+      fprintf(stderr, "Incorrect usage of --dram=<CHANNELS>:<RANKS>:<BANKS>:<ROWSIZE>:<open|closed>.\n");
+      exit(-1);
+   }
+   if (!IsPow2(DRAM_CHANNELS) || !IsPow2(DRAM_RANKS) || !IsPow2(DRAM_BANKS) || !IsPow2(temp_rowsize)) {
+      fprintf(stderr, "--dram: channels (%u), ranks (%u), banks (%u), and row size (%u) must be powers-of-2.\n", DRAM_CHANNELS, DRAM_RANKS, DRAM_BANKS, temp_rowsize);
+      exit(-1);
+   }
+   DRAM_ROW_SIZE = (unsigned int) log2((double)temp_rowsize);
+   if (!strcmp(temp_policy, "open"))
+      DRAM_OPEN_PAGE = true;
+   else if (!strcmp(temp_policy, "closed"))
+      DRAM_OPEN_PAGE = false;
+   else {
+      fprintf(stderr, "--dram: unknown page policy \"%s\" (use open or closed).\n", temp_policy);
+      exit(-1);
+   }
+   DRAM_PRESENT = true;
+}
+
+static void config_dram_timing(const char* config) {
+   if (sscanf(config, "%u:%u:%u:%u:%u:%u", &DRAM_tRCD, &DRAM_tCAS, &DRAM_tRP, &DRAM_tRAS, &DRAM_tBURST, &DRAM_tCTRL) != 6) {
+      fprintf(stderr, "Incorrect usage of --dramtiming=<tRCD>:<tCAS>:<tRP>:<tRAS>:<tBURST>:<tCTRL>.\n");
+      exit(-1);
+   }
+   if (DRAM_tBURST == 0) {
+      fprintf(stderr, "--dramtiming: tBURST must be at least 1.\n");
+      exit(-1);
+   }
+   DRAM_PRESENT = true;
+}
+
+static void config_dram_refresh(const char* config) {
+   if (sscanf(config, "%u:%u", &DRAM_tREFI, &DRAM_tRFC) != 2) {
+      fprintf(stderr, "Incorrect usage of --dramrefresh=<tREFI>:<tRFC>.\n");
+      exit(-1);
+   }
+   if (DRAM_tREFI && (DRAM_tRFC >= DRAM_tREFI)) {
+      fprintf(stderr, "--dramrefresh: tRFC (%u) must be less than tREFI (%u).\n", DRAM_tRFC, DRAM_tREFI);
+      exit(-1);
+   }
+   DRAM_PRESENT = true;
+}
+
+static void config_tlb(const char* option, const char* config, unsigned int& entries, unsigned int& assoc) {
+   if (sscanf(config, "%u:%u", &entries, &assoc) != 2) {
+      fprintf(stderr, "Incorrect usage of --%s=<ENTRIES>:<ASSOC>.\n", option);
+      exit(-1);
+   }
+   if (entries && (!IsPow2(entries) || !IsPow2(assoc) || (assoc > entries))) {
+      fprintf(stderr, "--%s: entries (%u) and assoc (%u) must be powers-of-2, with assoc <= entries.\n", option, entries, assoc);
+      exit(-1);
+   }
+}
+
+static void config_l2tlb(const char* config) {
+   if (sscanf(config, "%u:%u:%u", &L2_TLB_ENTRIES, &L2_TLB_ASSOC, &L2_TLB_LATENCY) != 3) {
+      fprintf(stderr, "Incorrect usage of --l2tlb=<ENTRIES>:<ASSOC>:<LATENCY>.\n");
+      exit(-1);
+   }
+   if (L2_TLB_ENTRIES && (!IsPow2(L2_TLB_ENTRIES) || !IsPow2(L2_TLB_ASSOC) || (L2_TLB_ASSOC > L2_TLB_ENTRIES))) {
+      fprintf(stderr, "--l2tlb: entries (%u) and assoc (%u) must be powers-of-2, with assoc <= entries.\n", L2_TLB_ENTRIES, L2_TLB_ASSOC);
+      exit(-1);
+   }
+}
+
+static void config_ptw(const char* config) {
+   if ((sscanf(config, "%u:%u", &PTW_WALKERS, &PTW_PWC_ENTRIES) != 2) || (PTW_WALKERS == 0)) {
+      fprintf(stderr, "Incorrect usage of --ptw=<WALKERS>:<PWC_ENTRIES>. At least one walker is required.\n");
+      exit(-1);
+   }
+}
+
+static void config_page_size(const char* config) {
+   unsigned int temp;
+   if ((sscanf(config, "%u", &temp) != 1) || !IsPow2(temp) || (temp < 64)) {
+      fprintf(stderr, "Incorrect usage of --pagesize=<BYTES>. Must be a power-of-2, at least 64.\n");
+      exit(-1);
+   }
+   TLB_PAGE_SIZE = (unsigned int) log2((double)temp);
+}
+
+static void config_sdp(const char* config) {
+   if ((sscanf(config, "%u:%u:%u", &SDP_MIN_SETS, &SDP_MAX_SETS, &SDP_MAX_ASSOC) != 3) ||
+       (SDP_MIN_SETS == 0) || (SDP_MAX_ASSOC == 0) || (SDP_MIN_SETS > SDP_MAX_SETS) ||
+       !IsPow2(SDP_MIN_SETS) || !IsPow2(SDP_MAX_SETS) || !IsPow2(SDP_MAX_ASSOC)) {
+      fprintf(stderr, "Incorrect usage of --sdp=<MIN_SETS>:<MAX_SETS>:<MAX_ASSOC>. All must be powers-of-2, MIN_SETS <= MAX_SETS.\n");
+      exit(-1);
+   }
+}
+
+static void config_fetchbundles(const char* config) {
+   FETCH_BUNDLES = atoi(config);
+   if ((FETCH_BUNDLES < 1) || (FETCH_BUNDLES > 2)) {
+      fprintf(stderr, "Incorrect usage of --fetchbundles=<n>. <n> is 1 or 2.\n");
+      exit(-1);
+   }
+}
+
+static void config_btbl2(const char* config) {
+   int n = sscanf(config, "%u:%u:%u", &BTB_L2_ENTRIES, &BTB_L2_ASSOC, &BTB_L2_LATENCY);
+   if (((n != 1) && (n != 3)) || (BTB_L2_ASSOC == 0)) {
+      fprintf(stderr, "Incorrect usage of --btbl2=<ENTRIES>[:<ASSOC>:<LATENCY>]. ENTRIES is 0 (no L2 BTB) or such that ENTRIES/(fetch width * ASSOC) is a power-of-2.\n");
+      exit(-1);
+   }
+}
+
+static void config_uopcache(const char* config) {
+   int n = sscanf(config, "%u:%u:%u", &UOP_CACHE_ENTRIES, &UOP_CACHE_ASSOC, &UOP_SWITCH_PENALTY);
+   if (((n != 1) && (n != 3)) || (UOP_CACHE_ASSOC == 0) ||
+       (UOP_CACHE_ENTRIES && (((UOP_CACHE_ENTRIES % UOP_CACHE_ASSOC) != 0) || !IsPow2(UOP_CACHE_ENTRIES / UOP_CACHE_ASSOC)))) {
+      fprintf(stderr, "Incorrect usage of --uopcache=<ENTRIES>[:<ASSOC>:<PENALTY>]. ENTRIES is 0 (no micro-op cache) or such that ENTRIES/ASSOC is a power-of-2.\n");
+      exit(-1);
+   }
+}
+
+static void config_gate(const char* config) {
+   unsigned int throttle = 0;
+   int n = sscanf(config, "%u:%u:%u", &GATE_CHKPTS, &GATE_LOWCONF, &throttle);
+   if (((n != 2) && (n != 3)) || (throttle > 1)) {
+      fprintf(stderr, "Incorrect usage of --gate=<CHKPTS>:<LOWCONF>[:<THROTTLE>]. CHKPTS and LOWCONF are thresholds (0: off), THROTTLE is 0 (stop fetch) or 1 (fetch every other cycle).\n");
+      exit(-1);
+   }
+   GATE_THROTTLE = (throttle == 1);
+}
+
+static void config_fusion(const char* config) {
+   char temp[64];
+   char* rule;
+   unsigned int i;
+
+   FUSION = 0;
+   if (!strcmp(config, "none"))
+      return;
+   if (!strcmp(config, "all")) {
+      FUSION = ((1 << NUM_FUSE_RULES) - 1);
+      return;
+   }
+   strncpy(temp, config, sizeof(temp) - 1);
+   temp[sizeof(temp) - 1] = '\0';
+   for (rule = strtok(temp, ","); rule; rule = strtok(NULL, ",")) {
+      for (i = 0; i < (unsigned int)NUM_FUSE_RULES; i++)
+         if (!strcmp(rule, fuse_rule_name[i]))
+            break;
+      if (i == (unsigned int)NUM_FUSE_RULES) {
+         fprintf(stderr, "Incorrect usage of --fusion=<rules>. Rules are comma-separated among: lui, auipc, cmpbr (or: all, none).\n");
+         exit(-1);
+      }
+      FUSION |= (1 << i);
+   }
+}
+
+static void config_tage(const char* config) {
+   int n = sscanf(config, "%u:%u:%u:%u", &TAGE_KB, &TAGE_TABLES, &TAGE_MIN_HIST, &TAGE_MAX_HIST);
+   if (((n != 1) && (n != 4)) || (TAGE_KB == 1) ||
+       (TAGE_TABLES < 2) || (TAGE_TABLES > 16) ||
+       (TAGE_MIN_HIST == 0) || (TAGE_MIN_HIST >= TAGE_MAX_HIST) || (TAGE_MAX_HIST > 4096)) {
+      fprintf(stderr, "Incorrect usage of --tage=<KB>[:<TABLES>:<MIN_HIST>:<MAX_HIST>]. KB is 0 (gshare) or at least 2, TABLES is 2 to 16, 0 < MIN_HIST < MAX_HIST <= 4096.\n");
+      exit(-1);
+   }
+}
+
+static void config_perceptron(const char* config) {
+   int n = sscanf(config, "%u:%u:%u", &PERCEPTRON_KB, &PERCEPTRON_TABLES, &PERCEPTRON_MAX_HIST);
+   if (((n != 1) && (n != 3)) || (PERCEPTRON_KB == 1) ||
+       (PERCEPTRON_TABLES < 2) || (PERCEPTRON_TABLES > 32) ||
+       (PERCEPTRON_MAX_HIST < (PERCEPTRON_TABLES - 1)) || (PERCEPTRON_MAX_HIST > 4096)) {
+      fprintf(stderr, "Incorrect usage of --perceptron=<KB>[:<TABLES>:<MAX_HIST>]. KB is 0 (gshare) or at least 2, TABLES is 2 to 32, TABLES-1 <= MAX_HIST <= 4096.\n");
+      exit(-1);
+   }
+}
+
+static void config_loop(const char* config) {
+   LOOP_ENTRIES = atoi(config);
+   if (LOOP_ENTRIES && (((LOOP_ENTRIES % 4) != 0) || !IsPow2(LOOP_ENTRIES / 4))) {
+      fprintf(stderr, "Incorrect usage of --loop=<ENTRIES>. ENTRIES is 0 (no loop predictor) or 4 times a power-of-2.\n");
+      exit(-1);
+   }
+}
+
+static void config_sc(const char* config) {
+   SC_ENTRIES = atoi(config);
+   if (SC_ENTRIES && ((SC_ENTRIES < 16) || !IsPow2(SC_ENTRIES))) {
+      fprintf(stderr, "Incorrect usage of --sc=<ENTRIES>. ENTRIES is 0 (no statistical corrector) or a power-of-2 of at least 16.\n");
+      exit(-1);
+   }
+}
+
+static void config_ittage(const char* config) {
+   int n = sscanf(config, "%u:%u:%u:%u", &ITTAGE_KB, &ITTAGE_TABLES, &ITTAGE_MIN_HIST, &ITTAGE_MAX_HIST);
+   if (((n != 1) && (n != 4)) || ((ITTAGE_KB > 0) && (ITTAGE_KB < 8)) ||
+       (ITTAGE_TABLES < 2) || (ITTAGE_TABLES > 16) ||
+       (ITTAGE_MIN_HIST == 0) || (ITTAGE_MIN_HIST >= ITTAGE_MAX_HIST) || (ITTAGE_MAX_HIST > 4096)) {
+      fprintf(stderr, "Incorrect usage of --ittage=<KB>[:<TABLES>:<MIN_HIST>:<MAX_HIST>]. KB is 0 (gshare) or at least 8, TABLES is 2 to 16, 0 < MIN_HIST < MAX_HIST <= 4096.\n");
+      exit(-1);
    }
 }
 
@@ -346,6 +681,7 @@ int main(int argc, char** argv)
   bool skip_enable = false;   /////////////
 
   std::string checkpoint_file = "";
+  std::string bp_trace_file = "";
 
   option_parser_t parser;
   parser.help(&help);
@@ -358,25 +694,53 @@ int main(int argc, char** argv)
   parser.option('s', 0, 1, [&](const char* s){skip_amt = atoll(s); skip_enable = true;});
   parser.option('e', 0, 1, [&](const char* s){stop_amt = atoll(s); use_stop_amt = true;});
   parser.option('c', 0, 1, [&](const char* s){checkpoint_file = s;});
+  parser.option(0, "bptrace", 1, [&](const char* s){bp_trace_file = s;});
   parser.option(0, "IC", 1, [&](const char* s){config_IC(s);});
   parser.option(0, "DC", 1, [&](const char* s){config_DC(s);});
   parser.option(0, "L2", 1, [&](const char* s){config_L2(s);});
   parser.option(0, "L3", 1, [&](const char* s){config_L3(s);});
   parser.option(0, "L2L3exist", 1, [&](const char* s){config_L2L3present(s);});
+  parser.option(0, "mhsrtargets", 1, [&](const char* s){config_mhsr_targets(s);});
+  parser.option(0, "pf", 1, [&](const char* s){config_pf(s);});
+  parser.option(0, "pfdegree", 1, [&](const char* s){config_pf_degree(s);});
+  parser.option(0, "inclusion", 1, [&](const char* s){config_inclusion(s);});
+  parser.option(0, "victimcache", 1, [&](const char* s){config_victim_cache(s);});
+  parser.option(0, "dcbanks", 1, [&](const char* s){config_dc_banks(s);});
+  parser.option(0, "dram", 1, [&](const char* s){config_dram(s);});
+  parser.option(0, "dramtiming", 1, [&](const char* s){config_dram_timing(s);});
+  parser.option(0, "dramrefresh", 1, [&](const char* s){config_dram_refresh(s);});
+  parser.option(0, "itlb", 1, [&](const char* s){config_tlb("itlb", s, ITLB_ENTRIES, ITLB_ASSOC);});
+  parser.option(0, "dtlb", 1, [&](const char* s){config_tlb("dtlb", s, DTLB_ENTRIES, DTLB_ASSOC);});
+  parser.option(0, "l2tlb", 1, [&](const char* s){config_l2tlb(s);});
+  parser.option(0, "ptw", 1, [&](const char* s){config_ptw(s);});
+  parser.option(0, "pagesize", 1, [&](const char* s){config_page_size(s);});
+  parser.option(0, "sdp", 1, [&](const char* s){config_sdp(s);});
   parser.option(0, "MEMLAT", 1, [&](const char* s){L1_IC_MISS_LATENCY = L1_DC_MISS_LATENCY = L2_MISS_LATENCY = atoi(s);});
   parser.option(0, "perf", 1, [&](const char* s){set_perfect_flags(s);});
   parser.option(0, "cp"  , 1, [&](const char* s){NUM_CHECKPOINTS = atoi(s);});
+  parser.option(0, "misphot", 1, [&](const char* s){MISP_HOTSPOTS = atoi(s);});
 
   parser.option(0, "bq", 1, [&](const char* s){BQ_SIZE = atoi(s); AUTO_BQ_SIZE = false;});
   parser.option(0, "btbentries", 1, [&](const char* s){BTB_ENTRIES = atoi(s);});
   parser.option(0, "btbassoc", 1, [&](const char* s){BTB_ASSOC = atoi(s);});
+  parser.option(0, "btbl2", 1, [&](const char* s){config_btbl2(s);});
   parser.option(0, "ras", 1, [&](const char* s){RAS_SIZE = atoi(s);});
+  parser.option(0, "ftq", 1, [&](const char* s){FTQ_SIZE = atoi(s);});
+  parser.option(0, "uopcache", 1, [&](const char* s){config_uopcache(s);});
+  parser.option(0, "gate", 1, [&](const char* s){config_gate(s);});
   parser.option(0, "mbp", 1, [&](const char* s){COND_BRANCH_PRED_PER_CYCLE = atoi(s);});
   parser.option(0, "cbpPC", 1, [&](const char* s){CBP_PC_LENGTH = atoi(s);});
   parser.option(0, "cbpBHR", 1, [&](const char* s){CBP_BHR_LENGTH = atoi(s);});
   parser.option(0, "ibpPC", 1, [&](const char* s){IBP_PC_LENGTH = atoi(s);});
   parser.option(0, "ibpBHR", 1, [&](const char* s){IBP_BHR_LENGTH = atoi(s);});
+  parser.option(0, "tage", 1, [&](const char* s){config_tage(s);});
+  parser.option(0, "perceptron", 1, [&](const char* s){config_perceptron(s);});
+  parser.option(0, "loop", 1, [&](const char* s){config_loop(s);});
+  parser.option(0, "sc", 1, [&](const char* s){config_sc(s);});
+  parser.option(0, "ittage", 1, [&](const char* s){config_ittage(s);});
   parser.option('t', 0, 0, [&](const char* s){ENABLE_TRACE_CACHE = true;});
+  parser.option(0, "tcentries", 1, [&](const char* s){TC_ENTRIES = atoi(s);});
+  parser.option(0, "tcassoc", 1, [&](const char* s){TC_ASSOC = atoi(s);});
 
   parser.option(0, "fq"  , 1, [&](const char* s){FETCH_QUEUE_SIZE = atoi(s);});
   parser.option(0, "al"  , 1, [&](const char* s){ACTIVE_LIST_SIZE = atoi(s);});
@@ -385,9 +749,13 @@ int main(int argc, char** argv)
   parser.option(0, "iqnp", 1, [&](const char* s){ISSUE_QUEUE_NUM_PARTS = atoi(s);});
   parser.option('a', 0, 0, [&](const char* s){PRESTEER = true;});
   parser.option('b', 0, 0, [&](const char* s){IDEAL_AGE_BASED = true;});
+  parser.option(0, "fusion", 1, [&](const char* s){config_fusion(s);});
   parser.option(0, "lsq" , 1, [&](const char* s){LQ_SIZE = atoi(s);SQ_SIZE = atoi(s);});
+  parser.option(0, "sb" , 1, [&](const char* s){STORE_BUFFER_SIZE = atoi(s);});
+  parser.option(0, "rfo" , 1, [&](const char* s){STORE_RFO = (atoi(s) != 0);});
   parser.option(0, "disambig", 1, [&](const char* s){set_disambig_flags(s);});
   parser.option(0, "fw"  , 1, [&](const char* s){FETCH_WIDTH = atoi(s);});
+  parser.option(0, "fetchbundles", 1, [&](const char* s){config_fetchbundles(s);});
   parser.option(0, "dw"  , 1, [&](const char* s){DISPATCH_WIDTH = atoi(s);});
   parser.option(0, "iw"  , 1, [&](const char* s){ISSUE_WIDTH = atoi(s);});
   parser.option(0, "rw"  , 1, [&](const char* s){RETIRE_WIDTH = atoi(s);});
@@ -397,6 +765,10 @@ int main(int argc, char** argv)
   parser.option('u', 0, 0, [&](const char* s){set_lane_matrix("0xffff:0xffff:0xffff:0xffff:0xffff:0xffff:0xffff"); set_lane_latencies("1:1:1:1:1:1:1");});
 
   auto argv1 = parser.parse(argv);
+  if (TAGE_KB && PERCEPTRON_KB) {
+    fprintf(stderr, "--tage and --perceptron are mutually exclusive.\n");
+    exit(-1);
+  }
   if (!*argv1)
     help();
   std::vector<std::string> htif_args(argv1, (const char*const*)argv + argc);
@@ -549,6 +921,8 @@ int main(int argc, char** argv)
   else if (skip_enable) {
       // If skip amount is provided, fast skip in the MICROS sim
       fprintf(stderr, "Fast skipping MICROS for %lu instructions\n",skip_amt);
+      if (bp_trace_file != "")
+        s_micro->set_bp_trace(bp_trace_file);
       htif_code = s_micro->run_fast(skip_amt);
       // Stop simulation if HTIF returns non-zero code
       if(!htif_code) return htif_code;
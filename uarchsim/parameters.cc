@@ -23,7 +23,10 @@ uint32_t ISSUE_QUEUE_SIZE	= 32;
 uint32_t ISSUE_QUEUE_NUM_PARTS	= 4;
 uint32_t LQ_SIZE		      = 32;
 uint32_t SQ_SIZE		      = 32;
+uint32_t STORE_BUFFER_SIZE     = 0;	// 0: no post-retirement store buffer
+bool STORE_RFO                 = false;	// Read-for-ownership when a store's address is computed (needs a store buffer)
 uint32_t FETCH_WIDTH	    = 8;//2;//4;
+uint32_t FETCH_BUNDLES	    = 1;	// fetch bundles per cycle (1 or 2)
 uint32_t DISPATCH_WIDTH	  = 8;//2;//4;
 uint32_t ISSUE_WIDTH	    = 8;//3;//8;
 uint32_t RETIRE_WIDTH	    = 8;//1;//4;
@@ -37,6 +40,7 @@ unsigned int MDP_MAX = 63;
 
 bool PRESTEER = false;
 bool IDEAL_AGE_BASED = false;
+unsigned int FUSION = 0;  // 0: no macro-op fusion, else a bit mask of fuse_rule_e (fu.h)
 uint32_t FU_LANE_MATRIX[(unsigned int)NUMBER_FU_TYPES] = {0x5A5A /*     BR: 0101 1010 */ ,
                                                           0x2121 /*     LS: 0010 0001 */ ,
                                                           0x5A5A /*  ALU_S: 0101 1010 */ ,
@@ -81,6 +85,15 @@ unsigned int L1_DC_MISS_LATENCY     = 100; // Used only when no L2 cache
 unsigned int L1_DC_NUM_MHSRs        = 128; 
 unsigned int L1_DC_MISS_SRV_PORTS   = 128;
 unsigned int L1_DC_MISS_SRV_LATENCY = 1;
+unsigned int L1_DC_REPL_POLICY      = 0;  // REPL_LRU
+unsigned int L1_DC_MHSR_TARGETS     = 0;  // Max. accesses per MHSR, 0: unlimited
+unsigned int L1_DC_PREFETCHER       = 0;  // PF_NONE
+unsigned int L1_DC_PF_DEGREE        = 2;
+unsigned int L1_DC_VICTIM_ENTRIES   = 0;  // 0: no victim cache
+unsigned int L1_DC_VICTIM_LATENCY   = 1;
+unsigned int L1_DC_PORTS            = 0;  // Loads+stores accessing the D$ per cycle, 0: unlimited
+unsigned int L1_DC_BANKS            = 0;  // 0 or 1: not banked
+unsigned int L1_DC_BANK_INTERLEAVE  = 3;  // 2^BANK_INTERLEAVE bytes per bank before moving to the next bank
 
 // L1 Instruction Cache.
 unsigned int L1_IC_SETS             = 128;
@@ -102,6 +115,11 @@ unsigned int L2_MISS_LATENCY      = 100;  // Used only when no L3
 unsigned int L2_NUM_MHSRs         = 128; 
 unsigned int L2_MISS_SRV_PORTS    = 128;
 unsigned int L2_MISS_SRV_LATENCY  = 1;
+unsigned int L2_REPL_POLICY       = 0;  // REPL_LRU
+unsigned int L2_MHSR_TARGETS      = 0;
+unsigned int L2_PREFETCHER        = 0;  // PF_NONE
+unsigned int L2_PF_DEGREE         = 4;
+unsigned int L2_INCLUSION         = 0;  // INCL_NON_INCLUSIVE
 
 // L3 Unified Cache.
 bool         L3_PRESENT           = true;
@@ -113,19 +131,84 @@ unsigned int L3_MISS_LATENCY      = 100;  // Used only when no L4
 unsigned int L3_NUM_MHSRs         = 128; 
 unsigned int L3_MISS_SRV_PORTS    = 128;
 unsigned int L3_MISS_SRV_LATENCY  = 1;
+unsigned int L3_REPL_POLICY       = 0;  // REPL_LRU
+unsigned int L3_MHSR_TARGETS      = 0;
+unsigned int L3_INCLUSION         = 0;  // INCL_NON_INCLUSIVE
+
+// Main memory (banked DRAM behind the last-level cache).
+// Timing in core cycles (roughly DDR4-2400 at a 3 GHz core).
+bool         DRAM_PRESENT         = false;  // false: fixed LLC miss latency
+unsigned int DRAM_CHANNELS        = 2;
+unsigned int DRAM_RANKS           = 1;
+unsigned int DRAM_BANKS           = 16;
+unsigned int DRAM_ROW_SIZE        = 13; // 2^ROW_SIZE bytes per row
+bool         DRAM_OPEN_PAGE       = true;
+unsigned int DRAM_tRCD            = 45;
+unsigned int DRAM_tCAS            = 45;
+unsigned int DRAM_tRP             = 45;
+unsigned int DRAM_tRAS            = 100;
+unsigned int DRAM_tBURST          = 10;
+unsigned int DRAM_tREFI           = 23400;
+unsigned int DRAM_tRFC            = 1050;
+unsigned int DRAM_tCTRL           = 20;
+
+// Address translation (TLBs and page table walker).
+unsigned int ITLB_ENTRIES         = 0;  // 0: no ITLB (translation is free)
+unsigned int ITLB_ASSOC           = 4;
+unsigned int DTLB_ENTRIES         = 0;  // 0: no DTLB (translation is free)
+unsigned int DTLB_ASSOC           = 4;
+unsigned int L2_TLB_ENTRIES       = 0;  // 0: no L2 TLB
+unsigned int L2_TLB_ASSOC         = 8;
+unsigned int L2_TLB_LATENCY       = 8;
+unsigned int TLB_PAGE_SIZE        = 12; // 2^PAGE_SIZE bytes per page
+unsigned int PTW_WALKERS          = 2;
+unsigned int PTW_PWC_ENTRIES      = 16; // 0: no page walk caches
+
+// Stack-distance profiling of the caches (stackdist.h)
+unsigned int SDP_MIN_SETS         = 0;  // 0: off
+unsigned int SDP_MAX_SETS         = 0;
+unsigned int SDP_MAX_ASSOC        = 0;
+
+// Misprediction hotspot report (stats_t::dump_br_hotspots())
+unsigned int MISP_HOTSPOTS        = 0;  // 0: off
 
 // Branch prediction unit
 bool AUTO_BQ_SIZE = true;
 unsigned int BQ_SIZE = 512;
 unsigned int BTB_ENTRIES = 8192;
 unsigned int BTB_ASSOC = 4;
+unsigned int BTB_L2_ENTRIES = 0;  // 0: no L2 BTB
+unsigned int BTB_L2_ASSOC = 8;
+unsigned int BTB_L2_LATENCY = 2;
 unsigned int RAS_SIZE = 64;
 unsigned int COND_BRANCH_PRED_PER_CYCLE = 3;
 unsigned int CBP_PC_LENGTH = 20;
 unsigned int CBP_BHR_LENGTH = 16;
 unsigned int IBP_PC_LENGTH = 20;
 unsigned int IBP_BHR_LENGTH = 16;
+unsigned int TAGE_KB = 0;  // 0: gshare conditional branch predictor
+unsigned int TAGE_TABLES = 12;
+unsigned int TAGE_MIN_HIST = 4;
+unsigned int TAGE_MAX_HIST = 640;
+unsigned int PERCEPTRON_KB = 0;  // 0: gshare (or TAGE) conditional branch predictor
+unsigned int PERCEPTRON_TABLES = 16;
+unsigned int PERCEPTRON_MAX_HIST = 256;
+unsigned int LOOP_ENTRIES = 0;  // 0: no loop predictor
+unsigned int SC_ENTRIES = 0;    // 0: no statistical corrector
+unsigned int ITTAGE_KB = 0;  // 0: gshare indirect branch predictor
+unsigned int ITTAGE_TABLES = 8;
+unsigned int ITTAGE_MIN_HIST = 4;
+unsigned int ITTAGE_MAX_HIST = 320;
 bool ENABLE_TRACE_CACHE = false;
+unsigned int TC_ENTRIES = 1024;  // real trace cache: total number of traces
+unsigned int TC_ASSOC = 4;
+unsigned int FTQ_SIZE = 0;  // 0: no fetch target queue (no fetch-directed I$ prefetching)
+unsigned int UOP_CACHE_ENTRIES = 0;  // 0: no micro-op cache
+unsigned int UOP_CACHE_ASSOC = 8;
+unsigned int UOP_SWITCH_PENALTY = 1;  // fetch cycles to switch from the micro-op cache to the decoders
+unsigned int GATE_CHKPTS = 0;   // 0: no fetch gating on free checkpoints
+unsigned int GATE_LOWCONF = 0;  // 0: no fetch gating on low-confidence branches
+bool GATE_THROTTLE = false;     // gated fetch: throttled to every other cycle instead of stopped
 
 // Benchmark control.
 bool logging_on                     = false;
@@ -134,5 +217,5 @@ int64_t logging_on_at               = -2;  //0xfffffffffffffffe
 bool use_stop_amt                   = false;
 uint64_t stop_amt                   = 0xffffffffffffffff;
 
-uint64_t phase_interval             = 10000;
+uint64_t phase_interval             = 0;	// 0: no phase log
 uint64_t verbose_phase_counters     = true;
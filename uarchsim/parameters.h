@@ -23,7 +23,10 @@ extern unsigned int ISSUE_QUEUE_SIZE;
 extern unsigned int ISSUE_QUEUE_NUM_PARTS;
 extern unsigned int LQ_SIZE;
 extern unsigned int SQ_SIZE;
+extern unsigned int STORE_BUFFER_SIZE;
+extern bool STORE_RFO;
 extern unsigned int FETCH_WIDTH;
+extern unsigned int FETCH_BUNDLES;
 extern unsigned int DISPATCH_WIDTH;
 extern unsigned int ISSUE_WIDTH;
 extern unsigned int RETIRE_WIDTH;
@@ -36,6 +39,7 @@ extern bool         MDP_STICKY;
 extern unsigned int MDP_MAX;
 extern bool         PRESTEER;
 extern bool         IDEAL_AGE_BASED;
+extern unsigned int FUSION;		// 0: no macro-op fusion, else a bit mask of fuse_rule_e (fu.h)
 extern unsigned int FU_LANE_MATRIX[];
 extern unsigned int FU_LAT[];
 
@@ -48,6 +52,15 @@ extern unsigned int L1_DC_MISS_LATENCY;
 extern unsigned int L1_DC_NUM_MHSRs;
 extern unsigned int L1_DC_MISS_SRV_PORTS;
 extern unsigned int L1_DC_MISS_SRV_LATENCY;
+extern unsigned int L1_DC_REPL_POLICY;  // repl_policy_e (cache.h)
+extern unsigned int L1_DC_MHSR_TARGETS; // 0: unlimited
+extern unsigned int L1_DC_PREFETCHER;   // pf_kind_e
+extern unsigned int L1_DC_PF_DEGREE;
+extern unsigned int L1_DC_VICTIM_ENTRIES; // 0: no victim cache
+extern unsigned int L1_DC_VICTIM_LATENCY;
+extern unsigned int L1_DC_PORTS;          // 0: unlimited
+extern unsigned int L1_DC_BANKS;          // 0 or 1: not banked
+extern unsigned int L1_DC_BANK_INTERLEAVE;
 
 // L1 Instruction Cache.
 extern unsigned int L1_IC_SETS;
@@ -69,6 +82,11 @@ extern unsigned int L2_MISS_LATENCY;
 extern unsigned int L2_NUM_MHSRs; 
 extern unsigned int L2_MISS_SRV_PORTS;
 extern unsigned int L2_MISS_SRV_LATENCY;
+extern unsigned int L2_REPL_POLICY;
+extern unsigned int L2_MHSR_TARGETS;
+extern unsigned int L2_PREFETCHER;      // pf_kind_e
+extern unsigned int L2_PF_DEGREE;
+extern unsigned int L2_INCLUSION;       // incl_policy_e
 
 // L3 Unified Cache.
 extern bool         L3_PRESENT;
@@ -80,19 +98,83 @@ extern unsigned int L3_MISS_LATENCY;
 extern unsigned int L3_NUM_MHSRs; 
 extern unsigned int L3_MISS_SRV_PORTS;
 extern unsigned int L3_MISS_SRV_LATENCY;
+extern unsigned int L3_REPL_POLICY;
+extern unsigned int L3_MHSR_TARGETS;
+extern unsigned int L3_INCLUSION;       // incl_policy_e
+
+// Main memory (banked DRAM behind the last-level cache).
+extern bool         DRAM_PRESENT;  // false: fixed LLC miss latency
+extern unsigned int DRAM_CHANNELS;
+extern unsigned int DRAM_RANKS;
+extern unsigned int DRAM_BANKS;
+extern unsigned int DRAM_ROW_SIZE; // 2^ROW_SIZE bytes per row
+extern bool         DRAM_OPEN_PAGE;
+extern unsigned int DRAM_tRCD;
+extern unsigned int DRAM_tCAS;
+extern unsigned int DRAM_tRP;
+extern unsigned int DRAM_tRAS;
+extern unsigned int DRAM_tBURST;
+extern unsigned int DRAM_tREFI;
+extern unsigned int DRAM_tRFC;
+extern unsigned int DRAM_tCTRL;
+
+// Address translation (TLBs and page table walker).
+extern unsigned int ITLB_ENTRIES;  // 0: no ITLB (translation is free)
+extern unsigned int ITLB_ASSOC;
+extern unsigned int DTLB_ENTRIES;  // 0: no DTLB (translation is free)
+extern unsigned int DTLB_ASSOC;
+extern unsigned int L2_TLB_ENTRIES; // 0: no L2 TLB
+extern unsigned int L2_TLB_ASSOC;
+extern unsigned int L2_TLB_LATENCY;
+extern unsigned int TLB_PAGE_SIZE; // 2^PAGE_SIZE bytes per page
+extern unsigned int PTW_WALKERS;
+extern unsigned int PTW_PWC_ENTRIES; // 0: no page walk caches
+
+// Stack-distance profiling of the caches (stackdist.h)
+extern unsigned int SDP_MIN_SETS;  // 0: off
+extern unsigned int SDP_MAX_SETS;
+extern unsigned int SDP_MAX_ASSOC;
+
+// Misprediction hotspot report (stats_t::dump_br_hotspots())
+extern unsigned int MISP_HOTSPOTS;  // 0: off
 
 // Branch prediction unit
 extern bool AUTO_BQ_SIZE;
 extern unsigned int BQ_SIZE;
 extern unsigned int BTB_ENTRIES;
 extern unsigned int BTB_ASSOC;
+extern unsigned int BTB_L2_ENTRIES;  // 0: no L2 BTB
+extern unsigned int BTB_L2_ASSOC;
+extern unsigned int BTB_L2_LATENCY;
 extern unsigned int RAS_SIZE;
 extern unsigned int COND_BRANCH_PRED_PER_CYCLE;
 extern unsigned int CBP_PC_LENGTH;
 extern unsigned int CBP_BHR_LENGTH;
 extern unsigned int IBP_PC_LENGTH;
 extern unsigned int IBP_BHR_LENGTH;
+extern unsigned int TAGE_KB;  // 0: gshare conditional branch predictor
+extern unsigned int TAGE_TABLES;
+extern unsigned int TAGE_MIN_HIST;
+extern unsigned int TAGE_MAX_HIST;
+extern unsigned int PERCEPTRON_KB;  // 0: gshare (or TAGE) conditional branch predictor
+extern unsigned int PERCEPTRON_TABLES;
+extern unsigned int PERCEPTRON_MAX_HIST;
+extern unsigned int LOOP_ENTRIES;  // 0: no loop predictor
+extern unsigned int SC_ENTRIES;    // 0: no statistical corrector
+extern unsigned int ITTAGE_KB;  // 0: gshare indirect branch predictor
+extern unsigned int ITTAGE_TABLES;
+extern unsigned int ITTAGE_MIN_HIST;
+extern unsigned int ITTAGE_MAX_HIST;
 extern bool ENABLE_TRACE_CACHE;
+extern unsigned int TC_ENTRIES;
+extern unsigned int TC_ASSOC;
+extern unsigned int FTQ_SIZE;  // 0: no fetch target queue (no fetch-directed I$ prefetching)
+extern unsigned int UOP_CACHE_ENTRIES;  // 0: no micro-op cache
+extern unsigned int UOP_CACHE_ASSOC;
+extern unsigned int UOP_SWITCH_PENALTY;
+extern unsigned int GATE_CHKPTS;   // 0: no fetch gating on free checkpoints
+extern unsigned int GATE_LOWCONF;  // 0: no fetch gating on low-confidence branches
+extern bool GATE_THROTTLE;
 
 // Benchmark control.
 extern bool logging_on;
@@ -101,7 +183,7 @@ extern int64_t logging_on_at;
 extern bool use_stop_amt;
 extern uint64_t stop_amt;
 
-extern uint64_t phase_interval;
+extern uint64_t phase_interval;  // 0: no phase log
 extern uint64_t verbose_phase_counters;
 
 #endif //PARAMETERS_H
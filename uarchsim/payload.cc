@@ -260,6 +260,31 @@ void payload::rollback(unsigned int index) {
 	length = MOD((PAYLOAD_BUFFER_SIZE + tail - head), PAYLOAD_BUFFER_SIZE);
 }
 
+unsigned int payload::rollback_count(unsigned int index) {
+	unsigned int count = 0;
+
+	for (unsigned int i = MOD((index + 2), PAYLOAD_BUFFER_SIZE); i != tail; i = MOD((i + 2), PAYLOAD_BUFFER_SIZE))
+		count++;
+	return(count);
+}
+
+unsigned int payload::checkpoint_count(unsigned int index) {
+	unsigned int good = 0;
+	unsigned int i = index;
+
+	// A checkpoint's instructions retire together, so they are all still in the payload buffer.
+	while (true) {
+		if (buf[i].good_instruction)
+			good++;
+		if (i == head)
+			break;
+		i = MOD((i + PAYLOAD_BUFFER_SIZE - 2), PAYLOAD_BUFFER_SIZE);
+		if (buf[i].Checkpoint_ID != buf[index].Checkpoint_ID)
+			break;
+	}
+	return(good);
+}
+
 unsigned int payload::checkpoint() {
 	return(tail);
 }
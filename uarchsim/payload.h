@@ -70,6 +70,11 @@ typedef struct {
    bool branch;				// This instruction was identified as a branch, by the BTB (if bundle came from instr. cache) or by the trace cache.
    btb_branch_type_e branch_type;	// If the instruction was identified as a branch, this is its type.
    uint64_t branch_target;        // If the instruction was identified as a branch, this is its taken target (not valid for indirect branches).
+   cycle_t fetch_cycle;           // The cycle in which the instruction was fetched (for the misprediction cost, see pipeline_t::writeback()).
+   bool uop_hit;                  // Its fetch bundle hit in the micro-op cache, which supplied the fields set by the Decode stage.
+   bool uop_fill;                 // Its fetch bundle came from the instruction cache: the Decode stage fills it into the micro-op cache,
+   uint64_t uop_start_pc;         // at the fetch bundle's start pc
+   unsigned int uop_pos;          // and the instruction's position in the fetch bundle.
 
    bool good_instruction;       // If 'true', this instruction has a
                                 // corresponding instruction in the
@@ -118,6 +123,11 @@ typedef struct {
                                 // half of a split instruction.
    bool split_store;            // Instruction is a split-store.
 
+   bool fused;                  // Macro-op fusion: the instruction before this
+                                // one was fused into it, and this instruction
+                                // carries both through the pipeline
+                                // (see pipeline_t::fuse()).
+
    // Source register A.
    bool A_valid;                // If 'true', the instruction has a
                                 // first source register.
@@ -273,6 +283,8 @@ public:
 	void split(unsigned int index);
 	void map_to_actual(pipeline_t* proc,unsigned int index);
 	void rollback(unsigned int index);
+	unsigned int rollback_count(unsigned int index);	// Instructions that rollback(index) would discard.
+	unsigned int checkpoint_count(unsigned int index);	// Good instructions from the start of index's checkpoint up to index.
 	unsigned int checkpoint();
 	void restore(unsigned int index);
   void dump(pipeline_t* proc,unsigned int index, FILE* file=stderr);
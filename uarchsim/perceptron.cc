@@ -0,0 +1,210 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "ghist.h"
+#include "perceptron.h"
+
+perceptron_t::perceptron_t(ghist_t *ghist, uint64_t m, uint64_t budget_kb, uint64_t num_tables, uint64_t max_hist) {
+   uint64_t i;
+
+   this->ghist = ghist;
+   this->m = m;
+   assert((m >= 1) && (m <= PERCEPTRON_MAX_LANES));
+   lanes = ((m <= 16) ? 16 : 32);
+
+   assert((num_tables >= 2) && (num_tables <= PERCEPTRON_MAX_TABLES));
+   assert(max_hist >= (num_tables - 1));
+   this->num_tables = num_tables;
+
+   // Partition the most recent max_hist outcomes into num_tables-1 segments whose ends grow geometrically, up to max_hist.
+   // Each segment is at least one outcome long.
+   seg_start[0] = seg_end[0] = 0;	// the bias table
+   for (i = 1; i < num_tables; i++) {
+      seg_start[i] = seg_end[i-1];
+      seg_end[i] = (uint64_t)(pow((double)max_hist, (double)i / (double)(num_tables - 1)) + 0.5);
+      if (seg_end[i] <= seg_start[i])
+         seg_end[i] = (seg_start[i] + 1);
+   }
+   seg_end[num_tables - 1] = max_hist;
+
+   // Size the tables from the budget: the largest number of rows (a power of 2) such that all tables, with "m" 8-bit weights
+   // per row, fit.  The rows are padded to "lanes" weights in the simulator; the padding is not counted.
+   log_rows = 0;
+   while (((num_tables * m) << (log_rows + 1)) <= (budget_kb << 10))
+      log_rows++;
+   assert(log_rows >= 4);	// budget too small
+
+   for (i = 0; i < num_tables; i++) {
+      weight[i] = new int8_t[lanes << log_rows];
+      memset(weight[i], 0, (lanes << log_rows));
+   }
+
+   theta = (int64_t)num_tables;
+   theta_ctr = 0;
+
+   meas_update = 0;
+   meas_mispred = 0;
+   meas_low_conf = 0;
+   meas_train = 0;
+}
+
+perceptron_t::~perceptron_t() {
+}
+
+uint64_t perceptron_t::max_history() {
+   return(seg_end[num_tables - 1]);
+}
+
+// The history is the same for all "m" predictions of a lookup (they differ in their lane), so each table's segment is folded
+// once per lookup.
+void perceptron_t::index(uint64_t pc, uint64_t hist, uint64_t row[]) {
+   uint64_t mask = ((1ULL << log_rows) - 1);
+   uint64_t h;
+
+   for (uint64_t i = 0; i < num_tables; i++) {
+      // A different pc hash per table, so that branches aliasing in one table don't alias in all of them.
+      h = ((pc >> 2) * (0x9E3779B97F4A7C15ULL + (i << 1)));
+      h ^= (h >> 29);
+      if (i > 0)
+         h ^= ghist->fold(hist - seg_start[i], seg_end[i] - seg_start[i], log_rows);
+      row[i] = (h & mask);
+   }
+}
+
+void perceptron_t::sum_weights(uint64_t row[], int16_t sum[]) {
+#if defined(__AVX2__)
+   // 16 lanes at a time: sign-extend 16 weights to 16 bits and accumulate.
+   for (uint64_t l = 0; l < lanes; l += 16) {
+      __m256i acc = _mm256_setzero_si256();
+      for (uint64_t i = 0; i < num_tables; i++)
+         acc = _mm256_add_epi16(acc, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)&weight[i][(row[i] * lanes) + l])));
+      _mm256_storeu_si256((__m256i *)&sum[l], acc);
+   }
+#elif defined(__SSE2__)
+   // 16 lanes at a time: sign-extend the low and high 8 weights to 16 bits (unpack each byte with itself, then shift
+   // arithmetic right by 8) and accumulate.
+   for (uint64_t l = 0; l < lanes; l += 16) {
+      __m128i lo = _mm_setzero_si128();
+      __m128i hi = _mm_setzero_si128();
+      for (uint64_t i = 0; i < num_tables; i++) {
+         __m128i w = _mm_loadu_si128((const __m128i *)&weight[i][(row[i] * lanes) + l]);
+         lo = _mm_add_epi16(lo, _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8));
+         hi = _mm_add_epi16(hi, _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8));
+      }
+      _mm_storeu_si128((__m128i *)&sum[l], lo);
+      _mm_storeu_si128((__m128i *)&sum[l + 8], hi);
+   }
+#else
+   for (uint64_t l = 0; l < lanes; l++)
+      sum[l] = 0;
+   for (uint64_t i = 0; i < num_tables; i++) {
+      int8_t *w = &weight[i][row[i] * lanes];
+      for (uint64_t l = 0; l < lanes; l++)
+         sum[l] += w[l];
+   }
+#endif
+}
+
+void perceptron_t::train(uint64_t row[], uint64_t pos, bool taken) {
+#if defined(__SSE2__)
+   // A saturating add of a vector that is +1 or -1 in lane "pos" and 0 elsewhere, to each selected row.
+   uint64_t l = (pos & ~15ULL);
+   __m128i delta;
+   int8_t d[16];
+
+   memset(d, 0, sizeof(d));
+   d[pos - l] = (taken ? 1 : -1);
+   delta = _mm_loadu_si128((const __m128i *)d);
+   for (uint64_t i = 0; i < num_tables; i++) {
+      __m128i *w = (__m128i *)&weight[i][(row[i] * lanes) + l];
+      _mm_storeu_si128(w, _mm_adds_epi8(_mm_loadu_si128(w), delta));
+   }
+#else
+   for (uint64_t i = 0; i < num_tables; i++) {
+      int8_t *w = &weight[i][(row[i] * lanes) + pos];
+      if (taken) {
+         if (*w < 127)
+            (*w)++;
+      }
+      else if (*w > -128) {
+         (*w)--;
+      }
+   }
+#endif
+}
+
+// Get "m" predictions packed into a uint64_t as 2-bit counters, like the gshare predictor's entries.
+// A taken prediction is 3 (strong) or 2 (weak), a not-taken prediction is 0 (strong) or 1 (weak).  A prediction is weak if the
+// magnitude of its sum does not exceed theta.
+uint64_t perceptron_t::predict(uint64_t pc, uint64_t hist) {
+   uint64_t row[PERCEPTRON_MAX_TABLES];
+   int16_t sum[PERCEPTRON_MAX_LANES];
+   uint64_t predictions = 0;
+   bool taken;
+   bool weak;
+
+   index(pc, hist, row);
+   sum_weights(row, sum);
+   for (uint64_t pos = 0; pos < m; pos++) {
+      taken = (sum[pos] >= 0);
+      weak = (std::abs((int64_t)sum[pos]) <= theta);
+      predictions |= ((uint64_t)(taken ? (weak ? 2 : 3) : (weak ? 1 : 0)) << (pos << 1));
+   }
+   return(predictions);
+}
+
+void perceptron_t::update(uint64_t pc, uint64_t hist, uint64_t pos, bool taken) {
+   uint64_t row[PERCEPTRON_MAX_TABLES];
+   int16_t sum[PERCEPTRON_MAX_LANES];
+   bool pred;
+   bool low_conf;
+
+   // Re-reference the predictor with the same context that was used to predict the branch.
+   index(pc, hist, row);
+   sum_weights(row, sum);
+   pred = (sum[pos] >= 0);
+   low_conf = (std::abs((int64_t)sum[pos]) <= theta);
+
+   meas_update++;
+   if (pred != taken)
+      meas_mispred++;
+   if (low_conf)
+      meas_low_conf++;
+
+   if ((pred != taken) || low_conf) {
+      meas_train++;
+      train(row, pos, taken);
+
+      // Adapt theta so that mispredictions and correct low-confidence predictions train the weights about equally often.
+      if (pred != taken) {
+         if (++theta_ctr >= PERCEPTRON_THETA_CTR) {
+            theta++;
+            theta_ctr = 0;
+         }
+      }
+      else if (--theta_ctr <= -PERCEPTRON_THETA_CTR) {
+         if (theta > 0)
+            theta--;
+         theta_ctr = 0;
+      }
+   }
+}
+
+void perceptron_t::output(FILE *fp) {
+   fprintf(fp, "PERCEPTRON MEASUREMENTS (%lu tables x %lu rows x %lu weights, %.1f KB)------\n", num_tables, ((uint64_t)1 << log_rows), m,
+           (double)((num_tables * m) << log_rows) / 1024.0);
+   fprintf(fp, "Table   history\n");
+   fprintf(fp, "T0      bias\n");
+   for (uint64_t i = 1; i < num_tables; i++)
+      fprintf(fp, "T%-2lu     %lu-%lu\n", i, seg_start[i], seg_end[i] - 1);
+   fprintf(fp, "Retired conditional branches = %lu, mispredicted = %lu (%.2f%%)\n", meas_update, meas_mispred, 100.0 * ((double)meas_mispred / (double)meas_update));
+   fprintf(fp, "Low-confidence (|sum| <= theta) = %lu, trained = %lu, final theta = %ld\n", meas_low_conf, meas_train, theta);
+}
@@ -0,0 +1,73 @@
+
+#define PERCEPTRON_MAX_TABLES	32
+#define PERCEPTRON_MAX_LANES	32	// at most 32 predictions per lookup: they are packed into a uint64_t as 2-bit counters
+#define PERCEPTRON_THETA_CTR	64	// the adaptive threshold changes after this many more mispredictions than low-confidence hits (or vice versa)
+
+// Hashed perceptron conditional branch predictor (D. Tarjan and K. Skadron, "Merging path and gshare indexing in perceptron branch
+// prediction"; A. Seznec, "Analysis of the O-GEometric History Length branch predictor").
+//
+// Table 0 is a bias table indexed with the pc.  Each of the other tables is indexed with a hash of the pc and one segment of the
+// global history: the segments partition the most recent "max_hist" outcomes, with geometrically increasing lengths.  The prediction
+// is the sign of the sum of the selected 8-bit weights.  The weights are trained at retirement if the prediction was wrong or the
+// magnitude of the sum did not exceed the threshold theta, which adapts to balance the two cases.
+//
+// It is a drop-in replacement for the gshare predictor of conditional branches, with the Fetch Unit's prediction model: one lookup
+// per fetch bundle, with the bundle's pc and the global history prior to the bundle, supplies "m" predictions packed into a uint64_t
+// as 2-bit counters.  Here the pc and history select one row per table, and a row holds a weight for each of the bundle's "m"
+// conditional branches (lanes).  So a lookup reads "num_tables" rows and sums them lane-by-lane, which is done with SIMD
+// instructions (AVX2 or SSE2, with a scalar fallback), keeping the host cost per bundle near that of the gshare predictor even
+// with long histories.  The predictor is trained at retirement with the same {pc, history, lane} context.
+//
+// The global history is the ghist_t owned by the Fetch Unit, which checkpoints and restores its position alongside the gshare BHRs.
+class perceptron_t {
+private:
+	ghist_t *ghist;
+
+	// "m": number of predictions per lookup.  Each row holds "lanes" weights (m rounded up to the SIMD width), of which "m" are used.
+	uint64_t m;
+	uint64_t lanes;
+
+	// Weight tables: row r of table t is weight[t][r * lanes ... r * lanes + lanes - 1].
+	uint64_t num_tables;
+	uint64_t log_rows;
+	int8_t *weight[PERCEPTRON_MAX_TABLES];
+	uint64_t seg_start[PERCEPTRON_MAX_TABLES];	// table t (t > 0) uses the outcomes [seg_start[t], seg_end[t]) before the bundle
+	uint64_t seg_end[PERCEPTRON_MAX_TABLES];
+
+	// Adaptive training threshold.
+	int64_t theta;
+	int64_t theta_ctr;
+
+	// Measurements, at retirement.
+	uint64_t meas_update;	// # retired conditional branches
+	uint64_t meas_mispred;	// # ... mispredicted by the perceptron
+	uint64_t meas_low_conf;	// # ... whose sum did not exceed theta
+	uint64_t meas_train;	// # ... that trained the weights
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	// Select the row of each table for the lookup {pc, hist}.
+	void index(uint64_t pc, uint64_t hist, uint64_t row[]);
+
+	// Sum the selected rows lane-by-lane.
+	void sum_weights(uint64_t row[], int16_t sum[]);
+
+	// Increment (taken) or decrement the weight of lane "pos" in the selected rows, saturating.
+	void train(uint64_t row[], uint64_t pos, bool taken);
+
+public:
+	perceptron_t(ghist_t *ghist, uint64_t m, uint64_t budget_kb, uint64_t num_tables, uint64_t max_hist);
+	~perceptron_t();
+
+	uint64_t max_history();
+
+	// Get "m" predictions for the fetch bundle at pc, using the history prior to the bundle (position "hist" in ghist).
+	uint64_t predict(uint64_t pc, uint64_t hist);
+
+	// Train the predictor with the outcome of the conditional branch that was the pos'th prediction of the lookup {pc, hist}.
+	void update(uint64_t pc, uint64_t hist, uint64_t pos, bool taken);
+
+	void output(FILE *fp);
+};
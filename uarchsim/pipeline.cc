@@ -33,7 +33,7 @@ static unsigned int count_bits32(unsigned int val)
   return count;
 }
 
-static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc, unsigned int blocksize, unsigned int latency, unsigned int MHSRs, const char *disclaimer)
+static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc, unsigned int blocksize, unsigned int latency, unsigned int MHSRs, unsigned int targets, unsigned int policy, const char *disclaimer)
 {
   unsigned int i = (sets * assoc * blocksize);
   if ((i >> 20) > 0)
@@ -52,6 +52,11 @@ static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc,
 
   fprintf(fp, "   hit latency = %d cycles %s\n", latency, disclaimer);
   fprintf(fp, "   MHSRs = %d\n", MHSRs);
+  if (targets)
+    fprintf(fp, "   targets per MHSR = %d\n", targets);
+  else
+    fprintf(fp, "   targets per MHSR = unlimited\n");
+  fprintf(fp, "   replacement policy = %s\n", repl_policy_name[policy]);
 }
 
 pipeline_t::pipeline_t(
@@ -73,13 +78,14 @@ pipeline_t::pipeline_t(
     uint32_t fu_lane_matrix[],
     uint32_t fu_lat[]) : processor_t(_sim, _mmu, _id),
                          statsModule(this),
-                         PAY(2 * fetch_width + fq_size /* FETCH2, DECODE, FQ */ + 2 * dispatch_width + rob_size /* RENAME2, DISPATCH, ROB */),
+                         PAY(2 * fetch_width * FETCH_BUNDLES + fq_size /* FETCH2, DECODE, FQ */ + 2 * dispatch_width + rob_size /* RENAME2, DISPATCH, ROB */),
                          FQ(fq_size, this),
                          IQ(iq_size, iq_num_parts, this),
                          LSU(lq_size, sq_size, Tid, _mmu, this)
 {
   // initializing the following variable to 0
   instr_renamed_since_last_checkpoint = 0;
+  misp_refill_pending = false;
   RETSTATE.state = RETIRE_IDLE;
   RETSTATE.chkpt_id = 0x0;
   RETSTATE.log_reg = 0;
@@ -107,6 +113,7 @@ pipeline_t::pipeline_t(
   // Pipeline widths.
   /////////////////////////////////////////////////////////////
   this->fetch_width = fetch_width;
+  this->decode_width = (fetch_width * FETCH_BUNDLES);
   this->dispatch_width = dispatch_width;
   this->issue_width = issue_width;
   this->retire_width = retire_width;
@@ -141,11 +148,12 @@ pipeline_t::pipeline_t(
                                   (ltm->tm_hour), (ltm->tm_min), (ltm->tm_sec)),           \
                           fopen(tempstr, "w"))
   this->stats_log = OPEN_LOG_FILE("stats");
-  // this->phase_log = OPEN_LOG_FILE("phase");
-  this->phase_log = (FILE *)NULL;
+  this->phase_log = (phase_interval ? OPEN_LOG_FILE("phase") : (FILE *)NULL);
+  this->sdp_log = (SDP_MIN_SETS ? OPEN_LOG_FILE("sdp") : (FILE *)NULL);
 #undef OPEN_LOG_FILE
   stats->set_log_files(stats_log, phase_log);
-  // stats->set_phase_interval("commit_count", phase_interval);
+  if (phase_interval)
+    stats->set_phase_interval("commit_count", phase_interval);
 
   /////////////////////////////////////////////////////////////
   // Unified L2 and L3 caches.
@@ -165,7 +173,12 @@ pipeline_t::pipeline_t(
                            L3_MISS_SRV_LATENCY,
                            this,
                            "l3_c",
-                           NULL);
+                           NULL,
+                           (repl_policy_e)L3_REPL_POLICY);
+      L3C->set_mhsr_targets(L3_MHSR_TARGETS, false);
+      L3C->set_inclusion((incl_policy_e)L3_INCLUSION);
+      if (SDP_MIN_SETS)
+        L3C->set_profiler(new stack_dist_t(L3_LINE_SIZE, SDP_MIN_SETS, SDP_MAX_SETS, SDP_MAX_ASSOC));
     }
     else
     {
@@ -182,12 +195,61 @@ pipeline_t::pipeline_t(
                          L2_MISS_SRV_LATENCY,
                          this,
                          "l2_c",
-                         L3C);
+                         L3C,
+                         (repl_policy_e)L2_REPL_POLICY);
+    L2C->set_mhsr_targets(L2_MHSR_TARGETS, false);
+    L2C->set_inclusion((incl_policy_e)L2_INCLUSION);
+    if (L3C)
+      L3C->add_upper_level(L2C);
+    if (L2_PREFETCHER != PF_NONE)
+      L2C->set_prefetcher(new_prefetcher((pf_kind_e)L2_PREFETCHER, L2_LINE_SIZE, L2_PF_DEGREE), false);
+    if (SDP_MIN_SETS)
+      L2C->set_profiler(new stack_dist_t(L2_LINE_SIZE, SDP_MIN_SETS, SDP_MAX_SETS, SDP_MAX_ASSOC));
+
+    // Main memory behind the last-level cache.
+    if (DRAM_PRESENT)
+    {
+      DRAM = new dram_t(DRAM_CHANNELS,
+                        DRAM_RANKS,
+                        DRAM_BANKS,
+                        DRAM_ROW_SIZE,
+                        DRAM_OPEN_PAGE,
+                        (L3C ? L3_LINE_SIZE : L2_LINE_SIZE),
+                        DRAM_tRCD, DRAM_tCAS, DRAM_tRP, DRAM_tRAS,
+                        DRAM_tBURST, DRAM_tREFI, DRAM_tRFC, DRAM_tCTRL);
+      (L3C ? L3C : L2C)->set_memory(DRAM);
+    }
+    else
+    {
+      DRAM = (dram_t *)NULL;
+    }
   }
   else
   {
     L2C = (CacheClass *)NULL;
     L3C = (CacheClass *)NULL;
+    DRAM = (dram_t *)NULL;
+  }
+
+  /////////////////////////////////////////////////////////////
+  // TLBs and page table walker.
+  /////////////////////////////////////////////////////////////
+
+  ITLB = (tlb_t *)NULL;
+  DTLB = (tlb_t *)NULL;
+  L2TLB = (tlb_t *)NULL;
+  PTW = (page_walker_t *)NULL;
+  if (ITLB_ENTRIES || DTLB_ENTRIES)
+  {
+    // Page table walks read PTEs through the L1 D$, like loads: the PTE lines are then cached the same way under every
+    // inclusion policy (an exclusive L2 only moves lines up to the L1 D$).
+    PTW = new page_walker_t(PTW_WALKERS, PTW_PWC_ENTRIES, TLB_PAGE_SIZE, LSU.get_dcache(), L1_DC_MISS_LATENCY, 0);
+    if (L2_TLB_ENTRIES)
+      L2TLB = new tlb_t("L2 TLB", L2_TLB_ENTRIES, L2_TLB_ASSOC, L2_TLB_LATENCY, TLB_PAGE_SIZE, (tlb_t *)NULL, PTW);
+    if (ITLB_ENTRIES)
+      ITLB = new tlb_t("ITLB", ITLB_ENTRIES, ITLB_ASSOC, 0, TLB_PAGE_SIZE, L2TLB, (L2TLB ? (page_walker_t *)NULL : PTW));
+    if (DTLB_ENTRIES)
+      DTLB = new tlb_t("DTLB", DTLB_ENTRIES, DTLB_ASSOC, 0, TLB_PAGE_SIZE, L2TLB, (L2TLB ? (page_walker_t *)NULL : PTW));
   }
 
   /////////////////////////////////////////////////////////////
@@ -199,19 +261,36 @@ pipeline_t::pipeline_t(
     // Auto-size the BQ to be the maximum number of in-flight instructions.
     // This is overkill the vast majority of the time but prevents the BQ overflow assertion,
     // which happens rarely in some program phases with dense branching.
-    BQ_SIZE = (2 * fetch_width + fq_size /* FETCH2, DECODE, FQ */ + 2 * dispatch_width + rob_size /* RENAME2, DISPATCH, ROB */);
+    BQ_SIZE = (2 * fetch_width * FETCH_BUNDLES + fq_size /* FETCH2, DECODE, FQ */ + 2 * dispatch_width + rob_size /* RENAME2, DISPATCH, ROB */);
   }
 
   FetchUnit = new fetchunit_t(fetch_width,
                               COND_BRANCH_PRED_PER_CYCLE,
+                              FETCH_BUNDLES,
                               BTB_ENTRIES,
                               BTB_ASSOC,
+                              BTB_L2_ENTRIES, BTB_L2_ASSOC, BTB_L2_LATENCY,
                               CBP_PC_LENGTH, CBP_BHR_LENGTH,
                               IBP_PC_LENGTH, IBP_BHR_LENGTH,
+                              TAGE_KB, TAGE_TABLES,
+                              TAGE_MIN_HIST, TAGE_MAX_HIST,
+                              PERCEPTRON_KB, PERCEPTRON_TABLES, PERCEPTRON_MAX_HIST,
+                              LOOP_ENTRIES, SC_ENTRIES,
+                              ITTAGE_KB, ITTAGE_TABLES,
+                              ITTAGE_MIN_HIST, ITTAGE_MAX_HIST,
                               RAS_SIZE,
                               BQ_SIZE,
+                              FTQ_SIZE,
                               ENABLE_TRACE_CACHE,
                               PERFECT_TRACE_CACHE,
+                              TC_ENTRIES,
+                              TC_ASSOC,
+                              UOP_CACHE_ENTRIES,
+                              UOP_CACHE_ASSOC,
+                              UOP_SWITCH_PENALTY,
+                              GATE_CHKPTS,
+                              GATE_LOWCONF,
+                              GATE_THROTTLE,
                               PERFECT_BRANCH_PRED,
                               PERFECT_ICACHE,
                               L1_IC_SETS,
@@ -226,11 +305,12 @@ pipeline_t::pipeline_t(
                               _mmu,  // pointer to mmu
                               this,  // pointer to pipeline_t
                               &PAY); // pointer to PAY
+  FetchUnit->set_itlb(ITLB);
 
   /////////////////////////////////////////////////////////////
   // Pipeline register between the Fetch and Decode Stages.
   /////////////////////////////////////////////////////////////
-  DECODE = new pipeline_register[fetch_width];
+  DECODE = new pipeline_register[decode_width];
 
   /////////////////////////////////////////////////////////////
   // Pipeline register between the Rename1 and Rename2
@@ -295,6 +375,7 @@ pipeline_t::pipeline_t(
   /////////////////////////////////////////////////////////////
 
   LSU.set_l2_cache(L2C);
+  LSU.set_dtlb(DTLB);
 
   // Declare and set the various knobs in the knobs database.
   // These will be printed in the stats.log file at the end of the run.
@@ -322,6 +403,8 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "LOAD/STORE UNIT:\n");
   fprintf(stats_log, "   LOAD QUEUE = %d\n", lq_size);
   fprintf(stats_log, "   STORE QUEUE = %d\n", sq_size);
+  if (STORE_BUFFER_SIZE)
+    fprintf(stats_log, "   STORE BUFFER = %d (post-retirement, write-combining%s)\n", STORE_BUFFER_SIZE, (STORE_RFO ? ", RFO at store address" : ""));
   if (ORACLE_DISAMBIG)
     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: oracle\n");
   else if (!SPEC_DISAMBIG)
@@ -332,9 +415,17 @@ pipeline_t::pipeline_t(
     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: MDP-sticky\n");
   else
     fprintf(stats_log, "   MEMORY DEPENDENCE PREDICTOR: MDP-ctr (max ctr: %d)\n", MDP_MAX);
+  fprintf(stats_log, "MACRO-OP FUSION:");
+  if (!FUSION)
+    fprintf(stats_log, " none");
+  for (unsigned int i = 0; i < (unsigned int)NUM_FUSE_RULES; i++)
+    if (FUSION & (1 << i))
+      fprintf(stats_log, " %s", fuse_rule_name[i]);
+  fprintf(stats_log, "\n");
 
   fprintf(stats_log, "\n=== PIPELINE STAGE WIDTHS =======================================================\n\n");
   fprintf(stats_log, "FETCH WIDTH = %d\n", fetch_width);
+  fprintf(stats_log, "FETCH BUNDLES = %d\n", FETCH_BUNDLES);
   fprintf(stats_log, "DISPATCH WIDTH = %d\n", dispatch_width);
   fprintf(stats_log, "ISSUE WIDTH = %d\n", issue_width);
   fprintf(stats_log, "RETIRE WIDTH = %d\n", retire_width);
@@ -357,42 +448,116 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "\n=== MEMORY HIERARCHY ============================================================\n\n");
 
   fprintf(stats_log, "L1 I$:\n");
-  print_cache_config(stats_log, L1_IC_SETS, L1_IC_ASSOC, (1 << L1_IC_LINE_SIZE), L1_IC_HIT_LATENCY, L1_IC_NUM_MHSRs, "(superseded by fetch unit's pipeline depth)");
+  print_cache_config(stats_log, L1_IC_SETS, L1_IC_ASSOC, (1 << L1_IC_LINE_SIZE), L1_IC_HIT_LATENCY, L1_IC_NUM_MHSRs, 0, REPL_LRU, "(superseded by fetch unit's pipeline depth)");
   if (!L2_PRESENT)
     fprintf(stats_log, "   miss latency = %d cycles\n", L1_IC_MISS_LATENCY);
 
   fprintf(stats_log, "L1 D$:\n");
-  print_cache_config(stats_log, L1_DC_SETS, L1_DC_ASSOC, (1 << L1_DC_LINE_SIZE), L1_DC_HIT_LATENCY, L1_DC_NUM_MHSRs, "(superseded by load/store lane's pipeline depth)");
+  print_cache_config(stats_log, L1_DC_SETS, L1_DC_ASSOC, (1 << L1_DC_LINE_SIZE), L1_DC_HIT_LATENCY, L1_DC_NUM_MHSRs, L1_DC_MHSR_TARGETS, L1_DC_REPL_POLICY, "(superseded by load/store lane's pipeline depth)");
+  if (L1_DC_PREFETCHER != PF_NONE)
+    fprintf(stats_log, "   prefetcher = %s, degree %d\n", pf_kind_name[L1_DC_PREFETCHER], L1_DC_PF_DEGREE);
+  if (L1_DC_VICTIM_ENTRIES)
+    fprintf(stats_log, "   victim cache = %d entries, fully associative, %d cycle(s)\n", L1_DC_VICTIM_ENTRIES, L1_DC_VICTIM_LATENCY);
+  if (L1_DC_PORTS || (L1_DC_BANKS > 1))
+    fprintf(stats_log, "   ports = %d (0: unlimited), banks = %d (interleaved every %d bytes)\n", L1_DC_PORTS, (L1_DC_BANKS ? L1_DC_BANKS : 1), (1 << L1_DC_BANK_INTERLEAVE));
   if (!L2_PRESENT)
     fprintf(stats_log, "   miss latency = %d cycles\n", L1_DC_MISS_LATENCY);
 
   if (L2_PRESENT)
   {
     fprintf(stats_log, "L2$:\n");
-    print_cache_config(stats_log, L2_SETS, L2_ASSOC, (1 << L2_LINE_SIZE), L2_HIT_LATENCY, L2_NUM_MHSRs, "");
+    print_cache_config(stats_log, L2_SETS, L2_ASSOC, (1 << L2_LINE_SIZE), L2_HIT_LATENCY, L2_NUM_MHSRs, L2_MHSR_TARGETS, L2_REPL_POLICY, "");
+    if (L2_PREFETCHER != PF_NONE)
+      fprintf(stats_log, "   prefetcher = %s, degree %d\n", pf_kind_name[L2_PREFETCHER], L2_PF_DEGREE);
+    fprintf(stats_log, "   inclusion of L1 caches = %s\n", incl_policy_name[L2_INCLUSION]);
     if (!L3_PRESENT)
-      fprintf(stats_log, "   miss latency = %d cycles\n", L2_MISS_LATENCY);
+      if (!DRAM_PRESENT)
+        fprintf(stats_log, "   miss latency = %d cycles\n", L2_MISS_LATENCY);
 
     if (L3_PRESENT)
     {
       fprintf(stats_log, "L3$:\n");
-      print_cache_config(stats_log, L3_SETS, L3_ASSOC, (1 << L3_LINE_SIZE), L3_HIT_LATENCY, L3_NUM_MHSRs, "");
-      fprintf(stats_log, "   miss latency = %d cycles\n", L3_MISS_LATENCY);
+      print_cache_config(stats_log, L3_SETS, L3_ASSOC, (1 << L3_LINE_SIZE), L3_HIT_LATENCY, L3_NUM_MHSRs, L3_MHSR_TARGETS, L3_REPL_POLICY, "");
+      fprintf(stats_log, "   inclusion of L2 cache = %s\n", incl_policy_name[L3_INCLUSION]);
+      if (!DRAM_PRESENT)
+        fprintf(stats_log, "   miss latency = %d cycles\n", L3_MISS_LATENCY);
+    }
+
+    if (DRAM_PRESENT)
+    {
+      fprintf(stats_log, "DRAM:\n");
+      fprintf(stats_log, "   %d channel(s), %d rank(s) per channel, %d bank(s) per rank\n", DRAM_CHANNELS, DRAM_RANKS, DRAM_BANKS);
+      fprintf(stats_log, "   %d B row buffer, %s-page policy\n", (1 << DRAM_ROW_SIZE), (DRAM_OPEN_PAGE ? "open" : "closed"));
+      fprintf(stats_log, "   tRCD = %d, tCAS = %d, tRP = %d, tRAS = %d, tBURST = %d cycles\n", DRAM_tRCD, DRAM_tCAS, DRAM_tRP, DRAM_tRAS, DRAM_tBURST);
+      fprintf(stats_log, "   tREFI = %d, tRFC = %d cycles\n", DRAM_tREFI, DRAM_tRFC);
+      fprintf(stats_log, "   controller latency = %d cycles\n", DRAM_tCTRL);
     }
   }
 
+  if (ITLB_ENTRIES || DTLB_ENTRIES)
+  {
+    fprintf(stats_log, "TLBs (%d B pages):\n", (1 << TLB_PAGE_SIZE));
+    if (ITLB_ENTRIES)
+      fprintf(stats_log, "   ITLB = %d entries, %d-way\n", ITLB_ENTRIES, ITLB_ASSOC);
+    else
+      fprintf(stats_log, "   ITLB = none (translation is free)\n");
+    if (DTLB_ENTRIES)
+      fprintf(stats_log, "   DTLB = %d entries, %d-way\n", DTLB_ENTRIES, DTLB_ASSOC);
+    else
+      fprintf(stats_log, "   DTLB = none (translation is free)\n");
+    if (L2_TLB_ENTRIES)
+      fprintf(stats_log, "   L2 TLB = %d entries, %d-way, %d cycles\n", L2_TLB_ENTRIES, L2_TLB_ASSOC, L2_TLB_LATENCY);
+    fprintf(stats_log, "   page table walker = %d walker(s), %d-entry page walk caches, PTEs read through the L1 D$\n",
+            PTW_WALKERS, PTW_PWC_ENTRIES);
+  }
+
   fprintf(stats_log, "\n=== BRANCH PREDICTOR ============================================================\n\n");
 
   fprintf(stats_log, "BQ_SIZE = %d (%s)\n", BQ_SIZE, (AUTO_BQ_SIZE ? "auto-sized" : "user-specified"));
   fprintf(stats_log, "BTB_ENTRIES = %d\n", BTB_ENTRIES);
   fprintf(stats_log, "BTB_ASSOC = %d\n", BTB_ASSOC);
+  fprintf(stats_log, "BTB_L2_ENTRIES = %d\n", BTB_L2_ENTRIES);
+  if (BTB_L2_ENTRIES) {
+     fprintf(stats_log, "BTB_L2_ASSOC = %d\n", BTB_L2_ASSOC);
+     fprintf(stats_log, "BTB_L2_LATENCY = %d\n", BTB_L2_LATENCY);
+  }
   fprintf(stats_log, "RAS_SIZE = %d\n", RAS_SIZE);
   fprintf(stats_log, "COND_BRANCH_PRED_PER_CYCLE = %d\n", COND_BRANCH_PRED_PER_CYCLE);
   fprintf(stats_log, "CBP_PC_LENGTH = %d\n", CBP_PC_LENGTH);
   fprintf(stats_log, "CBP_BHR_LENGTH = %d\n", CBP_BHR_LENGTH);
   fprintf(stats_log, "IBP_PC_LENGTH = %d\n", IBP_PC_LENGTH);
   fprintf(stats_log, "IBP_BHR_LENGTH = %d\n", IBP_BHR_LENGTH);
+  fprintf(stats_log, "TAGE_KB = %d\n", TAGE_KB);
+  if (TAGE_KB) {
+     fprintf(stats_log, "TAGE_TABLES = %d\n", TAGE_TABLES);
+     fprintf(stats_log, "TAGE_MIN_HIST = %d\n", TAGE_MIN_HIST);
+     fprintf(stats_log, "TAGE_MAX_HIST = %d\n", TAGE_MAX_HIST);
+  }
+  fprintf(stats_log, "PERCEPTRON_KB = %d\n", PERCEPTRON_KB);
+  if (PERCEPTRON_KB) {
+     fprintf(stats_log, "PERCEPTRON_TABLES = %d\n", PERCEPTRON_TABLES);
+     fprintf(stats_log, "PERCEPTRON_MAX_HIST = %d\n", PERCEPTRON_MAX_HIST);
+  }
+  fprintf(stats_log, "LOOP_ENTRIES = %d\n", LOOP_ENTRIES);
+  fprintf(stats_log, "SC_ENTRIES = %d\n", SC_ENTRIES);
+  fprintf(stats_log, "ITTAGE_KB = %d\n", ITTAGE_KB);
+  if (ITTAGE_KB) {
+     fprintf(stats_log, "ITTAGE_TABLES = %d\n", ITTAGE_TABLES);
+     fprintf(stats_log, "ITTAGE_MIN_HIST = %d\n", ITTAGE_MIN_HIST);
+     fprintf(stats_log, "ITTAGE_MAX_HIST = %d\n", ITTAGE_MAX_HIST);
+  }
   fprintf(stats_log, "ENABLE_TRACE_CACHE = %d\n", (ENABLE_TRACE_CACHE ? 1 : 0));
+  fprintf(stats_log, "TC_ENTRIES = %d\n", TC_ENTRIES);
+  fprintf(stats_log, "TC_ASSOC = %d\n", TC_ASSOC);
+  fprintf(stats_log, "UOP_CACHE_ENTRIES = %d\n", UOP_CACHE_ENTRIES);
+  if (UOP_CACHE_ENTRIES) {
+     fprintf(stats_log, "UOP_CACHE_ASSOC = %d\n", UOP_CACHE_ASSOC);
+     fprintf(stats_log, "UOP_SWITCH_PENALTY = %d\n", UOP_SWITCH_PENALTY);
+  }
+  fprintf(stats_log, "GATE_CHKPTS = %d\n", GATE_CHKPTS);
+  fprintf(stats_log, "GATE_LOWCONF = %d\n", GATE_LOWCONF);
+  if (GATE_CHKPTS || GATE_LOWCONF)
+     fprintf(stats_log, "GATE_THROTTLE = %d\n", (GATE_THROTTLE ? 1 : 0));
 
   fprintf(stats_log, "\n=== INTERNAL SIMULATOR STRUCTURES ===============================================\n\n");
 
@@ -427,6 +592,7 @@ pipeline_t::~pipeline_t()
   stats->dump_rates();
   stats->dump_pc_histogram();
   stats->dump_br_histogram();
+  stats->dump_br_hotspots(MISP_HOTSPOTS);
 #ifdef RISCV_ENABLE_HISTOGRAM
   if (histogram_enabled)
   {
@@ -440,6 +606,32 @@ pipeline_t::~pipeline_t()
 
   FetchUnit->output(stats->get_counter("commit_count"), stats->get_counter("cycle_count"), stats_log);
   LSU.dump_stats(stats_log);
+  if (L2C)
+    L2C->dump_stats(stats_log);
+  if (L3C)
+    L3C->dump_stats(stats_log);
+  if (DRAM)
+    DRAM->dump_stats(stats_log, stats->get_counter("cycle_count"));
+  if (PTW)
+  {
+    fprintf(stats_log, "\n=== TLB MEASUREMENTS ============================================================\n\n");
+    if (ITLB)
+      ITLB->dump_stats(stats_log, stats->get_counter("commit_count"));
+    if (DTLB)
+      DTLB->dump_stats(stats_log, stats->get_counter("commit_count"));
+    if (L2TLB)
+      L2TLB->dump_stats(stats_log, stats->get_counter("commit_count"));
+    PTW->dump_stats(stats_log);
+  }
+  if (sdp_log)
+  {
+    FetchUnit->dump_profile(sdp_log, stats->get_counter("commit_count"));
+    LSU.dump_profile(sdp_log, stats->get_counter("commit_count"));
+    if (L2C)
+      L2C->dump_profile(sdp_log, stats->get_counter("commit_count"));
+    if (L3C)
+      L3C->dump_profile(sdp_log, stats->get_counter("commit_count"));
+  }
 
 #ifdef RISCV_MICRO_DEBUG
   fclose(this->fetch_log);
@@ -457,7 +649,10 @@ pipeline_t::~pipeline_t()
 #endif
 
   fclose(this->stats_log);
-  // fclose(this->phase_log   );
+  if (this->phase_log)
+    fclose(this->phase_log);
+  if (this->sdp_log)
+    fclose(this->sdp_log);
 }
 
 inline void pipeline_t::update_histogram(size_t pc)
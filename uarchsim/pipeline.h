@@ -8,6 +8,7 @@
 #include <cstring>
 #include <vector>
 #include <map>
+#include <deque>
 #include <cassert>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -26,6 +27,8 @@
 
 #include "CacheClass.h" // generic cache class used for instr. cache in FetchUnit, data cache in LSU, and unified L2 cache
 
+#include "tlb.h" // ITLB, DTLB, L2 TLB, and page table walker
+
 #include "fetchunit.h" // FETCH UNIT
 
 #include "fetch_queue.h" // FETCH QUEUE
@@ -191,6 +194,11 @@ public:
 	retire_state_t RETSTATE;
 	// declaring the following variable
 	uint64_t instr_renamed_since_last_checkpoint;
+	// Misprediction hotspot report: the refill bubble of the last mispredicted branch, from its resolution (pc, cycle)
+	// to the first instruction renamed after it, is charged to the branch by the Rename2 stage.
+	bool misp_refill_pending;
+	uint64_t misp_refill_pc;
+	cycle_t misp_refill_cycle;
 	~pipeline_t();
 
 	//	void set_debug(bool value);
@@ -293,6 +301,7 @@ private:
 	FILE *program_log;
 	FILE *stats_log;
 	FILE *phase_log;
+	FILE *sdp_log;		// Stack-distance profiles (--sdp).
 	FILE *cache_log;
 
 	uint64_t sequence;
@@ -311,7 +320,8 @@ private:
 	/////////////////////////////////////////////////////////////
 	// Pipeline widths.
 	/////////////////////////////////////////////////////////////
-	unsigned int fetch_width;	 // fetch, decode width
+	unsigned int fetch_width;	 // fetch width (per fetch bundle)
+	unsigned int decode_width;	 // decode width: fetch width times the number of fetch bundles per cycle
 	unsigned int dispatch_width; // rename, dispatch width
 	unsigned int issue_width;	 // issue width
 	unsigned int retire_width;	 // retire width
@@ -365,10 +375,19 @@ private:
 	lsu LSU;
 
 	/////////////////////////////////////////////////////////////
-	// Unified L2 and L3 caches.
+	// Unified L2 and L3 caches, and main memory.
 	/////////////////////////////////////////////////////////////
 	CacheClass *L2C;
 	CacheClass *L3C;
+	dram_t *DRAM;
+
+	/////////////////////////////////////////////////////////////
+	// TLBs and page table walker (NULL: translation is free).
+	/////////////////////////////////////////////////////////////
+	tlb_t *ITLB;
+	tlb_t *DTLB;
+	tlb_t *L2TLB;
+	page_walker_t *PTW;
 
 	//////////////////////
 	// PRIVATE FUNCTIONS
@@ -377,6 +396,7 @@ private:
 	unsigned int steer(fu_type fu);
 	void agen(unsigned int index);
 	void alu(unsigned int index);
+	void alu_fused(unsigned int index);
 	void squash_complete(reg_t jump_PC);
 	void selective_squash(uint64_t squash_mask);
 	void checker();
@@ -404,6 +424,9 @@ public:
 	// Functions for pipeline stages.
 	void fetch();
 	void decode();
+	void decode_instr(unsigned int index);
+	void decode_bypass();
+	bool fuse(unsigned int first, unsigned int second);
 	void rename1();
 	void rename2();
 	void dispatch();
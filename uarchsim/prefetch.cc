@@ -0,0 +1,334 @@
+/*--------------------------------------------------------------------------*\
+ | prefetch.cc
+ |
+ | Hardware data prefetchers for CacheClass.  See prefetch.h.
+\*--------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <cassert>
+
+#include "prefetch.h"
+
+/*--------------------------------------------------------------------------*\
+ | Next-N-line.
+\*--------------------------------------------------------------------------*/
+
+void nextline_prefetcher_t::train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+                                  std::vector<reg_t>& candidates)
+{
+	reg_t line = (addr >> lineSize);
+
+	if (!miss && !pfHit)
+		return;
+
+	for (unsigned int k = 1; k <= degree; k++)
+		candidates.push_back((line + k) << lineSize);
+}
+
+/*--------------------------------------------------------------------------*\
+ | PC-indexed stride.
+\*--------------------------------------------------------------------------*/
+
+stride_prefetcher_t::stride_prefetcher_t(unsigned int _lineSize, unsigned int _degree)
+	: prefetcher_t(_lineSize, _degree)
+{
+	for (unsigned int i = 0; i < PF_STRIDE_ENTRIES; i++)
+		table[i].valid = false;
+	n_allocs = 0;
+	n_confident = 0;
+}
+
+void stride_prefetcher_t::train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+                                std::vector<reg_t>& candidates)
+{
+	stride_entry_t* e = &table[(pc >> 1) % PF_STRIDE_ENTRIES];
+	int64_t stride;
+	bool wasConfident;
+	reg_t line;
+	reg_t target;
+	unsigned int k;
+
+	if (!e->valid || (e->tag != pc)) {
+		e->valid = true;
+		e->tag = pc;
+		e->lastAddr = addr;
+		e->stride = 0;
+		e->conf = 0;
+		n_allocs++;
+		return;
+	}
+
+	wasConfident = (e->conf >= PF_STRIDE_CONF_THRESHOLD);
+
+	stride = (int64_t)(addr - e->lastAddr);
+	if (stride == e->stride) {
+		if (e->conf < PF_STRIDE_CONF_MAX)
+			e->conf++;
+	}
+	else {
+		if (e->conf > 0)
+			e->conf--;
+		if (e->conf == 0)
+			e->stride = stride;
+		wasConfident = false;
+	}
+	e->lastAddr = addr;
+
+	if ((e->conf < PF_STRIDE_CONF_THRESHOLD) || (e->stride == 0))
+		return;
+
+	n_confident++;
+
+	// The lines up to (degree-1) strides ahead were requested by the
+	// previous accesses of this PC: only the newest one is new.
+	line = (addr >> lineSize);
+	for (k = (wasConfident ? degree : 1); k <= degree; k++) {
+		target = ((addr + (reg_t)(k * e->stride)) >> lineSize);
+		if (target != line)
+			candidates.push_back(target << lineSize);
+	}
+}
+
+void stride_prefetcher_t::dump(FILE* fp)
+{
+	fprintf(fp, "  stride table allocations        = %" PRIu64 "\n", n_allocs);
+	fprintf(fp, "  accesses with a confirmed stride= %" PRIu64 "\n", n_confident);
+}
+
+/*--------------------------------------------------------------------------*\
+ | Stream.
+\*--------------------------------------------------------------------------*/
+
+stream_prefetcher_t::stream_prefetcher_t(unsigned int _lineSize, unsigned int _degree)
+	: prefetcher_t(_lineSize, _degree)
+{
+	for (unsigned int i = 0; i < PF_STREAMS; i++) {
+		stream[i].valid = false;
+		stream[i].lru = 0;
+	}
+	timestamp = 0;
+	n_allocs = 0;
+	n_confirmed = 0;
+}
+
+void stream_prefetcher_t::train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+                                std::vector<reg_t>& candidates)
+{
+	reg_t line = (addr >> lineSize);
+	stream_entry_t* s = NULL;
+	unsigned int i;
+	unsigned int victim = 0;
+	int64_t distance;
+	int d;
+	reg_t target;
+	reg_t next;
+
+	if (!miss && !pfHit)
+		return;
+
+	for (i = 0; i < PF_STREAMS; i++) {
+		if (stream[i].valid) {
+			distance = (int64_t)(line - stream[i].lastLine);
+			if ((distance >= -PF_STREAM_WINDOW) && (distance <= PF_STREAM_WINDOW)) {
+				s = &stream[i];
+				break;
+			}
+		}
+		if (!stream[i].valid || (stream[i].lru < stream[victim].lru))
+			victim = i;
+	}
+
+	timestamp++;
+
+	if (s == NULL) {
+		// Allocate a new, unconfirmed stream.
+		s = &stream[victim];
+		s->valid = true;
+		s->lastLine = line;
+		s->pfLine = line;
+		s->dir = 0;
+		s->confirmed = false;
+		s->lru = timestamp;
+		n_allocs++;
+		return;
+	}
+
+	s->lru = timestamp;
+	if (line == s->lastLine)
+		return;
+	d = ((line > s->lastLine) ? 1 : -1);
+
+	if (!s->confirmed) {
+		// Two consecutive moves in the same direction confirm the stream.
+		if (s->dir == d) {
+			s->confirmed = true;
+			s->pfLine = line;
+			n_confirmed++;
+		}
+		s->dir = d;
+	}
+	else if (s->dir != d) {
+		s->confirmed = false;
+		s->dir = d;
+	}
+	s->lastLine = line;
+
+	if (!s->confirmed)
+		return;
+
+	// Keep 'degree' lines prefetched ahead of the stream.
+	target = (line + (reg_t)((int64_t)s->dir * (int64_t)degree));
+	distance = (int64_t)(s->pfLine - line) * s->dir;
+	next = ((distance > 0) ? s->pfLine : line) + (reg_t)(int64_t)s->dir;
+	while (((int64_t)(target - next) * s->dir) >= 0) {
+		candidates.push_back(next << lineSize);
+		next += (reg_t)(int64_t)s->dir;
+	}
+	if (((int64_t)(target - s->pfLine) * s->dir) > 0)
+		s->pfLine = target;
+}
+
+void stream_prefetcher_t::dump(FILE* fp)
+{
+	fprintf(fp, "  streams allocated               = %" PRIu64 "\n", n_allocs);
+	fprintf(fp, "  streams confirmed               = %" PRIu64 "\n", n_confirmed);
+}
+
+/*--------------------------------------------------------------------------*\
+ | Best-offset.
+\*--------------------------------------------------------------------------*/
+
+bo_prefetcher_t::bo_prefetcher_t(unsigned int _lineSize, unsigned int _degree)
+	: prefetcher_t(_lineSize, _degree)
+{
+	int i, n;
+
+	// Offsets 1..256 whose only prime factors are 2, 3, and 5.
+	for (i = 1; i <= 256; i++) {
+		n = i;
+		while ((n % 2) == 0) n /= 2;
+		while ((n % 3) == 0) n /= 3;
+		while ((n % 5) == 0) n /= 5;
+		if (n == 1)
+			offsets.push_back(i);
+	}
+	scores.assign(offsets.size(), 0);
+	chosen.assign(offsets.size(), 0);
+
+	testIndex = 0;
+	round = 0;
+	bestOffset = 1;
+
+	for (i = 0; i < PF_BO_RR_ENTRIES; i++)
+		rrValid[i] = false;
+
+	n_phases = 0;
+	n_phases_off = 0;
+}
+
+void bo_prefetcher_t::rr_insert(reg_t line)
+{
+	unsigned int i = (unsigned int)((line ^ (line >> 8)) % PF_BO_RR_ENTRIES);
+	rr[i] = line;
+	rrValid[i] = true;
+}
+
+bool bo_prefetcher_t::rr_hit(reg_t line)
+{
+	unsigned int i = (unsigned int)((line ^ (line >> 8)) % PF_BO_RR_ENTRIES);
+	return(rrValid[i] && (rr[i] == line));
+}
+
+void bo_prefetcher_t::end_phase()
+{
+	unsigned int best = 0;
+	unsigned int i;
+
+	for (i = 1; i < offsets.size(); i++)
+		if (scores[i] > scores[best])
+			best = i;
+
+	n_phases++;
+	if (scores[best] <= PF_BO_BAD_SCORE) {
+		bestOffset = 0;
+		n_phases_off++;
+	}
+	else {
+		bestOffset = offsets[best];
+		chosen[best]++;
+	}
+
+	scores.assign(offsets.size(), 0);
+	testIndex = 0;
+	round = 0;
+}
+
+void bo_prefetcher_t::train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+                            std::vector<reg_t>& candidates)
+{
+	reg_t line = (addr >> lineSize);
+	reg_t d;
+
+	// Prefetches that have completed by now become recent requests.
+	while (!pending.empty() && (pending.front().first <= curCycle)) {
+		rr_insert(pending.front().second);
+		pending.pop_front();
+	}
+
+	if (!miss && !pfHit)
+		return;
+
+	// Learning: test one offset per trigger.
+	d = (reg_t)offsets[testIndex];
+	if ((line >= d) && rr_hit(line - d)) {
+		if (++scores[testIndex] >= PF_BO_SCORE_MAX) {
+			end_phase();
+			d = 0;
+		}
+	}
+	if (d != 0) {
+		if (++testIndex == offsets.size()) {
+			testIndex = 0;
+			if (++round >= PF_BO_ROUND_MAX)
+				end_phase();
+		}
+	}
+
+	if (bestOffset != 0)
+		candidates.push_back((line + (reg_t)bestOffset) << lineSize);
+	else
+		rr_insert(line);
+}
+
+void bo_prefetcher_t::fill(cycle_t fillCycle, reg_t addr)
+{
+	// The base line of the prefetch enters the RR table once it is filled.
+	pending.push_back(std::make_pair(fillCycle, (addr >> lineSize) - (reg_t)bestOffset));
+	if (pending.size() > PF_BO_RR_ENTRIES) {
+		rr_insert(pending.front().second);
+		pending.pop_front();
+	}
+}
+
+void bo_prefetcher_t::dump(FILE* fp)
+{
+	fprintf(fp, "  learning phases                 = %" PRIu64 " (%" PRIu64 " turned prefetching off)\n", n_phases, n_phases_off);
+	fprintf(fp, "  current offset                  = %d\n", bestOffset);
+	fprintf(fp, "  offsets chosen (offset, phases):\n");
+	for (unsigned int i = 0; i < offsets.size(); i++) {
+		if (chosen[i])
+			fprintf(fp, "    %3d %12" PRIu64 "\n", offsets[i], chosen[i]);
+	}
+}
+
+prefetcher_t* new_prefetcher(pf_kind_e kind, unsigned int lineSize, unsigned int degree)
+{
+	switch (kind) {
+		case PF_NONE:        return((prefetcher_t*)NULL);
+		case PF_NEXTLINE:    return(new nextline_prefetcher_t(lineSize, degree));
+		case PF_STRIDE:      return(new stride_prefetcher_t(lineSize, degree));
+		case PF_STREAM:      return(new stream_prefetcher_t(lineSize, degree));
+		case PF_BEST_OFFSET: return(new bo_prefetcher_t(lineSize, degree));
+		default:             assert(0); return((prefetcher_t*)NULL);
+	}
+}
@@ -0,0 +1,205 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+/*--------------------------------------------------------------------------*\
+ | prefetch.h
+ |
+ | Hardware data prefetchers for CacheClass.
+ |
+ | A prefetcher is attached to one cache level (CacheClass::set_prefetcher).
+ |  The level trains it with its access stream and issues the candidate
+ |  lines it returns into spare MHSRs (see CacheClass::Prefetch).
+ |
+ |  L1 D$:  trained by the LSU with every load and store (PC available).
+ |  L2 $:   trained by the L2 itself with its demand miss stream and with
+ |          demand hits on prefetched lines (no PC).
+ |
+ | Prefetchers:
+ |  nextline   On a miss or prefetch hit to line X, fetch X+1 .. X+degree.
+ |  stride     PC-indexed reference prediction table.  Once a load/store
+ |             PC repeats the same stride twice, fetch degree strides ahead.
+ |  stream     Tracks up to PF_STREAMS ascending or descending miss streams.
+ |             A confirmed stream keeps 'degree' lines prefetched ahead of
+ |             its most recent access.
+ |  bo         Best-offset prefetcher (Michaud, HPCA 2016).  Learns the
+ |             offset D for which X-D was recently a completed prefetch (or
+ |             miss), so that prefetching X+D is timely.  One prefetch per
+ |             trigger; turns itself off when no offset scores.
+\*--------------------------------------------------------------------------*/
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <vector>
+#include <deque>
+#include "decode.h"
+
+typedef enum {
+	PF_NONE = 0,
+	PF_NEXTLINE,
+	PF_STRIDE,
+	PF_STREAM,
+	PF_BEST_OFFSET,
+	NUM_PF_KINDS
+} pf_kind_e;
+
+static const char* const pf_kind_name[NUM_PF_KINDS] = {
+	"none", "nextline", "stride", "stream", "bo"
+};
+
+// Returns NUM_PF_KINDS if 'name' is not a prefetcher.
+static inline pf_kind_e pf_kind_from_name(const char* name) {
+	for (unsigned int i = 0; i < (unsigned int)NUM_PF_KINDS; i++)
+		if (!strcmp(name, pf_kind_name[i]))
+			return((pf_kind_e)i);
+	return(NUM_PF_KINDS);
+}
+
+class prefetcher_t {
+public:
+	prefetcher_t(unsigned int _lineSize, unsigned int _degree)
+		: lineSize(_lineSize), degree(_degree) { }
+	virtual ~prefetcher_t() { }
+
+	virtual pf_kind_e kind() = 0;
+
+	virtual void train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+	                   std::vector<reg_t>& candidates) = 0;
+	/*------------------------------------------------------------------------*\
+	 | One access of the training stream.
+	 |
+	 |  pc         PC of the load/store (0 below the L1).
+	 |  addr       Byte address accessed.
+	 |  miss       The access missed (primary or secondary miss).
+	 |  pfHit      The access was the first demand hit on a prefetched line.
+	 |
+	 | Appends the byte addresses of the lines to prefetch to 'candidates'.
+	\*------------------------------------------------------------------------*/
+
+	virtual void fill(cycle_t fillCycle, reg_t addr) { }
+	/*------------------------------------------------------------------------*\
+	 | A prefetch of 'addr' was issued and will be in the array by fillCycle.
+	\*------------------------------------------------------------------------*/
+
+	virtual void dump(FILE* fp) { }
+
+	unsigned int get_degree() { return(degree); }
+
+protected:
+	unsigned int lineSize;  /* log2 of the line size in bytes. */
+	unsigned int degree;    /* Max. prefetches per trigger.    */
+};
+
+/*--------------------------------------------------------------------------*\
+ | Next-N-line.
+\*--------------------------------------------------------------------------*/
+class nextline_prefetcher_t : public prefetcher_t {
+public:
+	nextline_prefetcher_t(unsigned int _lineSize, unsigned int _degree)
+		: prefetcher_t(_lineSize, _degree) { }
+	pf_kind_e kind() { return(PF_NEXTLINE); }
+	void train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+	           std::vector<reg_t>& candidates);
+};
+
+/*--------------------------------------------------------------------------*\
+ | PC-indexed stride (reference prediction table).
+\*--------------------------------------------------------------------------*/
+#define PF_STRIDE_ENTRIES 256
+#define PF_STRIDE_CONF_MAX 3
+#define PF_STRIDE_CONF_THRESHOLD 2
+
+class stride_entry_t {
+public:
+	reg_t   tag;        /* PC.                                */
+	reg_t   lastAddr;   /* Last address accessed by this PC.  */
+	int64_t stride;
+	unsigned int conf;  /* 2-bit confidence.                  */
+	bool    valid;
+};
+
+class stride_prefetcher_t : public prefetcher_t {
+public:
+	stride_prefetcher_t(unsigned int _lineSize, unsigned int _degree);
+	pf_kind_e kind() { return(PF_STRIDE); }
+	void train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+	           std::vector<reg_t>& candidates);
+	void dump(FILE* fp);
+private:
+	stride_entry_t table[PF_STRIDE_ENTRIES];
+	uint64_t n_allocs;
+	uint64_t n_confident;   /* Accesses whose PC had a confirmed stride. */
+};
+
+/*--------------------------------------------------------------------------*\
+ | Stream.
+\*--------------------------------------------------------------------------*/
+#define PF_STREAMS 16
+#define PF_STREAM_WINDOW 16  /* Lines around a stream's last access that train it. */
+
+class stream_entry_t {
+public:
+	reg_t    lastLine;  /* Line of the most recent access.        */
+	reg_t    pfLine;    /* Furthest line prefetched so far.       */
+	int      dir;       /* +1, -1, or 0 (direction not known).    */
+	bool     confirmed;
+	bool     valid;
+	uint64_t lru;
+};
+
+class stream_prefetcher_t : public prefetcher_t {
+public:
+	stream_prefetcher_t(unsigned int _lineSize, unsigned int _degree);
+	pf_kind_e kind() { return(PF_STREAM); }
+	void train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+	           std::vector<reg_t>& candidates);
+	void dump(FILE* fp);
+private:
+	stream_entry_t stream[PF_STREAMS];
+	uint64_t timestamp;
+	uint64_t n_allocs;
+	uint64_t n_confirmed;
+};
+
+/*--------------------------------------------------------------------------*\
+ | Best-offset.
+\*--------------------------------------------------------------------------*/
+#define PF_BO_RR_ENTRIES 256
+#define PF_BO_SCORE_MAX 31
+#define PF_BO_ROUND_MAX 100
+#define PF_BO_BAD_SCORE 1
+
+class bo_prefetcher_t : public prefetcher_t {
+public:
+	bo_prefetcher_t(unsigned int _lineSize, unsigned int _degree);
+	pf_kind_e kind() { return(PF_BEST_OFFSET); }
+	void train(cycle_t curCycle, reg_t pc, reg_t addr, bool miss, bool pfHit,
+	           std::vector<reg_t>& candidates);
+	void fill(cycle_t fillCycle, reg_t addr);
+	void dump(FILE* fp);
+private:
+	void rr_insert(reg_t line);
+	bool rr_hit(reg_t line);
+	void end_phase();
+
+	std::vector<int> offsets;    /* Candidate offsets (lines).           */
+	std::vector<unsigned int> scores;
+	unsigned int testIndex;      /* Next offset to test.                  */
+	unsigned int round;
+	int bestOffset;              /* Offset in use, 0: prefetching off.    */
+
+	reg_t rr[PF_BO_RR_ENTRIES];  /* Recent requests: base lines of fills. */
+	bool  rrValid[PF_BO_RR_ENTRIES];
+
+	/* Prefetches issued but not yet filled: (fill cycle, base line). */
+	std::deque<std::pair<cycle_t, reg_t> > pending;
+
+	uint64_t n_phases;
+	uint64_t n_phases_off;
+	std::vector<uint64_t> chosen;  /* Phases that chose each offset. */
+};
+
+prefetcher_t* new_prefetcher(pf_kind_e kind, unsigned int lineSize, unsigned int degree);
+/*------------------------------------------------------------------------*\
+ | Returns a new prefetcher of the given kind, or NULL for PF_NONE.
+\*------------------------------------------------------------------------*/
+
+#endif //PREFETCH_H
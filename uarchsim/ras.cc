@@ -30,6 +30,18 @@ uint64_t ras_t::peek() {
    return(ras[temp]);
 }
 
+// Peek and pop with a private TOS (from get_tos()), leaving the RAS's own TOS alone.
+
+uint64_t ras_t::peek(uint64_t tos) {
+   uint64_t temp = ((tos > 0) ? (tos - 1) : (size - 1));
+   return(ras[temp]);
+}
+
+uint64_t ras_t::pop(uint64_t &tos) {
+   tos = ((tos > 0) ? (tos - 1) : (size - 1));
+   return(ras[tos]);
+}
+
 // Functions to get and set the top-of-stack index, e.g., for checkpoint/restore purposes.
 
 uint64_t ras_t::get_tos() {
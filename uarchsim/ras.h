@@ -12,6 +12,10 @@ public:
 	uint64_t pop();		// a return pops its predicted return address from the RAS
 	uint64_t peek();	// the branch prediction unit can examine the predicted return address without popping it
 
+	// Peek and pop with a private TOS (from get_tos()), leaving the RAS's own TOS alone: for a predictor running ahead (see fetchunit.h).
+	uint64_t peek(uint64_t tos);
+	uint64_t pop(uint64_t &tos);
+
 	// Functions to get and set the top-of-stack index, e.g., for checkpoint/restore purposes.
 	uint64_t get_tos();
 	void set_tos(uint64_t tos);
@@ -221,6 +221,11 @@ void pipeline_t::rename2()
       }
       PAY.buf[index].Checkpoint_ID = REN->get_checkpoint_ID(load, store, branch, amo, csr);
 
+      // Macro-op fusion: the instruction fused into this one (see fuse()) belongs to the same checkpoint,
+      // but does not count in its instruction counter.
+      if (PAY.buf[index].fused)
+         PAY.buf[MOD((index + PAY.PAYLOAD_BUFFER_SIZE - 2), PAY.PAYLOAD_BUFFER_SIZE)].Checkpoint_ID = PAY.buf[index].Checkpoint_ID;
+
       // FIX_ME #3
       // Rename source registers (first) and destination register (second).
       //
@@ -304,6 +309,13 @@ void pipeline_t::rename2()
       // FIX_ME #5 END
    }
 
+   // Misprediction hotspot report: the refill bubble after the last mispredicted branch ends with this rename bundle.
+   if (misp_refill_pending)
+   {
+      stats->update_br_refill(misp_refill_pc, (cycle - misp_refill_cycle));
+      misp_refill_pending = false;
+   }
+
    //
    // Transfer the rename bundle from the Rename Stage to the Dispatch Stage.
    //
@@ -389,37 +389,32 @@ void renamer::free_checkpoint() {
 //     }
 // }
 
-bool renamer::stall_checkpoint(uint64_t bundle_chkpts) {
-  // The rename stage must stall if there are not enough free checkpoints in the
-  // Checkpoint Buffer Inputs: bundle_chkpts: number of checkpoints that are
-  // needed for the current rename bundle Return vaue: Return "true" (stall) if
-  // the Checkpoint Buffer does not have enough free checkpoints that are
-  // required by the rename bundle
-
+uint64_t renamer::free_checkpoints() {
   // Finding the number of free checkpoints in the Checkpoint Buffer
-  uint64_t NumberOfAvailableCheckpointsInCheckpointBuffer =
-      CheckpointBuffer.CheckpointBufferSize;
   if (CheckpointBuffer.Head == CheckpointBuffer.Tail &&
       CheckpointBuffer.HeadPhaseBit != CheckpointBuffer.TailPhaseBit)
-    NumberOfAvailableCheckpointsInCheckpointBuffer =
-        0; // There are no free checkpoints available in the checkpoint buffer
-
+    return 0; // There are no free checkpoints available in the checkpoint buffer
   else if (CheckpointBuffer.Head != CheckpointBuffer.Tail &&
            CheckpointBuffer.HeadPhaseBit != CheckpointBuffer.TailPhaseBit)
-    NumberOfAvailableCheckpointsInCheckpointBuffer =
-        CheckpointBuffer.Head - CheckpointBuffer.Tail;
-
+    return CheckpointBuffer.Head - CheckpointBuffer.Tail;
   else if (CheckpointBuffer.Head != CheckpointBuffer.Tail &&
            CheckpointBuffer.HeadPhaseBit == CheckpointBuffer.TailPhaseBit)
-    NumberOfAvailableCheckpointsInCheckpointBuffer =
-        CheckpointBuffer.CheckpointBufferSize -
-        (CheckpointBuffer.Tail - CheckpointBuffer.Head);
+    return CheckpointBuffer.CheckpointBufferSize -
+           (CheckpointBuffer.Tail - CheckpointBuffer.Head);
+  else
+    return CheckpointBuffer.CheckpointBufferSize;
+}
+
+bool renamer::stall_checkpoint(uint64_t bundle_chkpts) {
+  // The rename stage must stall if there are not enough free checkpoints in the
+  // Checkpoint Buffer Inputs: bundle_chkpts: number of checkpoints that are
+  // needed for the current rename bundle Return vaue: Return "true" (stall) if
+  // the Checkpoint Buffer does not have enough free checkpoints that are
+  // required by the rename bundle
 
   // If the number of available checkpoints in the Checkpoint Buffer are greater
   // than or equal to bundle_chkpts then return false else return true
-  // cout<<"@@@@@@@@@@@@@@@@@@@@@@@@@@@@Stall_checkpoint()\t"<<NumberOfAvailableCheckpointsInCheckpointBuffer<<'\t'<<bundle_chkpts
-  // <<'\n';
-  if (NumberOfAvailableCheckpointsInCheckpointBuffer >= bundle_chkpts)
+  if (free_checkpoints() >= bundle_chkpts)
     return false;
   else
     return true;
@@ -413,6 +413,13 @@ public:
 	/////////////////////////////////////////////////////////////////////
 	bool stall_checkpoint(uint64_t bundle_chkpts);
 
+	/////////////////////////////////////////////////////////////////////
+	// Return value:
+	// The number of free checkpoints in the Checkpoint Buffer.
+	// (The Fetch Unit may gate fetch when few are left, see fetch1().)
+	/////////////////////////////////////////////////////////////////////
+	uint64_t free_checkpoints();
+
 	/////////////////////////////////////////////////////////////////////
 	// This function dispatches a single instruction into the Active
 	// List.
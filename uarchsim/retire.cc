@@ -68,7 +68,12 @@ void pipeline_t::retire(size_t &instret, size_t instret_limit)
         bool proceed = REN->precommit(RETSTATE.chkpt_id, RETSTATE.num_loads_left, RETSTATE.num_stores_left, RETSTATE.num_branches_left, RETSTATE.amo, RETSTATE.csr, RETSTATE.exception);
 
         if (!proceed)
+        {
+            // Retirement is blocked on memory if a load of the oldest checkpoint waits for the D$.
+            if ((PAY.head != PAY.tail) && LSU.retire_blocked(PAY.buf[PAY.head].Checkpoint_ID))
+                inc_counter(retire_mem_stall_count);
             return;
+        }
 
         // Sanity checks of the 'amo' and 'csr' flags.
         assert(!RETSTATE.amo || IS_AMO(PAY.buf[PAY.head].flags));
@@ -162,6 +167,12 @@ void pipeline_t::retire(size_t &instret, size_t instret_limit)
             }
             if (RETSTATE.num_stores_left > 0)
             {
+                // Bulk commit waits for a free store buffer entry.
+                if (LSU.sb_stall(cycle))
+                {
+                    inc_counter(retire_mem_stall_count);
+                    return;
+                }
                 LSU.train(false);
                 amo_success = LSU.commit(false, RETSTATE.amo);
                 assert(amo_success);
@@ -180,6 +191,7 @@ void pipeline_t::retire(size_t &instret, size_t instret_limit)
             if ((RETSTATE.num_loads_left == 0) && (RETSTATE.num_stores_left == 0) && (RETSTATE.num_branches_left == 0) && (RETSTATE.log_reg == NXPR + NFPR))
             {
                 REN->free_checkpoint();
+                LSU.retire_checkpoint();
                 RETSTATE.state = RETIRE_FINALIZE;
                 return;
             }
@@ -207,6 +219,24 @@ void pipeline_t::retire(size_t &instret, size_t instret_limit)
             if (PAY.buf[PAY.head].split && PAY.buf[PAY.head].upper)
                 num_insn_split++;
 
+            // Macro-op fusion: count the fused pairs, by fusion rule (see fuse()).
+            if (PAY.buf[PAY.head].fused)
+            {
+                inc_counter(fused_count);
+                switch (PAY.buf[PAY.head].inst.opcode())
+                {
+                case OP_JALR:
+                    inc_counter(fused_auipc_count);
+                    break;
+                case OP_BRANCH:
+                    inc_counter(fused_cmpbr_count);
+                    break;
+                default:
+                    inc_counter(fused_lui_count);
+                    break;
+                }
+            }
+
             // Sanity checks of the 'amo' and 'csr' flags.
             assert(!RETSTATE.amo || IS_AMO(PAY.buf[PAY.head].flags));
             assert(!RETSTATE.csr || IS_CSR(PAY.buf[PAY.head].flags));
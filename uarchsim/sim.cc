@@ -12,6 +12,7 @@
 #include <fstream>
 #include <gzstream.h>
 #include "pipeline.h"
+#include "bptrace.h"
 
 volatile bool ctrlc_pressed = false;
 static void handle_signal(int sig)
@@ -25,7 +26,7 @@ static void handle_signal(int sig)
 
 sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args, proc_type_t _proc_type)
 	: htif(new htif_isasim_t(this, args)), procs(std::max(nprocs, size_t(1))),
-	  current_step(0), idle_cycles(0), current_proc(0), debug(false), checkpointing_enabled(false)
+	  current_step(0), idle_cycles(0), current_proc(0), debug(false), checkpointing_enabled(false), bp_trace(NULL)
 {
 	signal(SIGINT, &handle_signal);
 	// allocate target machine's memory, shrinking it as necessary
@@ -195,9 +196,26 @@ bool sim_t::run_fast(size_t n)
     size_t instret = 0;
 		steps = std::min(n - total_retired, INTERLEAVE - current_step);
 
+    if (bp_trace) {
+      // Step one instruction at a time, to trace it: get the instruction before stepping and the next pc after.
+      reg_t pc = procs[current_proc]->get_pc();
+      insn_t insn;
+      bool fetched = true;
+      try {
+        insn = procs[current_proc]->get_mmu()->load_insn(pc).insn;
+      }
+      catch (trap_t& t) {
+        fetched = false;	// Fetch exception: the instruction won't retire.
+      }
+      procs[current_proc]->step(1,instret);
+      if (instret && fetched)
+        bp_trace->retire(pc, insn, procs[current_proc]->get_pc());
+    }
+    else {
     // This function continues until it has retired "steps" instructions
     // or it encounters a cycle with 0 retired instructions.
   	procs[current_proc]->step(steps,instret);
+    }
 
     if(instret){
       idle_cycles = 0;
@@ -235,11 +253,27 @@ bool sim_t::run_fast(size_t n)
   //fprintf(stderr,"State for %s:\n",proc_type == MICRO_SIM ? "micro_sim" : "isa_sim");
   //procs[current_proc]->get_state()->dump(stderr);
 
+  // The branch trace covers this run_fast() only.
+  if (bp_trace) {
+    delete bp_trace;
+    bp_trace = NULL;
+  }
+
   set_procs_debug(old_debug);
   set_procs_checker(old_checker);
   return htif_return;
 }
 
+void sim_t::set_bp_trace(std::string bp_trace_file)
+{
+  // Check if file name has .gz extension. If not, append .gz to the name
+  if(bp_trace_file.substr(bp_trace_file.find_last_of(".") + 1) != "gz") {
+    bp_trace_file = bp_trace_file+".gz";
+  }
+  fprintf(stderr, "Writing the branch trace to %s\n", bp_trace_file.c_str());
+  bp_trace = new bptrace_writer_t(bp_trace_file.c_str());
+}
+
 void sim_t::step_till_pc(reg_t break_pc,unsigned int proc_n)
 {
   procs[proc_n]->set_debug(true);
@@ -18,6 +18,7 @@ enum proc_type_t {ISA_SIM,MICRO_SIM};
 
 class htif_isasim_t;
 class debug_buffer_t;
+class bptrace_writer_t;
 
 // this class encapsulates the processors and memory in a RISC-V machine.
 class sim_t
@@ -70,6 +71,9 @@ public:
 
   bool run_fast(size_t n);
 
+  // Write the branches of the instructions retired by the next run_fast() to a branch trace file (see bptrace.h).
+  void set_bp_trace(std::string bp_trace_file);
+
   proc_type_t get_proc_type(){return proc_type;}
 
 private:
@@ -89,6 +93,7 @@ private:
 	bool histogram_enabled; // provide a histogram of PCs
   bool checkpointing_enabled;
   std::string checkpoint_file;
+  bptrace_writer_t* bp_trace;	// NULL: no branch trace
 
 	// presents a prompt for introspection into the simulation
 	void interactive();
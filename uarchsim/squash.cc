@@ -14,7 +14,7 @@ void pipeline_t::squash_complete(reg_t jump_PC)
     // Decode Stage
     //////////////////////////
 
-    for (i = 0; i < fetch_width; i++)
+    for (i = 0; i < decode_width; i++)
     {
         if (DECODE[i].valid)
         {
@@ -186,7 +186,7 @@ void pipeline_t::selective_squash(uint64_t squash_mask)
     // Squash all instructions in the Decode through Dispatch Stages.
 
     // Decode Stage:
-    for (i = 0; i < fetch_width; i++)
+    for (i = 0; i < decode_width; i++)
     {
         if (DECODE[i].valid)
         {
@@ -0,0 +1,126 @@
+/*--------------------------------------------------------------------------*\
+ | stackdist.cc
+ |
+ | LRU stack-distance profiler for CacheClass.  See stackdist.h.
+\*--------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <cassert>
+
+#include "stackdist.h"
+
+stack_dist_t::stack_dist_t(unsigned int _lineSize, unsigned int _minSets, unsigned int _maxSets, unsigned int _maxAssoc)
+	: lineSize(_lineSize),
+	  minSets(_minSets),
+	  maxAssoc(_maxAssoc)
+{
+	unsigned int sets;
+	unsigned int i;
+
+	assert((minSets > 0) && (minSets <= _maxSets) && (maxAssoc > 0));
+
+	numConfigs = 0;
+	for (sets = minSets; sets <= _maxSets; sets <<= 1)
+		numConfigs++;
+
+	stack.resize(numConfigs);
+	depth.resize(numConfigs);
+	dist.resize(numConfigs);
+	for (i = 0, sets = minSets; i < numConfigs; i++, sets <<= 1) {
+		stack[i].assign((size_t)sets * maxAssoc, 0);
+		depth[i].assign(sets, 0);
+		dist[i].assign(maxAssoc + 1, 0);
+	}
+
+	n_accesses = 0;
+}
+
+void stack_dist_t::Access(reg_t line)
+{
+	unsigned int sets;
+	unsigned int set;
+	unsigned int i;
+	unsigned int d;
+	unsigned int n;
+	reg_t* s;
+
+	n_accesses++;
+
+	for (i = 0, sets = minSets; i < numConfigs; i++, sets <<= 1) {
+		set = (unsigned int)(line & (sets - 1));
+		s = &stack[i][(size_t)set * maxAssoc];
+		n = depth[i][set];
+
+		for (d = 0; (d < n) && (s[d] != line); d++)
+			;
+
+		// Move (or push) the line to the top of the stack.
+		if (d == n) {
+			dist[i][maxAssoc]++;
+			if (n < maxAssoc)
+				depth[i][set] = ++n;
+			d = (n - 1);
+		}
+		else {
+			dist[i][d]++;
+		}
+		for ( ; d > 0; d--)
+			s[d] = s[d-1];
+		s[0] = line;
+	}
+}
+
+uint64_t stack_dist_t::Misses(unsigned int config, unsigned int assoc)
+{
+	uint64_t hits = 0;
+
+	for (unsigned int d = 0; d < assoc; d++)
+		hits += dist[config][d];
+	return(n_accesses - hits);
+}
+
+void stack_dist_t::dump(FILE* fp, const char* name, uint64_t num_insn)
+{
+	unsigned int i;
+	unsigned int sets;
+	unsigned int assoc;
+
+	fprintf(fp, "%s STACK DISTANCE PROFILE (LRU, %u B lines, %" PRIu64 " accesses)\n", name, (1 << lineSize), n_accesses);
+
+	fprintf(fp, "  miss rate (%%), sets x ways:\n");
+	fprintf(fp, "  %8s", "sets");
+	for (assoc = 1; assoc <= maxAssoc; assoc <<= 1)
+		fprintf(fp, " %8u", assoc);
+	fprintf(fp, "\n");
+	for (i = 0, sets = minSets; i < numConfigs; i++, sets <<= 1) {
+		fprintf(fp, "  %8u", sets);
+		for (assoc = 1; assoc <= maxAssoc; assoc <<= 1)
+			fprintf(fp, " %8.2f", 100.0*(double)Misses(i, assoc)/(double)n_accesses);
+		fprintf(fp, "\n");
+	}
+
+	fprintf(fp, "  MPKI, sets x ways:\n");
+	fprintf(fp, "  %8s", "sets");
+	for (assoc = 1; assoc <= maxAssoc; assoc <<= 1)
+		fprintf(fp, " %8u", assoc);
+	fprintf(fp, "\n");
+	for (i = 0, sets = minSets; i < numConfigs; i++, sets <<= 1) {
+		fprintf(fp, "  %8u", sets);
+		for (assoc = 1; assoc <= maxAssoc; assoc <<= 1)
+			fprintf(fp, " %8.2f", 1000.0*(double)Misses(i, assoc)/(double)num_insn);
+		fprintf(fp, "\n");
+	}
+
+	fprintf(fp, "  capacity (KB), sets x ways:\n");
+	fprintf(fp, "  %8s", "sets");
+	for (assoc = 1; assoc <= maxAssoc; assoc <<= 1)
+		fprintf(fp, " %8u", assoc);
+	fprintf(fp, "\n");
+	for (i = 0, sets = minSets; i < numConfigs; i++, sets <<= 1) {
+		fprintf(fp, "  %8u", sets);
+		for (assoc = 1; assoc <= maxAssoc; assoc <<= 1)
+			fprintf(fp, " %8.1f", (double)((uint64_t)sets * assoc << lineSize)/1024.0);
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, "\n");
+}
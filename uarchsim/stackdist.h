@@ -0,0 +1,67 @@
+#ifndef STACKDIST_H
+#define STACKDIST_H
+/*--------------------------------------------------------------------------*\
+ | stackdist.h
+ |
+ | LRU stack-distance profiler for CacheClass.
+ |
+ | Attached to one cache level (CacheClass::set_profiler), it sees every
+ |  demand access of that level (loads and stores, including the misses
+ |  and writebacks of the levels above) and, for each number of sets in
+ |  [minSets, maxSets] (powers of 2), keeps a per-set LRU stack of the
+ |  most recent maxAssoc lines.  The position of the accessed line in its
+ |  set's stack (its stack distance) is histogrammed.
+ |
+ | By the LRU stack property, an access misses in an S-set, A-way LRU
+ |  cache exactly when its stack distance for S sets is A or more (or the
+ |  line is not in the stack).  So one run gives the miss counts of every
+ |  (sets, ways) configuration in the sweep.
+ |
+ | Caveats: the results are for LRU replacement and for the access stream
+ |  this level sees in the simulated configuration (the levels above, their
+ |  prefetchers and inclusion policies are as configured).  Only the array
+ |  is profiled: MHSRs, prefetches and victim caches are not.
+\*--------------------------------------------------------------------------*/
+#include <cstdio>
+#include <cinttypes>
+#include <vector>
+#include "decode.h"
+
+class stack_dist_t {
+public:
+	stack_dist_t(unsigned int _lineSize, unsigned int _minSets, unsigned int _maxSets, unsigned int _maxAssoc);
+	/*------------------------------------------------------------------------*\
+	 | lineSize is log2 of the line size in bytes.  minSets, maxSets and
+	 |  maxAssoc must be powers of 2.
+	\*------------------------------------------------------------------------*/
+
+	void Access(reg_t lineAddr);
+	/*------------------------------------------------------------------------*\
+	 | One access of the level's stream, to the line 'lineAddr' (the address
+	 |  shifted right by lineSize).
+	\*------------------------------------------------------------------------*/
+
+	void dump(FILE* fp, const char* name, uint64_t num_insn);
+	/*------------------------------------------------------------------------*\
+	 | Print the miss rate and MPKI of every (sets, ways) configuration.
+	\*------------------------------------------------------------------------*/
+
+private:
+	uint64_t Misses(unsigned int config, unsigned int assoc);
+
+	unsigned int lineSize;
+	unsigned int minSets;
+	unsigned int maxAssoc;
+	unsigned int numConfigs;      /* Set counts minSets, 2*minSets, ... maxSets. */
+
+	/* Per set count: LRU stacks (maxAssoc lines per set, MRU first), the
+	 * number of valid lines in each stack, and the distance histogram
+	 * (last bin: not within maxAssoc, including first references).       */
+	std::vector<std::vector<reg_t> >    stack;
+	std::vector<std::vector<unsigned int> > depth;
+	std::vector<std::vector<uint64_t> > dist;
+
+	uint64_t n_accesses;
+};
+
+#endif //STACKDIST_H
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+#include "ghist.h"
+#include "statcorr.h"
+
+stat_corrector_t::stat_corrector_t(ghist_t *ghist, uint64_t entries, uint64_t m) {
+   this->ghist = ghist;
+
+   assert((entries >= 16) && ((entries & (entries - 1)) == 0));
+   log_size = 0;
+   while ((1ULL << log_size) < entries)
+      log_size++;
+
+   pos_bits = 0;
+   while ((1ULL << pos_bits) < m)
+      pos_bits++;
+
+   hist_length[0] = 0;
+   hist_length[1] = 6;
+   hist_length[2] = 12;
+   hist_length[3] = 24;
+   for (uint64_t i = 0; i < SC_TABLES; i++) {
+      table[i] = new int8_t[entries];
+      for (uint64_t j = 0; j < entries; j++)
+         table[i][j] = 0;
+   }
+
+   theta = (2 * SC_TABLES);
+   theta_ctr = 0;
+   meas_update = 0;
+}
+
+stat_corrector_t::~stat_corrector_t() {
+}
+
+// Sum of the counters, each counter c contributing (2c + 1) so that the sum is never zero.
+int64_t stat_corrector_t::sum(uint64_t pc, uint64_t hist, uint64_t pos, bool main_taken, uint64_t index[]) {
+   uint64_t key = (((pc >> 2) << pos_bits) | pos);
+   uint64_t mask = ((1ULL << log_size) - 1);
+   int64_t s = 0;
+
+   index[0] = (((key << 1) | (main_taken ? 1 : 0)) & mask);
+   for (uint64_t i = 1; i < SC_TABLES; i++)
+      index[i] = ((key ^ (key >> (log_size - i)) ^ ghist->fold(hist, hist_length[i], log_size)) & mask);
+
+   for (uint64_t i = 0; i < SC_TABLES; i++)
+      s += ((2 * table[i][index[i]]) + 1);
+   return(s);
+}
+
+bool stat_corrector_t::revert(uint64_t pc, uint64_t hist, uint64_t pos, bool main_taken, bool main_weak) {
+   uint64_t index[SC_TABLES];
+   int64_t s;
+
+   if (!main_weak)
+      return(false);
+   s = sum(pc, hist, pos, main_taken, index);
+   return(((s >= 0) != main_taken) && (((s >= 0) ? s : -s) >= theta));
+}
+
+void stat_corrector_t::update(uint64_t pc, uint64_t hist, uint64_t pos, bool main_taken, bool main_weak, bool taken) {
+   uint64_t index[SC_TABLES];
+   int64_t s;
+   bool sc_taken;
+
+   // The statistical corrector only learns the branches it may revert.
+   if (!main_weak)
+      return;
+
+   meas_update++;
+   s = sum(pc, hist, pos, main_taken, index);
+   sc_taken = (s >= 0);
+
+   // Adapt the threshold: raise it when the sum is wrong, lower it when the sum is right but below the threshold.
+   if (sc_taken != taken) {
+      if (++theta_ctr >= 32) {
+         theta++;
+	 theta_ctr = 0;
+      }
+   }
+   else if ((s >= 0 ? s : -s) < theta) {
+      if (--theta_ctr <= -32) {
+         if (theta > 1)
+	    theta--;
+	 theta_ctr = 0;
+      }
+   }
+
+   // Train the counters if the sum was wrong or not confident.
+   if ((sc_taken != taken) || ((s >= 0 ? s : -s) < theta)) {
+      for (uint64_t i = 0; i < SC_TABLES; i++) {
+         if (taken && (table[i][index[i]] < 31))
+	    table[i][index[i]]++;
+	 else if (!taken && (table[i][index[i]] > -32))
+	    table[i][index[i]]--;
+      }
+   }
+}
+
+void stat_corrector_t::output(FILE *fp) {
+   fprintf(fp, "Statistical corrector: %d tables x %lu entries (histories 0, %lu, %lu, %lu), threshold = %ld, trained on %lu low-confidence predictions\n",
+           SC_TABLES, ((uint64_t)1 << log_size), hist_length[1], hist_length[2], hist_length[3], theta, meas_update);
+}
@@ -0,0 +1,47 @@
+
+#define SC_TABLES	4	// a bias table and three global history tables
+
+// Statistical corrector add-on to the conditional branch predictor (as in TAGE-SC-L: A. Seznec, "TAGE-SC-L branch predictors").
+//
+// Some branches are not well predicted by the main predictor's counters, e.g., branches that are statistically biased but whose
+// outcome is only weakly correlated with the global history.  The statistical corrector sums signed counters from a bias table,
+// indexed with the pc and the main prediction, and from tables indexed with the pc and short global histories.  If the main
+// prediction is low-confidence (a weak 2-bit counter) and the sum confidently disagrees with it, the main prediction is reverted.
+//
+// Like the main predictors, it predicts the bundle's i'th conditional branch from the bundle's pc combined with i, and the history
+// prior to the bundle (position "hist" in the long global history).  It is trained at retirement with the same context.
+class stat_corrector_t {
+private:
+	ghist_t *ghist;
+	uint64_t pos_bits;	// number of bits used to combine the position of a prediction with the pc
+
+	// SC_TABLES tables of 6-bit signed counters.
+	int8_t *table[SC_TABLES];
+	uint64_t log_size;
+	uint64_t hist_length[SC_TABLES];	// table 0 is the bias table (no history)
+
+	// Adaptive threshold on the magnitude of the sum (A. Seznec, "Analysis of the O-GEometric History Length branch predictor").
+	int64_t theta;
+	int64_t theta_ctr;
+
+	// Measurements.
+	uint64_t meas_update;	// # retired low-confidence main predictions (the only ones the statistical corrector may revert)
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	int64_t sum(uint64_t pc, uint64_t hist, uint64_t pos, bool main_taken, uint64_t index[]);
+
+public:
+	stat_corrector_t(ghist_t *ghist, uint64_t entries, uint64_t m);
+	~stat_corrector_t();
+
+	// Returns true if the main prediction of the pos'th conditional branch of the fetch bundle {pc, hist} should be reverted.
+	bool revert(uint64_t pc, uint64_t hist, uint64_t pos, bool main_taken, bool main_weak);
+
+	// Train with the outcome of a retired conditional branch, given the main prediction it had at fetch.
+	void update(uint64_t pc, uint64_t hist, uint64_t pos, bool main_taken, bool main_weak, bool taken);
+
+	void output(FILE *fp);
+};
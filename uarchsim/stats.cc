@@ -1,14 +1,25 @@
 #include "stats.h"
 #include "pipeline.h"
 #include "parameters.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
 
 stats_t::stats_t(pipeline_t* _proc){
 
   this->proc = _proc;
 
+  // The fixed counters' slots (see STATS_COUNTERS), undeclared until declared below.
+  counter_t c = {0, 0, NULL, NULL, false, false};
+  counters.assign(NUM_STATS_COUNTERS, c);
+  phase_counter = (counter_id_t)-1;
+
   DECLARE_COUNTER(this, cycle_count               ,proc);
   DECLARE_COUNTER(this, commit_count              ,proc);
   DECLARE_COUNTER(this, ld_vio_count              ,proc);
+  DECLARE_COUNTER(this, retire_mem_stall_count    ,proc);
+  DECLARE_COUNTER(this, retired_chkpt_count       ,proc);
+  DECLARE_COUNTER(this, retired_load_miss_count   ,proc);
 #if 0
   DECLARE_COUNTER(this, load_count                ,proc);
   DECLARE_COUNTER(this, store_count               ,proc);
@@ -69,7 +80,20 @@ stats_t::stats_t(pipeline_t* _proc){
   DECLARE_COUNTER(this, freelist_write_count      ,proc);
 #endif
 
+  // Macro-op fusion (pipeline_t::fuse()): fused pairs retired.
+  // fusion_rate is the percentage of retired instructions that did not occupy a pipeline slot of their own.
+  if (FUSION) {
+    DECLARE_COUNTER(this, fused_count               ,proc);
+    DECLARE_COUNTER(this, fused_lui_count           ,proc);
+    DECLARE_COUNTER(this, fused_auipc_count         ,proc);
+    DECLARE_COUNTER(this, fused_cmpbr_count         ,proc);
+  }
+
   DECLARE_RATE(this, ipc_rate, proc, commit_count, cycle_count, 1.0);
+  if (FUSION)
+    DECLARE_RATE(this, fusion_rate, proc, fused_count, commit_count, 100.0);
+  DECLARE_RATE(this, retire_mem_stall_rate, proc, retire_mem_stall_count, cycle_count, 100.0);
+  DECLARE_RATE(this, chkpt_load_miss_rate, proc, retired_load_miss_count, retired_chkpt_count, 1.0);
 #if 0
   DECLARE_RATE(this, mispredict_rate, proc, mispredict_count, cond_branch_count, 100);
   DECLARE_RATE(this, mpki_rate, proc, mispredict_count, commit_count, 1000.0);
@@ -80,6 +104,9 @@ stats_t::stats_t(pipeline_t* _proc){
 
   DECLARE_PHASE_COUNTER(this, cycle_count               ,proc);
   DECLARE_PHASE_COUNTER(this, commit_count              ,proc);
+  DECLARE_PHASE_COUNTER(this, retire_mem_stall_count    ,proc);
+  DECLARE_PHASE_COUNTER(this, retired_chkpt_count       ,proc);
+  DECLARE_PHASE_COUNTER(this, retired_load_miss_count   ,proc);
 
 #if 0
   if(verbose_phase_counters){
@@ -136,6 +163,8 @@ stats_t::stats_t(pipeline_t* _proc){
 #endif
 
   DECLARE_PHASE_RATE(this, ipc_rate, proc, commit_count, cycle_count, 1.0);
+  DECLARE_PHASE_RATE(this, retire_mem_stall_rate, proc, retire_mem_stall_count, cycle_count, 100.0);
+  DECLARE_PHASE_RATE(this, chkpt_load_miss_rate, proc, retired_load_miss_count, retired_chkpt_count, 1.0);
 #if 0
   DECLARE_PHASE_RATE(this, mispredict_rate, proc, mispredict_count, cond_branch_count, 1.0);
   DECLARE_PHASE_RATE(this, mpki_rate, proc, mispredict_count, commit_count, 1000.0);
@@ -154,56 +183,75 @@ void stats_t::set_log_files(FILE* _stats_log,FILE* _phase_log){
   this->phase_log = _phase_log;
 }
 
+// A name that is not a declared counter disables phases ("nada").
 void stats_t::set_phase_interval(const char* name,uint64_t interval)
 {
-  std::strcpy(phase_counter_name,name);
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter = counter_map.find(name);
+  phase_counter = ((ctr_iter != counter_map.end()) ? ctr_iter->second : (counter_id_t)-1);
   phase_interval = interval;
-  ifprintf(logging_on,stderr,"Setting phase interval to %s = %lu\n",phase_counter_name,interval);
+  ifprintf(logging_on,stderr,"Setting phase interval to %s = %lu\n",name,interval);
 }
 
 void stats_t::reset_counters(){
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
-  for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    ctr_iter->second->count = 0;
+  for(size_t i = 0; i < counters.size(); i++){
+    counters[i].count = 0;
   }
 }
 
 void stats_t::reset_phase_counters(){
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
-  for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    ctr_iter->second->phase_count = 0;
+  for(size_t i = 0; i < counters.size(); i++){
+    counters[i].phase_count = 0;
   }
 }
 
-void stats_t::register_counter(const char* name, const char* hierarchy){
+// Declare the counter in slot "id" as "name": from now on, it is dumped.
+void stats_t::register_counter(counter_id_t id, const char* name, const char* hierarchy){
 
-  counter_t* c    = new counter_t;
+  counter_t* c    = &counters[id];
   c->count        = 0;
   c->phase_count  = 0;
-  c->name         = new char[strlen(name)+1];
-  c->hierarchy    = new char[strlen(hierarchy)+1];
-  c->valid_phase_counter    = false;
-  strcpy(c->name,name);
-  strcpy(c->hierarchy,hierarchy);
-  counter_map[name] = c;
-  ifprintf(logging_on,stderr,"Counter name %s %s\n",name,hierarchy);
-}
-
-void stats_t::register_phase_counter(const char* name, const char* hierarchy){
-  // If the counter has been declared, mark it as a phase counter
-  if(counter_map.find(name) != counter_map.end()){
-    counter_map[name]->valid_phase_counter = true;
-  } 
-  // If it does not exist, declare it and mark it as a phase counter
-  else {
-    counter_t* c    = new counter_t;
+  if(!c->valid_counter){
     c->name         = new char[strlen(name)+1];
     c->hierarchy    = new char[strlen(hierarchy)+1];
-    c->valid_phase_counter  = true;
+    c->valid_counter        = true;
+    c->valid_phase_counter  = false;
     strcpy(c->name,name);
     strcpy(c->hierarchy,hierarchy);
-    counter_map[name] = c;
+    counter_map[name] = id;
   }
+  ifprintf(logging_on,stderr,"Counter name %s %s\n",name,hierarchy);
+}
+
+void stats_t::register_phase_counter(counter_id_t id, const char* name, const char* hierarchy){
+  // If it does not exist, declare it; then mark it as a phase counter
+  if(!counters[id].valid_counter)
+    register_counter(id, name, hierarchy);
+  counters[id].valid_phase_counter = true;
+}
+
+// Counters registered by name (e.g., by the caches, whose counter names are prefixed by their identifiers) get new slots.
+// Registering a name again returns its handle.
+counter_id_t stats_t::register_counter(const char* name, const char* hierarchy){
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter = counter_map.find(name);
+  if(ctr_iter != counter_map.end())
+    return ctr_iter->second;
+
+  counter_t c = {0, 0, NULL, NULL, false, false};
+  counters.push_back(c);
+  register_counter((counter_id_t)(counters.size()-1), name, hierarchy);
+  return (counter_id_t)(counters.size()-1);
+}
+
+counter_id_t stats_t::register_phase_counter(const char* name, const char* hierarchy){
+  counter_id_t id = register_counter(name, hierarchy);
+  counters[id].valid_phase_counter = true;
+  return id;
+}
+
+// The handle of a counter registered by name, or CTR_null if it was not declared: its updates are ignored.
+counter_id_t stats_t::find_counter(const char* name){
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter = counter_map.find(name);
+  return ((ctr_iter != counter_map.end()) ? ctr_iter->second : (counter_id_t)CTR_null);
 }
 
 void stats_t::register_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier){
@@ -255,22 +303,16 @@ void stats_t::register_knob(const char* name, const char* hierarchy, unsigned in
 }
 
 
+// Update a counter by name (slow: prefer its handle).  Ignored if the counter has not been declared.
 void stats_t::update_counter(const char* name,unsigned int inc){
-  // If the counter has been declared and initialized
-  if(counter_map.find(name) != counter_map.end()){
-    counter_map[name]->count++;
-    counter_map[name]->phase_count++;
-  }
-  // Tick the phase check mechanism if updating the 
-  // counter on which phases are based on. Normally this
-  // would be commit_count or cycle_count.
-  if(!std::strcmp(name, phase_counter_name)){
-    phase_tick();
-  }
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter = counter_map.find(name);
+  if(ctr_iter != counter_map.end())
+    update_counter(ctr_iter->second, (uint64_t)inc);
 }
 
 uint64_t stats_t::get_counter(const char* name){
-  return counter_map[name]->count;
+  assert(counter_map.find(name) != counter_map.end());
+  return counters[counter_map[name]].count;
 }
 
 unsigned int stats_t::get_knob(const char* name){
@@ -278,7 +320,7 @@ unsigned int stats_t::get_knob(const char* name){
 }
 
 void stats_t::phase_tick(){
-  if(counter_map[phase_counter_name]->phase_count >= phase_interval){
+  if(counters[phase_counter].phase_count >= phase_interval){
     phase_id++;
     update_rates();
     dump_phase_counters();
@@ -293,29 +335,33 @@ void stats_t::phase_tick(){
 void stats_t::update_rates(){
   std::map<std::string, rate_t*, ltstr>::iterator rate_iter;
   for(rate_iter = rate_map.begin();rate_iter != rate_map.end(); rate_iter++){
-    if(counter_map[rate_iter->second->denominator]->count == 0){
+    assert(counter_map.find(rate_iter->second->numerator) != counter_map.end());
+    assert(counter_map.find(rate_iter->second->denominator) != counter_map.end());
+    counter_t* numerator = &counters[counter_map[rate_iter->second->numerator]];
+    counter_t* denominator = &counters[counter_map[rate_iter->second->denominator]];
+    if(denominator->count == 0){
       rate_iter->second->rate = (double)0.0;
     } else {
       rate_iter->second->rate = rate_iter->second->multiplier*
-                                double(counter_map[rate_iter->second->numerator]->count)/
-                                double(counter_map[rate_iter->second->denominator]->count);
+                                double(numerator->count)/
+                                double(denominator->count);
     }
 
-    if(counter_map[rate_iter->second->denominator]->phase_count == 0){
+    if(denominator->phase_count == 0){
       rate_iter->second->phase_rate = (double)0.0;
     } else {
       rate_iter->second->phase_rate = rate_iter->second->multiplier*
-                                      double(counter_map[rate_iter->second->numerator]->phase_count)/
-                                      double(counter_map[rate_iter->second->denominator]->phase_count);
+                                      double(numerator->phase_count)/
+                                      double(denominator->phase_count);
     }
   }
 }
 
 void stats_t::dump_counters(){
   fprintf(stats_log,"[stats]\n");
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter;
   for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    fprintf(stats_log,"%s : %" PRIu64 "\n",ctr_iter->second->name, ctr_iter->second->count);
+    fprintf(stats_log,"%s : %" PRIu64 "\n",counters[ctr_iter->second].name, counters[ctr_iter->second].count);
   }
 }
 
@@ -329,10 +375,10 @@ void stats_t::dump_rates(){
 
 void stats_t::dump_phase_counters(){
   fprintf(phase_log,"-------- Phase Counters Phase ID %" PRIu64 "--------\n",phase_id);
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter;
   for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    if(ctr_iter->second->valid_phase_counter)
-      fprintf(phase_log,"%s : %" PRIu64 "\n",ctr_iter->second->name, ctr_iter->second->phase_count);
+    if(counters[ctr_iter->second].valid_phase_counter)
+      fprintf(phase_log,"%s : %" PRIu64 "\n",counters[ctr_iter->second].name, counters[ctr_iter->second].phase_count);
   }
 }
 
@@ -366,6 +412,20 @@ void stats_t::update_br_histogram(size_t pc,bool misp){
     br_histogram[pc >> 2].mispredicted ++;
 }
 
+void stats_t::update_br_misp_cost(size_t pc, uint64_t resolve_cycles, uint64_t squashed, uint64_t exposed){
+  branch_t &br = br_histogram[pc >> 2];
+  br.resolve_cycles += resolve_cycles;
+  br.squashed += squashed;
+  br.exposed += exposed;
+  br.cycles_lost += resolve_cycles;
+}
+
+void stats_t::update_br_refill(size_t pc, uint64_t refill_cycles){
+  branch_t &br = br_histogram[pc >> 2];
+  br.refill_cycles += refill_cycles;
+  br.cycles_lost += refill_cycles;
+}
+
 void stats_t::dump_pc_histogram(){
   if (proc->get_histogram())
   {
@@ -387,3 +447,41 @@ void stats_t::dump_br_histogram(){
     }
   }
 }
+
+// The top_n branches by cycles lost to their mispredictions.  The windows of overlapping mispredictions are each counted in full,
+// so the cycles lost can add up to more than the cycles of the run.
+void stats_t::dump_br_hotspots(unsigned int top_n){
+  std::vector<std::pair<uint64_t,size_t> > hotspots;
+  uint64_t total_lost = 0;
+  uint64_t cycles = get_counter("cycle_count");
+  size_t num_mispredicted;
+
+  if (top_n == 0)
+    return;
+
+  for(auto iterator = br_histogram.begin(); iterator != br_histogram.end(); ++iterator) {
+    if (iterator->second.mispredicted) {
+      hotspots.push_back(std::make_pair(iterator->second.cycles_lost, iterator->first));
+      total_lost += iterator->second.cycles_lost;
+    }
+  }
+  num_mispredicted = hotspots.size();
+  std::sort(hotspots.begin(), hotspots.end(), std::greater<std::pair<uint64_t,size_t> >());
+  if (hotspots.size() > top_n)
+    hotspots.resize(top_n);
+
+  fprintf(stats_log, "\n=== MISPREDICTION HOTSPOTS (top %u of %lu mispredicted branches, by cycles lost) ===\n\n", top_n, num_mispredicted);
+  fprintf(stats_log, "cycles lost to mispredictions = %lu (%.2f%% of %lu cycles)\n", total_lost, (cycles ? 100.0*(double)total_lost/(double)cycles : 0.0), cycles);
+  fprintf(stats_log, "  per misprediction: fetch-to-resolve cycles, refill cycles (resolve to first instruction renamed), squashed instructions,\n");
+  fprintf(stats_log, "  and correct-path instructions a rollback to the start of the branch's checkpoint would re-execute (exposed, not in cycles lost)\n\n");
+  fprintf(stats_log, "%16s %10s %10s %7s %9s %9s %9s %9s %12s %7s\n", "pc", "executed", "mispred", "misp%", "resolve", "refill", "squashed", "exposed", "cycles lost", "%lost");
+  for (size_t i = 0; i < hotspots.size(); i++) {
+    branch_t &br = br_histogram[hotspots[i].second];
+    double m = (double)br.mispredicted;
+    fprintf(stats_log, "%16lx %10lu %10lu %6.2f%% %9.2f %9.2f %9.2f %9.2f %12lu %6.2f%%\n",
+            (hotspots[i].second << 2), br.executed, br.mispredicted,
+            (br.executed ? 100.0*m/(double)br.executed : 0.0),
+            (double)br.resolve_cycles/m, (double)br.refill_cycles/m, (double)br.squashed/m, (double)br.exposed/m,
+            br.cycles_lost, (total_lost ? 100.0*(double)br.cycles_lost/(double)total_lost : 0.0));
+  }
+}
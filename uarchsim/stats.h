@@ -6,20 +6,51 @@
 #include <map>
 #include <cstdio>
 #include <string>
+#include <vector>
 
 
 // Statistics related variables and funcions
 
-#define inc_counter(x)  stats->update_counter(#x,1)
+// The pipeline's counters.  Each gets a fixed handle, CTR_<name>, into the stats module's flat counter array, so that
+// incrementing a counter is a single add.  A counter is dumped (by name) only if it was declared: see DECLARE_COUNTER() in
+// the stats_t constructor.  Counters that are updated but not declared are kept, and ignored.  Add new counters here.
+#define STATS_COUNTERS(X) \
+  X(cycle_count) X(commit_count) X(ld_vio_count) X(retire_mem_stall_count) X(retired_chkpt_count) X(retired_load_miss_count) \
+  X(retired_bundle_count) X(exception_count) X(recovery_count) \
+  X(fused_count) X(fused_lui_count) X(fused_auipc_count) X(fused_cmpbr_count) \
+  X(load_count) X(store_count) X(fp_count) X(branch_count) X(cond_branch_count) X(uncond_branch_count) X(mispredict_count) \
+  X(spec_inst_count) X(spec_cond_branch_count) X(spec_uncond_branch_count) X(spec_mispredict_count) \
+  X(load_stall_count) X(load_stall_miss_count) X(load_forward_count) \
+  X(spec_load_count) X(spec_store_count) X(load_replay_count) X(load_miss_count) X(store_miss_count) \
+  X(spec_load_miss_count) X(spec_store_miss_count) X(store_mhsr_miss_count) X(load_mhsr_miss_count) X(ld_replay_mhsr_miss_count) \
+  X(fetched_bundle_count) X(fetched_inst_count) X(btb_write_count) X(bp_write_count) X(ras_read_count) X(ras_write_count) \
+  X(ctiq_read_count) X(ctiq_write_count) \
+  X(dispatched_bundle_count) X(dispatched_inst_count) X(dispatched_load_count) X(dispatched_store_count) \
+  X(issued_bundle_count) X(issued_inst_count) X(retired_inst_count) \
+  X(lane0_inst_executed_count) X(lane1_inst_executed_count) X(lane2_inst_executed_count) X(lane3_inst_executed_count) \
+  X(lane4_inst_executed_count) X(lane5_inst_executed_count) X(lane6_inst_executed_count) X(lane7_inst_executed_count) \
+  X(prf_read_count) X(prf_write_count) X(rmt_write_count) X(amt_write_count) X(wakeup_cam_read_count) X(freelist_write_count)
+
+#define STATS_COUNTER_ID(name) CTR_##name,
+typedef enum {
+  STATS_COUNTERS(STATS_COUNTER_ID)
+  CTR_null,             // Handle of a counter that is not declared (see stats_t::find_counter()).
+  NUM_STATS_COUNTERS    // Counters registered by name at run time (e.g., the caches' counters) get handles from here on.
+} stats_counter_e;
+#undef STATS_COUNTER_ID
+
+typedef unsigned int counter_id_t;
+
+#define inc_counter(x)  stats->update_counter(CTR_##x,1)
 #define inc_counter_str(x)  stats->update_counter(x,1)
-#define dec_counter(x)  stats->update_counter(#x,-1)
-#define counter(x)      stats->get_counter(#x)
+#define dec_counter(x)  stats->update_counter(CTR_##x,(uint64_t)-1)
+#define counter(x)      stats->get_counter(CTR_##x)
 #define knob(x)         stats->get_knob(#x)
 
 // Macro has been written this way to swallow semicolon
 #define DECLARE_COUNTER(stats,name,hierarchy) \
   do  {\
-    stats->register_counter(#name, #hierarchy);  \
+    stats->register_counter(CTR_##name, #name, #hierarchy);  \
   } while(0) 
 
 // Macro has been written this way to swallow semicolon
@@ -31,7 +62,7 @@
 // Macro has been written this way to swallow semicolon
 #define DECLARE_PHASE_COUNTER(stats,name,hierarchy) \
   do  {\
-    stats->register_phase_counter(#name, #hierarchy);  \
+    stats->register_phase_counter(CTR_##name, #name, #hierarchy);  \
   } while(0) 
 
 // Macro has been written this way to swallow semicolon
@@ -61,6 +92,7 @@ typedef struct counter {
   uint64_t phase_count;
   char* name;
   char* hierarchy;
+  bool valid_counter;         // When "true", the counter was declared (it is dumped)
   bool valid_phase_counter;   // When "true", indicates this must be dumped for each phase
 } counter_t;
 
@@ -85,6 +117,13 @@ typedef struct branch {
   size_t pc;
   size_t executed;
   size_t mispredicted;
+  // Cost of the mispredictions (see dump_br_hotspots()).
+  uint64_t resolve_cycles;  // fetch of the branch to its resolution
+  uint64_t refill_cycles;   // resolution to the first instruction renamed after the rollback
+  uint64_t squashed;        // instructions squashed by the rollback (all wrong-path: there is a checkpoint right after the branch)
+  uint64_t exposed;         // correct-path instructions from the start of the branch's checkpoint to the branch, which a rollback
+                            // to that checkpoint (no checkpoint right after the branch) would re-execute; not in cycles_lost
+  uint64_t cycles_lost;     // resolve_cycles + refill_cycles
 } branch_t;
 
 //Forward declaring classes
@@ -97,12 +136,25 @@ public:
   ~stats_t(){}
   void set_phase_interval(const char* name,uint64_t interval);
   void update_counter(const char* name,unsigned int inc=1);
+  // Counters are updated through their handles: a single add, plus a phase tick if it is the counter phases are based on.
+  inline void update_counter(counter_id_t id,uint64_t inc){
+    counters[id].count += inc;
+    counters[id].phase_count += inc;
+    if(id == phase_counter)
+      phase_tick();
+  }
   void update_pc_histogram(size_t pc);
   void update_br_histogram(size_t pc,bool misp);
+  void update_br_misp_cost(size_t pc, uint64_t resolve_cycles, uint64_t squashed, uint64_t exposed);
+  void update_br_refill(size_t pc, uint64_t refill_cycles);
   uint64_t get_counter(const char* name);
+  inline uint64_t get_counter(counter_id_t id){return counters[id].count;}
+  counter_id_t find_counter(const char* name);
   unsigned int get_knob(const char* name);
-  void register_counter(const char* name, const char* hierarchy);
-  void register_phase_counter(const char* name, const char* hierarchy);
+  void register_counter(counter_id_t id, const char* name, const char* hierarchy);
+  void register_phase_counter(counter_id_t id, const char* name, const char* hierarchy);
+  counter_id_t register_counter(const char* name, const char* hierarchy);
+  counter_id_t register_phase_counter(const char* name, const char* hierarchy);
   void register_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier);
   void register_phase_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier);
   void register_knob(const char* name, const char* hierarchy, unsigned int value);
@@ -118,12 +170,14 @@ public:
   void dump_knobs();  
   void dump_pc_histogram();  
   void dump_br_histogram();  
+  void dump_br_hotspots(unsigned int top_n);
 
   //inline void set_histogram(bool val){histogram_enabled = val;}
 
 private:
 
-  std::map<std::string, counter_t*, ltstr> counter_map;
+  std::vector<counter_t> counters;                          // Flat counter array, indexed by handle.
+  std::map<std::string, counter_id_t, ltstr> counter_map;   // Handles of the declared counters, by name (dump order).
   std::map<std::string, rate_t*, ltstr> rate_map;
   //map<const char*, counter_t*, ltstr> phase_counter_map;
   std::map<std::string, knob_t*, ltstr> knob_map;
@@ -132,7 +186,7 @@ private:
 
   uint64_t phase_id;
   uint64_t phase_interval;
-  char phase_counter_name[16];
+  counter_id_t phase_counter;  // Handle of the counter on which phases are based ((counter_id_t)-1: none).
   FILE* stats_log;
   FILE* phase_log;
 
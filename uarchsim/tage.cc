@@ -0,0 +1,284 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+#include <cmath>
+#include "ghist.h"
+#include "tage.h"
+
+tage_t::tage_t(ghist_t *ghist, uint64_t m, uint64_t budget_kb, uint64_t num_tables, uint64_t min_hist, uint64_t max_hist) {
+   uint64_t budget_bits = (budget_kb << 13);
+   uint64_t entry_bits;
+   uint64_t i;
+
+   this->ghist = ghist;
+   this->m = m;
+   pos_bits = 0;
+   while ((1ULL << pos_bits) < m)
+      pos_bits++;
+
+   assert((num_tables >= 2) && (num_tables <= TAGE_MAX_TABLES));
+   assert((min_hist >= 1) && (min_hist < max_hist));
+   this->num_tables = num_tables;
+
+   // Geometric history lengths, from min_hist (table 0) to max_hist (the last table).
+   // Tag widths increase with history length, from 7 to 13 bits: longer histories see more aliasing.
+   for (i = 0; i < num_tables; i++) {
+      hist_length[i] = (uint64_t)(min_hist * pow((double)max_hist / (double)min_hist, (double)i / (double)(num_tables - 1)) + 0.5);
+      if ((i > 0) && (hist_length[i] <= hist_length[i-1]))
+         hist_length[i] = (hist_length[i-1] + 1);
+      tag_bits[i] = (7 + ((6 * i) / (num_tables - 1)));
+   }
+
+   // Size the tables from the budget: the largest log_size such that the tagged tables (2^log_size entries each, with a 3-bit
+   // counter, a 2-bit useful counter and a tag) and the bimodal table (2^(log_size+1) 2-bit counters) fit.
+   entry_bits = 0;
+   for (i = 0; i < num_tables; i++)
+      entry_bits += (3 + 2 + tag_bits[i]);
+   log_size = 0;
+   while (((entry_bits << (log_size + 1)) + (4ULL << (log_size + 1))) <= budget_bits)
+      log_size++;
+   assert(log_size >= 4);	// budget too small
+
+   bim_mask = ((2ULL << log_size) - 1);
+   bim = new uint8_t[bim_mask + 1];
+   for (i = 0; i <= bim_mask; i++)
+      bim[i] = 2;	// weakly-taken, like the gshare predictor
+
+   for (i = 0; i < num_tables; i++) {
+      table[i] = new tage_entry_t[1ULL << log_size];
+      for (uint64_t j = 0; j < (1ULL << log_size); j++) {
+         table[i][j].ctr = 0;
+         table[i][j].tag = 0;
+         table[i][j].u = 0;
+      }
+   }
+
+   use_alt_on_na = 0;
+   num_updates = 0;
+   rand_state = 0x2545F4914F6CDD1DULL;
+
+   for (i = 0; i <= TAGE_MAX_TABLES; i++) {
+      meas_provider[i] = 0;
+      meas_provider_m[i] = 0;
+   }
+   meas_use_alt = 0;
+   meas_alloc = 0;
+   meas_alloc_fail = 0;
+}
+
+tage_t::~tage_t() {
+}
+
+uint64_t tage_t::max_history() {
+   return(hist_length[num_tables - 1]);
+}
+
+// Fold each table's history length into its index width and tag width.
+// The history is the same for all "m" predictions of a lookup, so it is folded once per lookup.
+void tage_t::fold_history(uint64_t hist, uint64_t fold_index[], uint64_t fold_tag[]) {
+   for (uint64_t i = 0; i < num_tables; i++) {
+      fold_index[i] = ghist->fold(hist, hist_length[i], log_size);
+      fold_tag[i] = (ghist->fold(hist, hist_length[i], tag_bits[i]) ^ (ghist->fold(hist, hist_length[i], tag_bits[i] - 1) << 1));
+   }
+}
+
+void tage_t::lookup(uint64_t pc, uint64_t pos, uint64_t fold_index[], uint64_t fold_tag[], tage_lookup_t &l) {
+   uint64_t key = (((pc >> 2) << pos_bits) | pos);
+   uint64_t index_mask = ((1ULL << log_size) - 1);
+   uint64_t i;
+   tage_entry_t *e;
+
+   l.bim_index = (key & bim_mask);
+   for (i = 0; i < num_tables; i++) {
+      l.index[i] = ((key ^ (key >> (log_size - (i % log_size))) ^ fold_index[i]) & index_mask);
+      l.tag[i] = ((key ^ fold_tag[i]) & ((1ULL << tag_bits[i]) - 1));
+   }
+
+   // The provider is the hitting table with the longest history, and the alternate is the hitting table with the next longest history.
+   l.provider = num_tables;
+   l.alt = num_tables;
+   for (i = num_tables; i > 0; i--) {
+      if (table[i-1][l.index[i-1]].tag == l.tag[i-1]) {
+         if (l.provider == num_tables) {
+            l.provider = (i - 1);
+         }
+         else {
+            l.alt = (i - 1);
+            break;
+         }
+      }
+   }
+
+   l.alt_pred = ((l.alt < num_tables) ? (table[l.alt][l.index[l.alt]].ctr >= 0) : (bim[l.bim_index] >= 2));
+   if (l.provider < num_tables) {
+      e = &(table[l.provider][l.index[l.provider]]);
+      l.provider_pred = (e->ctr >= 0);
+      l.use_alt = (((e->ctr == 0) || (e->ctr == -1)) && (use_alt_on_na >= 0));
+      l.pred = (l.use_alt ? l.alt_pred : l.provider_pred);
+   }
+   else {
+      l.provider_pred = l.alt_pred;
+      l.use_alt = false;
+      l.pred = l.alt_pred;
+   }
+}
+
+uint64_t tage_t::random() {
+   rand_state ^= (rand_state << 13);
+   rand_state ^= (rand_state >> 7);
+   rand_state ^= (rand_state << 17);
+   return(rand_state);
+}
+
+// Get "m" predictions packed into a uint64_t as 2-bit counters, like the gshare predictor's entries.
+// A taken prediction is 3 (strong) or 2 (weak), a not-taken prediction is 0 (strong) or 1 (weak).
+uint64_t tage_t::predict(uint64_t pc, uint64_t hist) {
+   uint64_t fold_index[TAGE_MAX_TABLES];
+   uint64_t fold_tag[TAGE_MAX_TABLES];
+   uint64_t predictions = 0;
+   tage_lookup_t l;
+   bool weak;
+
+   fold_history(hist, fold_index, fold_tag);
+   for (uint64_t pos = 0; pos < m; pos++) {
+      lookup(pc, pos, fold_index, fold_tag, l);
+      if (l.provider == num_tables)
+         weak = ((bim[l.bim_index] == 1) || (bim[l.bim_index] == 2));
+      else
+         weak = (l.use_alt || (table[l.provider][l.index[l.provider]].ctr == (l.pred ? 0 : -1)));
+      predictions |= ((uint64_t)(l.pred ? (weak ? 2 : 3) : (weak ? 1 : 0)) << (pos << 1));
+   }
+   return(predictions);
+}
+
+void tage_t::update(uint64_t pc, uint64_t hist, uint64_t pos, bool taken) {
+   uint64_t fold_index[TAGE_MAX_TABLES];
+   uint64_t fold_tag[TAGE_MAX_TABLES];
+   tage_lookup_t l;
+   tage_entry_t *e;
+   uint64_t i;
+
+   // Re-reference the predictor with the same context that was used to predict the branch.
+   fold_history(hist, fold_index, fold_tag);
+   lookup(pc, pos, fold_index, fold_tag, l);
+
+   // Measurements.
+   i = ((l.provider < num_tables) ? l.provider : TAGE_MAX_TABLES);
+   meas_provider[i]++;
+   if (l.pred != taken)
+      meas_provider_m[i]++;
+   if (l.use_alt)
+      meas_use_alt++;
+
+   // Learn whether to trust weak (newly allocated) providers.
+   if ((l.provider < num_tables) && (l.provider_pred != l.alt_pred)) {
+      e = &(table[l.provider][l.index[l.provider]]);
+      if ((e->ctr == 0) || (e->ctr == -1)) {
+         if (l.alt_pred == taken) {
+	    if (use_alt_on_na < 7)
+	       use_alt_on_na++;
+	 }
+	 else if (use_alt_on_na > -8) {
+	    use_alt_on_na--;
+	 }
+      }
+   }
+
+   // Allocate on a misprediction, in one of the tables with a longer history than the provider whose entry is not useful:
+   // the shortest such table, or with probability 1/2 the next shortest one, to spread allocations.
+   // If all of the entries are useful, age them instead.
+   if ((l.pred != taken) && ((l.provider == num_tables) || (l.provider < (num_tables - 1)))) {
+      uint64_t start = ((l.provider == num_tables) ? 0 : (l.provider + 1));
+      uint64_t victim = num_tables;
+
+      for (i = start; i < num_tables; i++) {
+         if (table[i][l.index[i]].u == 0) {
+	    if (victim == num_tables) {
+	       victim = i;
+	       if (random() & 1)
+	          break;
+	    }
+	    else {
+	       victim = i;
+	       break;
+	    }
+	 }
+      }
+
+      if (victim == num_tables) {
+	 meas_alloc_fail++;
+         for (i = start; i < num_tables; i++)
+	    table[i][l.index[i]].u--;
+      }
+      else {
+	 meas_alloc++;
+         e = &(table[victim][l.index[victim]]);
+	 e->tag = l.tag[victim];
+	 e->ctr = (taken ? 0 : -1);
+	 e->u = 0;
+      }
+   }
+
+   // Update the provider's prediction counter, and the alternate's if the provider is newly allocated and not yet useful.
+   if (l.provider < num_tables) {
+      e = &(table[l.provider][l.index[l.provider]]);
+      if ((e->u == 0) && ((e->ctr == 0) || (e->ctr == -1))) {
+         if (l.alt < num_tables) {
+	    tage_entry_t *a = &(table[l.alt][l.index[l.alt]]);
+	    if (taken && (a->ctr < 3))
+	       a->ctr++;
+	    else if (!taken && (a->ctr > -4))
+	       a->ctr--;
+	 }
+	 else {
+	    if (taken && (bim[l.bim_index] < 3))
+	       bim[l.bim_index]++;
+	    else if (!taken && (bim[l.bim_index] > 0))
+	       bim[l.bim_index]--;
+	 }
+      }
+      if (taken && (e->ctr < 3))
+         e->ctr++;
+      else if (!taken && (e->ctr > -4))
+         e->ctr--;
+
+      // The provider is useful if it was right where the alternate was wrong.
+      if (l.provider_pred != l.alt_pred) {
+         if ((l.provider_pred == taken) && (e->u < 3))
+	    e->u++;
+	 else if ((l.provider_pred != taken) && (e->u > 0))
+	    e->u--;
+      }
+   }
+   else {
+      if (taken && (bim[l.bim_index] < 3))
+         bim[l.bim_index]++;
+      else if (!taken && (bim[l.bim_index] > 0))
+         bim[l.bim_index]--;
+   }
+
+   // Graceful reset: periodically halve all useful counters, so that stale entries become replaceable.
+   num_updates++;
+   if ((num_updates & ((1ULL << TAGE_U_RESET_PERIOD) - 1)) == 0) {
+      for (i = 0; i < num_tables; i++)
+         for (uint64_t j = 0; j < (1ULL << log_size); j++)
+	    table[i][j].u >>= 1;
+   }
+}
+
+void tage_t::output(FILE *fp) {
+   uint64_t bits = (4ULL << log_size);
+
+   for (uint64_t i = 0; i < num_tables; i++)
+      bits += ((5 + tag_bits[i]) << log_size);
+
+   fprintf(fp, "TAGE MEASUREMENTS (%lu tagged tables x %lu entries, %.1f KB)------\n", num_tables, ((uint64_t)1 << log_size), (double)bits / 8192.0);
+   fprintf(fp, "Provider   hist  tag          n          m     mr\n");
+   fprintf(fp, "bimodal       0    0 %10lu %10lu %5.2lf%%\n", meas_provider[TAGE_MAX_TABLES], meas_provider_m[TAGE_MAX_TABLES],
+           100.0 * ((double)meas_provider_m[TAGE_MAX_TABLES] / (double)meas_provider[TAGE_MAX_TABLES]));
+   for (uint64_t i = 0; i < num_tables; i++)
+      fprintf(fp, "T%-2lu      %5lu %4lu %10lu %10lu %5.2lf%%\n", i + 1, hist_length[i], tag_bits[i], meas_provider[i], meas_provider_m[i],
+              100.0 * ((double)meas_provider_m[i] / (double)meas_provider[i]));
+   fprintf(fp, "Final predictions from the alternate (weak provider) = %lu\n", meas_use_alt);
+   fprintf(fp, "Allocations = %lu, failed allocations = %lu\n", meas_alloc, meas_alloc_fail);
+}
@@ -0,0 +1,93 @@
+
+#define TAGE_MAX_TABLES		16
+#define TAGE_U_RESET_PERIOD	18	// log2 of the number of updates between graceful resets of the useful counters
+
+// One entry of a TAGE tagged table.
+typedef
+struct {
+   int8_t ctr;     // 3-bit signed prediction counter: taken if >= 0
+   uint16_t tag;
+   uint8_t u;      // 2-bit useful counter
+} tage_entry_t;
+
+// The result of looking up one conditional branch prediction.
+typedef
+struct {
+   uint64_t bim_index;
+   uint64_t index[TAGE_MAX_TABLES];
+   uint64_t tag[TAGE_MAX_TABLES];
+   uint64_t provider;	// table that provided the prediction (num_tables: none, i.e., the bimodal table)
+   uint64_t alt;	// next table that hit, after the provider (num_tables: none, i.e., the bimodal table)
+   bool provider_pred;
+   bool alt_pred;
+   bool use_alt;	// the provider's counter is weak (newly allocated), and the alternate prediction was used instead
+   bool pred;		// final prediction
+} tage_lookup_t;
+
+
+// TAGE conditional branch predictor: a bimodal base predictor plus "num_tables" tagged tables indexed with geometrically
+// increasing lengths of global history (A. Seznec and P. Michaud, "A case for (partially) TAgged GEometric history length branch prediction").
+//
+// It is a drop-in replacement for the gshare predictor of conditional branches, so it keeps the Fetch Unit's prediction model:
+// one lookup per fetch bundle, with the bundle's pc and the global history prior to the bundle, supplies "m" predictions packed
+// into a uint64_t as 2-bit counters.  The i'th prediction is for the bundle's i'th conditional branch: the pc used for hashing
+// is the bundle's pc combined with i.  The predictor is trained at retirement with the same {pc, history, i} context.
+//
+// The global history is a ghist_t owned by the Fetch Unit, which checkpoints and restores its position alongside the gshare BHRs.
+class tage_t {
+private:
+	ghist_t *ghist;
+
+	// "m": number of predictions per lookup, and the number of bits used to combine the position of a prediction with the pc.
+	uint64_t m;
+	uint64_t pos_bits;
+
+	// Bimodal base predictor: 2-bit counters.
+	uint8_t *bim;
+	uint64_t bim_mask;
+
+	// Tagged tables.
+	uint64_t num_tables;
+	uint64_t log_size;			// log2 of the number of entries in each tagged table
+	tage_entry_t *table[TAGE_MAX_TABLES];
+	uint64_t hist_length[TAGE_MAX_TABLES];	// table 0 uses the shortest history
+	uint64_t tag_bits[TAGE_MAX_TABLES];
+
+	// The alternate prediction is used instead of a weak (newly allocated) provider's prediction, if this 4-bit signed counter is >= 0.
+	int8_t use_alt_on_na;
+
+	// Graceful reset of the useful counters, every 2^TAGE_U_RESET_PERIOD updates.
+	uint64_t num_updates;
+
+	// Pseudo-random number generator for choosing among tables for allocation.
+	uint64_t rand_state;
+
+	// Measurements, at retirement.
+	uint64_t meas_provider[TAGE_MAX_TABLES + 1];	// # predictions provided by each tagged table (the last one counts the bimodal table)
+	uint64_t meas_provider_m[TAGE_MAX_TABLES + 1];	// # ... that were wrong
+	uint64_t meas_use_alt;				// # final predictions that were the alternate prediction
+	uint64_t meas_alloc;				// # entries allocated
+	uint64_t meas_alloc_fail;			// # mispredictions that could not allocate an entry
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	void fold_history(uint64_t hist, uint64_t fold_index[], uint64_t fold_tag[]);
+	void lookup(uint64_t pc, uint64_t pos, uint64_t fold_index[], uint64_t fold_tag[], tage_lookup_t &l);
+	uint64_t random();
+
+public:
+	tage_t(ghist_t *ghist, uint64_t m, uint64_t budget_kb, uint64_t num_tables, uint64_t min_hist, uint64_t max_hist);
+	~tage_t();
+
+	uint64_t max_history();
+
+	// Get "m" predictions for the fetch bundle at pc, using the history prior to the bundle (position "hist" in ghist).
+	uint64_t predict(uint64_t pc, uint64_t hist);
+
+	// Train the predictor with the outcome of the conditional branch that was the pos'th prediction of the lookup {pc, hist}.
+	void update(uint64_t pc, uint64_t hist, uint64_t pos, bool taken);
+
+	void output(FILE *fp);
+};
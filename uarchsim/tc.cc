@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <cinttypes>
 #include <cassert>
 #include <cmath>
@@ -11,11 +12,46 @@
 #include "tc.h"
 
 
-tc_t::tc_t(bool perfect, mmu_t *mmu, uint64_t max_cb, uint64_t max_length) {
+tc_t::tc_t(bool perfect, mmu_t *mmu, uint64_t max_cb, uint64_t max_length, uint64_t entries, uint64_t assoc) {
    this->perfect = perfect;
    this->mmu = mmu;
    this->max_cb = max_cb;
    this->max_length = max_length;
+
+   // The path of a trace is a bit vector with one bit per conditional branch.
+   assert(max_cb <= 64);
+
+   // Real trace cache.
+   this->assoc = assoc;
+   this->sets = (entries / assoc);
+   assert((sets > 0) && IsPow2(sets));
+
+   tc = new tc_line_t *[sets];
+   for (uint64_t s = 0; s < sets; s++) {
+      tc[s] = new tc_line_t[assoc];
+      for (uint64_t way = 0; way < assoc; way++) {
+         tc[s][way].valid = false;
+         tc[s][way].lru = way;
+         tc[s][way].slot = new tc_slot_t[max_length];
+      }
+   }
+
+   // Fill unit.
+   fill_trace.valid = false;
+   fill_trace.length = 0;
+   fill_trace.num_cb = 0;
+   fill_trace.path = 0;
+   fill_trace.slot = new tc_slot_t[max_length];
+   fill_valid = false;
+
+   meas_lookup = 0;
+   meas_hit = 0;
+   meas_partial = 0;
+   meas_hit_instr = 0;
+   meas_partial_instr = 0;
+   meas_fill = 0;
+   meas_fill_present = 0;
+   meas_fill_restart = 0;
 }
 
 tc_t::~tc_t() {
@@ -46,7 +82,8 @@ bool tc_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_ta
    uint64_t num_cond_branch = 0;
    bool terminated = false;
 
-   assert(perfect);	// FIX_ME: add a real trace cache, too.
+   if (!perfect)
+      return(real_lookup(pc, cb_predictions, ib_predicted_target, ras_predicted_target, bundle, update));
 
    // Initialize these two fields in the "update" variable (which is needed by the Fetch Unit to speculatively update its predictors and pc).
    // Initially assume the fetch bundle doesn't end in a call (push_ras) or return (pop_ras) instruction, and set to true if and when we determine that it does.
@@ -219,3 +256,299 @@ bool tc_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_ta
 
    return(true);	// Perfect trace cache always hits.  The fetch bundle has at least one instruction.
 }
+
+
+// Real trace cache lookup.  Same inputs and outputs as lookup(), above.
+//
+// Search the set for traces that start at pc.  A trace whose path (directions of its embedded conditional branches) agrees with all
+// the predictions in cb_predictions is a hit: it is supplied whole.  Otherwise, the trace whose path agrees with the most leading
+// predictions is a partial hit: it is supplied up to and including the first conditional branch whose prediction disagrees with
+// the path, and that branch's next_pc follows the prediction.  The targets of indirect branches and returns, which end a trace, come
+// from the indirect branch predictor and RAS as usual.
+//
+// Like the instruction cache (ic.cc), the trace cache only models which instructions it holds; the instructions themselves are read via the MMU.
+bool tc_t::real_lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update) {
+   uint64_t set = ((pc >> 2) & (sets - 1));
+   uint64_t way;
+   uint64_t best_way = assoc;	// out-of-bounds
+   uint64_t best_match = 0;
+   uint64_t match;
+   bool full = false;
+   tc_line_t *line;
+   tc_slot_t *s;
+   bool taken;
+   uint64_t pos = 0;
+   uint64_t num_cond_branch = 0;
+   bool terminated = false;
+
+   meas_lookup++;
+
+   for (way = 0; way < assoc; way++) {
+      line = &(tc[set][way]);
+      if (line->valid && (line->start_pc == pc)) {
+         // Count the leading conditional branches whose directions agree with their predictions.
+         match = 0;
+         while ((match < line->num_cb) && (((line->path >> match) & 1) == (((cb_predictions >> (match << 1)) & 3) >= 2)))
+            match++;
+
+         if (match == line->num_cb) {
+            best_way = way;
+            full = true;
+            break;
+         }
+         else if ((best_way == assoc) || (match > best_match)) {
+            best_way = way;
+            best_match = match;
+         }
+      }
+   }
+
+   if (best_way == assoc)
+      return(false);	// Trace cache miss.
+
+   update_lru(set, best_way);
+   line = &(tc[set][best_way]);
+
+   // Initialize these two fields in the "update" variable (see lookup()).
+   update->pop_ras = false;
+   update->push_ras = false;
+
+   while ((pos < line->length) && !terminated) {
+      s = &(line->slot[pos]);
+
+      bundle[pos].valid = true;
+      bundle[pos].pc = s->pc;
+      bundle[pos].branch = s->branch;
+      bundle[pos].branch_type = s->branch_type;
+      bundle[pos].branch_target = s->branch_target;
+
+      // Try fetching the instruction via the MMU.
+      // Generate a "NOP with fetch exception" if the MMU reference generates an exception.
+      bundle[pos].exception = false;
+      try {
+         bundle[pos].insn = (mmu->load_insn(s->pc)).insn;
+      }
+      catch (trap_t& t) {
+	 bundle[pos].exception = true;
+         bundle[pos].exception_cause = t.cause();
+         bundle[pos].insn = insn_t(INSN_NOP);
+	 terminated = true;	// Terminate the fetch bundle at the offending instruction.
+      }
+
+      // (1) Determine the instruction's next_pc field.
+      // (2) Determine if this is the last instruction in the bundle: the end of the trace, or a partial hit's first mispredicted-path branch.
+      // (3) Record push_ras/pop_ras information in the "update" variable.
+      if (!s->branch) {
+         bundle[pos].next_pc = INCREMENT_PC(s->pc);
+      }
+      else {
+         switch (s->branch_type) {
+            case BTB_BRANCH:
+	       num_cond_branch++;
+	       taken = ((cb_predictions & 3) >= 2);
+	       cb_predictions = (cb_predictions >> 2);
+	       bundle[pos].next_pc = (taken ? s->branch_target : INCREMENT_PC(s->pc));
+	       if (taken != s->taken)
+	          terminated = true;
+	       break;
+
+            case BTB_JUMP_DIRECT:
+	       bundle[pos].next_pc = s->branch_target;
+	       break;
+
+            case BTB_CALL_DIRECT:
+	       bundle[pos].next_pc = s->branch_target;
+	       update->push_ras = true;
+	       update->push_ras_pc = INCREMENT_PC(s->pc);
+	       break;
+
+            case BTB_JUMP_INDIRECT:
+	       bundle[pos].next_pc = ib_predicted_target;
+	       break;
+
+            case BTB_CALL_INDIRECT:
+	       bundle[pos].next_pc = ib_predicted_target;
+	       update->push_ras = true;
+	       update->push_ras_pc = INCREMENT_PC(s->pc);
+	       break;
+
+            case BTB_RETURN:
+	       bundle[pos].next_pc = ras_predicted_target;
+	       update->pop_ras = true;
+	       break;
+
+            default:
+	       assert(0);
+	       break;
+         }
+      }
+
+      pos++;
+   }
+
+   // Finalize the "update" variable.
+   assert(pos > 0);
+   update->next_pc = bundle[pos-1].next_pc;
+   update->num_cb = num_cond_branch;
+
+   if (full) {
+      meas_hit++;
+      meas_hit_instr += pos;
+   }
+   else {
+      meas_partial++;
+      meas_partial_instr += pos;
+   }
+
+   // Mark any residual slots in the fetch bundle as invalid (no instructions in those slots).
+   while (pos < max_length) {
+      bundle[pos].valid = false;
+      pos++;
+   }
+
+   return(true);
+}
+
+
+// Fill unit.
+//
+// A branch retired.  First append the sequential non-branch instructions that retired since the previously retired instruction
+// (fill_pc), then append the branch.  Retirement continues at next_pc.
+void tc_t::fill(uint64_t pc, btb_branch_type_e branch_type, uint64_t branch_target, bool taken, uint64_t next_pc) {
+   if (fill_valid && (pc >= fill_pc)) {
+      for (uint64_t p = fill_pc; p < pc; p = INCREMENT_PC(p))
+         fill_append(p, false, BTB_BRANCH, 0, false);
+      fill_append(pc, true, branch_type, branch_target, taken);
+   }
+   else {
+      // The fill unit lost track of the retired instruction stream.  Discard the trace being built and resynchronize at next_pc.
+      fill_trace.valid = false;
+   }
+
+   fill_valid = true;
+   fill_pc = next_pc;
+}
+
+void tc_t::fill_restart(uint64_t pc) {
+   if (fill_trace.valid)
+      meas_fill_restart++;
+   fill_trace.valid = false;
+   fill_valid = true;
+   fill_pc = pc;
+}
+
+// Append one retired instruction to the trace being built.
+// The trace ends with the same selection policy as the perfect trace cache: at the maximum number of instructions, at the maximum
+// number of conditional branches, or at a call direct, jump indirect, call indirect, or return.
+void tc_t::fill_append(uint64_t pc, bool branch, btb_branch_type_e branch_type, uint64_t branch_target, bool taken) {
+   tc_slot_t *s;
+   bool terminated;
+
+   if (!fill_trace.valid) {
+      // Start a new trace.
+      fill_trace.valid = true;
+      fill_trace.start_pc = pc;
+      fill_trace.path = 0;
+      fill_trace.length = 0;
+      fill_trace.num_cb = 0;
+   }
+
+   s = &(fill_trace.slot[fill_trace.length]);
+   s->pc = pc;
+   s->branch = branch;
+   s->branch_type = branch_type;
+   s->branch_target = branch_target;
+   s->taken = taken;
+   fill_trace.length++;
+
+   if (branch && (branch_type == BTB_BRANCH)) {
+      if (taken)
+         fill_trace.path |= (1ULL << fill_trace.num_cb);
+      fill_trace.num_cb++;
+   }
+
+   if (fill_trace.length == max_length)
+      terminated = true;
+   else if (!branch)
+      terminated = false;
+   else if (branch_type == BTB_BRANCH)
+      terminated = (fill_trace.num_cb == max_cb);
+   else
+      terminated = (branch_type != BTB_JUMP_DIRECT);
+
+   if (terminated)
+      fill_end();
+}
+
+// Write the completed trace into the trace cache.
+// A trace with the same start pc and path replaces the one in the set (a set holds at most one trace per path); otherwise the
+// trace goes into an invalid way or replaces the LRU way.
+void tc_t::fill_end() {
+   uint64_t set = ((fill_trace.start_pc >> 2) & (sets - 1));
+   uint64_t way;
+   uint64_t victim = assoc;	// out-of-bounds
+   tc_line_t *line;
+
+   assert(fill_trace.valid && (fill_trace.length > 0));
+   meas_fill++;
+
+   for (way = 0; way < assoc; way++) {
+      line = &(tc[set][way]);
+      if (line->valid && (line->start_pc == fill_trace.start_pc) && (line->num_cb == fill_trace.num_cb) && (line->path == fill_trace.path)) {
+         if (line->length == fill_trace.length)
+	    meas_fill_present++;
+         victim = way;
+	 break;
+      }
+   }
+
+   if (victim == assoc) {
+      for (way = 0; way < assoc; way++) {
+         if (!tc[set][way].valid) {
+	    victim = way;
+	    break;
+	 }
+	 else if (tc[set][way].lru == (assoc - 1)) {
+	    victim = way;
+	 }
+      }
+   }
+   assert(victim < assoc);
+
+   line = &(tc[set][victim]);
+   line->valid = true;
+   line->start_pc = fill_trace.start_pc;
+   line->path = fill_trace.path;
+   line->length = fill_trace.length;
+   line->num_cb = fill_trace.num_cb;
+   for (uint64_t i = 0; i < fill_trace.length; i++)
+      line->slot[i] = fill_trace.slot[i];
+   update_lru(set, victim);
+
+   // Start a new trace with the next retired instruction.
+   fill_trace.valid = false;
+}
+
+void tc_t::update_lru(uint64_t set, uint64_t way) {
+   // Make "way" most-recently-used.
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (tc[set][i].lru < tc[set][way].lru)
+         tc[set][i].lru++;
+   }
+   tc[set][way].lru = 0;
+}
+
+void tc_t::output(uint64_t num_instr, FILE *fp) {
+   uint64_t miss = (meas_lookup - meas_hit - meas_partial);
+
+   if (perfect)
+      return;
+
+   fprintf(fp, "TRACE CACHE MEASUREMENTS (%lu sets x %lu ways, m=%lu, n=%lu)---\n", sets, assoc, max_cb, max_length);
+   fprintf(fp, "Lookups      = %lu\n", meas_lookup);
+   fprintf(fp, "Hits         = %lu (%.2f%%), avg. %.2f instr.\n", meas_hit, 100.0 * ((double)meas_hit / (double)meas_lookup), ((double)meas_hit_instr / (double)meas_hit));
+   fprintf(fp, "Partial hits = %lu (%.2f%%), avg. %.2f instr.\n", meas_partial, 100.0 * ((double)meas_partial / (double)meas_lookup), ((double)meas_partial_instr / (double)meas_partial));
+   fprintf(fp, "Misses       = %lu (%.2f%%)\n", miss, 100.0 * ((double)miss / (double)meas_lookup));
+   fprintf(fp, "Instructions supplied by the trace cache = %lu (%.2f%% of retired)\n", (meas_hit_instr + meas_partial_instr), 100.0 * ((double)(meas_hit_instr + meas_partial_instr) / (double)num_instr));
+   fprintf(fp, "Traces filled = %lu (already present = %lu), fill unit restarts = %lu\n", meas_fill, meas_fill_present, meas_fill_restart);
+}
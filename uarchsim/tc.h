@@ -1,9 +1,35 @@
 
+// One instruction slot of a trace.
+typedef
+struct {
+   uint64_t pc;                    // PC of the instruction.
+   bool branch;                    // The instruction is a branch.
+   btb_branch_type_e branch_type;  // If a branch, its type.
+   uint64_t branch_target;         // If a branch, its taken target (not valid for indirect branches).
+   bool taken;                     // If a conditional branch, its direction along the trace's path.
+} tc_slot_t;
+
+// A trace (a trace cache line, or the trace being built by the fill unit).
+typedef
+struct {
+   // Metadata for hit/miss determination and replacement.
+   bool valid;
+   uint64_t start_pc;      // Tag: start pc of the trace.
+   uint64_t path;          // Path: bit i is the direction of the i'th conditional branch in the trace (path associativity).
+   uint64_t lru;
+
+   // Payload.
+   uint64_t length;        // Number of instructions in the trace.
+   uint64_t num_cb;        // Number of conditional branches in the trace.
+   tc_slot_t *slot;        // The instructions, in trace order.
+} tc_line_t;
+
+
 class tc_t {
 private:
 	// Perfect vs. real trace cache.
 	bool perfect;
-	mmu_t *mmu;	// need to reference the mmu if modeling a perfect trace cache
+	mmu_t *mmu;	// need to reference the mmu if modeling a perfect trace cache (a real trace cache reads instructions through it, too)
 
 	// "m": maximum number of conditional branches in a trace.
 	uint64_t max_cb;
@@ -11,8 +37,49 @@ private:
         // "n": maximum number of instructions in a trace.
         uint64_t max_length;
 
+	// Real trace cache: tc[set][way].
+	// A set is selected by the start pc of the trace.  Several traces with the same start pc, but different paths
+	// (directions of their embedded conditional branches), may be in a set at once (path associativity).
+	tc_line_t **tc;
+	uint64_t sets;
+	uint64_t assoc;
+
+	// Fill unit: builds traces from the retired instruction stream, following the same selection policy as lookup()
+	// (see fetchunit.h), and writes each completed trace into the trace cache.
+	tc_line_t fill_trace;	// The trace being built.
+	bool fill_valid;	// The fill unit knows the pc of the next retired instruction (fill_pc).
+	uint64_t fill_pc;
+
+	// Measurements.
+	uint64_t meas_lookup;		// # lookups
+	uint64_t meas_hit;		// # hits: a trace whose path matches all of the predictions
+	uint64_t meas_partial;		// # partial hits: the longest path matching a prefix of the predictions, cut at the first mismatch
+	uint64_t meas_hit_instr;	// # instructions supplied by hits
+	uint64_t meas_partial_instr;	// # instructions supplied by partial hits
+	uint64_t meas_fill;		// # traces completed by the fill unit
+	uint64_t meas_fill_present;	// # ... that were already in the trace cache
+	uint64_t meas_fill_restart;	// # times the fill unit discarded its trace (complete squash)
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	bool real_lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
+	void fill_append(uint64_t pc, bool branch, btb_branch_type_e branch_type, uint64_t branch_target, bool taken);
+	void fill_end();
+	void update_lru(uint64_t set, uint64_t way);
+
 public:
-	tc_t(bool perfect, mmu_t *mmu, uint64_t max_cb, uint64_t max_length);
+	tc_t(bool perfect, mmu_t *mmu, uint64_t max_cb, uint64_t max_length, uint64_t entries, uint64_t assoc);
 	~tc_t();
 	bool lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
+
+	// Fill unit interface.
+	// fill(): A branch retired (fetchunit_t::commit()).  The instructions between the previously retired branch and this one are
+	//         sequential non-branches, so the retired branches describe the whole retired instruction stream.
+	// fill_restart(): Retirement continues at pc after a complete squash.  Discard the trace being built and start a new one at pc.
+	void fill(uint64_t pc, btb_branch_type_e branch_type, uint64_t branch_target, bool taken, uint64_t next_pc);
+	void fill_restart(uint64_t pc);
+
+	void output(uint64_t num_instr, FILE *fp);
 };
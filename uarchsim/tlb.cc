@@ -0,0 +1,236 @@
+/*--------------------------------------------------------------------------*\
+ | tlb.cc
+ |
+ | Address translation timing: TLBs and a page table walker.  See tlb.h.
+\*--------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <cassert>
+
+#include "CacheClass.h"
+#include "tlb.h"
+
+/*--------------------------------------------------------------------------*\
+ | Page table walker.
+\*--------------------------------------------------------------------------*/
+
+page_walker_t::page_walker_t(unsigned int _walkers, unsigned int pwcEntries, unsigned int _pageBits,
+                             CacheClass* _mem, cycle_t _memLatency, unsigned int _Tid)
+	: walkers(_walkers),
+	  pageBits(_pageBits),
+	  mem(_mem),
+	  memLatency(_memLatency),
+	  Tid(_Tid)
+{
+	unsigned int i;
+
+	assert(walkers > 0);
+
+	walkerFree = new cycle_t[walkers];
+	for (i = 0; i < walkers; i++)
+		walkerFree[i] = 0;
+
+	for (i = 0; i < (PTW_LEVELS-1); i++) {
+		pwc[i] = (pwcEntries ? new_cache_array<tlb_entry_t>(REPL_LRU, 1, pwcEntries) : (TLBArray*)NULL);
+		n_pwc_hits[i] = 0;
+	}
+
+	n_walks = 0;
+	n_coalesced = 0;
+	n_queued = 0;
+	queueCycles = 0;
+	walkCycles = 0;
+	n_pte_reads = 0;
+	n_pte_retries = 0;
+}
+
+page_walker_t::~page_walker_t()
+{
+	delete [] walkerFree;
+	for (unsigned int i = 0; i < (PTW_LEVELS-1); i++)
+		if (pwc[i])
+			delete pwc[i];
+}
+
+reg_t page_walker_t::PteAddr(unsigned int level, reg_t vpn)
+/*------------------------------------------------------------------------*\
+ | The table read at 'level' is selected by the VPN bits above that level
+ |  (the root is table 0); the PTE within it by the VPN bits of the level.
+\*------------------------------------------------------------------------*/
+{
+	unsigned int shift = (PTW_LEVELS - 1 - level) * PTW_LEVEL_BITS;
+	reg_t index = ((vpn >> shift) & ((1 << PTW_LEVEL_BITS) - 1));
+	reg_t table = ((level == 0) ? 0 : ((vpn >> (shift + PTW_LEVEL_BITS)) & 0xFFFFF));
+
+	return(PTW_TABLE_BASE + ((reg_t)level << 36) + (table << pageBits) + (index * PTW_PTE_SIZE));
+}
+
+cycle_t page_walker_t::ReadPte(cycle_t curCycle, reg_t addr)
+{
+	cycle_t done;
+	bool hit;
+
+	n_pte_reads++;
+	if (!mem)
+		return(curCycle + memLatency);
+
+	// A refused read (no free MHSR) is retried once an MHSR frees up.
+	while ((done = mem->Access(Tid, curCycle, addr, false, &hit)) == -1) {
+		n_pte_retries++;
+		curCycle = mem->RetryCycle(Tid, curCycle, addr);
+	}
+	return(done);
+}
+
+cycle_t page_walker_t::Walk(cycle_t curCycle, reg_t vpn)
+{
+	unsigned int i;
+	unsigned int w;
+	unsigned int level;
+	reg_t oldVpn;
+	bool hit;
+	cycle_t t;
+
+	// Retire completed walks; join a walk of the same VPN in progress.
+	for (i = 0; i < inFlight.size(); ) {
+		if (inFlight[i].second <= curCycle) {
+			inFlight[i] = inFlight.back();
+			inFlight.pop_back();
+		}
+		else if (inFlight[i].first == vpn) {
+			n_coalesced++;
+			return(inFlight[i].second);
+		}
+		else {
+			i++;
+		}
+	}
+
+	n_walks++;
+
+	// Wait for a free walker.
+	w = 0;
+	for (i = 1; i < walkers; i++)
+		if (walkerFree[i] < walkerFree[w])
+			w = i;
+	t = curCycle;
+	if (walkerFree[w] > t) {
+		n_queued++;
+		queueCycles += (walkerFree[w] - t);
+		t = walkerFree[w];
+	}
+
+	// Start below the deepest level whose PTE is in a page walk cache.
+	level = 0;
+	for (i = (PTW_LEVELS-1); i > 0; i--) {
+		if (pwc[i-1]) {
+			pwc[i-1]->lookup(vpn >> ((PTW_LEVELS - i) * PTW_LEVEL_BITS), NULL, &hit, &oldVpn, false);
+			if (hit) {
+				n_pwc_hits[i-1]++;
+				level = i;
+				break;
+			}
+		}
+	}
+
+	// One dependent PTE read per remaining level.
+	for ( ; level < PTW_LEVELS; level++) {
+		t = ReadPte(t, PteAddr(level, vpn));
+		if ((level < (PTW_LEVELS-1)) && pwc[level])
+			pwc[level]->lookup(vpn >> ((PTW_LEVELS - 1 - level) * PTW_LEVEL_BITS), NULL, &hit, &oldVpn, true);
+	}
+
+	walkerFree[w] = t;
+	inFlight.push_back(std::make_pair(vpn, t));
+	walkCycles += (t - curCycle);
+	return(t);
+}
+
+void page_walker_t::dump_stats(FILE* fp)
+{
+	unsigned int i;
+
+	fprintf(fp, "PAGE TABLE WALKER (%u walker(s), %u levels)\n", walkers, PTW_LEVELS);
+	fprintf(fp, "  walks            = %" PRIu64 "\n", n_walks);
+	fprintf(fp, "  avg. walk latency = %.2f cycles (incl. waiting for a walker)\n", (double)walkCycles/(double)n_walks);
+	fprintf(fp, "  waited for a walker = %" PRIu64 " (avg. %.2f cycles)\n", n_queued, (double)queueCycles/(double)n_queued);
+	fprintf(fp, "  misses joining a walk in progress = %" PRIu64 "\n", n_coalesced);
+	fprintf(fp, "  PTE reads        = %" PRIu64 " (%.2f per walk, %" PRIu64 " refused and retried)\n",
+	        n_pte_reads, (double)n_pte_reads/(double)n_walks, n_pte_retries);
+	for (i = 0; i < (PTW_LEVELS-1); i++) {
+		if (pwc[i])
+			fprintf(fp, "  page walk cache, level %u PTEs: hits = %" PRIu64 "\n", i, n_pwc_hits[i]);
+	}
+}
+
+/*--------------------------------------------------------------------------*\
+ | TLB.
+\*--------------------------------------------------------------------------*/
+
+tlb_t::tlb_t(const char* _name, unsigned int entries, unsigned int assoc, cycle_t _hitLatency,
+             unsigned int _pageBits, tlb_t* _nextLevel, page_walker_t* _walker)
+	: name(_name),
+	  hitLatency(_hitLatency),
+	  pageBits(_pageBits),
+	  nextLevel(_nextLevel),
+	  walker(_walker)
+{
+	assert(nextLevel || walker);
+	array = new_cache_array<tlb_entry_t>(REPL_LRU, (entries / assoc), assoc);
+
+	n_accesses = 0;
+	n_misses = 0;
+	n_pending = 0;
+	missCycles = 0;
+}
+
+tlb_t::~tlb_t()
+{
+	delete array;
+}
+
+cycle_t tlb_t::Translate(cycle_t curCycle, reg_t addr)
+{
+	reg_t vpn = this->vpn(addr);
+	reg_t oldVpn;
+	bool hit;
+	tlb_entry_t* entry;
+	tlb_entry_t* old;
+	cycle_t ready;
+
+	n_accesses++;
+
+	entry = array->lookup(vpn, NULL, &hit, &oldVpn, false);
+	if (hit) {
+		if (entry->ready > (curCycle + hitLatency)) {
+			n_pending++;
+			return(entry->ready);
+		}
+		return(curCycle + hitLatency);
+	}
+
+	n_misses++;
+	if (nextLevel)
+		ready = nextLevel->Translate(curCycle + hitLatency, addr);
+	else
+		ready = walker->Walk(curCycle + hitLatency, vpn);
+	missCycles += (ready - curCycle);
+
+	entry = new tlb_entry_t;
+	entry->ready = ready;
+	old = array->lookup(vpn, entry, &hit, &oldVpn, true);
+	if (old)
+		delete old;
+
+	return(ready);
+}
+
+void tlb_t::dump_stats(FILE* fp, uint64_t num_insn)
+{
+	fprintf(fp, "%s\n", name);
+	fprintf(fp, "  accesses         = %" PRIu64 "\n", n_accesses);
+	fprintf(fp, "  misses           = %" PRIu64 " (%.2f%%, %.2f MPKI)\n",
+	        n_misses, 100.0*(double)n_misses/(double)n_accesses, 1000.0*(double)n_misses/(double)num_insn);
+	fprintf(fp, "  avg. miss latency = %.2f cycles\n", (double)missCycles/(double)n_misses);
+	fprintf(fp, "  hits on entries still being filled = %" PRIu64 "\n", n_pending);
+}
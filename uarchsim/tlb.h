@@ -0,0 +1,123 @@
+#ifndef TLB_H
+#define TLB_H
+/*--------------------------------------------------------------------------*\
+ | tlb.h
+ |
+ | Address translation timing: TLBs and a hardware page table walker.
+ | Like CacheClass, only time-stamps are kept.  The functional translation
+ |  is still done by the mmu.
+ |
+ | Organization:
+ |  L1 ITLB (used by ic_t) and L1 DTLB (used by the LSU), each backed by an
+ |  optional shared L2 TLB, which is backed by the page table walker.
+ |  An L1 TLB hit is free (looked up in parallel with the VIPT L1 cache).
+ |
+ | Page table walker:
+ |  Walks a 3-level radix page table (Sv39: 9 VPN bits per level).  Each
+ |  level is one 8-byte PTE read through the cache hierarchy (the L1 D$, or
+ |  a fixed latency without one).  The page table is synthetic: level l of
+ |  the walk for a VPN reads the PTE at a fixed address determined by the
+ |  VPN bits above and at that level, so neighbouring pages share PTE
+ |  lines and upper-level PTEs as in a real page table.
+ |
+ |  Page walk caches (one per non-leaf level, fully associative, LRU) hold
+ |  recently used upper-level PTEs, so a walk can start below the root.
+ |  At most 'walkers' walks are in progress at once; a walk for a VPN that
+ |  is already being walked waits for that walk instead.
+\*--------------------------------------------------------------------------*/
+#include <cstdio>
+#include <cinttypes>
+#include <vector>
+#include "decode.h"
+#include "cache.h"
+
+#define PTW_LEVELS 3          /* Levels of the page table (Sv39).       */
+#define PTW_LEVEL_BITS 9      /* VPN bits translated by each level.     */
+#define PTW_PTE_SIZE 8        /* Bytes per PTE.                         */
+#define PTW_TABLE_BASE ((reg_t)1 << 40)  /* Synthetic page table region. */
+
+class CacheClass;
+
+class tlb_entry_t {
+public:
+	cycle_t ready;    /* Cycle when the translation is in the TLB. */
+};
+
+typedef cache_array_t<tlb_entry_t> TLBArray;
+
+class page_walker_t {
+public:
+	page_walker_t(unsigned int _walkers, unsigned int pwcEntries, unsigned int _pageBits,
+	              CacheClass* _mem, cycle_t _memLatency, unsigned int _Tid);
+	~page_walker_t();
+
+	cycle_t Walk(cycle_t curCycle, reg_t vpn);
+	/*------------------------------------------------------------------------*\
+	 | Translate 'vpn', starting at curCycle.  Returns the cycle when the
+	 |  leaf PTE has been read.
+	\*------------------------------------------------------------------------*/
+
+	void dump_stats(FILE* fp);
+
+private:
+	reg_t PteAddr(unsigned int level, reg_t vpn);
+	cycle_t ReadPte(cycle_t curCycle, reg_t addr);
+
+	unsigned int walkers;
+	unsigned int pageBits;     /* log2 of the page size in bytes.            */
+	CacheClass*  mem;          /* PTE reads go here (NULL: memLatency).      */
+	cycle_t      memLatency;
+	unsigned int Tid;
+
+	cycle_t*     walkerFree;   /* Cycle each walker finishes its walk.       */
+	TLBArray*    pwc[PTW_LEVELS-1];  /* Page walk caches, by level.          */
+
+	/* Walks in progress: (VPN, cycle the walk completes). */
+	std::vector<std::pair<reg_t, cycle_t> > inFlight;
+
+	/* stats */
+	uint64_t     n_walks;
+	uint64_t     n_coalesced;  /* Misses that waited for a walk in progress. */
+	uint64_t     n_queued;     /* Walks that waited for a free walker.       */
+	uint64_t     queueCycles;
+	uint64_t     walkCycles;   /* Sum of walk latencies, incl. queueing.     */
+	uint64_t     n_pte_reads;
+	uint64_t     n_pte_retries;  /* PTE reads the cache refused (retried).     */
+	uint64_t     n_pwc_hits[PTW_LEVELS-1];
+};
+
+class tlb_t {
+public:
+	tlb_t(const char* _name, unsigned int entries, unsigned int assoc, cycle_t _hitLatency,
+	      unsigned int _pageBits, tlb_t* _nextLevel, page_walker_t* _walker);
+	~tlb_t();
+
+	cycle_t Translate(cycle_t curCycle, reg_t addr);
+	/*------------------------------------------------------------------------*\
+	 | Translate the virtual address 'addr'.  Returns the cycle when the
+	 |  translation is available: curCycle + hitLatency on a hit, later if
+	 |  the entry is still being filled or on a miss.  A miss fills the entry
+	 |  from the next level (or the walker) right away, with the cycle the
+	 |  translation will be ready.
+	\*------------------------------------------------------------------------*/
+
+	reg_t vpn(reg_t addr) { return(addr >> pageBits); }
+
+	void dump_stats(FILE* fp, uint64_t num_insn);
+
+private:
+	const char*  name;
+	TLBArray*    array;
+	cycle_t      hitLatency;
+	unsigned int pageBits;
+	tlb_t*       nextLevel;
+	page_walker_t* walker;
+
+	/* stats */
+	uint64_t     n_accesses;
+	uint64_t     n_misses;
+	uint64_t     n_pending;    /* Hits on entries that were still being filled. */
+	uint64_t     missCycles;   /* Sum of miss latencies.                       */
+};
+
+#endif //TLB_H
@@ -0,0 +1,186 @@
+#include <cstdio>
+#include <cinttypes>
+#include <cassert>
+
+#include "processor.h"
+#include "decode.h"
+#include "config.h"
+
+#include "payload.h"
+#include "uopcache.h"
+
+
+uop_cache_t::uop_cache_t(uint64_t max_length, uint64_t entries, uint64_t assoc) {
+   this->max_length = max_length;
+   this->assoc = assoc;
+   this->sets = (entries / assoc);
+   assert((sets > 0) && IsPow2(sets));
+
+   uc = new uop_line_t *[sets];
+   for (uint64_t s = 0; s < sets; s++) {
+      uc[s] = new uop_line_t[assoc];
+      for (uint64_t way = 0; way < assoc; way++) {
+         uc[s][way].valid = false;
+         uc[s][way].lru = way;
+         uc[s][way].length = 0;
+         uc[s][way].uop = new uop_t[max_length];
+      }
+   }
+
+   meas_lookup = 0;
+   meas_hit = 0;
+   meas_short = 0;
+   meas_hit_uops = 0;
+   meas_miss_instr = 0;
+   meas_fill = 0;
+}
+
+uop_cache_t::~uop_cache_t() {
+}
+
+bool uop_cache_t::search(uint64_t start_pc, uint64_t &set, uint64_t &way) {
+   set = ((start_pc >> 2) & (sets - 1));
+   for (way = 0; way < assoc; way++) {
+      if (uc[set][way].valid && (uc[set][way].start_pc == start_pc))
+         return(true);
+   }
+   return(false);
+}
+
+bool uop_cache_t::lookup(uint64_t start_pc, uint64_t length) {
+   uint64_t set, way;
+
+   assert(length <= max_length);
+   meas_lookup++;
+
+   if (search(start_pc, set, way)) {
+      if (uc[set][way].length >= length) {
+         update_lru(set, way);
+         meas_hit++;
+         meas_hit_uops += length;
+         return(true);
+      }
+      meas_short++;
+   }
+
+   meas_miss_instr += length;
+   return(false);
+}
+
+void uop_cache_t::read(uint64_t start_pc, uint64_t pos, payload_t *p) {
+   uint64_t set, way;
+   uop_t *uop;
+
+   // Only called after a hit in the same cycle.
+   if (!search(start_pc, set, way))
+      assert(0);
+   assert(pos < uc[set][way].length);
+   uop = &(uc[set][way].uop[pos]);
+   assert(uop->pc == p->pc);
+
+   p->flags = uop->flags;
+   p->fu = uop->fu;
+   p->checkpoint = uop->checkpoint;
+   p->split = uop->split;
+   p->split_store = uop->split_store;
+   p->A_valid = uop->A_valid;
+   p->A_log_reg = uop->A_log_reg;
+   p->B_valid = uop->B_valid;
+   p->B_log_reg = uop->B_log_reg;
+   p->C_valid = uop->C_valid;
+   p->C_log_reg = uop->C_log_reg;
+   p->D_valid = uop->D_valid;
+   p->D_log_reg = uop->D_log_reg;
+   p->A_value = uop->A_value;
+   p->iq = uop->iq;
+   p->CSR_addr = uop->CSR_addr;
+   p->size = uop->size;
+   p->is_signed = uop->is_signed;
+   p->left = false;
+   p->right = false;
+}
+
+void uop_cache_t::fill(uint64_t start_pc, uint64_t pos, payload_t *p) {
+   uint64_t set, way;
+   uop_line_t *line;
+   uop_t *uop;
+
+   assert(pos < max_length);
+   assert(p->pc == (start_pc + (pos << 2)));
+
+   if (!search(start_pc, set, way)) {
+      // Only the first instruction of a fetch bundle allocates a line.
+      if (pos > 0)
+         return;
+
+      // Replace the LRU way.
+      for (way = 0; way < assoc; way++) {
+         if (uc[set][way].lru == (assoc - 1))
+            break;
+      }
+      assert(way < assoc);
+      uc[set][way].valid = true;
+      uc[set][way].start_pc = start_pc;
+      uc[set][way].length = 0;
+      update_lru(set, way);
+      meas_fill++;
+   }
+
+   line = &(uc[set][way]);
+
+   // The line holds a sequential run of micro-ops from the start of the fetch bundle: skip an instruction past its end.
+   if (pos > line->length)
+      return;
+
+   // An instruction that the Decode stage turned into a trap (e.g., ecall, or an illegal instruction) is not cached,
+   // and neither are the instructions after it.
+   if (p->trap.valid()) {
+      line->length = pos;
+      return;
+   }
+
+   uop = &(line->uop[pos]);
+   uop->pc = p->pc;
+   uop->flags = p->flags;
+   uop->fu = p->fu;
+   uop->checkpoint = p->checkpoint;
+   uop->split = p->split;
+   uop->split_store = p->split_store;
+   uop->A_valid = p->A_valid;
+   uop->A_log_reg = p->A_log_reg;
+   uop->B_valid = p->B_valid;
+   uop->B_log_reg = p->B_log_reg;
+   uop->C_valid = p->C_valid;
+   uop->C_log_reg = p->C_log_reg;
+   uop->D_valid = p->D_valid;
+   uop->D_log_reg = p->D_log_reg;
+   uop->A_value = p->A_value;
+   uop->iq = p->iq;
+   uop->CSR_addr = p->CSR_addr;
+   uop->size = p->size;
+   uop->is_signed = p->is_signed;
+
+   if (pos == line->length)
+      line->length++;
+}
+
+void uop_cache_t::update_lru(uint64_t set, uint64_t way) {
+   // Make "way" most-recently-used.
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (uc[set][i].lru < uc[set][way].lru)
+         uc[set][i].lru++;
+   }
+   uc[set][way].lru = 0;
+}
+
+void uop_cache_t::output(FILE *fp) {
+   uint64_t miss = (meas_lookup - meas_hit);
+
+   fprintf(fp, "MICRO-OP CACHE MEASUREMENTS (%lu sets x %lu ways, n=%lu)---\n", sets, assoc, max_length);
+   fprintf(fp, "Lookups      = %lu\n", meas_lookup);
+   fprintf(fp, "Hits         = %lu (%.2f%%), avg. %.2f micro-ops\n", meas_hit, 100.0 * ((double)meas_hit / (double)meas_lookup), ((double)meas_hit_uops / (double)meas_hit));
+   fprintf(fp, "Misses       = %lu (%.2f%%), of which the line held only part of the fetch bundle = %lu\n", miss, 100.0 * ((double)miss / (double)meas_lookup), meas_short);
+   fprintf(fp, "Micro-op hit rate (instructions supplied by the micro-op cache) = %.2f%% (%lu of %lu fetched)\n",
+           100.0 * ((double)meas_hit_uops / (double)(meas_hit_uops + meas_miss_instr)), meas_hit_uops, (meas_hit_uops + meas_miss_instr));
+   fprintf(fp, "Lines filled = %lu\n", meas_fill);
+}
@@ -0,0 +1,86 @@
+
+// Micro-op cache: holds the decoded instructions of recently decoded fetch bundles.
+//
+// A line holds the decoded payload fields of up to "n" sequential instructions, keyed by the start pc of the fetch bundle
+// they were fetched in.  The Fetch1 stage looks it up with the start pc of each fetch bundle formed by the instruction cache + BTB:
+// it hits if the line holds the decoded instructions of the whole bundle, which then skips the Decode stage (see pipeline_t::decode_bypass()).
+// The Decode stage fills it with the instructions that it decodes.
+
+// One decoded instruction (micro-op): the payload fields set by the Decode stage.
+typedef
+struct {
+   uint64_t pc;
+   unsigned int flags;
+   fu_type fu;
+   bool checkpoint;
+   bool split;
+   bool split_store;
+   bool A_valid;
+   unsigned int A_log_reg;
+   bool B_valid;
+   unsigned int B_log_reg;
+   bool C_valid;
+   unsigned int C_log_reg;
+   bool D_valid;
+   unsigned int D_log_reg;
+   union64_t A_value;	// Only set by the Decode stage for a nop (it has no source register to read).
+   sel_iq iq;
+   uint64_t CSR_addr;
+   unsigned int size;
+   bool is_signed;
+} uop_t;
+
+// A micro-op cache line.
+typedef
+struct {
+   // Metadata for hit/miss determination and replacement.
+   bool valid;
+   uint64_t start_pc;	// Tag: start pc of the fetch bundle.
+   uint64_t lru;
+
+   // Payload.
+   uint64_t length;	// Number of micro-ops, in fetch bundle order.
+   uop_t *uop;
+} uop_line_t;
+
+
+class uop_cache_t {
+private:
+	// "n": maximum number of micro-ops in a line (instructions in a fetch bundle).
+	uint64_t max_length;
+
+	// uc[set][way].  A set is selected by the start pc of the fetch bundle.
+	uop_line_t **uc;
+	uint64_t sets;
+	uint64_t assoc;
+
+	// Measurements.
+	uint64_t meas_lookup;		// # lookups
+	uint64_t meas_hit;		// # hits
+	uint64_t meas_short;		// # lookups that found the line, but it held only part of the fetch bundle (miss)
+	uint64_t meas_hit_uops;		// # micro-ops supplied by hits
+	uint64_t meas_miss_instr;	// # instructions of fetch bundles that missed (decoded by the Decode stage)
+	uint64_t meas_fill;		// # lines allocated by the Decode stage
+
+	////////////////////////////////////
+	// Private utility functions.
+	////////////////////////////////////
+
+	bool search(uint64_t start_pc, uint64_t &set, uint64_t &way);
+	void update_lru(uint64_t set, uint64_t way);
+
+public:
+	uop_cache_t(uint64_t max_length, uint64_t entries, uint64_t assoc);
+	~uop_cache_t();
+
+	// Fetch1 stage: returns true if the line of the fetch bundle at start_pc holds its first "length" instructions.
+	// If so, read() supplies their micro-ops.
+	bool lookup(uint64_t start_pc, uint64_t length);
+	void read(uint64_t start_pc, uint64_t pos, payload_t *p);
+
+	// Decode stage: the instruction at position pos of the fetch bundle at start_pc was decoded into p.
+	// The first instruction of a fetch bundle allocates its line, and the following ones are appended to it.
+	void fill(uint64_t start_pc, uint64_t pos, payload_t *p);
+
+	void output(FILE *fp);
+};
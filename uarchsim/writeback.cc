@@ -122,6 +122,13 @@ void pipeline_t::writeback(unsigned int lane_number)
                 //******************SquashMask = REN->rollback(PAY.buf[index].Checkpoint_ID, true, TotalLoads, TotalStores, TotalBranches);
                 //******************selective_squash(SquashMask);
                 // FIX_ME #15b END
+
+                // The branch is resolved: the Fetch Unit stops counting it as unresolved (fetch gating).
+                FetchUnit->resolve(PAY.buf[index].pred_tag);
+
+                // Misprediction hotspot report (see stats_t::dump_br_hotspots()).
+                if (MISP_HOTSPOTS || histogram_enabled)
+                    stats->update_br_histogram(PAY.buf[index].pc, false);
             }
             // else
             else if (PAY.buf[index].good_instruction && (PAY.buf[index].next_pc != PAY.buf[index].c_next_pc))
@@ -190,6 +197,24 @@ void pipeline_t::writeback(unsigned int lane_number)
                 selective_squash(SquashMask);
                 // FIX_ME #15d END
 
+                // Charge the misprediction to the branch (misprediction hotspot report, see stats_t::dump_br_hotspots()):
+                // the cycles from its fetch to its resolution, and the instructions that the rollback squashes.  The Rename2
+                // stage places a checkpoint right after every mispredicted branch, so all of them are wrong-path instructions
+                // and nothing is re-executed.  What a checkpoint policy without that oracle would re-execute, by rolling back
+                // to the start of the branch's checkpoint, is reported separately: the good instructions from there to the branch.
+                // The refill bubble that follows is charged by the Rename2 stage, when the next instruction is renamed.
+                if (MISP_HOTSPOTS || histogram_enabled)
+                {
+                    stats->update_br_histogram(PAY.buf[index].pc, true);
+                    stats->update_br_misp_cost(PAY.buf[index].pc, (cycle - PAY.buf[index].fetch_cycle), PAY.rollback_count(index),
+                                               PAY.checkpoint_count(index));
+                    if (misp_refill_pending)
+                        stats->update_br_refill(misp_refill_pc, (cycle - misp_refill_cycle));
+                    misp_refill_pending = true;
+                    misp_refill_pc = PAY.buf[index].pc;
+                    misp_refill_cycle = cycle;
+                }
+
                 // Rollback PAY to the point of the branch.
                 PAY.rollback(index);
             }